@@ -0,0 +1,194 @@
+#include "TileMatchEnv.h"
+#include <GameStateBatch.h>
+#include <JobSystem.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * The environment behind the C handle: a GameStateBatch stepped block by block on its own JobSystem.
+ * The JobSystem has threads of its own only, the host's thread is no worker of it, so handles may be created and
+ * destroyed in any order. All per board buffers are allocated here, once.
+ */
+struct TileMatchEnv
+{
+    TileMatchEnv (int boards, Uint32 seed, int rows, int columns, int colors, int minMatchSize, int episodeMoves, int workers) :
+        mJobSystem (workers, false),
+        mGameStateBatch (boards, rows, columns, minMatchSize, colors, episodeMoves),
+        mSeed (seed),
+        mEpisodeMoves (episodeMoves),
+        mIsReset (false),
+        mMoves (boards, GameStateBatch::NO_MOVE),
+        mEpisodeSteps (boards, 0),
+        mEpisodes (boards, 0),
+        mSeeds (boards, 0),
+        mIsEpisodeOver (boards, 0)
+    {
+    }
+
+    JobSystem mJobSystem;
+    GameStateBatch mGameStateBatch;
+    Uint32 mSeed;
+    int mEpisodeMoves;
+    bool mIsReset;
+    std::vector<int> mMoves;            ///< the actions of the last step as GameStateBatch moves
+    std::vector<int> mEpisodeSteps;     ///< actions taken in the current episode of each board
+    std::vector<Uint32> mEpisodes;      ///< episodes started on each board
+    std::vector<Uint32> mSeeds;         ///< seeds of the boards starting an episode
+    std::vector<Uint8> mIsEpisodeOver;  ///< boards starting an episode
+};
+
+
+/*!
+ * Picks the seed of the next episode of a board.
+ */
+static void StartEpisode (TileMatchEnv* env, int board)
+{
+    const Uint32 boards = static_cast<Uint32>(env->mGameStateBatch.GetBoards());
+    env->mSeeds [board] = env->mSeed + env->mEpisodes [board] * boards + static_cast<Uint32>(board);
+    env->mEpisodes [board]++;
+    env->mEpisodeSteps [board] = 0;
+    env->mIsEpisodeOver [board] = 1;
+}
+
+
+/*!
+ * Writes the one-hot planes of boards [firstBoard, endBoard) straight into the caller's buffer.
+ */
+static void WriteObservations (const GameStateBatch& gameStateBatch, int firstBoard, int endBoard, unsigned char* observations)
+{
+    const int cells = gameStateBatch.GetRows() * gameStateBatch.GetColumns();
+    const size_t boardSize = static_cast<size_t>(gameStateBatch.GetColors()) * cells;
+    memset (observations + firstBoard * boardSize, 0, (endBoard - firstBoard) * boardSize);
+    // the batch keeps a cell of all boards together, so the tiles of a block are read a cell at a time
+    for (int cell = 0; cell < cells; cell++) {
+        const Uint8* cellTiles = gameStateBatch.GetCellAcrossBoards (cell);
+        for (int board = firstBoard; board < endBoard; board++) {
+            observations [board * boardSize + (cellTiles [board] - 1) * cells + cell] = 1;
+        }
+    }
+}
+
+
+TileMatchEnv* env_create (int n, unsigned int seed)
+{
+    return env_create_ex (n, seed, 8, 8, 5, 3, 100, 0);
+}
+
+
+TileMatchEnv* env_create_ex (int n, unsigned int seed, int rows, int columns, int colors, int min_match_size, int episode_moves, int workers)
+{
+    if (n <= 0 || rows < 1 || rows > GameStateBatch::MAX_SIDE || columns < 1 || columns > GameStateBatch::MAX_SIDE ||
+            colors < 2 || colors > 254 || min_match_size < 2 || episode_moves < 1 || workers < 0) {
+        printf ("ERROR: env_create_ex called with n %d, %dx%d board, %d colors, match size %d, %d moves, %d workers.\n",
+                n, rows, columns, colors, min_match_size, episode_moves, workers);
+        return NULL;
+    }
+    // the host program owns stdout, only errors are printed into it
+    JobSystem::SetIsLoggingEnabled (false);
+    return new TileMatchEnv (n, seed, rows, columns, colors, min_match_size, episode_moves, workers);
+}
+
+
+void env_destroy (TileMatchEnv* env)
+{
+    delete env;
+}
+
+
+int env_get_board_count (const TileMatchEnv* env)
+{
+    return env != NULL ? env->mGameStateBatch.GetBoards() : -1;
+}
+
+
+int env_get_rows (const TileMatchEnv* env)
+{
+    return env != NULL ? env->mGameStateBatch.GetRows() : -1;
+}
+
+
+int env_get_columns (const TileMatchEnv* env)
+{
+    return env != NULL ? env->mGameStateBatch.GetColumns() : -1;
+}
+
+
+int env_get_colors (const TileMatchEnv* env)
+{
+    return env != NULL ? env->mGameStateBatch.GetColors() : -1;
+}
+
+
+int env_get_action_count (const TileMatchEnv* env)
+{
+    return env != NULL ? env->mGameStateBatch.GetRows() * env->mGameStateBatch.GetColumns() * 2 : -1;
+}
+
+
+int env_reset (TileMatchEnv* env, unsigned char* observations)
+{
+    if (env == NULL || observations == NULL) {
+        return -1;
+    }
+    for (int board = 0; board < env->mGameStateBatch.GetBoards(); board++) {
+        StartEpisode (env, board);
+    }
+    env->mJobSystem.ParallelFor (env->mGameStateBatch.GetBlocks(), 1, [env, observations] (int firstBlock, int endBlock) {
+        GameStateBatch& gameStateBatch = env->mGameStateBatch;
+        gameStateBatch.ResetBoards (env->mIsEpisodeOver.data(), env->mSeeds.data(), firstBlock, endBlock);
+        const int firstBoard = firstBlock * GameStateBatch::BLOCK_SIZE;
+        const int endBoard = endBlock * GameStateBatch::BLOCK_SIZE < gameStateBatch.GetBoards() ? endBlock * GameStateBatch::BLOCK_SIZE : gameStateBatch.GetBoards();
+        WriteObservations (gameStateBatch, firstBoard, endBoard, observations);
+    });
+    env->mIsReset = true;
+    return 0;
+}
+
+
+int env_step (TileMatchEnv* env, const int* actions, unsigned char* observations, float* rewards, unsigned char* dones)
+{
+    if (env == NULL || actions == NULL || observations == NULL || rewards == NULL || dones == NULL) {
+        return -1;
+    }
+    if (!env->mIsReset) {
+        printf ("ERROR: env_step called before env_reset.\n");
+        return -1;
+    }
+    // every block is stepped, rewarded, reset and observed by one job while its tiles are in cache
+    env->mJobSystem.ParallelFor (env->mGameStateBatch.GetBlocks(), 1, [env, actions, observations, rewards, dones] (int firstBlock, int endBlock) {
+        GameStateBatch& gameStateBatch = env->mGameStateBatch;
+        const int columns = gameStateBatch.GetColumns();
+        const int actionCount = gameStateBatch.GetRows() * columns * 2;
+        const int firstBoard = firstBlock * GameStateBatch::BLOCK_SIZE;
+        const int endBoard = endBlock * GameStateBatch::BLOCK_SIZE < gameStateBatch.GetBoards() ? endBlock * GameStateBatch::BLOCK_SIZE : gameStateBatch.GetBoards();
+        for (int board = firstBoard; board < endBoard; board++) {
+            const int action = actions [board];
+            if (action < 0 || action >= actionCount) {
+                env->mMoves [board] = GameStateBatch::NO_MOVE;
+            } else {
+                env->mMoves [board] = GameStateBatch::EncodeMove ((action / 2) / columns, (action / 2) % columns, (action & 1) != 0);
+            }
+        }
+        gameStateBatch.StepBlocks (env->mMoves.data(), firstBlock, endBlock);
+        for (int board = firstBoard; board < endBoard; board++) {
+            rewards [board] = static_cast<float>(gameStateBatch.GetLastStepScore (board));
+            env->mIsEpisodeOver [board] = 0;
+            if (++env->mEpisodeSteps [board] >= env->mEpisodeMoves) {
+                StartEpisode (env, board);
+            }
+            dones [board] = env->mIsEpisodeOver [board];
+        }
+        gameStateBatch.ResetBoards (env->mIsEpisodeOver.data(), env->mSeeds.data(), firstBlock, endBlock);
+        WriteObservations (gameStateBatch, firstBoard, endBoard, observations);
+    });
+    return 0;
+}
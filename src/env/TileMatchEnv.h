@@ -0,0 +1,97 @@
+#pragma once
+
+/*!
+ * C interface for training agents on many boards at once, built as the TileMatchEnv shared library.
+ * The rules are those of GameState and GameStateLogic without animations; every board is one GameStateBatch board.
+ *
+ * An environment steps n independent boards. All buffers belong to the caller and are written in place:
+ * - observations: n * colors * rows * columns bytes, one-hot color planes; the byte of board b, color c (0 based,
+ *   GameState::Color c + 1), row r and column k is at ((b * colors + c) * rows + r) * columns + k.
+ * - rewards: n floats, the points (destroyed tiles) the action scored.
+ * - dones: n bytes, 1 if the action ended the episode of the board. The board then starts its next episode right
+ *   away and its observation already shows the new board.
+ * Action a of a board swaps the tile at cell a / 2 (row major) with its right neighbour (a even) or the one below
+ * (a odd). Actions run from 0 to env_get_action_count() - 1; swaps past the edge of the board do nothing.
+ * Every action, valid or not, uses up one of the episode's moves.
+ *
+ * Stepping runs on all cores and does not allocate. Functions returning int give 0 on success and -1 on bad arguments.
+ * An environment must not be used from two threads at the same time.
+ */
+
+#ifdef _WIN32
+    #ifdef TILEMATCHENV_EXPORTS
+        #define TILEMATCHENV_API __declspec(dllexport)
+    #else
+        #define TILEMATCHENV_API __declspec(dllimport)
+    #endif
+#else
+    #define TILEMATCHENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TileMatchEnv TileMatchEnv;
+
+
+/*!
+ * Creates n boards of 8x8 tiles, 5 colors, matches of 3 and 100 moves per episode.
+ * @param n the number of boards.
+ * @param seed episode e of board b starts from seed + e * n + b.
+ * @return the environment, NULL if n is not positive.
+ */
+TILEMATCHENV_API TileMatchEnv* env_create (int n, unsigned int seed);
+
+
+/*!
+ * Creates n boards with the given rules.
+ * @param rows rows of each board, 1 to 16.
+ * @param columns columns of each board, 1 to 16.
+ * @param colors number of tile colors, 2 to 254.
+ * @param min_match_size how many tiles of same color in a row are a match, at least 2.
+ * @param episode_moves actions per episode.
+ * @param workers threads stepping the boards besides the calling one, 0 for every hardware thread.
+ * @return the environment, NULL if an argument is out of range.
+ */
+TILEMATCHENV_API TileMatchEnv* env_create_ex (int n, unsigned int seed, int rows, int columns, int colors,
+        int min_match_size, int episode_moves, int workers);
+
+
+/*!
+ * Destroys an environment made by env_create or env_create_ex.
+ */
+TILEMATCHENV_API void env_destroy (TileMatchEnv* env);
+
+
+TILEMATCHENV_API int env_get_board_count (const TileMatchEnv* env);
+TILEMATCHENV_API int env_get_rows (const TileMatchEnv* env);
+TILEMATCHENV_API int env_get_columns (const TileMatchEnv* env);
+TILEMATCHENV_API int env_get_colors (const TileMatchEnv* env);
+
+
+/*!
+ * Retrieves the number of actions of a board, rows * columns * 2.
+ */
+TILEMATCHENV_API int env_get_action_count (const TileMatchEnv* env);
+
+
+/*!
+ * Starts a new episode on every board.
+ * @param observations output of n * colors * rows * columns bytes.
+ */
+TILEMATCHENV_API int env_reset (TileMatchEnv* env, unsigned char* observations);
+
+
+/*!
+ * Applies one action to every board.
+ * @param actions n actions.
+ * @param observations output of n * colors * rows * columns bytes.
+ * @param rewards output of n floats.
+ * @param dones output of n bytes.
+ */
+TILEMATCHENV_API int env_step (TileMatchEnv* env, const int* actions, unsigned char* observations, float* rewards, unsigned char* dones);
+
+#ifdef __cplusplus
+}
+#endif
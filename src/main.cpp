@@ -1,16 +1,22 @@
+#include	<stdio.h>
 #include	<stdlib.h>
 #include  <TestGame.h>
 
 
 /*!
  * Main function. Creates a TestGame objects and calls testGame.Start().
- * @param argc does nothing; it is left here for convention or arguments in the future.
- * @param argv does nothing; it is left here for convention or arguments in the future.
+ * @param argc up to 2 arguments: the frame pacing, "vsync" (default), "adaptive" (vsync letting late frames tear),
+ *  "cap" followed by the frames per second (default 60) or "uncapped" (draws every frame as fast as it can and prints
+ *  the frame rate on exit).
  * @return returns 0 if the program exited without detected issues.
  */
 int main (int argc, char* argv[])
 {
     TestGame testGame;
+    if (argc > 1 && !testGame.GetFramePacer().SetMode (argv [1], argc > 2 ? argv [2] : NULL)) {
+        printf ("usage: TestGame [vsync | adaptive | cap [frames per second] | uncapped]\n");
+        return EXIT_FAILURE;
+    }
     testGame.Start();
     return EXIT_SUCCESS;
 }				/* ----------  end of function main  ---------- */
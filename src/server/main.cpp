@@ -0,0 +1,102 @@
+#include <malloc.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <GameServer.h>
+#include <GameState.h>
+#include <Leaderboard.h>
+
+
+static volatile sig_atomic_t sIsToStop = 0;
+
+
+static void HandleStopSignal (int signal)
+{
+    (void)signal;
+    sIsToStop = 1;
+}
+
+
+/*!
+ * Main function of the game server. Hosts 8x8 games until interrupted and prints the counters of every event loop
+ * every STATS_SECONDS.
+ * @param argc up to 6 arguments: the address ("unix:<path>" or a TCP port, default 7777),
+ *  the number of event loops (default one per hardware thread), the gameplay seconds of a game (default 60),
+ *  the miliseconds a game rests before it hibernates (default 0, never), the file prefix to spill hibernating games to
+ *  (default none, they are kept in memory; "-" for none) and the leaderboard log file (default none).
+ * @return returns 0 if the server stopped without detected issues.
+ */
+int main (int argc, char* argv[])
+{
+    static const int STATS_SECONDS = 5;
+    const char* address = argc > 1 ? argv [1] : "7777";
+    const int loopCount = argc > 2 ? atoi (argv [2]) : 0;
+    const int gameplaySeconds = argc > 3 ? atoi (argv [3]) : 60;
+    const int hibernationMilis = argc > 4 ? atoi (argv [4]) : 0;
+    const char* spillFilePrefix = argc > 5 && strcmp (argv [5], "-") != 0 ? argv [5] : NULL;
+    const char* leaderboardPath = argc > 6 ? argv [6] : NULL;
+    if (gameplaySeconds < 1 || hibernationMilis < 0) {
+        printf ("usage: GameServer [unix:<socket path> | port] [event loops] [gameplay seconds] [hibernation miliseconds] [spill file prefix | -] [leaderboard file]\n");
+        return EXIT_FAILURE;
+    }
+
+    // every session is a socket
+    rlimit fileLimit;
+    if (getrlimit (RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_cur < fileLimit.rlim_max) {
+        fileLimit.rlim_cur = fileLimit.rlim_max;
+        setrlimit (RLIMIT_NOFILE, &fileLimit);
+    }
+    signal (SIGINT, HandleStopSignal);
+    signal (SIGTERM, HandleStopSignal);
+    signal (SIGPIPE, SIG_IGN);
+    GameState::SetIsLoggingEnabled (false);
+
+    Leaderboard leaderboard;
+    if (leaderboardPath != NULL) {
+        if (!leaderboard.Open (leaderboardPath)) {
+            return EXIT_FAILURE;
+        }
+        printf ("leaderboard '%s': %llu scores\n", leaderboardPath, static_cast<unsigned long long>(leaderboard.GetRecordCount()));
+    }
+
+    GameServer gameServer (8, 8, 3, gameplaySeconds);
+    gameServer.SetHibernation (static_cast<Uint32>(hibernationMilis), spillFilePrefix);
+    gameServer.SetLeaderboard (leaderboardPath != NULL ? &leaderboard : NULL);
+    if (!gameServer.Start (address, loopCount)) {
+        return EXIT_FAILURE;
+    }
+    // what the heap grows by from here on is the sessions'
+    const double startHeapBytes = static_cast<double>(mallinfo2().uordblks);
+    std::vector<Uint64> lastSwaps (gameServer.GetLoopCount(), 0);
+    int seconds = 0;
+    while (sIsToStop == 0) {
+        std::this_thread::sleep_for (std::chrono::seconds (1));
+        if (++seconds % STATS_SECONDS != 0) {
+            continue;
+        }
+        int sessions = 0;
+        for (int loop = 0; loop < gameServer.GetLoopCount(); loop++) {
+            GameServer::LoopStats& stats = gameServer.GetLoopStats (loop);
+            const Uint64 swaps = stats.mSwaps.load();
+            printf ("loop %2d: %6d sessions, %6d hibernating, %5d animating, %7.0f swaps/s, longest tick %5.2f ms\n", loop, stats.mSessions.load(),
+                    stats.mHibernatingSessions.load(), stats.mAnimatingSessions.load(), static_cast<double>(swaps - lastSwaps [loop]) / STATS_SECONDS, stats.mMaxTickMicroseconds.exchange (0) / 1000.0);
+            lastSwaps [loop] = swaps;
+            sessions += stats.mSessions.load();
+        }
+        printf ("heap: %.0f bytes per session\n", sessions > 0 ? (static_cast<double>(mallinfo2().uordblks) - startHeapBytes) / sessions : 0.0);
+        if (leaderboardPath != NULL) {
+            Leaderboard::Record best;
+            const int bestCount = leaderboard.GetTop (Leaderboard::MakeRules (8, 8, 3, gameplaySeconds), Leaderboard::Day, Leaderboard::GetTimeNow(), 1, &best);
+            printf ("leaderboard: %llu scores in %llu commits, best today %d\n", static_cast<unsigned long long>(leaderboard.GetRecordCount()),
+                    static_cast<unsigned long long>(leaderboard.GetCommitCount()), bestCount > 0 ? best.mScore : 0);
+        }
+    }
+    gameServer.Stop();
+    leaderboard.Close();
+    return EXIT_SUCCESS;
+}				/* ----------  end of function main  ---------- */
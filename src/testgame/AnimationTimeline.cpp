@@ -0,0 +1,74 @@
+#include "AnimationTimeline.h"
+#include <algorithm>
+#include <float.h>
+
+
+AnimationTimeline::AnimationTimeline () :
+    mTargets(),
+    mChannels(),
+    mStarts(),
+    mInverseDurations(),
+    mFroms(),
+    mDeltas(),
+    mCurvatures()
+{
+}
+
+
+float AnimationTimeline::GetEnd () const
+{
+    float end = -FLT_MAX;
+    for (size_t tween = 0; tween < mStarts.size(); tween++) {
+        const float tweenEnd = mStarts [tween] + (mInverseDurations [tween] > 0.0f ? 1.0f / mInverseDurations [tween] : 0.0f);
+        end = tweenEnd > end ? tweenEnd : end;
+    }
+    return end;
+}
+
+
+bool AnimationTimeline::IsSameAs (const AnimationTimeline& other) const
+{
+    return mTargets == other.mTargets && mChannels == other.mChannels && mStarts == other.mStarts && mInverseDurations == other.mInverseDurations
+        && mFroms == other.mFroms && mDeltas == other.mDeltas && mCurvatures == other.mCurvatures;
+}
+
+
+void AnimationTimeline::Evaluate (float time, float* values) const
+{
+    const int count = GetTweenCount();
+    const float* starts = mStarts.data();
+    const float* inverseDurations = mInverseDurations.data();
+    const float* froms = mFroms.data();
+    const float* deltas = mDeltas.data();
+    const float* curvatures = mCurvatures.data();
+    // no branches, so the loop is vectorized: std::min and std::max of floats become min and max instructions
+    for (int tween = 0; tween < count; tween++) {
+        const float t = std::min (std::max ((time - starts [tween]) * inverseDurations [tween], 0.0f), 1.0f);
+        const float eased = t + curvatures [tween] * t * (t - 1.0f);
+        values [tween] = froms [tween] + deltas [tween] * eased;
+    }
+}
+
+
+void AnimationTimeline::Add (int target, int channel, float start, float duration, float from, float to, Easing easing)
+{
+    mTargets.push_back (target);
+    mChannels.push_back (static_cast<Uint8>(channel));
+    mStarts.push_back (start);
+    mInverseDurations.push_back (duration > 0.0f ? 1.0f / duration : 0.0f);
+    mFroms.push_back (duration > 0.0f ? from : to);
+    mDeltas.push_back (duration > 0.0f ? to - from : 0.0f);
+    mCurvatures.push_back (EaseIn == easing ? 1.0f : (EaseOut == easing ? -1.0f : 0.0f));
+}
+
+
+void AnimationTimeline::Clear ()
+{
+    mTargets.clear();
+    mChannels.clear();
+    mStarts.clear();
+    mInverseDurations.clear();
+    mFroms.clear();
+    mDeltas.clear();
+    mCurvatures.clear();
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Any number of tweens running at the same time, each moving one value of one target (eg. the vertical offset of a
+ * tile) from a value to another over its own start and duration with an easing.
+ *
+ * The tweens are kept as a structure of arrays, one array per field, and Evaluate runs over all of them in a single
+ * loop without branches, so the compiler vectorizes it and thousands of moving tiles cost about as little as a few.
+ * The easing is stored as the curvature of a quadratic (eased = t + curvature * t * (t - 1)): 0 for Linear, 1 for
+ * EaseIn, -1 for EaseOut.
+ *
+ * Times are in miliseconds from any origin the caller picks; a tween is at its from value until it starts and at its
+ * to value from its end on.
+ */
+class AnimationTimeline
+{
+    public:
+        enum Easing {
+            Linear,
+            EaseIn,         ///< starts slow and speeds up, like a falling tile
+            EaseOut         ///< starts fast and slows down
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        AnimationTimeline ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        int GetTweenCount () const
+        {
+            return static_cast<int>(mTargets.size());
+        }
+
+        int GetTarget (int tween) const
+        {
+            return mTargets [tween];
+        }
+
+        int GetChannel (int tween) const
+        {
+            return mChannels [tween];
+        }
+
+
+        /*!
+         * Retrieves the time the last tween ends at.
+         * @return the end, or the smallest float if there is no tween.
+         */
+        float GetEnd () const;
+
+
+        /*!
+         * Compares the tweens of two timelines.
+         * @return true if both have the same tweens in the same order.
+         */
+        bool IsSameAs (const AnimationTimeline& other) const;
+
+
+        /*!
+         * Calculates the values of all tweens at a time, in one pass.
+         * @param values output of GetTweenCount values, in the order the tweens were added.
+         */
+        void Evaluate (float time, float* values) const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Adds a tween. The arrays are not allocated again once the timeline held as many tweens.
+         * @param target what the tween moves, eg. the index of a tile.
+         * @param channel which value of the target the tween moves, eg. its horizontal offset.
+         * @param start the time the tween starts at.
+         * @param duration how long the tween takes; with 0 the tween is at its to value all the time.
+         */
+        void Add (int target, int channel, float start, float duration, float from, float to, Easing easing);
+
+
+        /*!
+         * Removes all tweens, keeping the arrays.
+         */
+        void Clear ();
+
+    private:
+        /* ====================  DATA MEMBERS  ======================================= */
+        std::vector<int> mTargets;
+        std::vector<Uint8> mChannels;
+        std::vector<float> mStarts;
+        std::vector<float> mInverseDurations;   ///< 1 / duration, so Evaluate needs no division
+        std::vector<float> mFroms;
+        std::vector<float> mDeltas;             ///< to - from
+        std::vector<float> mCurvatures;         ///< the easing
+
+}; /* -----  end of class AnimationTimeline  ----- */
@@ -0,0 +1,211 @@
+#include "AudioMixer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Appends decaying sine tones, one after the other.
+ * @param frequencies the tones in Hz.
+ * @param noteSeconds how long each tone lasts.
+ */
+static void AppendTones (std::vector<Sint16>& samples, const float* frequencies, int toneCount, float noteSeconds)
+{
+    const float amplitude = 0.25f * 32767.0f;
+    const int noteLength = static_cast<int>(noteSeconds * AudioMixer::SAMPLE_RATE);
+    for (int tone = 0; tone < toneCount; tone++) {
+        const float phaseStep = 2.0f * 3.14159265f * frequencies [tone] / AudioMixer::SAMPLE_RATE;
+        for (int sample = 0; sample < noteLength; sample++) {
+            // a short attack against clicks, then an exponential decay
+            const float attack = sample < 96 ? sample / 96.0f : 1.0f;
+            const float decay = expf (-4.0f * sample / noteLength);
+            samples.push_back (static_cast<Sint16>(amplitude * attack * decay * sinf (phaseStep * sample)));
+        }
+    }
+}
+
+
+AudioMixer::AudioMixer () :
+    mDevice (0),
+    mIsSubSystemInitialized (false),
+    mCounterFrequency (1),
+    mTail (0),
+    mDroppedCount (0),
+    mHead (0),
+    mVoiceCount (0),
+    mEventLatencies (10000, 0.01)
+{
+    SDL_zero (mSpec);
+}
+
+
+AudioMixer::~AudioMixer ()
+{
+    Close();
+}
+
+
+void AudioMixer::PrintStats () const
+{
+    if (mEventLatencies.GetCount() == 0) {
+        printf ("AudioMixer: no sounds played.\n");
+        return;
+    }
+    printf ("AudioMixer: %llu sounds played, %llu dropped, latency to the mixed buffer p50 %.3f ms, p99 %.3f ms, max %.3f ms, "
+            "plus up to %.3f ms the device buffers.\n", static_cast<unsigned long long>(mEventLatencies.GetCount()),
+            static_cast<unsigned long long>(mDroppedCount), mEventLatencies.GetPercentile (50), mEventLatencies.GetPercentile (99),
+            mEventLatencies.GetMaximum(), 1000.0 * mSpec.samples / (mSpec.freq > 0 ? mSpec.freq : SAMPLE_RATE));
+}
+
+
+bool AudioMixer::Open (int bufferFrames)
+{
+    if (IsOpen()) {
+        return true;
+    }
+    if (bufferFrames < 1 || bufferFrames > MAX_BUFFER_FRAMES) {
+        printf ("ERROR: AudioMixer::Open called with %d buffer frames, supported are 1 to %d.\n", bufferFrames, MAX_BUFFER_FRAMES);
+        return false;
+    }
+    if (SDL_InitSubSystem (SDL_INIT_AUDIO) < 0) {
+        printf ("AudioMixer::Open: SDL audio failed, playing without sound. SDL_ERROR: %s\n", SDL_GetError());
+        return false;
+    }
+    mIsSubSystemInitialized = true;
+    if (mSounds [0].empty()) {
+        MakeSounds();
+    }
+    mCounterFrequency = SDL_GetPerformanceFrequency();
+
+    // SDL converts to whatever the device plays, the callback always mixes mono 16 bit samples
+    SDL_AudioSpec desiredSpec;
+    SDL_zero (desiredSpec);
+    desiredSpec.freq = SAMPLE_RATE;
+    desiredSpec.format = AUDIO_S16SYS;
+    desiredSpec.channels = 1;
+    desiredSpec.samples = static_cast<Uint16>(bufferFrames);
+    desiredSpec.callback = AudioCallback;
+    desiredSpec.userdata = this;
+    mDevice = SDL_OpenAudioDevice (NULL, 0, &desiredSpec, &mSpec, 0);
+    if (mDevice == 0) {
+        printf ("AudioMixer::Open: no audio device, playing without sound. SDL_ERROR: %s\n", SDL_GetError());
+        SDL_QuitSubSystem (SDL_INIT_AUDIO);
+        mIsSubSystemInitialized = false;
+        return false;
+    }
+    SDL_PauseAudioDevice (mDevice, 0);
+    printf ("AudioMixer::Open: playing on %s, %d frames a buffer.\n", SDL_GetCurrentAudioDriver(), mSpec.samples);
+    return true;
+}
+
+
+void AudioMixer::Close ()
+{
+    if (mDevice != 0) {
+        // waits for the audio thread to end, its data is the caller's from here on
+        SDL_CloseAudioDevice (mDevice);
+        mDevice = 0;
+    }
+    if (mIsSubSystemInitialized) {
+        SDL_QuitSubSystem (SDL_INIT_AUDIO);
+        mIsSubSystemInitialized = false;
+    }
+}
+
+
+void AudioMixer::Play (Sound sound)
+{
+    const Uint32 tail = mTail.load (std::memory_order_relaxed);
+    if (!IsOpen() || tail - mHead.load (std::memory_order_acquire) == EVENT_CAPACITY) {
+        mDroppedCount += IsOpen() ? 1 : 0;
+        return;
+    }
+    SoundEvent& event = mEvents [tail & (EVENT_CAPACITY - 1)];
+    event.mSound = sound;
+    event.mCounter = SDL_GetPerformanceCounter();
+    mTail.store (tail + 1, std::memory_order_release);
+}
+
+
+void AudioMixer::MakeSounds ()
+{
+    const float swapTones[] = {660.0f};
+    const float matchTones[] = {784.0f, 1046.5f};
+    const float cascadeTones[] = {784.0f, 987.8f, 1174.7f, 1568.0f};
+    const float gameOverTones[] = {523.3f, 440.0f, 349.2f, 261.6f};
+    AppendTones (mSounds [Swap], swapTones, 1, 0.06f);
+    AppendTones (mSounds [Match], matchTones, 2, 0.08f);
+    AppendTones (mSounds [Cascade], cascadeTones, 4, 0.06f);
+    AppendTones (mSounds [GameOver], gameOverTones, 4, 0.2f);
+}
+
+
+void AudioMixer::Mix (Sint16* samples, int frames)
+{
+    // the sounds queued since the last buffer start with it
+    const Uint64 counter = SDL_GetPerformanceCounter();
+    const Uint32 tail = mTail.load (std::memory_order_acquire);
+    Uint32 head = mHead.load (std::memory_order_relaxed);
+    for (; head != tail; head++) {
+        const SoundEvent& event = mEvents [head & (EVENT_CAPACITY - 1)];
+        int voice = mVoiceCount;
+        if (mVoiceCount < MAX_VOICES) {
+            mVoiceCount++;
+        } else {
+            voice = 0;
+            for (int other = 1; other < MAX_VOICES; other++) {
+                if (mVoices [other].mLength - mVoices [other].mPosition < mVoices [voice].mLength - mVoices [voice].mPosition) {
+                    voice = other;
+                }
+            }
+        }
+        mVoices [voice].mSamples = &mSounds [event.mSound][0];
+        mVoices [voice].mLength = static_cast<int>(mSounds [event.mSound].size());
+        mVoices [voice].mPosition = 0;
+        mEventLatencies.Add (1000.0 * static_cast<double>(counter - event.mCounter) / static_cast<double>(mCounterFrequency));
+    }
+    mHead.store (head, std::memory_order_release);
+
+    memset (mAccumulator, 0, frames * sizeof (mAccumulator [0]));
+    for (int voice = 0; voice < mVoiceCount;) {
+        Voice& playing = mVoices [voice];
+        const int count = playing.mLength - playing.mPosition < frames ? playing.mLength - playing.mPosition : frames;
+        const Sint16* source = playing.mSamples + playing.mPosition;
+        for (int frame = 0; frame < count; frame++) {
+            mAccumulator [frame] += source [frame];
+        }
+        playing.mPosition += count;
+        // a finished voice is replaced by the last one
+        if (playing.mPosition == playing.mLength) {
+            playing = mVoices [--mVoiceCount];
+        } else {
+            voice++;
+        }
+    }
+    for (int frame = 0; frame < frames; frame++) {
+        const Sint32 value = mAccumulator [frame];
+        samples [frame] = static_cast<Sint16>(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+    }
+}
+
+
+void SDLCALL AudioMixer::AudioCallback (void* userdata, Uint8* stream, int length)
+{
+    AudioMixer* audioMixer = static_cast<AudioMixer*>(userdata);
+    Sint16* samples = reinterpret_cast<Sint16*>(stream);
+    int frames = length / static_cast<int>(sizeof (Sint16));
+    // the device asks for its buffer size, in case it ever asks for more the events start with the first part
+    while (frames > 0) {
+        const int count = frames < MAX_BUFFER_FRAMES ? frames : MAX_BUFFER_FRAMES;
+        audioMixer->Mix (samples, count);
+        samples += count;
+        frames -= count;
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <Histogram.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Plays the sounds of the game: a SDL audio callback mixes up to MAX_VOICES sounds at once from PCM samples made
+ * once in Open, so playing a sound costs no decoding.
+ *
+ * Sounds are asked for with Play from one thread, the simulation thread, and handed to the audio thread through a
+ * fixed ring of EVENT_CAPACITY events without locks, like InputQueue does. The callback takes the queued events, starts
+ * a voice for each, stealing the one closest to its end if all are busy, and mixes the voices into the buffer: it
+ * never locks nor allocates, so it never waits for the game and the device never runs dry because of it.
+ *
+ * Every sound's latency is recorded, from Play to the callback that mixes its first sample; the device still has to
+ * play out the buffer before it, at most GetBufferFrames more.
+ */
+class AudioMixer
+{
+    public:
+        enum Sound {
+            Swap,
+            Match,
+            Cascade,        ///< a match the refill made, not the player
+            GameOver,
+            SOUND_COUNT
+        };
+
+        static const int SAMPLE_RATE = 48000;
+        static const int DEFAULT_BUFFER_FRAMES = 512;   ///< 10.7 ms at SAMPLE_RATE
+        static const int MAX_BUFFER_FRAMES = 8192;
+        static const int MAX_VOICES = 16;
+        static const int EVENT_CAPACITY = 64;           ///< a power of two
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        AudioMixer ();
+        ~AudioMixer ();                                 /* destructor, closes the device */
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        bool IsOpen () const
+        {
+            return mDevice != 0;
+        }
+
+        /// the frames of the device's buffer, the audio callback fills that many at once
+        int GetBufferFrames () const
+        {
+            return mSpec.samples;
+        }
+
+        /// miliseconds from Play to the callback mixing the sound's first sample, read when the device is closed
+        const Histogram& GetEventLatencies () const
+        {
+            return mEventLatencies;
+        }
+
+        /// sounds not played because the event ring was full, producer thread
+        Uint64 GetDroppedCount () const
+        {
+            return mDroppedCount;
+        }
+
+
+        /*!
+         * Prints the buffer size and the event latency percentiles. Call when the device is closed.
+         */
+        void PrintStats () const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Initializes SDL audio, makes the sounds and starts playing on the default device of the current driver (the
+         * SDL_AUDIODRIVER environment variable picks one, eg. "dummy" to play without sound hardware).
+         * @param bufferFrames the size of the device's buffer, a power of two up to MAX_BUFFER_FRAMES; smaller buffers
+         *  play sooner but call back more often.
+         * @return false if no device could be opened, the game then plays silently.
+         */
+        bool Open (int bufferFrames = DEFAULT_BUFFER_FRAMES);
+
+
+        /*!
+         * Stops the audio thread and closes the device.
+         */
+        void Close ();
+
+
+        /*!
+         * Plays a sound as soon as the audio thread mixes the next buffer. Producer thread, never blocks.
+         */
+        void Play (Sound sound);
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        AudioMixer (const AudioMixer&);
+        AudioMixer& operator= (const AudioMixer&);
+
+        /*!
+         * A sound queued by Play.
+         */
+        struct SoundEvent {
+            Uint64 mCounter;                    ///< SDL_GetPerformanceCounter at Play
+            int mSound;
+        };
+
+        /*!
+         * A sound being played, audio thread.
+         */
+        struct Voice {
+            const Sint16* mSamples;
+            int mLength;
+            int mPosition;                      ///< the next sample to mix
+        };
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Makes the samples of every sound, a few decaying tones each.
+         */
+        void MakeSounds ();
+
+
+        /*!
+         * Starts the queued sounds and mixes the voices into samples. Audio thread.
+         */
+        void Mix (Sint16* samples, int frames);
+
+
+        static void SDLCALL AudioCallback (void* userdata, Uint8* stream, int length);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        std::vector<Sint16> mSounds [SOUND_COUNT];  ///< mono at SAMPLE_RATE
+        SDL_AudioDeviceID mDevice;                  ///< 0 while closed
+        SDL_AudioSpec mSpec;
+        bool mIsSubSystemInitialized;
+        Uint64 mCounterFrequency;
+
+        // producer side
+        SoundEvent mEvents [EVENT_CAPACITY];
+        std::atomic<Uint32> mTail;                  ///< events pushed, wrapping
+        Uint64 mDroppedCount;
+        char mProducerPadding [64];
+        // audio thread
+        std::atomic<Uint32> mHead;                  ///< events taken, wrapping
+        Voice mVoices [MAX_VOICES];
+        int mVoiceCount;
+        Sint32 mAccumulator [MAX_BUFFER_FRAMES];    ///< the sum of the voices before clipping
+        Histogram mEventLatencies;
+
+}; /* -----  end of class AudioMixer  ----- */
@@ -0,0 +1,434 @@
+#include "AutosaveJournal.h"
+#include <Crc32.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+static const char MAGIC [8] = { 'T', 'M', 'J', 'O', 'U', 'R', 'N', 'L' };
+static const Uint32 VERSION = 2;
+
+
+AutosaveJournal::AutosaveJournal () :
+    mIsOpen (false),
+    mIsSwapUnresolved (false),
+    mIsGameOver (false),
+    mSeed (0),
+    mSyncIntervalMilis (0),
+    mLastEntryGameplayTime (0),
+    mSequence (0),
+    mRecordedCount (0),
+    mSyncedCount (0),
+    mSyncRequestedCount (0),
+    mSyncCount (0),
+    mIsClosing (false),
+    mFile (-1)
+{
+}
+
+
+AutosaveJournal::~AutosaveJournal ()
+{
+    Close();
+}
+
+
+Uint32 AutosaveJournal::GetEntryChecksum (const Entry& entry)
+{
+    return Crc32::Update (0, reinterpret_cast<const Uint8*>(&entry) + sizeof (entry.mChecksum), sizeof (Entry) - sizeof (entry.mChecksum));
+}
+
+
+bool AutosaveJournal::Start (const char* filePath, const GameState& gameState, Uint32 seed, Uint32 syncIntervalMilis)
+{
+    Close();
+#ifdef TARGET_UNIX
+    GameState::Keyframe keyframe;
+    mGrid.resize (gameState.GetRows() * gameState.GetColumns());
+    if (!gameState.GetKeyframe (keyframe, mGrid.data())) {
+        printf ("ERROR: AutosaveJournal::Start called with a game that is not resting.\n");
+        return false;
+    }
+    mFilePath = filePath;
+    mIsSwapUnresolved = false;
+    mIsGameOver = false;
+    TakeSnapshot (gameState, seed);
+    StartWriter (syncIntervalMilis);
+    return true;
+#else
+    printf ("ERROR: AutosaveJournal::Start is not supported on this platform, %s is not used.\n", filePath);
+    return false;
+#endif
+}
+
+
+bool AutosaveJournal::Resume (const char* filePath, GameStateLogic& gameStateLogic, std::unique_ptr<GameState>& gameState, Uint32& seed,
+        Uint32 syncIntervalMilis)
+{
+    Close();
+#ifdef TARGET_UNIX
+    FILE* file = fopen (filePath, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    std::vector<Uint8> data;
+    Uint8 buffer [4096];
+    size_t readSize;
+    while ((readSize = fread (buffer, 1, sizeof (buffer), file)) > 0) {
+        data.insert (data.end(), buffer, buffer + readSize);
+    }
+    fclose (file);
+
+    Header header;
+    if (data.size() < sizeof (header)) {
+        printf ("WARNING: AutosaveJournal::Resume %s has no complete snapshot.\n", filePath);
+        return false;
+    }
+    memcpy (&header, data.data(), sizeof (header));
+    const size_t gridSize = static_cast<size_t>(header.mRows) * header.mColumns;
+    if (memcmp (header.mMagic, MAGIC, sizeof (MAGIC)) != 0 || header.mVersion != VERSION || header.mEntrySize != sizeof (Entry) ||
+            header.mRows < 1 || header.mColumns < 1 || header.mRows > 64 || header.mColumns > 64 || data.size() < sizeof (header) + gridSize ||
+            Crc32::Update (0, data.data() + offsetof (Header, mRows), sizeof (header) - offsetof (Header, mRows) + gridSize) != header.mChecksum) {
+        printf ("WARNING: AutosaveJournal::Resume %s is not a journal or its snapshot is damaged.\n", filePath);
+        return false;
+    }
+
+    // the journal ends at the first entry that is damaged or out of sequence; an ended game is not resumed
+    size_t entryCount = 0;
+    const size_t entriesOffset = sizeof (header) + gridSize;
+    while (entriesOffset + (entryCount + 1) * sizeof (Entry) <= data.size()) {
+        Entry entry;
+        memcpy (&entry, &data [entriesOffset + entryCount * sizeof (Entry)], sizeof (entry));
+        if (entry.mChecksum != GetEntryChecksum (entry) || entry.mSequence != entryCount) {
+            break;
+        }
+        if (entry.mType == GAME_OVER_ENTRY) {
+            return false;
+        }
+        entryCount++;
+    }
+
+    std::unique_ptr<GameState> resumedGameState (new GameState (header.mRows, header.mColumns, header.mMinMatchSize, header.mMaxGameplayTimeSeconds, header.mSeed));
+    resumedGameState->AttachGameStateGridChangeObserver (&gameStateLogic);
+    resumedGameState->RestoreKeyframe (header.mKeyframe, &data [sizeof (header)]);
+    mGrid.resize (gridSize);
+    mLastEntryGameplayTime = header.mKeyframe.mGameplayTime;
+    mIsSwapUnresolved = false;
+    mSequence = 0;
+    size_t offset = entriesOffset;
+    for (size_t index = 0; index < entryCount; index++) {
+        Entry entry;
+        memcpy (&entry, &data [offset], sizeof (entry));
+        if (!ReplayEntry (entry, gameStateLogic, *resumedGameState)) {
+            printf ("WARNING: AutosaveJournal::Resume entry %u of %s does not match the game, the journal ends before it.\n",
+                    entry.mSequence, filePath);
+            break;
+        }
+        mIsSwapUnresolved = entry.mType == SWAP_ENTRY;
+        mLastEntryGameplayTime = entry.mGameplayTime;
+        mSequence++;
+        offset += sizeof (Entry);
+    }
+
+    // continue the journal after the last good entry
+    mFile = open (filePath, O_WRONLY);
+    if (mFile < 0 || ftruncate (mFile, static_cast<off_t>(offset)) != 0 || lseek (mFile, static_cast<off_t>(offset), SEEK_SET) < 0) {
+        printf ("ERROR: AutosaveJournal::Resume cannot continue writing %s.\n", filePath);
+        if (mFile >= 0) {
+            close (mFile);
+            mFile = -1;
+        }
+        return false;
+    }
+    if (offset < data.size()) {
+        printf ("WARNING: AutosaveJournal::Resume cut %u damaged bytes off %s.\n", static_cast<unsigned>(data.size() - offset), filePath);
+    }
+    mFilePath = filePath;
+    mSeed = header.mSeed;
+    mIsGameOver = false;
+    gameState.swap (resumedGameState);
+    seed = header.mSeed;
+    StartWriter (syncIntervalMilis);
+    return true;
+#else
+    printf ("ERROR: AutosaveJournal::Resume is not supported on this platform, %s is not used.\n", filePath);
+    return false;
+#endif
+}
+
+
+bool AutosaveJournal::ReplayEntry (const Entry& entry, GameStateLogic& gameStateLogic, GameState& gameState)
+{
+    if (entry.mType != TICK_ENTRY && entry.mType != SWAP_ENTRY && entry.mType != RESOLVED_ENTRY) {
+        return false;
+    }
+    // however the time is split into updates the same game is played, so one update reaches the entry exactly
+    if (gameState.GetAnimationState() == GameState::GameOver || entry.mGameTime < gameState.GetGameTime() ||
+            entry.mGameplayTime < gameState.GetGameplayTime()) {
+        return false;
+    }
+    gameStateLogic.Update (entry.mGameTime - gameState.GetGameTime(), gameState);
+    if (gameState.GetAnimationState() == GameState::GameOver || gameState.GetGameplayTime() != entry.mGameplayTime) {
+        return false;
+    }
+    if (entry.mType == SWAP_ENTRY) {
+        if (abs (entry.mTileARow - entry.mTileBRow) + abs (entry.mTileAColumn - entry.mTileBColumn) != 1 ||
+                entry.mValue > gameStateLogic.GetAnimationDuration()) {
+            return false;
+        }
+        // tiles off the board or in motion are refused
+        return gameState.SwapTiles (entry.mTileARow, entry.mTileAColumn, entry.mTileBRow, entry.mTileBColumn,
+                gameStateLogic.GetAnimationDuration(), true, entry.mValue);
+    }
+    if (entry.mType == RESOLVED_ENTRY) {
+        GameState::Keyframe keyframe;
+        return gameState.GetKeyframe (keyframe, mGrid.data()) && keyframe.mGameScore == entry.mScore && keyframe.mRandomState == entry.mValue;
+    }
+    return true;
+}
+
+
+void AutosaveJournal::Close ()
+{
+    if (!mIsOpen) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock (mMutex);
+        mIsClosing = true;
+    }
+    mCondition.notify_all();
+    mWriterThread.join();
+#ifdef TARGET_UNIX
+    if (mFile >= 0) {
+        close (mFile);
+        mFile = -1;
+    }
+#endif
+    mIsOpen = false;
+}
+
+
+void AutosaveJournal::Sync ()
+{
+    if (!mIsOpen) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock (mMutex);
+    mSyncRequestedCount = mRecordedCount;
+    mCondition.notify_all();
+    while (mSyncedCount < mSyncRequestedCount) {
+        mCondition.wait (lock);
+    }
+}
+
+
+void AutosaveJournal::RecordSwap (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationHeadStart, const GameState& gameState)
+{
+    if (!mIsOpen || mIsGameOver) {
+        return;
+    }
+    Entry entry;
+    entry.mType = SWAP_ENTRY;
+    entry.mTileARow = static_cast<Uint8>(tileARow);
+    entry.mTileAColumn = static_cast<Uint8>(tileAColumn);
+    entry.mTileBRow = static_cast<Uint8>(tileBRow);
+    entry.mTileBColumn = static_cast<Uint8>(tileBColumn);
+    entry.mScore = gameState.GetScore();
+    entry.mValue = animationHeadStart;
+    Append (entry, gameState);
+    mIsSwapUnresolved = true;
+}
+
+
+void AutosaveJournal::RecordUpdate (const GameState& gameState, bool isGridCheckPending)
+{
+    if (!mIsOpen || mIsGameOver) {
+        return;
+    }
+    Entry entry;
+    if (gameState.GetAnimationState() == GameState::GameOver) {
+        entry.mType = GAME_OVER_ENTRY;
+        entry.mScore = gameState.GetScore();
+        entry.mValue = 0;
+        Append (entry, gameState);
+        mIsGameOver = true;
+        return;
+    }
+    if (gameState.GetAnimationState() != GameState::Idle || isGridCheckPending) {
+        return;
+    }
+    if (mIsSwapUnresolved) {
+        GameState::Keyframe keyframe;
+        if (!gameState.GetKeyframe (keyframe, mGrid.data())) {
+            return;
+        }
+        mIsSwapUnresolved = false;
+        if (mSequence >= COMPACT_ENTRY_COUNT) {
+            // the snapshot replaces the journal so far, resuming stays quick
+            TakeSnapshot (gameState, mSeed);
+            return;
+        }
+        entry.mType = RESOLVED_ENTRY;
+        entry.mScore = keyframe.mGameScore;
+        entry.mValue = keyframe.mRandomState;
+        Append (entry, gameState);
+    } else if (gameState.GetGameplayTime() - mLastEntryGameplayTime >= mSyncIntervalMilis) {
+        entry.mType = TICK_ENTRY;
+        entry.mScore = gameState.GetScore();
+        entry.mValue = 0;
+        Append (entry, gameState);
+    }
+}
+
+
+void AutosaveJournal::Append (Entry& entry, const GameState& gameState)
+{
+    entry.mSequence = mSequence++;
+    entry.mGameTime = gameState.GetGameTime();
+    entry.mGameplayTime = gameState.GetGameplayTime();
+    memset (entry.mPadding, 0, sizeof (entry.mPadding));
+    if (entry.mType != SWAP_ENTRY) {
+        entry.mTileARow = entry.mTileAColumn = entry.mTileBRow = entry.mTileBColumn = 0;
+    }
+    entry.mChecksum = GetEntryChecksum (entry);
+    mLastEntryGameplayTime = entry.mGameplayTime;
+    std::lock_guard<std::mutex> lock (mMutex);
+    mQueue.push_back (entry);
+    mRecordedCount++;
+}
+
+
+void AutosaveJournal::TakeSnapshot (const GameState& gameState, Uint32 seed)
+{
+    Header header;
+    memset (&header, 0, sizeof (header));
+    memcpy (header.mMagic, MAGIC, sizeof (MAGIC));
+    header.mVersion = VERSION;
+    header.mRows = gameState.GetRows();
+    header.mColumns = gameState.GetColumns();
+    header.mMinMatchSize = gameState.GetMinMatchSize();
+    header.mMaxGameplayTimeSeconds = gameState.GetMaxGameplayTimeSeconds();
+    header.mSeed = seed;
+    header.mEntrySize = sizeof (Entry);
+    gameState.GetKeyframe (header.mKeyframe, mGrid.data());
+    std::vector<Uint8> snapshot (sizeof (header) + mGrid.size());
+    memcpy (&snapshot [sizeof (header)], mGrid.data(), mGrid.size());
+    header.mChecksum = Crc32::Update (0, reinterpret_cast<const Uint8*>(&header) + offsetof (Header, mRows), sizeof (header) - offsetof (Header, mRows));
+    header.mChecksum = Crc32::Update (header.mChecksum, mGrid.data(), mGrid.size());
+    memcpy (&snapshot [0], &header, sizeof (header));
+
+    mSeed = seed;
+    mSequence = 0;
+    mLastEntryGameplayTime = header.mKeyframe.mGameplayTime;
+    std::lock_guard<std::mutex> lock (mMutex);
+    // everything queued so far is in the snapshot
+    mSnapshot.swap (snapshot);
+    mQueue.clear();
+    mRecordedCount++;
+}
+
+
+void AutosaveJournal::StartWriter (Uint32 syncIntervalMilis)
+{
+    mSyncIntervalMilis = syncIntervalMilis;
+    mIsClosing = false;
+    mIsOpen = true;
+    mWriterThread = std::thread (&AutosaveJournal::RunWriter, this);
+}
+
+
+void AutosaveJournal::RunWriter ()
+{
+    std::vector<Entry> entries;
+    std::vector<Uint8> snapshot;
+    std::unique_lock<std::mutex> lock (mMutex);
+    while (true) {
+        mCondition.wait_for (lock, std::chrono::milliseconds (mSyncIntervalMilis), [this] {
+            // a new snapshot is written right away, until then the file may hold an older game
+            return mIsClosing || mSyncedCount < mSyncRequestedCount || !mSnapshot.empty();
+        });
+        const bool isClosing = mIsClosing;
+        const Uint64 recordedCount = mRecordedCount;
+        entries.swap (mQueue);
+        snapshot.swap (mSnapshot);
+        if (!entries.empty() || !snapshot.empty()) {
+            lock.unlock();
+            if (snapshot.empty()) {
+                WriteEntries (entries);
+            } else {
+                WriteSnapshot (snapshot, entries);
+            }
+            entries.clear();
+            snapshot.clear();
+            lock.lock();
+            mSyncCount++;
+        }
+        mSyncedCount = recordedCount;
+        mCondition.notify_all();
+        if (isClosing) {
+            break;
+        }
+    }
+}
+
+
+bool AutosaveJournal::WriteSnapshot (const std::vector<Uint8>& snapshot, const std::vector<Entry>& entries)
+{
+#ifdef TARGET_UNIX
+    // a new file replaces the old one in a single rename, so a crash leaves one of them complete
+    const std::string temporaryPath = mFilePath + ".tmp";
+    const int file = open (temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool isWritten = file >= 0 && write (file, snapshot.data(), snapshot.size()) == static_cast<ssize_t>(snapshot.size());
+    isWritten = isWritten && (entries.empty() || write (file, entries.data(), entries.size() * sizeof (Entry)) == static_cast<ssize_t>(entries.size() * sizeof (Entry)));
+    isWritten = isWritten && fdatasync (file) == 0 && rename (temporaryPath.c_str(), mFilePath.c_str()) == 0;
+    if (!isWritten) {
+        printf ("ERROR: AutosaveJournal::WriteSnapshot cannot write %s.\n", temporaryPath.c_str());
+        if (file >= 0) {
+            close (file);
+        }
+        return false;
+    }
+    // make the rename itself durable
+    const size_t slash = mFilePath.find_last_of ('/');
+    const int directory = open (slash == std::string::npos ? "." : mFilePath.substr (0, slash + 1).c_str(), O_RDONLY);
+    if (directory >= 0) {
+        fsync (directory);
+        close (directory);
+    }
+    if (mFile >= 0) {
+        close (mFile);
+    }
+    mFile = file;
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool AutosaveJournal::WriteEntries (const std::vector<Entry>& entries)
+{
+#ifdef TARGET_UNIX
+    const ssize_t size = static_cast<ssize_t>(entries.size() * sizeof (Entry));
+    if (mFile < 0 || write (mFile, entries.data(), size) != size || fdatasync (mFile) != 0) {
+        printf ("ERROR: AutosaveJournal::WriteEntries cannot append %u entries to %s.\n", static_cast<unsigned>(entries.size()), mFilePath.c_str());
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
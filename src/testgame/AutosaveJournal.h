@@ -0,0 +1,184 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GameState.h>
+#include <GameStateLogic.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Keeps a running game on disk so that it survives the process dying. GameStateLogic reports accepted swaps and
+ * updates (see GameStateLogic::SetAutosaveJournal); the journal turns them into small entries and a writer thread
+ * appends and syncs them once per sync interval, so the game loop never waits for the disk.
+ *
+ * The file is a snapshot, a Header with the GameState::Keyframe and grid of a resting game, followed by fixed-size
+ * Entries, each with a CRC-32:
+ * - SWAP_ENTRY: a swap was accepted, with the game and gameplay time it started at;
+ * - RESOLVED_ENTRY: the board rests again after a swap, with the exact times, score and random state;
+ * - TICK_ENTRY: the game rested for another sync interval, so resting time is not lost;
+ * - GAME_OVER_ENTRY: the game ended, there is nothing left to resume.
+ * Once COMPACT_ENTRY_COUNT entries follow the snapshot, the next resting board becomes a new snapshot, written to a
+ * new file that replaces the old one.
+ *
+ * Resume restores the snapshot and plays the entries again, one update up to the game time of each entry; as
+ * GameStateLogic::Update plays the same game however the time is split, the times, score and random state of every
+ * entry are reached exactly and the game continues where the last synced entry left it. A torn or damaged entry
+ * ends the journal.
+ */
+class AutosaveJournal
+{
+    public:
+        static const Uint32 SWAP_ENTRY = 1;
+        static const Uint32 RESOLVED_ENTRY = 2;
+        static const Uint32 TICK_ENTRY = 3;
+        static const Uint32 GAME_OVER_ENTRY = 4;
+        static const Uint32 COMPACT_ENTRY_COUNT = 1024;
+
+        struct Header {
+            char mMagic [8];
+            Uint32 mVersion;
+            Uint32 mChecksum;               ///< CRC-32 of the rest of the header and the grid after it
+            Sint32 mRows, mColumns, mMinMatchSize;
+            Sint32 mMaxGameplayTimeSeconds;
+            Uint32 mSeed;
+            Uint32 mEntrySize;
+            GameState::Keyframe mKeyframe;
+        };
+
+        struct Entry {
+            Uint32 mChecksum;               ///< CRC-32 of the rest of the entry
+            Uint32 mSequence;               ///< entries since the snapshot, counting from 0
+            Uint8 mType;
+            Uint8 mTileARow, mTileAColumn;  ///< swap: the tiles
+            Uint8 mTileBRow, mTileBColumn;
+            Uint8 mPadding [3];
+            Uint32 mGameTime;
+            Uint32 mGameplayTime;
+            Sint32 mScore;                  ///< resolved and game over: the score
+            Uint32 mValue;                  ///< swap: the animation head start, resolved: the random state
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        AutosaveJournal ();
+        ~AutosaveJournal ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        bool IsOpen () const
+        {
+            return mIsOpen;
+        }
+
+        /// the number of syncs done so far
+        Uint64 GetSyncCount () const
+        {
+            std::lock_guard<std::mutex> lock (mMutex);
+            return mSyncCount;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Starts journaling a new game, replacing any journal in the file.
+         * @param gameState a resting game, eg. one just created.
+         * @param seed the seed gameState was created with.
+         * @param syncIntervalMilis how often the writer thread syncs, also the resting time a TICK_ENTRY covers.
+         * @return false if the game is not resting; failing writes are reported by the writer thread.
+         */
+        bool Start (const char* filePath, const GameState& gameState, Uint32 seed, Uint32 syncIntervalMilis = 250);
+
+
+        /*!
+         * Brings back the game of a journal and continues journaling it in the same file.
+         * @param gameStateLogic attached to the resumed game, it must not have a pending grid check.
+         * @param gameState output, the resumed game.
+         * @param seed output, the seed of the game.
+         * @return false if there is no journal, it is damaged before its first entry or its game is over.
+         */
+        bool Resume (const char* filePath, GameStateLogic& gameStateLogic, std::unique_ptr<GameState>& gameState, Uint32& seed,
+                Uint32 syncIntervalMilis = 250);
+
+
+        /*!
+         * Syncs what is left and stops the writer thread. The file stays, to be resumed.
+         */
+        void Close ();
+
+
+        /*!
+         * Waits until everything recorded so far is synced.
+         */
+        void Sync ();
+
+
+        /*!
+         * Records a swap a player or bot started.
+         */
+        void RecordSwap (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationHeadStart, const GameState& gameState);
+
+
+        /*!
+         * Records the outcome of an update, after GameStateLogic ran it.
+         * @param isGridCheckPending whether the next update still has to check the grid.
+         */
+        void RecordUpdate (const GameState& gameState, bool isGridCheckPending);
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        AutosaveJournal (const AutosaveJournal&);
+        AutosaveJournal& operator= (const AutosaveJournal&);
+
+        /* ====================  ACCESSORS     ======================================= */
+        static Uint32 GetEntryChecksum (const Entry& entry);
+
+        /* ====================  MUTATORS      ======================================= */
+        void Append (Entry& entry, const GameState& gameState);
+        void TakeSnapshot (const GameState& gameState, Uint32 seed);
+        bool ReplayEntry (const Entry& entry, GameStateLogic& gameStateLogic, GameState& gameState);
+        void RunWriter ();
+        bool WriteSnapshot (const std::vector<Uint8>& snapshot, const std::vector<Entry>& entries);
+        bool WriteEntries (const std::vector<Entry>& entries);
+        void StartWriter (Uint32 syncIntervalMilis);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        // game loop side
+        bool mIsOpen;
+        bool mIsSwapUnresolved;             ///< a SWAP_ENTRY waits for its RESOLVED_ENTRY
+        bool mIsGameOver;
+        Uint32 mSeed;
+        Uint32 mSyncIntervalMilis;
+        Uint32 mLastEntryGameplayTime;
+        Uint32 mSequence;                   ///< of the next entry
+        std::vector<Uint8> mGrid;
+
+        // shared with the writer thread, guarded by mMutex
+        mutable std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::vector<Entry> mQueue;
+        std::vector<Uint8> mSnapshot;       ///< a Header and grid to start a new file with, empty if none
+        Uint64 mRecordedCount;              ///< entries and snapshots handed to the writer
+        Uint64 mSyncedCount;
+        Uint64 mSyncRequestedCount;         ///< recorded count Sync waits for
+        Uint64 mSyncCount;
+        bool mIsClosing;
+
+        // writer thread side
+        std::thread mWriterThread;
+        std::string mFilePath;
+        int mFile;
+
+}; /* -----  end of class AutosaveJournal  ----- */
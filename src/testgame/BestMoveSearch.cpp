@@ -0,0 +1,157 @@
+#include "BestMoveSearch.h"
+#include <JobSystem.h>
+#include <assert.h>
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+BestMoveSearch::BestMoveSearch (JobSystem& jobSystem, int tableSizeLog2) :
+    mJobSystem (jobSystem),
+    mTable (static_cast<size_t>(1) << tableSizeLog2),
+    mTableMask ((static_cast<Uint64>(1) << tableSizeLog2) - 1)
+{
+    ClearTable();
+}
+
+
+void BestMoveSearch::ClearTable ()
+{
+    for (size_t i = 0; i < mTable.size(); i++) {
+        mTable [i].mKeyXorData.store (0, std::memory_order_relaxed);
+        mTable [i].mData.store (0, std::memory_order_relaxed);
+    }
+}
+
+
+bool BestMoveSearch::Probe (Uint64 hash, int depth, int& points) const
+{
+    const TableEntry& entry = mTable [hash & mTableMask];
+    const Uint64 data = entry.mData.load (std::memory_order_relaxed);
+    const Uint64 keyXorData = entry.mKeyXorData.load (std::memory_order_relaxed);
+    // depth 0 is never stored, so an empty entry never matches
+    if ((keyXorData ^ data) != hash || static_cast<int>(data >> 32) != depth) {
+        return false;
+    }
+    points = static_cast<int>(static_cast<Uint32>(data));
+    return true;
+}
+
+
+void BestMoveSearch::Store (Uint64 hash, int depth, int points)
+{
+    TableEntry& entry = mTable [hash & mTableMask];
+    const Uint64 data = (static_cast<Uint64>(depth) << 32) | static_cast<Uint32>(points);
+    entry.mKeyXorData.store (hash ^ data, std::memory_order_relaxed);
+    entry.mData.store (data, std::memory_order_relaxed);
+}
+
+
+int BestMoveSearch::Expand (const GameBoard& board, int level, SearchStack& stack)
+{
+    int moves [GameBoard::MAX_MOVES];
+    const int moveCount = board.GetMatchingMoves (moves);
+    std::vector<GameBoard>& children = stack.mChildren [level];
+    int* childPoints = stack.mChildPoints [level];
+    int* childMoves = stack.mChildMoves [level];
+    children.clear();
+    for (int i = 0; i < moveCount; i++) {
+        children.push_back (board);
+        childPoints [i] = children [i].ApplyMove (moves [i]);
+        childMoves [i] = moves [i];
+    }
+    stack.mNodes += static_cast<Uint64>(moveCount);
+    return moveCount;
+}
+
+
+int BestMoveSearch::SearchNode (const GameBoard& board, int depth, int level, SearchStack& stack)
+{
+    if (depth <= 0) {
+        return 0;
+    }
+    // the last move is cheaper to redo than to look up
+    const Uint64 hash = depth > 1 ? board.GetHash() : 0;
+    if (depth > 1) {
+        int points = 0;
+        stack.mTableProbes++;
+        if (Probe (hash, depth, points)) {
+            stack.mTableHits++;
+            return points;
+        }
+    }
+    const int childCount = Expand (board, level, stack);
+    int bestPoints = 0;
+    for (int i = 0; i < childCount; i++) {
+        const int points = stack.mChildPoints [level][i] + SearchNode (stack.mChildren [level][i], depth - 1, level + 1, stack);
+        if (points > bestPoints) {
+            bestPoints = points;
+        }
+    }
+    if (depth > 1) {
+        Store (hash, depth, bestPoints);
+    }
+    return bestPoints;
+}
+
+
+BestMoveSearch::SearchResult BestMoveSearch::Search (const GameBoard& board, int depth)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (depth < 1 || depth > MAX_DEPTH) {
+        printf ("ERROR: BestMoveSearch::Search called with depth %d, supported are 1 to %d.\n", depth, MAX_DEPTH);
+        assert (0);
+        depth = depth < 1 ? 1 : MAX_DEPTH;
+    }
+    std::unique_ptr<SearchStack> rootStack (new SearchStack());
+    rootStack->mNodes = 0;
+    rootStack->mTableProbes = 0;
+    rootStack->mTableHits = 0;
+    const int childCount = Expand (board, 0, *rootStack);
+
+    // every root move is a job with its own stack, the table is what the jobs share
+    std::vector<int> childResults (childCount, 0);
+    std::atomic<Uint64> nodes (rootStack->mNodes);
+    std::atomic<Uint64> tableProbes (0);
+    std::atomic<Uint64> tableHits (0);
+    const SearchStack& root = *rootStack;
+    mJobSystem.ParallelFor (childCount, 1, [this, &root, &childResults, &nodes, &tableProbes, &tableHits, depth] (int begin, int end) {
+        std::unique_ptr<SearchStack> stack (new SearchStack());
+        stack->mNodes = 0;
+        stack->mTableProbes = 0;
+        stack->mTableHits = 0;
+        for (int i = begin; i < end; i++) {
+            childResults [i] = root.mChildPoints [0][i] + SearchNode (root.mChildren [0][i], depth - 1, 1, *stack);
+        }
+        nodes.fetch_add (stack->mNodes, std::memory_order_relaxed);
+        tableProbes.fetch_add (stack->mTableProbes, std::memory_order_relaxed);
+        tableHits.fetch_add (stack->mTableHits, std::memory_order_relaxed);
+    });
+
+    SearchResult result;
+    result.mMove = -1;
+    result.mPoints = 0;
+    int bestMovePoints = 0;
+    for (int i = 0; i < childCount; i++) {
+        // ties go to the bigger immediate score, then to the first move
+        if (result.mMove < 0 || childResults [i] > result.mPoints ||
+                (childResults [i] == result.mPoints && root.mChildPoints [0][i] > bestMovePoints)) {
+            result.mMove = root.mChildMoves [0][i];
+            result.mPoints = childResults [i];
+            bestMovePoints = root.mChildPoints [0][i];
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.mNodes = nodes.load();
+    result.mTableProbes = tableProbes.load();
+    result.mTableHits = tableHits.load();
+    result.mSeconds = elapsed.count();
+    return result;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <GameBoard.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+class JobSystem;
+
+
+/*!
+ * Finds the sequence of swaps that scores the most points within a given number of moves.
+ * The refills are a fixed function of the board (GameBoard's random state or its column refills), so there are
+ * no chance nodes: the search is an exhaustive depth-limited maximum, and the same board and depth always give
+ * the same move, however many workers take part.
+ * Values are shared between workers through a lock-free transposition table keyed by GameBoard::GetHash.
+ * Nothing is cut off, so the children of a board are searched in move order; among root moves of equal value the one
+ * whose own cascade scores more is chosen.
+ */
+class BestMoveSearch
+{
+    public:
+        /// the deepest supported search
+        static const int MAX_DEPTH = 16;
+
+        /*!
+         * The outcome of a search.
+         */
+        struct SearchResult {
+            int mMove;              ///< first move of the best sequence, -1 if no swap makes a match
+            int mPoints;            ///< points of the best sequence
+            Uint64 mNodes;          ///< boards a move was applied to
+            Uint64 mTableProbes;    ///< transposition table look-ups
+            Uint64 mTableHits;      ///< look-ups that found the value of the board at the same depth
+            double mSeconds;        ///< wall time of the search
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates a searcher and its transposition table.
+         * @param jobSystem the job system running the search, it must outlive the searcher.
+         * @param tableSizeLog2 the table has 2 to the power of tableSizeLog2 entries of 16 bytes.
+         */
+        BestMoveSearch (JobSystem& jobSystem, int tableSizeLog2 = 20);
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Searches the board to the given depth on all workers. The table keeps its entries between searches.
+         * @param board the board to search, use GameBoard::SetColumnRefills to get transpositions between move orders.
+         * @param depth the number of moves to look ahead, from 1 to MAX_DEPTH.
+         * @return the best move and the search statistics.
+         */
+        SearchResult Search (const GameBoard& board, int depth);
+
+
+        /*!
+         * Forgets all transposition table entries.
+         */
+        void ClearTable ();
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        BestMoveSearch (const BestMoveSearch&);
+        BestMoveSearch& operator= (const BestMoveSearch&);
+
+        /*!
+         * A table entry. The key is stored xor-ed with the data, so an entry torn by two workers writing
+         * at once fails the key check instead of returning a wrong value.
+         */
+        struct TableEntry {
+            std::atomic<Uint64> mKeyXorData;
+            std::atomic<Uint64> mData;      ///< points in the low 32 bits, depth above
+        };
+
+        /*!
+         * Scratch space and counters of one search job, allocated once per job so the recursion does not allocate.
+         */
+        struct SearchStack {
+            std::vector<GameBoard> mChildren [MAX_DEPTH];       ///< the children of the board at each depth
+            int mChildPoints [MAX_DEPTH][GameBoard::MAX_MOVES]; ///< the points of each child's move
+            int mChildMoves [MAX_DEPTH][GameBoard::MAX_MOVES];
+            Uint64 mNodes;
+            Uint64 mTableProbes;
+            Uint64 mTableHits;
+        };
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Looks up the points of a board at a depth.
+         * @return true if found.
+         */
+        bool Probe (Uint64 hash, int depth, int& points) const;
+
+        /* ====================  MUTATORS      ======================================= */
+
+        void Store (Uint64 hash, int depth, int points);
+
+
+        /*!
+         * Fills level of the stack with the children of board and the points of their move.
+         * @return the number of children.
+         */
+        static int Expand (const GameBoard& board, int level, SearchStack& stack);
+
+
+        /*!
+         * Answers the most points depth moves from board can score.
+         * @param level the stack level free for the children of board.
+         */
+        int SearchNode (const GameBoard& board, int depth, int level, SearchStack& stack);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        JobSystem& mJobSystem;
+        std::vector<TableEntry> mTable;
+        Uint64 mTableMask;
+
+}; /* -----  end of class BestMoveSearch  ----- */
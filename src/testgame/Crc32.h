@@ -0,0 +1,49 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * CRC-32 (reflected polynomial 0xEDB88320, as in zip and PNG) guarding the records of the files the game appends to.
+ * Table driven, about a byte per cycle, which is plenty for records of a few dozen bytes.
+ */
+namespace Crc32
+{
+    struct Table {
+        Table ()
+        {
+            for (Uint32 index = 0; index < 256; index++) {
+                Uint32 crc = index;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320U : crc >> 1;
+                }
+                mValues [index] = crc;
+            }
+        }
+
+        Uint32 mValues [256];
+    };
+
+
+    /*!
+     * Continues a checksum over more bytes.
+     * @param checksum the checksum of the bytes before, 0 to start.
+     */
+    inline Uint32 Update (Uint32 checksum, const void* data, size_t size)
+    {
+        // built once, thread safe since C++11
+        static const Table sTable;
+        const Uint8* bytes = static_cast<const Uint8*>(data);
+        Uint32 crc = ~checksum;
+        for (size_t index = 0; index < size; index++) {
+            crc = sTable.mValues [(crc ^ bytes [index]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+}
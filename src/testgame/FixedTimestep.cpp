@@ -0,0 +1,57 @@
+#include "FixedTimestep.h"
+#include <stdio.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+FixedTimestep::FixedTimestep (Uint32 stepMilis, int maxStepsPerFrame) :
+    mStepMilis (stepMilis > 0 ? stepMilis : 1),
+    mMaxStepsPerFrame (maxStepsPerFrame > 0 ? maxStepsPerFrame : 1),
+    mCounter (0),
+    mStepSize (mStepMilis),
+    mAccumulator (0),
+    mStepCount (0),
+    mDroppedStepCount (0)
+{
+    if (stepMilis == 0 || maxStepsPerFrame < 1) {
+        printf ("ERROR: FixedTimestep::FixedTimestep called with a step of %u ms and %d steps per frame.\n", stepMilis, maxStepsPerFrame);
+    }
+}
+
+
+float FixedTimestep::GetInterpolation () const
+{
+    return static_cast<float>(static_cast<double>(mAccumulator) / static_cast<double>(mStepSize));
+}
+
+
+void FixedTimestep::Start (Uint64 counter, Uint64 counterFrequency)
+{
+    mCounter = counter;
+    mStepSize = (counterFrequency > 0 ? counterFrequency : 1) * mStepMilis;
+    mAccumulator = 0;
+}
+
+
+int FixedTimestep::Advance (Uint64 counter)
+{
+    mAccumulator += (counter - mCounter) * 1000;
+    mCounter = counter;
+    int stepCount = 0;
+    while (mAccumulator >= mStepSize && stepCount < mMaxStepsPerFrame) {
+        mAccumulator -= mStepSize;
+        stepCount++;
+    }
+    // what the cap left over is dropped, keeping the fraction of a step to stay smooth
+    if (mAccumulator >= mStepSize) {
+        mDroppedStepCount += mAccumulator / mStepSize;
+        mAccumulator %= mStepSize;
+    }
+    mStepCount += stepCount;
+    return stepCount;
+}
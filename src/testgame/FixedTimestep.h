@@ -0,0 +1,103 @@
+#pragma once
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Turns the time between frames into simulation steps of a fixed length. Elapsed time from a high resolution counter
+ * (eg. SDL_GetPerformanceCounter) is added to an accumulator and every whole step in it is simulated, so the game
+ * advances the same way whatever the frame times are. What is left over, less than a step, is the interpolation
+ * factor to render between the last two simulated states.
+ *
+ * The accumulator counts in counter ticks times 1000, so steps of whole miliseconds are exact and no time is lost
+ * to rounding. After a long stall (a breakpoint, a dragged window) at most maxStepsPerFrame steps are simulated at
+ * once and the rest of the time is dropped, so the game slows down instead of falling further and further behind.
+ *
+ * The counter is passed in, so tests can drive the game with made up frame times, as fast as they like.
+ */
+class FixedTimestep
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * @param stepMilis the game time a step simulates.
+         * @param maxStepsPerFrame the most steps Advance hands out at once.
+         */
+        FixedTimestep (Uint32 stepMilis, int maxStepsPerFrame);
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /// the game time every step simulates
+        Uint32 GetStepMilis () const
+        {
+            return mStepMilis;
+        }
+
+        /*!
+         * Retrieves how far the time is between the last step and the next one, to render in between.
+         * @return 0 when a step was just simulated, approaching 1 just before the next one.
+         */
+        float GetInterpolation () const;
+
+        /*!
+         * Retrieves the counter value the last step handed out was due at; the next one is due GetStepCounterTicks later.
+         */
+        Uint64 GetStepCounter () const
+        {
+            return mCounter - mAccumulator / 1000;
+        }
+
+        /// how much the counter advances per step
+        Uint64 GetStepCounterTicks () const
+        {
+            return mStepSize / 1000 > 0 ? mStepSize / 1000 : 1;
+        }
+
+        /// steps handed out so far
+        Uint64 GetStepCount () const
+        {
+            return mStepCount;
+        }
+
+        /// steps that were due but dropped by the catch-up cap
+        Uint64 GetDroppedStepCount () const
+        {
+            return mDroppedStepCount;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Starts counting time.
+         * @param counter the current value of the counter.
+         * @param counterFrequency how much the counter advances per second.
+         */
+        void Start (Uint64 counter, Uint64 counterFrequency);
+
+
+        /*!
+         * Adds the time since the last call and hands out the steps that are due.
+         * @param counter the current value of the counter.
+         * @return the number of steps of GetStepMilis to simulate now, at most maxStepsPerFrame.
+         */
+        int Advance (Uint64 counter);
+
+    private:
+        /* ====================  DATA MEMBERS  ======================================= */
+        Uint32 mStepMilis;
+        int mMaxStepsPerFrame;
+        Uint64 mCounter;                ///< at the last Advance
+        Uint64 mStepSize;               ///< counter ticks * 1000 per step
+        Uint64 mAccumulator;            ///< counter ticks * 1000 not simulated yet
+        Uint64 mStepCount;
+        Uint64 mDroppedStepCount;
+
+}; /* -----  end of class FixedTimestep  ----- */
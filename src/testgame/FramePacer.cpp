@@ -0,0 +1,147 @@
+#include "FramePacer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+FramePacer::FramePacer () :
+    mMode (Vsync),
+    mCapFramesPerSecond (DEFAULT_CAP_FRAMES_PER_SECOND),
+    mCapFrameTime (std::chrono::nanoseconds (1000000000 / DEFAULT_CAP_FRAMES_PER_SECOND)),
+    mIsFollowingFrame (false),
+    mFrameTimes (10000, 0.01)
+{
+}
+
+
+int FramePacer::GetSwapInterval () const
+{
+    switch (mMode) {
+        case Vsync:
+            return 1;
+        case AdaptiveVsync:
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+
+const char* FramePacer::GetModeName (Mode mode)
+{
+    switch (mode) {
+        case Vsync:
+            return "vsync";
+        case AdaptiveVsync:
+            return "adaptive";
+        case Capped:
+            return "cap";
+        default:
+            return "uncapped";
+    }
+}
+
+
+void FramePacer::PrintStats () const
+{
+    if (mFrameTimes.GetCount() == 0) {
+        printf ("FramePacer: %s, no frames timed.\n", GetModeName (mMode));
+        return;
+    }
+    printf ("FramePacer: %s, %llu frames timed, %.1f frames per second, frame time p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms.\n",
+            GetModeName (mMode), static_cast<unsigned long long>(mFrameTimes.GetCount()), 1000.0 / mFrameTimes.GetMean(),
+            mFrameTimes.GetPercentile (50), mFrameTimes.GetPercentile (90), mFrameTimes.GetPercentile (99), mFrameTimes.GetMaximum());
+}
+
+
+bool FramePacer::SetMode (const char* modeName, const char* capFramesPerSecond)
+{
+    if (strcmp (modeName, "vsync") == 0) {
+        SetMode (Vsync, mCapFramesPerSecond);
+    } else if (strcmp (modeName, "adaptive") == 0) {
+        SetMode (AdaptiveVsync, mCapFramesPerSecond);
+    } else if (strcmp (modeName, "uncapped") == 0) {
+        SetMode (Uncapped, mCapFramesPerSecond);
+    } else if (strcmp (modeName, "cap") == 0) {
+        const int framesPerSecond = capFramesPerSecond != NULL ? atoi (capFramesPerSecond) : DEFAULT_CAP_FRAMES_PER_SECOND;
+        if (framesPerSecond < 1) {
+            return false;
+        }
+        SetMode (Capped, framesPerSecond);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+void FramePacer::SetMode (Mode mode, int capFramesPerSecond)
+{
+    mMode = mode;
+    mCapFramesPerSecond = capFramesPerSecond > 0 ? capFramesPerSecond : DEFAULT_CAP_FRAMES_PER_SECOND;
+    mCapFrameTime = std::chrono::nanoseconds (1000000000 / mCapFramesPerSecond);
+    mIsFollowingFrame = false;
+}
+
+
+void FramePacer::ApplySwapInterval ()
+{
+    if (AdaptiveVsync == mMode && SDL_GL_SetSwapInterval (-1) < 0) {
+        printf ("FramePacer::ApplySwapInterval: no adaptive vsync, using vsync. SDL_ERROR: %s\n", SDL_GetError());
+        SetMode (Vsync, mCapFramesPerSecond);
+    }
+    if (Vsync == mMode && SDL_GL_SetSwapInterval (1) < 0) {
+        SDL_DisplayMode displayMode;
+        const bool isRefreshRateKnown = SDL_GetCurrentDisplayMode (0, &displayMode) == 0 && displayMode.refresh_rate > 0;
+        SetMode (Capped, isRefreshRateKnown ? displayMode.refresh_rate : DEFAULT_CAP_FRAMES_PER_SECOND);
+        printf ("FramePacer::ApplySwapInterval: no vsync, capping at %d frames per second. SDL_ERROR: %s\n", mCapFramesPerSecond, SDL_GetError());
+    }
+    if (GetSwapInterval() == 0 && SDL_GL_SetSwapInterval (0) < 0) {
+        printf ("FramePacer::ApplySwapInterval: vsync cannot be turned off, frames stay synced to the display. SDL_ERROR: %s\n", SDL_GetError());
+    }
+    if (Capped == mMode) {
+        printf ("FramePacer::ApplySwapInterval: frame pacing %s %d.\n", GetModeName (mMode), mCapFramesPerSecond);
+    } else {
+        printf ("FramePacer::ApplySwapInterval: frame pacing %s.\n", GetModeName (mMode));
+    }
+}
+
+
+void FramePacer::EndFrame ()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (Capped == mMode) {
+        // a frame after a pause or more than a frame late is not held back, the cap starts over from it
+        std::chrono::steady_clock::time_point due = mNextFrameDue;
+        if (!mIsFollowingFrame || now > due + mCapFrameTime) {
+            due = now;
+        }
+        const std::chrono::steady_clock::time_point sleepEnd = due - std::chrono::microseconds (SPIN_MICROSECONDS);
+        if (now < sleepEnd) {
+            std::this_thread::sleep_until (sleepEnd);
+        }
+        while (now < due) {
+            now = std::chrono::steady_clock::now();
+        }
+        mNextFrameDue = due + mCapFrameTime;
+    }
+    if (mIsFollowingFrame) {
+        mFrameTimes.Add (std::chrono::duration<double, std::milli> (now - mLastFrameEnd).count());
+    }
+    mLastFrameEnd = now;
+    mIsFollowingFrame = true;
+}
+
+
+void FramePacer::Pause ()
+{
+    mIsFollowingFrame = false;
+}
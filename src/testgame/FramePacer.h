@@ -0,0 +1,129 @@
+#pragma once
+#include <chrono>
+#include <Histogram.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Decides how the frames of the render thread are paced and records how long they take.
+ *
+ * Vsync and AdaptiveVsync leave the pacing to the buffer swap (see GetSwapInterval; adaptive vsync lets a late frame
+ * tear instead of waiting a whole refresh). Capped paces the frames itself in EndFrame: it sleeps until shortly before
+ * the frame is due and spins the rest of the way, as a sleep alone wakes up to a millisecond or more late. Uncapped
+ * does not wait at all, and the render thread draws every frame even while the game rests, to measure how fast the
+ * game renders; PrintStats reports it.
+ *
+ * The time of every frame that directly follows another is recorded, from the end of one to the end of the next.
+ */
+class FramePacer
+{
+    public:
+        enum Mode {
+            Vsync,
+            AdaptiveVsync,
+            Capped,
+            Uncapped
+        };
+
+        static const int DEFAULT_CAP_FRAMES_PER_SECOND = 60;
+        static const int SPIN_MICROSECONDS = 2000;      ///< how long before a capped frame is due the sleep ends
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        FramePacer ();                                  /* constructor, Vsync */
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        Mode GetMode () const
+        {
+            return mMode;
+        }
+
+        int GetCapFramesPerSecond () const
+        {
+            return mCapFramesPerSecond;
+        }
+
+        /// the interval for SDL_GL_SetSwapInterval: 1 for vsync, -1 for adaptive vsync, 0 otherwise
+        int GetSwapInterval () const;
+
+        /// false if every frame has to be drawn, whether the game changed or not
+        bool IsIdleAllowed () const
+        {
+            return mMode != Uncapped;
+        }
+
+        /// the frame times in miliseconds
+        const Histogram& GetFrameTimes () const
+        {
+            return mFrameTimes;
+        }
+
+        static const char* GetModeName (Mode mode);
+
+
+        /*!
+         * Prints the mode, frames per second and frame time percentiles.
+         */
+        void PrintStats () const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Sets the mode from command line arguments.
+         * @param modeName "vsync", "adaptive", "cap" or "uncapped".
+         * @param capFramesPerSecond the frame rate after "cap", NULL for DEFAULT_CAP_FRAMES_PER_SECOND.
+         * @return false if the arguments are not a mode, the mode is left as it was.
+         */
+        bool SetMode (const char* modeName, const char* capFramesPerSecond);
+
+
+        /*!
+         * @param capFramesPerSecond the frame rate of Capped, ignored by the other modes.
+         */
+        void SetMode (Mode mode, int capFramesPerSecond);
+
+
+        /*!
+         * Sets the swap interval of the current OpenGL context for the mode. Where the driver refuses it, falls back:
+         * adaptive vsync to vsync, vsync to a cap at the refresh rate of the display.
+         */
+        void ApplySwapInterval ();
+
+
+        /*!
+         * Ends a frame after the buffer swap, waits until the next one is due if capped and records the frame time.
+         */
+        void EndFrame ();
+
+
+        /*!
+         * Tells that the render thread stops drawing for a while, eg. while the game rests. The next frame is drawn as
+         * soon as it is needed and its time is not recorded.
+         */
+        void Pause ();
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        FramePacer (const FramePacer&);
+        FramePacer& operator= (const FramePacer&);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        Mode mMode;
+        int mCapFramesPerSecond;
+        std::chrono::steady_clock::duration mCapFrameTime;
+        bool mIsFollowingFrame;                                 ///< the frame ending next directly follows the last one
+        std::chrono::steady_clock::time_point mLastFrameEnd;
+        std::chrono::steady_clock::time_point mNextFrameDue;    ///< capped only
+        Histogram mFrameTimes;
+
+}; /* -----  end of class FramePacer  ----- */
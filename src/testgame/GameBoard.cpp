@@ -0,0 +1,290 @@
+#include "GameBoard.h"
+#include <GameRandom.h>
+#include <GameState.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+GameBoard::GameBoard (int rows, int columns, int minMatchSize, int colors) :
+    mRows (rows),
+    mColumns (columns),
+    mMinMatchSize (minMatchSize),
+    mColors (colors),
+    mScore (0),
+    mMoveCount (0),
+    mLastCascades (0),
+    mRandomState (GameRandom::SeedToState (0)),
+    mIsColumnRefill (false),
+    mColumnRefillSeed (0)
+{
+    if (rows < 1 || rows > MAX_SIDE || columns < 1 || columns > MAX_SIDE) {
+        printf ("ERROR: GameBoard::GameBoard called with unsupported board size %dx%d.\n", rows, columns);
+        assert (0);
+    }
+    if (minMatchSize < 2 || colors < 2 || colors > 254) {
+        printf ("ERROR: GameBoard::GameBoard called with minMatchSize %d and colors %d.\n", minMatchSize, colors);
+        assert (0);
+    }
+    memset (mColumnRefillCounts, 0, sizeof (mColumnRefillCounts));
+    memset (mTiles, 0, sizeof (mTiles));
+}
+
+
+bool GameBoard::IsMatchedAt (const Uint8* tiles, int row, int column) const
+{
+    const Uint8 color = tiles [row * mColumns + column];
+    int runLength = 1;
+    for (int currentColumn = column - 1; currentColumn >= 0 && tiles [row * mColumns + currentColumn] == color; currentColumn--) {
+        runLength++;
+    }
+    for (int currentColumn = column + 1; currentColumn < mColumns && tiles [row * mColumns + currentColumn] == color; currentColumn++) {
+        runLength++;
+    }
+    if (runLength >= mMinMatchSize) {
+        return true;
+    }
+    runLength = 1;
+    for (int currentRow = row - 1; currentRow >= 0 && tiles [currentRow * mColumns + column] == color; currentRow--) {
+        runLength++;
+    }
+    for (int currentRow = row + 1; currentRow < mRows && tiles [currentRow * mColumns + column] == color; currentRow++) {
+        runLength++;
+    }
+    return runLength >= mMinMatchSize;
+}
+
+
+bool GameBoard::IsMatchingMove (int move) const
+{
+    if (move < 0) {
+        return false;
+    }
+    int tileARow, tileAColumn, tileBRow, tileBColumn;
+    DecodeMove (move, tileARow, tileAColumn, tileBRow, tileBColumn);
+    if (tileBRow >= mRows || tileBColumn >= mColumns || move >= MAX_MOVES) {
+        return false;
+    }
+    const int cellA = tileARow * mColumns + tileAColumn;
+    const int cellB = tileBRow * mColumns + tileBColumn;
+    if (mTiles [cellA] == mTiles [cellB]) {
+        return false;
+    }
+    Uint8 tiles [MAX_CELLS];
+    memcpy (tiles, mTiles, static_cast<size_t>(mRows * mColumns));
+    std::swap (tiles [cellA], tiles [cellB]);
+    return IsMatchedAt (tiles, tileARow, tileAColumn) || IsMatchedAt (tiles, tileBRow, tileBColumn);
+}
+
+
+int GameBoard::GetMatchingMoves (int* moves) const
+{
+    int moveCount = 0;
+    for (int row = 0; row < mRows; row++) {
+        for (int column = 0; column < mColumns; column++) {
+            for (int isVertical = 0; isVertical < 2; isVertical++) {
+                const int move = EncodeMove (row, column, isVertical != 0);
+                if (IsMatchingMove (move)) {
+                    moves [moveCount++] = move;
+                }
+            }
+        }
+    }
+    return moveCount;
+}
+
+
+bool GameBoard::FindMatches (Uint8* matched) const
+{
+    const int cells = mRows * mColumns;
+    memset (matched, 0, static_cast<size_t>(cells));
+    bool isAnyMatched = false;
+    // runs of equal non-destroyed colors, first along rows, then along columns
+    for (int row = 0; row < mRows; row++) {
+        int runStart = 0;
+        for (int column = 1; column <= mColumns; column++) {
+            if (column < mColumns && mTiles [row * mColumns + column] == mTiles [row * mColumns + runStart]) {
+                continue;
+            }
+            if (column - runStart >= mMinMatchSize && mTiles [row * mColumns + runStart] != 0) {
+                memset (&matched [row * mColumns + runStart], 1, static_cast<size_t>(column - runStart));
+                isAnyMatched = true;
+            }
+            runStart = column;
+        }
+    }
+    for (int column = 0; column < mColumns; column++) {
+        int runStart = 0;
+        for (int row = 1; row <= mRows; row++) {
+            if (row < mRows && mTiles [row * mColumns + column] == mTiles [runStart * mColumns + column]) {
+                continue;
+            }
+            if (row - runStart >= mMinMatchSize && mTiles [runStart * mColumns + column] != 0) {
+                for (int currentRow = runStart; currentRow < row; currentRow++) {
+                    matched [currentRow * mColumns + column] = 1;
+                }
+                isAnyMatched = true;
+            }
+            runStart = row;
+        }
+    }
+    return isAnyMatched;
+}
+
+
+void GameBoard::CollapseAndRefill ()
+{
+    Uint32 state = mRandomState;
+    for (int column = 0; column < mColumns; column++) {
+        // row 0 is the top of the board, tiles keep their order while falling to the bottom
+        int targetRow = mRows - 1;
+        for (int row = mRows - 1; row >= 0; row--) {
+            const Uint8 tile = mTiles [row * mColumns + column];
+            if (tile != 0) {
+                mTiles [targetRow * mColumns + column] = tile;
+                targetRow--;
+            }
+        }
+        // the refill draws bottom to top, the same order as GameStateBatch
+        for (int row = targetRow; row >= 0; row--) {
+            if (mIsColumnRefill) {
+                const Uint32 columnState = GameRandom::SeedToState (mColumnRefillSeed + 0x9e3779b9U * static_cast<Uint32>(column) +
+                        0x85ebca6bU * static_cast<Uint32>(mColumnRefillCounts [column]++));
+                mTiles [row * mColumns + column] = static_cast<Uint8>(1 + GameRandom::ToRange (columnState, mColors));
+            } else {
+                state = GameRandom::Step (state);
+                mTiles [row * mColumns + column] = static_cast<Uint8>(1 + GameRandom::ToRange (state, mColors));
+            }
+        }
+    }
+    mRandomState = state;
+}
+
+
+void GameBoard::Reset (Uint32 seed)
+{
+    const int cells = mRows * mColumns;
+    mRandomState = GameRandom::SeedToState (seed);
+    mIsColumnRefill = false;
+    mScore = 0;
+    mMoveCount = 0;
+    mLastCascades = 0;
+    Uint8 matched [MAX_CELLS];
+    memset (matched, 1, sizeof (matched));
+    bool isAnyMatched = true;
+    while (isAnyMatched) {
+        // every tile is rolled first, then only matched tiles are rerolled, like GameState::ResetGridToRandomNoNMatches
+        for (int cell = 0; cell < cells; cell++) {
+            if (matched [cell]) {
+                mRandomState = GameRandom::Step (mRandomState);
+                mTiles [cell] = static_cast<Uint8>(1 + GameRandom::ToRange (mRandomState, mColors));
+            }
+        }
+        isAnyMatched = FindMatches (matched);
+    }
+}
+
+
+void GameBoard::CopyFrom (const GameState& gameState, Uint32 seed)
+{
+    if (gameState.GetRows() != mRows || gameState.GetColumns() != mColumns) {
+        printf ("ERROR: GameBoard::CopyFrom called with a %dx%d game state for a %dx%d board.\n",
+                gameState.GetRows(), gameState.GetColumns(), mRows, mColumns);
+        return;
+    }
+    for (int row = 0; row < mRows; row++) {
+        for (int column = 0; column < mColumns; column++) {
+            const GameState::Color color = gameState.GetColorAt (row, column);
+            mTiles [row * mColumns + column] = (color == GameState::DestroyedColor) ? 0 : static_cast<Uint8>(color);
+        }
+    }
+    mRandomState = GameRandom::SeedToState (seed);
+    mIsColumnRefill = false;
+    mScore = 0;
+    mMoveCount = 0;
+    mLastCascades = 0;
+}
+
+
+void GameBoard::SetRandomState (Uint32 randomState)
+{
+    mRandomState = randomState == 0 ? GameRandom::SeedToState (0) : randomState;
+    mIsColumnRefill = false;
+}
+
+
+void GameBoard::SetColumnRefills (Uint32 seed)
+{
+    mIsColumnRefill = true;
+    mColumnRefillSeed = seed;
+    memset (mColumnRefillCounts, 0, sizeof (mColumnRefillCounts));
+}
+
+
+Uint64 GameBoard::GetHash () const
+{
+    // FNV-1a over the tiles and the refill state, then a final mix so nearby boards spread over the whole range
+    Uint64 hash = 0xcbf29ce484222325ULL;
+    const int cells = mRows * mColumns;
+    for (int cell = 0; cell < cells; cell++) {
+        hash = (hash ^ mTiles [cell]) * 0x100000001b3ULL;
+    }
+    if (mIsColumnRefill) {
+        hash = (hash ^ mColumnRefillSeed) * 0x100000001b3ULL;
+        for (int column = 0; column < mColumns; column++) {
+            hash = (hash ^ static_cast<Uint64>(mColumnRefillCounts [column])) * 0x100000001b3ULL;
+        }
+    } else {
+        hash = (hash ^ mRandomState) * 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+
+int GameBoard::ApplyMove (int move)
+{
+    mLastCascades = 0;
+    if (move < 0 || move >= MAX_MOVES) {
+        return 0;
+    }
+    int tileARow, tileAColumn, tileBRow, tileBColumn;
+    DecodeMove (move, tileARow, tileAColumn, tileBRow, tileBColumn);
+    if (tileBRow >= mRows || tileBColumn >= mColumns) {
+        return 0;
+    }
+    mMoveCount++;
+    const int cellA = tileARow * mColumns + tileAColumn;
+    const int cellB = tileBRow * mColumns + tileBColumn;
+    // the cheap local check spares the full scan for the common swap that makes no match
+    if (!IsMatchingMove (move)) {
+        return 0;
+    }
+    std::swap (mTiles [cellA], mTiles [cellB]);
+
+    const int cells = mRows * mColumns;
+    int points = 0;
+    Uint8 matched [MAX_CELLS];
+    while (FindMatches (matched)) {
+        for (int cell = 0; cell < cells; cell++) {
+            if (matched [cell]) {
+                mTiles [cell] = 0;
+                points++;
+            }
+        }
+        mLastCascades++;
+        CollapseAndRefill();
+    }
+    mScore += points;
+    return points;
+}
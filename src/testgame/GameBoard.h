@@ -0,0 +1,247 @@
+#pragma once
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+class GameState;
+
+
+/*!
+ * A single board with the rules of GameStateLogic and no animations, small enough to be copied for every playout.
+ * It resolves a move exactly like one board of GameStateBatch does: the same move encoding, the same GameRandom
+ * draws for the initial grid and the refills, so a GameBoard and a GameStateBatch board reset with the same seed
+ * stay identical move after move. Tile values follow GameState::Color (1 to colors).
+ */
+class GameBoard
+{
+    public:
+        /// the maximum number of rows or columns of a board
+        static const int MAX_SIDE = 16;
+        /// the maximum number of tiles on a board
+        static const int MAX_CELLS = MAX_SIDE * MAX_SIDE;
+        /// an upper bound of the number of different moves on any board, for sizing move lists
+        static const int MAX_MOVES = MAX_CELLS * 2;
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates a board. Call Reset or CopyFrom before the first move.
+         * @param rows rows of the board, at most MAX_SIDE.
+         * @param columns columns of the board, at most MAX_SIDE.
+         * @param minMatchSize how many tiles of same color in a row are a match, at least 2.
+         * @param colors number of tile colors, from 2 to 254.
+         */
+        GameBoard (int rows, int columns, int minMatchSize, int colors);
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Encodes a swap of a tile with its right or lower neighbour, same as GameStateBatch::EncodeMove.
+         * @param row the row of the tile.
+         * @param column the column of the tile.
+         * @param isVertical swap with the tile below if true, with the tile to the right otherwise.
+         * @return the move value.
+         */
+        static int EncodeMove (int row, int column, bool isVertical)
+        {
+            return (row * MAX_SIDE + column) * 2 + (isVertical ? 1 : 0);
+        }
+
+
+        /*!
+         * Retrieves the two tiles swapped by a move.
+         * @param move a move value made with EncodeMove.
+         */
+        static void DecodeMove (int move, int& tileARow, int& tileAColumn, int& tileBRow, int& tileBColumn)
+        {
+            tileARow = (move / 2) / MAX_SIDE;
+            tileAColumn = (move / 2) % MAX_SIDE;
+            tileBRow = (move & 1) ? tileARow + 1 : tileARow;
+            tileBColumn = (move & 1) ? tileAColumn : tileAColumn + 1;
+        }
+
+        int GetRows () const
+        {
+            return mRows;
+        }
+
+        int GetColumns () const
+        {
+            return mColumns;
+        }
+
+        int GetMinMatchSize () const
+        {
+            return mMinMatchSize;
+        }
+
+        int GetColors () const
+        {
+            return mColors;
+        }
+
+        Uint8 GetColorAt (int row, int column) const
+        {
+            return mTiles [row * mColumns + column];
+        }
+
+
+        /*!
+         * Retrieves the rows * columns tiles in row major order.
+         */
+        const Uint8* GetTiles () const
+        {
+            return mTiles;
+        }
+
+
+        /*!
+         * Retrieves the total score. Like GameState, every destroyed tile is worth a point.
+         */
+        int GetScore () const
+        {
+            return mScore;
+        }
+
+
+        /*!
+         * Retrieves how many valid moves were applied since the board was reset.
+         */
+        int GetMoveCount () const
+        {
+            return mMoveCount;
+        }
+
+
+        /*!
+         * Retrieves how many destroy and collapse rounds the last move caused.
+         */
+        int GetLastCascades () const
+        {
+            return mLastCascades;
+        }
+
+
+        /*!
+         * Retrieves the state of the generator that refills the board.
+         */
+        Uint32 GetRandomState () const
+        {
+            return mRandomState;
+        }
+
+
+        /*!
+         * Answers whether the refills come from one fixed sequence per column, see SetColumnRefills.
+         */
+        bool IsColumnRefill () const
+        {
+            return mIsColumnRefill;
+        }
+
+
+        /*!
+         * Hashes the tiles and everything that decides the future refills, so equal hashes mean equal futures.
+         * @return a 64 bit hash of the board.
+         */
+        Uint64 GetHash () const;
+
+
+        /*!
+         * Answers whether the move is on the board and its swap makes a match.
+         * @param move a move value made with EncodeMove.
+         */
+        bool IsMatchingMove (int move) const;
+
+
+        /*!
+         * Lists all moves whose swap makes a match, in increasing move value.
+         * @param moves output array of at least MAX_MOVES values.
+         * @return the number of moves written.
+         */
+        int GetMatchingMoves (int* moves) const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Resets the board to a random grid without matches, like GameStateBatch::ResetBoard.
+         * @param seed the seed of the random generator.
+         */
+        void Reset (Uint32 seed);
+
+
+        /*!
+         * Takes over the grid of a GameState, clears score and moves.
+         * GameState refills with its own generator, so only the current grid is shared, not the future refills.
+         * @param gameState a game state of at most MAX_SIDE rows and columns that is not destroying or collapsing tiles.
+         * @param seed the seed of the random generator for the refills.
+         */
+        void CopyFrom (const GameState& gameState, Uint32 seed);
+
+
+        /*!
+         * Replaces the generator state, eg. to sample different refills from the same board. Switches off column refills.
+         * @param randomState a non-zero state from GetRandomState or GameRandom.
+         */
+        void SetRandomState (Uint32 randomState);
+
+
+        /*!
+         * Switches the refills to one fixed sequence per column: the n-th tile refilled into a column is
+         * the same whichever moves brought it there. Moves in different parts of the board then commute,
+         * which searches exploit with a transposition table.
+         * @param seed the seed of the column sequences.
+         */
+        void SetColumnRefills (Uint32 seed);
+
+
+        /*!
+         * Swaps two tiles and resolves all resulting matches, collapses and refills.
+         * A swap without a match is swapped back but still counts as a move. Moves off the board are ignored.
+         * @param move a move value made with EncodeMove.
+         * @return the points scored by the move.
+         */
+        int ApplyMove (int move);
+
+    private:
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Marks all tiles that are part of a row or column of at least mMinMatchSize equal colors.
+         * @param matched output of rows * columns values, 1 for matched tiles.
+         * @return true if any tile is matched.
+         */
+        bool FindMatches (Uint8* matched) const;
+
+
+        /*!
+         * Answers whether the tile at cell is part of a match in tiles.
+         */
+        bool IsMatchedAt (const Uint8* tiles, int row, int column) const;
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Lets tiles fall into destroyed (0) tiles and refills the top of the columns with random colors.
+         */
+        void CollapseAndRefill ();
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mRows, mColumns, mMinMatchSize, mColors;
+        int mScore;
+        int mMoveCount;
+        int mLastCascades;
+        Uint32 mRandomState;
+        bool mIsColumnRefill;
+        Uint32 mColumnRefillSeed;
+        int mColumnRefillCounts [MAX_SIDE];     ///< tiles refilled into each column since SetColumnRefills
+        Uint8 mTiles [MAX_CELLS];
+
+}; /* -----  end of class GameBoard  ----- */
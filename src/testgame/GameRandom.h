@@ -0,0 +1,117 @@
+#pragma once
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Small deterministic random number generator (xorshift32) used by the headless game rules.
+ * It has no hidden global state, so every board can own one and be reproduced from its seed.
+ * The static functions allow structure-of-arrays code to keep the states in plain arrays.
+ */
+class GameRandom
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+        explicit GameRandom (Uint32 seed = 1) : mState (SeedToState (seed))   /* constructor */
+        {
+        }
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Scrambles a user provided seed into a valid (non-zero) generator state.
+         * @param seed any value, consecutive seeds give unrelated states.
+         * @return the generator state to start from.
+         */
+        static Uint32 SeedToState (Uint32 seed)
+        {
+            seed ^= seed >> 16;
+            seed *= 0x7feb352dU;
+            seed ^= seed >> 15;
+            seed *= 0x846ca68bU;
+            seed ^= seed >> 16;
+            return seed == 0 ? 0x9e3779b9U : seed;
+        }
+
+
+        /*!
+         * Advances a generator state by one step.
+         * @param state a non-zero generator state.
+         * @return the next generator state, which is also the next random value.
+         */
+        static Uint32 Step (Uint32 state)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+
+        /*!
+         * Maps a random value onto [0, range) without division.
+         * Only 32 bit multiplication is used, so loops over many generators vectorize.
+         * @param value a random value from Step.
+         * @param range the number of possible results, at most 65536.
+         * @return an integer from [0, range).
+         */
+        static int ToRange (Uint32 value, int range)
+        {
+            return static_cast<int>(((value >> 16) * static_cast<Uint32>(range)) >> 16);
+        }
+
+
+        /*!
+         * Retrieves the generator state, eg. to store it in a snapshot.
+         * @return the current generator state.
+         */
+        Uint32 GetState () const
+        {
+            return mState;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Draws the next random value.
+         * @return a random 32 bit value.
+         */
+        Uint32 Next ()
+        {
+            mState = Step (mState);
+            return mState;
+        }
+
+
+        /*!
+         * Draws an integer from [0, range).
+         * @param range the number of possible results.
+         * @return an integer from [0, range).
+         */
+        int NextInt (int range)
+        {
+            return ToRange (Next(), range);
+        }
+
+
+        /*!
+         * Restores a state previously retrieved by GetState.
+         * @param state non-zero generator state.
+         */
+        void SetState (Uint32 state)
+        {
+            mState = state == 0 ? SeedToState (0) : state;
+        }
+
+    private:
+        /* ====================  DATA MEMBERS  ======================================= */
+        Uint32 mState;
+
+}; /* -----  end of class GameRandom  ----- */
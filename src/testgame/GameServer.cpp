@@ -0,0 +1,640 @@
+#include "GameServer.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+#ifndef EPOLLEXCLUSIVE
+    #define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
+
+// events taken from epoll at once
+static const int MAX_EVENTS = 256;
+// connections accepted per wake up, so that a burst of connections spreads over the loops
+static const int MAX_ACCEPTS = 16;
+static const int LISTEN_BACKLOG = 4096;
+// free GameState objects a loop keeps when games hibernate
+static const int MAX_FREE_GAME_STATES = 64;
+// sessions allocated at once
+static const int SESSIONS_PER_BLOCK = 1024;
+// Session::mHibernationSlot of a session whose game is over and whose ActiveSession is freed
+static const int GAME_OVER_SLOT = -2;
+
+
+/// what every connection keeps, hibernating or not; small, most sessions of a busy server hibernate
+struct GameServer::Session {
+    ActiveSession* mActive;                 ///< the game and the buffers, NULL while hibernating
+    int mSocket;                            ///< -1 while the entry of Loop::mSessionBlocks is free
+    Uint32 mConnection;                     ///< accept count of the loop, identifies the player with the loop index
+    int mHibernationSlot;                   ///< slot in Loop::mHibernationStore, -1 if not hibernating, or GAME_OVER_SLOT
+    union {
+        Uint32 mGameOverTime;               ///< when the gameplay time of the hibernating game runs out
+        Sint32 mFinalScore;                 ///< of the game that is over, in GAME_OVER_SLOT
+    };
+};
+
+
+/// the rest of an awake session
+struct GameServer::ActiveSession {
+    GameState* mGameState;                  ///< from Loop::mGameStatePool, NULL without a running game
+    GameStateLogic mGameStateLogic;
+    Uint32 mLastUpdateTime;
+    bool mIsAnimating;                      ///< in Loop::mAnimatingSessions, until the accepted swap is resolved
+    bool mIsGameOverSent;                   ///< the game is over and freed, only mFinalScore is left
+    Sint32 mFinalScore;
+    Uint32 mLastMessageTime;
+    Uint32 mSwapSequence;                   ///< of the swap being resolved
+    Uint32 mSeed;                           ///< of the current game
+    Uint8 mInput [sizeof (GameServerMessage)];
+    int mInputSize;                         ///< bytes of a message received so far
+    std::vector<Uint8> mOutput;             ///< bytes the socket did not take yet
+};
+
+
+/// an event loop thread with the sessions it owns
+struct GameServer::Loop {
+    int mEpoll;
+    int mIndex;
+    std::thread mThread;
+    GameRandom mRandom;                     ///< seeds of new games
+    Uint32 mAcceptCount;
+    std::vector<std::unique_ptr<Session[]>> mSessionBlocks;    ///< SESSIONS_PER_BLOCK each, never moved
+    std::vector<Session*> mFreeSessions;
+    int mSessionCount;
+    std::vector<Session*> mAnimatingSessions;
+    size_t mSweepPosition;                  ///< entry of mSessionBlocks
+    std::unique_ptr<HibernationStore> mHibernationStore;
+    std::unique_ptr<GameStatePool> mGameStatePool;
+    Leaderboard::SubmitBuffer* mLeaderboardBuffer;  ///< NULL without a leaderboard
+    LoopStats mStats;
+};
+
+
+GameServer::GameServer (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds) :
+    mRows (rows),
+    mColumns (columns),
+    mMinMatchSize (minMatchSize),
+    mMaxGameplayTimeSeconds (maxGameplayTimeSeconds),
+    mHibernationMilis (0),
+    mLeaderboard (NULL),
+    mListenSocket (-1),
+    mIsRunning (false),
+    mStartTime (std::chrono::steady_clock::now())
+{
+}
+
+
+GameServer::~GameServer ()
+{
+    Stop();
+}
+
+
+GameServer::LoopStats& GameServer::GetLoopStats (int loop)
+{
+    return mLoops [loop]->mStats;
+}
+
+
+void GameServer::SetHibernation (Uint32 idleMilis, const char* spillFilePrefix)
+{
+    mHibernationMilis = idleMilis;
+    mSpillFilePrefix = spillFilePrefix != NULL ? spillFilePrefix : "";
+}
+
+
+Uint32 GameServer::GetTime () const
+{
+    return static_cast<Uint32>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mStartTime).count());
+}
+
+
+bool GameServer::Start (const char* address, int loopCount)
+{
+    if (mIsRunning) {
+        printf ("GameServer::Start: already running.\n");
+        return false;
+    }
+    if (strncmp (address, "unix:", 5) == 0) {
+        sockaddr_un unixAddress;
+        memset (&unixAddress, 0, sizeof (unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        if (strlen (address + 5) >= sizeof (unixAddress.sun_path)) {
+            printf ("GameServer::Start: socket path '%s' is too long.\n", address + 5);
+            return false;
+        }
+        strcpy (unixAddress.sun_path, address + 5);
+        unlink (unixAddress.sun_path);
+        mListenSocket = socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (mListenSocket < 0 || bind (mListenSocket, reinterpret_cast<sockaddr*>(&unixAddress), sizeof (unixAddress)) != 0) {
+            printf ("GameServer::Start: cannot bind '%s': %s\n", address, strerror (errno));
+            Stop();
+            return false;
+        }
+        mUnixSocketPath = unixAddress.sun_path;
+    } else {
+        sockaddr_in tcpAddress;
+        memset (&tcpAddress, 0, sizeof (tcpAddress));
+        tcpAddress.sin_family = AF_INET;
+        tcpAddress.sin_addr.s_addr = htonl (INADDR_ANY);
+        tcpAddress.sin_port = htons (static_cast<uint16_t>(atoi (address)));
+        mListenSocket = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int isReusable = 1;
+        if (mListenSocket < 0 || setsockopt (mListenSocket, SOL_SOCKET, SO_REUSEADDR, &isReusable, sizeof (isReusable)) != 0 ||
+                bind (mListenSocket, reinterpret_cast<sockaddr*>(&tcpAddress), sizeof (tcpAddress)) != 0) {
+            printf ("GameServer::Start: cannot bind port '%s': %s\n", address, strerror (errno));
+            Stop();
+            return false;
+        }
+    }
+    if (listen (mListenSocket, LISTEN_BACKLOG) != 0) {
+        printf ("GameServer::Start: cannot listen on '%s': %s\n", address, strerror (errno));
+        Stop();
+        return false;
+    }
+
+    if (loopCount <= 0) {
+        loopCount = std::max (1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    mIsRunning = true;
+    for (int index = 0; index < loopCount; index++) {
+        std::unique_ptr<Loop> loop (new Loop());
+        loop->mEpoll = epoll_create1 (0);
+        loop->mIndex = index;
+        loop->mRandom = GameRandom (static_cast<Uint32>(time (NULL)) + static_cast<Uint32>(index) * 7919u);
+        loop->mSweepPosition = 0;
+        loop->mAcceptCount = 0;
+        loop->mSessionCount = 0;
+        loop->mStats.mSessions = 0;
+        loop->mStats.mAnimatingSessions = 0;
+        loop->mStats.mSwaps = 0;
+        loop->mStats.mMaxTickMicroseconds = 0;
+        loop->mStats.mHibernatingSessions = 0;
+        loop->mStats.mRestores = 0;
+        loop->mStats.mRestoreNanoseconds = 0;
+        loop->mHibernationStore.reset (new HibernationStore (mRows, mColumns));
+        loop->mGameStatePool.reset (new GameStatePool (mRows, mColumns, mMinMatchSize, mMaxGameplayTimeSeconds));
+        loop->mLeaderboardBuffer = mLeaderboard != NULL ? mLeaderboard->CreateSubmitBuffer() : NULL;
+        if (mHibernationMilis > 0) {
+            // hibernated games give their memory back, the pool only smooths the wake ups of a sweep
+            loop->mGameStatePool->SetMaxFreeCount (MAX_FREE_GAME_STATES);
+        }
+        if (mHibernationMilis > 0 && !mSpillFilePrefix.empty()) {
+            char filePath [1024];
+            snprintf (filePath, sizeof (filePath), "%s_%d.hib", mSpillFilePrefix.c_str(), index);
+            loop->mHibernationStore->OpenFile (filePath);
+        }
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.ptr = NULL;
+        if (loop->mEpoll < 0 || epoll_ctl (loop->mEpoll, EPOLL_CTL_ADD, mListenSocket, &event) != 0) {
+            printf ("GameServer::Start: cannot create event loop: %s\n", strerror (errno));
+            if (loop->mEpoll >= 0) {
+                close (loop->mEpoll);
+            }
+            Stop();
+            return false;
+        }
+        mLoops.push_back (std::move (loop));
+    }
+    for (size_t index = 0; index < mLoops.size(); index++) {
+        Loop* loop = mLoops [index].get();
+        loop->mThread = std::thread ([this, loop] () { RunLoop (*loop); });
+    }
+    printf ("GameServer::Start: listening on '%s' with %d event loops.\n", address, loopCount);
+    return true;
+}
+
+
+void GameServer::Stop ()
+{
+    mIsRunning = false;
+    for (size_t index = 0; index < mLoops.size(); index++) {
+        Loop& loop = *mLoops [index];
+        if (loop.mThread.joinable()) {
+            loop.mThread.join();
+        }
+        for (size_t block = 0; block < loop.mSessionBlocks.size(); block++) {
+            for (int entry = 0; entry < SESSIONS_PER_BLOCK; entry++) {
+                if (loop.mSessionBlocks [block][entry].mSocket >= 0) {
+                    Close (loop, loop.mSessionBlocks [block][entry]);
+                }
+            }
+        }
+        close (loop.mEpoll);
+    }
+    mLoops.clear();
+    if (mListenSocket >= 0) {
+        close (mListenSocket);
+        mListenSocket = -1;
+    }
+    if (!mUnixSocketPath.empty()) {
+        unlink (mUnixSocketPath.c_str());
+        mUnixSocketPath.clear();
+    }
+}
+
+
+void GameServer::RunLoop (Loop& loop)
+{
+    epoll_event events [MAX_EVENTS];
+    Uint32 nextTick = GetTime() + TICK_MILIS;
+    while (mIsRunning) {
+        Uint32 now = GetTime();
+        const int timeout = static_cast<Sint32>(nextTick - now) > 0 ? static_cast<int>(nextTick - now) : 0;
+        const int eventCount = epoll_wait (loop.mEpoll, events, MAX_EVENTS, timeout);
+        for (int index = 0; index < eventCount; index++) {
+            if (events [index].data.ptr == NULL) {
+                Accept (loop);
+                continue;
+            }
+            Session& session = *static_cast<Session*>(events [index].data.ptr);
+            if ((events [index].events & (EPOLLERR | EPOLLHUP)) != 0) {
+                Close (loop, session);
+                continue;
+            }
+            if ((events [index].events & EPOLLIN) != 0 && !Receive (loop, session)) {
+                continue;
+            }
+            if ((events [index].events & EPOLLOUT) != 0) {
+                Flush (loop, session);
+            }
+        }
+
+        now = GetTime();
+        if (static_cast<Sint32>(now - nextTick) < 0) {
+            continue;
+        }
+        std::chrono::steady_clock::time_point tickStart = std::chrono::steady_clock::now();
+        // animating sessions every tick
+        size_t kept = 0;
+        for (size_t index = 0; index < loop.mAnimatingSessions.size(); index++) {
+            Session& session = *loop.mAnimatingSessions [index];
+            CatchUp (loop, session, now);
+            if (session.mActive->mIsAnimating) {
+                loop.mAnimatingSessions [kept++] = &session;
+            }
+        }
+        loop.mAnimatingSessions.resize (kept);
+        // resting sessions once per sweep, a slice of the session entries every tick
+        const size_t entryCount = loop.mSessionBlocks.size() * SESSIONS_PER_BLOCK;
+        const size_t sweepCount = std::min (entryCount, entryCount * TICK_MILIS / SWEEP_MILIS + 1);
+        for (size_t count = 0; count < sweepCount; count++) {
+            loop.mSweepPosition = loop.mSweepPosition + 1 < entryCount ? loop.mSweepPosition + 1 : 0;
+            Session& session = loop.mSessionBlocks [loop.mSweepPosition / SESSIONS_PER_BLOCK][loop.mSweepPosition % SESSIONS_PER_BLOCK];
+            if (session.mSocket < 0 || session.mHibernationSlot == GAME_OVER_SLOT) {
+                continue;
+            }
+            if (session.mHibernationSlot >= 0) {
+                if (static_cast<Sint32>(now - session.mGameOverTime) >= 0) {
+                    Wake (loop, session);
+                    CatchUp (loop, session, now);
+                }
+            } else if (!session.mActive->mIsAnimating) {
+                CatchUp (loop, session, now);
+                if (session.mActive->mIsGameOverSent) {
+                    Retire (session);
+                } else if (mHibernationMilis > 0 && session.mActive->mGameState != NULL && now - session.mActive->mLastMessageTime >= mHibernationMilis) {
+                    Hibernate (loop, session);
+                }
+            }
+        }
+        nextTick += TICK_MILIS;
+        if (static_cast<Sint32>(nextTick - now) <= 0) {
+            // the loop fell behind, do not try to catch up with the missed ticks
+            nextTick = now + TICK_MILIS;
+        }
+
+        const Uint64 tickMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tickStart).count();
+        if (tickMicroseconds > loop.mStats.mMaxTickMicroseconds.load (std::memory_order_relaxed)) {
+            loop.mStats.mMaxTickMicroseconds.store (tickMicroseconds, std::memory_order_relaxed);
+        }
+        loop.mStats.mSessions.store (loop.mSessionCount, std::memory_order_relaxed);
+        loop.mStats.mAnimatingSessions.store (static_cast<int>(loop.mAnimatingSessions.size()), std::memory_order_relaxed);
+        loop.mStats.mHibernatingSessions.store (loop.mHibernationStore->GetCount(), std::memory_order_relaxed);
+    }
+}
+
+
+void GameServer::Accept (Loop& loop)
+{
+    for (int count = 0; count < MAX_ACCEPTS; count++) {
+        const int socket = accept4 (mListenSocket, NULL, NULL, SOCK_NONBLOCK);
+        if (socket < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                printf ("GameServer::Accept: %s\n", strerror (errno));
+            }
+            return;
+        }
+        int isNoDelay = 1;
+        setsockopt (socket, IPPROTO_TCP, TCP_NODELAY, &isNoDelay, sizeof (isNoDelay));
+
+        if (loop.mFreeSessions.empty()) {
+            Session* block = new Session [SESSIONS_PER_BLOCK];
+            loop.mSessionBlocks.push_back (std::unique_ptr<Session[]> (block));
+            // the lowest entries are handed out first
+            for (int entry = SESSIONS_PER_BLOCK - 1; entry >= 0; entry--) {
+                block [entry].mSocket = -1;
+                block [entry].mActive = NULL;
+                loop.mFreeSessions.push_back (&block [entry]);
+            }
+        }
+        Session* session = loop.mFreeSessions.back();
+        loop.mFreeSessions.pop_back();
+        session->mSocket = socket;
+        session->mConnection = loop.mAcceptCount++;
+        session->mHibernationSlot = -1;
+        session->mGameOverTime = 0;
+        Activate (*session);
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = session;
+        if (epoll_ctl (loop.mEpoll, EPOLL_CTL_ADD, socket, &event) != 0) {
+            printf ("GameServer::Accept: %s\n", strerror (errno));
+            close (socket);
+            delete session->mActive;
+            session->mActive = NULL;
+            session->mSocket = -1;
+            loop.mFreeSessions.push_back (session);
+            continue;
+        }
+        loop.mSessionCount++;
+    }
+}
+
+
+void GameServer::Activate (Session& session)
+{
+    ActiveSession* active = new ActiveSession();
+    active->mGameState = NULL;
+    active->mLastUpdateTime = GetTime();
+    active->mIsAnimating = false;
+    active->mIsGameOverSent = false;
+    active->mFinalScore = 0;
+    active->mLastMessageTime = active->mLastUpdateTime;
+    active->mSwapSequence = 0;
+    active->mSeed = 0;
+    active->mInputSize = 0;
+    session.mActive = active;
+}
+
+
+bool GameServer::Receive (Loop& loop, Session& session)
+{
+    if (session.mActive == NULL) {
+        Wake (loop, session);
+    }
+    ActiveSession& active = *session.mActive;
+    Uint8 buffer [4096];
+    for (;;) {
+        const ssize_t size = recv (session.mSocket, buffer, sizeof (buffer), 0);
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            Close (loop, session);
+            return false;
+        }
+        if (size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return true;
+        }
+        for (ssize_t position = 0; position < size; ) {
+            const int copySize = static_cast<int>(std::min (static_cast<ssize_t>(sizeof (active.mInput) - active.mInputSize), size - position));
+            memcpy (active.mInput + active.mInputSize, buffer + position, copySize);
+            active.mInputSize += copySize;
+            position += copySize;
+            if (active.mInputSize == static_cast<int>(sizeof (active.mInput))) {
+                GameServerMessage message;
+                memcpy (&message, active.mInput, sizeof (message));
+                active.mInputSize = 0;
+                HandleMessage (loop, session, message);
+            }
+        }
+    }
+}
+
+
+void GameServer::HandleMessage (Loop& loop, Session& session, const GameServerMessage& message)
+{
+    const Uint32 now = GetTime();
+    ActiveSession& active = *session.mActive;
+    active.mLastMessageTime = now;
+    if (message.mType == GameServerMessage::START_GAME) {
+        const Uint32 seed = loop.mRandom.Next();
+        active.mSeed = seed;
+        loop.mGameStatePool->Release (active.mGameState);
+        active.mGameState = loop.mGameStatePool->Acquire (seed);
+        active.mGameStateLogic = GameStateLogic();
+        active.mGameState->AttachGameStateGridChangeObserver (&active.mGameStateLogic);
+        active.mLastUpdateTime = now;
+        active.mIsGameOverSent = false;
+        if (active.mIsAnimating) {
+            active.mIsAnimating = false;
+            loop.mAnimatingSessions.erase (std::find (loop.mAnimatingSessions.begin(), loop.mAnimatingSessions.end(), &session));
+        }
+        Send (loop, session, GameServerMessage::GAME_STARTED, message.mSequence, static_cast<Sint32>(seed));
+        return;
+    }
+    if (message.mType != GameServerMessage::SWAP) {
+        printf ("GameServer::HandleMessage: unknown message type %d.\n", message.mType);
+        return;
+    }
+    if (active.mGameState != NULL && !active.mIsAnimating) {
+        CatchUp (loop, session, now);
+    }
+    if (active.mGameState == NULL || active.mIsAnimating) {
+        Send (loop, session, GameServerMessage::SWAP_REJECTED, message.mSequence, active.mGameState == NULL ? active.mFinalScore : active.mGameState->GetScore());
+        return;
+    }
+    GameState& gameState = *active.mGameState;
+    if (!active.mGameStateLogic.RequestSwap (message.mTileARow, message.mTileAColumn, message.mTileBRow, message.mTileBColumn, gameState)) {
+        Send (loop, session, GameServerMessage::SWAP_REJECTED, message.mSequence, gameState.GetScore());
+        return;
+    }
+    active.mIsAnimating = true;
+    active.mSwapSequence = message.mSequence;
+    loop.mAnimatingSessions.push_back (&session);
+    loop.mStats.mSwaps.fetch_add (1, std::memory_order_relaxed);
+    Send (loop, session, GameServerMessage::SWAP_ACCEPTED, message.mSequence, gameState.GetScore());
+}
+
+
+void GameServer::CatchUp (Loop& loop, Session& session, Uint32 now)
+{
+    ActiveSession& active = *session.mActive;
+    const Uint32 deltaTime = now - active.mLastUpdateTime;
+    active.mLastUpdateTime = now;
+    if (active.mGameState == NULL || active.mIsGameOverSent) {
+        return;
+    }
+    GameState& gameState = *active.mGameState;
+    if (deltaTime > 0) {
+        active.mGameStateLogic.Update (deltaTime, gameState);
+    }
+    if (gameState.GetAnimationState() == GameState::GameOver) {
+        active.mIsAnimating = false;
+        active.mIsGameOverSent = true;
+        active.mFinalScore = gameState.GetScore();
+        loop.mGameStatePool->Release (active.mGameState);
+        active.mGameState = NULL;
+        Send (loop, session, GameServerMessage::GAME_OVER, active.mSwapSequence, active.mFinalScore);
+        if (loop.mLeaderboardBuffer != NULL) {
+            loop.mLeaderboardBuffer->Submit (Leaderboard::MakeRules (mRows, mColumns, mMinMatchSize, mMaxGameplayTimeSeconds), active.mFinalScore,
+                    active.mSeed, (static_cast<Uint64>(loop.mIndex) << 48) | session.mConnection);
+        }
+    } else if (active.mIsAnimating && gameState.GetAnimationState() == GameState::Idle && !active.mGameStateLogic.IsGridCheckPending()) {
+        active.mIsAnimating = false;
+        Send (loop, session, GameServerMessage::SWAP_RESOLVED, active.mSwapSequence, gameState.GetScore());
+    }
+}
+
+
+void GameServer::Hibernate (Loop& loop, Session& session)
+{
+    ActiveSession& active = *session.mActive;
+    const GameState& gameState = *active.mGameState;
+    // a message half received or an answer not sent yet keeps the session awake
+    if (gameState.GetAnimationState() != GameState::Idle || active.mGameStateLogic.IsGridCheckPending() || active.mInputSize > 0 || !active.mOutput.empty()) {
+        return;
+    }
+    const int slot = loop.mHibernationStore->Store (gameState, active.mSeed);
+    if (slot < 0) {
+        return;
+    }
+    // resting, the game is over once the gameplay time left passed
+    session.mGameOverTime = active.mLastUpdateTime + static_cast<Uint32>(gameState.GetMaxGameplayTimeSeconds()) * 1000 - gameState.GetGameplayTime();
+    session.mHibernationSlot = slot;
+    loop.mGameStatePool->Release (active.mGameState);
+    delete session.mActive;
+    session.mActive = NULL;
+}
+
+
+void GameServer::Retire (Session& session)
+{
+    ActiveSession& active = *session.mActive;
+    // a message half received or an answer not sent yet keeps the session awake
+    if (active.mInputSize > 0 || !active.mOutput.empty()) {
+        return;
+    }
+    session.mFinalScore = active.mFinalScore;
+    session.mHibernationSlot = GAME_OVER_SLOT;
+    delete session.mActive;
+    session.mActive = NULL;
+}
+
+
+void GameServer::Wake (Loop& loop, Session& session)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Activate (session);
+    ActiveSession& active = *session.mActive;
+    if (session.mHibernationSlot == GAME_OVER_SLOT) {
+        // no game to restore, the next message answers with the final score or starts a game
+        active.mIsGameOverSent = true;
+        active.mFinalScore = session.mFinalScore;
+        session.mHibernationSlot = -1;
+        return;
+    }
+    // the pooled game is restored in place, no random grid is made only to be overwritten
+    GameState::Keyframe keyframe;
+    const Uint8* grid = loop.mHibernationStore->Restore (session.mHibernationSlot, keyframe, active.mSeed);
+    session.mHibernationSlot = -1;
+    active.mGameState = loop.mGameStatePool->Acquire (keyframe, grid);
+    active.mGameState->AttachGameStateGridChangeObserver (&active.mGameStateLogic);
+    // the last update is the one the game over time was counted from
+    active.mLastUpdateTime = session.mGameOverTime - (static_cast<Uint32>(active.mGameState->GetMaxGameplayTimeSeconds()) * 1000 - active.mGameState->GetGameplayTime());
+    loop.mStats.mRestores.fetch_add (1, std::memory_order_relaxed);
+    loop.mStats.mRestoreNanoseconds.fetch_add (std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+            std::memory_order_relaxed);
+}
+
+
+void GameServer::Send (Loop& loop, Session& session, Uint8 type, Uint32 sequence, Sint32 value)
+{
+    GameServerMessage message;
+    memset (&message, 0, sizeof (message));
+    message.mType = type;
+    message.mSequence = sequence;
+    message.mValue = value;
+    const Uint8* bytes = reinterpret_cast<const Uint8*>(&message);
+    std::vector<Uint8>& output = session.mActive->mOutput;
+    if (!output.empty()) {
+        output.insert (output.end(), bytes, bytes + sizeof (message));
+        return;
+    }
+    ssize_t sent = send (session.mSocket, bytes, sizeof (message), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        // the peer is gone, epoll reports the hang up and the session is closed then
+        shutdown (session.mSocket, SHUT_RDWR);
+        return;
+    }
+    sent = sent < 0 ? 0 : sent;
+    if (sent < static_cast<ssize_t>(sizeof (message))) {
+        output.insert (output.end(), bytes + sent, bytes + sizeof (message));
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.ptr = &session;
+        epoll_ctl (loop.mEpoll, EPOLL_CTL_MOD, session.mSocket, &event);
+    }
+}
+
+
+void GameServer::Flush (Loop& loop, Session& session)
+{
+    std::vector<Uint8>& output = session.mActive->mOutput;
+    const ssize_t sent = send (session.mSocket, output.data(), output.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            shutdown (session.mSocket, SHUT_RDWR);
+        }
+        return;
+    }
+    output.erase (output.begin(), output.begin() + sent);
+    if (output.empty()) {
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = &session;
+        epoll_ctl (loop.mEpoll, EPOLL_CTL_MOD, session.mSocket, &event);
+    }
+}
+
+
+void GameServer::Close (Loop& loop, Session& session)
+{
+    epoll_ctl (loop.mEpoll, EPOLL_CTL_DEL, session.mSocket, NULL);
+    close (session.mSocket);
+    if (session.mHibernationSlot >= 0) {
+        loop.mHibernationStore->Release (session.mHibernationSlot);
+        session.mHibernationSlot = -1;
+    }
+    if (session.mActive != NULL) {
+        loop.mGameStatePool->Release (session.mActive->mGameState);
+        if (session.mActive->mIsAnimating) {
+            loop.mAnimatingSessions.erase (std::find (loop.mAnimatingSessions.begin(), loop.mAnimatingSessions.end(), &session));
+        }
+        delete session.mActive;
+        session.mActive = NULL;
+    }
+    // the entry is reused by the next connection
+    session.mSocket = -1;
+    loop.mFreeSessions.push_back (&session);
+    loop.mSessionCount--;
+}
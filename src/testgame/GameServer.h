@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <GameStatePool.h>
+#include <HibernationStore.h>
+#include <Leaderboard.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * A message between a game client and the GameServer. Messages have a fixed size and are sent in host byte order,
+ * the server is meant for clients on the same machine or network of equal machines.
+ */
+struct GameServerMessage {
+    // client to server
+    static const Uint8 START_GAME = 1;      ///< starts a new game on the connection, ending the one before
+    static const Uint8 SWAP = 2;            ///< swaps tile A with its neighbour B
+    // server to client
+    static const Uint8 GAME_STARTED = 16;   ///< mValue is the seed, the client can play the same game locally with it
+    static const Uint8 SWAP_ACCEPTED = 17;  ///< mValue is the score before the swap
+    static const Uint8 SWAP_REJECTED = 18;  ///< not a neighbour, the board is not resting or there is no game, mValue is the score
+    static const Uint8 SWAP_RESOLVED = 19;  ///< the board rests again after an accepted swap, mValue is the score
+    static const Uint8 GAME_OVER = 20;      ///< mValue is the final score
+
+    Uint8 mType;
+    Uint8 mTileARow, mTileAColumn;
+    Uint8 mTileBRow, mTileBColumn;
+    Uint8 mPadding [3];
+    Uint32 mSequence;                       ///< chosen by the client, echoed in the answers to SWAP
+    Sint32 mValue;
+};
+
+
+/*!
+ * Hosts many games at once. Every connection is a session with its own GameState and GameStateLogic; the server
+ * runs the game time, so clients only send swaps and learn the outcome. The GameState objects come from a
+ * GameStatePool per loop, so starting, ending and waking games does not allocate once the pool has grown.
+ *
+ * There is one event loop thread per core, each with its own epoll instance. They all wait on the listening socket
+ * with EPOLLEXCLUSIVE, so a new connection wakes a single loop, which accepts it and owns the session from then on.
+ * The loops share nothing but the listening socket and their counters, so they need no locks; each submits final
+ * scores through a Leaderboard::SubmitBuffer of its own, which only the leaderboard's commit thread takes as well.
+ *
+ * A loop updates the sessions with animations in flight every TICK_MILIS. Resting sessions only have gameplay time
+ * passing, which one Update catches up on whenever needed: before a swap, and in a sweep that visits every session
+ * once per SWEEP_MILIS so games running out of time end. So idle sessions cost next to nothing.
+ *
+ * With hibernation enabled, the sweep also moves games resting for longer than the hibernation time out of their
+ * GameState into the loop's HibernationStore, and the next message restores them. A hibernating session keeps a
+ * 24 byte entry, in blocks of entries the loop allocates at once, and its slot in the store; its game, its logic
+ * and its buffers are freed. A finished game is submitted to the Leaderboard if the server has one, and the next
+ * sweep frees its session the same way, hibernation or not: only the 24 byte entry with the final score is left.
+ *
+ * Linux only.
+ */
+class GameServer
+{
+    public:
+        static const Uint32 TICK_MILIS = 16;
+        static const Uint32 SWEEP_MILIS = 1000;
+
+        /// counters of an event loop, written by the loop and readable from any thread
+        struct LoopStats {
+            std::atomic<int> mSessions;
+            std::atomic<int> mAnimatingSessions;
+            std::atomic<Uint64> mSwaps;
+            std::atomic<Uint64> mMaxTickMicroseconds;   ///< longest tick since the counter was reset
+            std::atomic<int> mHibernatingSessions;
+            std::atomic<Uint64> mRestores;
+            std::atomic<Uint64> mRestoreNanoseconds;    ///< time spent restoring hibernated games
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Prepares a server whose games have the given rules.
+         */
+        GameServer (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds);
+        ~GameServer ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        int GetLoopCount () const
+        {
+            return static_cast<int>(mLoops.size());
+        }
+
+        /*!
+         * Retrieves the counters of an event loop.
+         */
+        LoopStats& GetLoopStats (int loop);
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Enables hibernating resting games, to be called before Start.
+         * @param idleMilis how long a game rests before it hibernates; sessions are checked once per SWEEP_MILIS.
+         * @param spillFilePrefix NULL to keep hibernating games in memory, otherwise every loop maps a file
+         *  '<prefix>_<loop>.hib' to keep them in.
+         */
+        void SetHibernation (Uint32 idleMilis, const char* spillFilePrefix = NULL);
+
+
+        /*!
+         * Submits the final score of every game to a leaderboard, to be called before Start.
+         * @param leaderboard an open leaderboard that outlives the server, NULL for none.
+         */
+        void SetLeaderboard (Leaderboard* leaderboard)
+        {
+            mLeaderboard = leaderboard;
+        }
+
+
+        /*!
+         * Listens on an address and starts the event loops.
+         * @param address a TCP port on all interfaces (eg. "7777") or "unix:" followed by a socket file path.
+         * @param loopCount the number of event loops, 0 for one per hardware thread.
+         * @return false if the address cannot be listened on.
+         */
+        bool Start (const char* address, int loopCount = 0);
+
+
+        /*!
+         * Stops the event loops and closes every session.
+         */
+        void Stop ();
+
+    private:
+        struct Session;
+        struct ActiveSession;
+        struct Loop;
+
+        /* ====================  LIFECYCLE     ======================================= */
+        GameServer (const GameServer&);
+        GameServer& operator= (const GameServer&);
+
+        /* ====================  MUTATORS      ======================================= */
+        void RunLoop (Loop& loop);
+        void Accept (Loop& loop);
+        void Activate (Session& session);
+        bool Receive (Loop& loop, Session& session);
+        void HandleMessage (Loop& loop, Session& session, const GameServerMessage& message);
+        void CatchUp (Loop& loop, Session& session, Uint32 now);
+        void Hibernate (Loop& loop, Session& session);
+        void Retire (Session& session);
+        void Wake (Loop& loop, Session& session);
+        Uint32 GetTime () const;
+        void Send (Loop& loop, Session& session, Uint8 type, Uint32 sequence, Sint32 value);
+        void Flush (Loop& loop, Session& session);
+        void Close (Loop& loop, Session& session);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mRows, mColumns, mMinMatchSize;
+        int mMaxGameplayTimeSeconds;
+        Uint32 mHibernationMilis;           ///< 0 when games do not hibernate
+        std::string mSpillFilePrefix;
+        Leaderboard* mLeaderboard;
+        int mListenSocket;
+        std::string mUnixSocketPath;        ///< removed on Stop
+        std::atomic<bool> mIsRunning;
+        std::chrono::steady_clock::time_point mStartTime;
+        std::vector<std::unique_ptr<Loop>> mLoops;
+
+}; /* -----  end of class GameServer  ----- */
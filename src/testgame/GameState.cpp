@@ -1,4 +1,5 @@
 #include "GameState.h"
+#include <string.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -11,14 +12,21 @@
 
 
 const unsigned int GameState::sNUMBER_OF_TILE_COLORS = 5;
+bool GameState::sIsLoggingEnabled = true;
+
+
+/*!
+ * Converts a displacement in tiles to fixed point, clamped to one tile either way.
+ */
+static Sint32 ToTileDisplacement (float tiles)
+{
+    tiles = tiles < -1.0f ? -1.0f : (tiles > 1.0f ? 1.0f : tiles);
+    return static_cast<Sint32>(tiles * static_cast<float>(GameState::TILE_DISPLACEMENT_ONE));
+}
 
 
 GameState::Color GameState::GetRandomColor() {
-    int colorInt = 1 + glm::linearRand (0.0f, static_cast<float>(sNUMBER_OF_TILE_COLORS));
-    if (colorInt == sNUMBER_OF_TILE_COLORS + 1){
-        colorInt -=1;
-    }
-    return static_cast<GameState::Color>(colorInt);
+    return static_cast<GameState::Color>(1 + mRandom.NextInt (sNUMBER_OF_TILE_COLORS));
 }
 
 
@@ -38,15 +46,15 @@ GameState::Color GameState::GetColorAt (int row, int column) const
 
 GameState::Color GameState::GetColorAt (int index) const
 {
-    if (index >= mGrid.size() || index < 0) {
-        printf ("WARNING: GameState::GetColorAt index %d (size() == %d) out of bounds.\n", index, static_cast<int>(mGrid.size()));
+    if (index >= mRows * mColumns || index < 0) {
+        printf ("WARNING: GameState::GetColorAt index %d (size() == %d) out of bounds.\n", index, mRows * mColumns);
         return NotAColor;
     }
     return mGrid [index];
 }
 
 
-GameState::Color GameState::GetColorAtOrRandom (int row, int column) const
+GameState::Color GameState::GetColorAtOrRandom (int row, int column)
 {
     if (row >= mRows || row < 0) {
         return GetRandomColor();
@@ -59,15 +67,22 @@ GameState::Color GameState::GetColorAtOrRandom (int row, int column) const
 }		/* -----  end of function GetColorAt  ----- */
 
 
-std::vector<bool> GameState::GetMatchesOfN (int n) const
+template <class Flags>
+void GameState::MarkMatchesOfN (int n, Flags& matches) const
 {
-    std::vector<bool> matches (mRows*mColumns, false);
+    for (int index = 0; index < mRows * mColumns; index++) {
+        matches [index] = false;
+    }
     // check for horizontal n-in-a-rows
     for (int currentRow = 0; currentRow < mRows; currentRow++) {
         for (int currentColumn = 0; currentColumn < mColumns - n + 1; currentColumn++) {
+            if (!IsMatchable (currentRow * mColumns + currentColumn)) {
+                continue;
+            }
             GameState::Color currentColor = GetColorAt (currentRow, currentColumn);
             int colorRepetitionCount = 1;
-            while (GetColorAt (currentRow, currentColumn+colorRepetitionCount) == currentColor) {
+            while (currentColumn + colorRepetitionCount < mColumns && IsMatchable (currentRow * mColumns + currentColumn + colorRepetitionCount) &&
+                    GetColorAt (currentRow, currentColumn+colorRepetitionCount) == currentColor) {
                 colorRepetitionCount++;
             }
             if (colorRepetitionCount >= n) {
@@ -80,9 +95,13 @@ std::vector<bool> GameState::GetMatchesOfN (int n) const
     // check for horizontal n-in-a-rows
     for (int currentColumn = 0; currentColumn < mColumns; currentColumn++) {
         for (int currentRow = 0; currentRow < mRows - n + 1; currentRow++) {
+            if (!IsMatchable (currentRow * mColumns + currentColumn)) {
+                continue;
+            }
             GameState::Color currentColor = GetColorAt (currentRow, currentColumn);
             int colorRepetitionCount = 1;
-            while (GetColorAt (currentRow+colorRepetitionCount, currentColumn) == currentColor) {
+            while (currentRow + colorRepetitionCount < mRows && IsMatchable ((currentRow + colorRepetitionCount) * mColumns + currentColumn) &&
+                    GetColorAt (currentRow+colorRepetitionCount, currentColumn) == currentColor) {
                 colorRepetitionCount++;
             }
             if (colorRepetitionCount >= n) {
@@ -92,26 +111,63 @@ std::vector<bool> GameState::GetMatchesOfN (int n) const
             }
         }
     }
+}
+
+
+std::vector<bool> GameState::GetMatchesOfN (int n) const
+{
+    std::vector<bool> matches (mRows*mColumns, false);
+    MarkMatchesOfN (n, matches);
     return matches;
 }
 
 
+GameState::GameState (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds, const Keyframe& keyframe, const Uint8* grid) :
+    mTileDragData(),
+    mTweenStartTimes (NULL),
+    mTweenDurations (NULL),
+    mTweenFromXs (NULL),
+    mTweenFromYs (NULL),
+    mSwapBackPartners (NULL),
+    mMotions (NULL),
+    mMatches (NULL),
+    mStorage(),
+    mGrid (NULL),
+    mRows (0),
+    mColumns (0),
+    mMinMatchSize (minMatchSize),
+    mIsGameOver (false),
+    mGameTime (0),
+    mGameplayTime (0),
+    mGameStateGridChangeObserverCount (0),
+    mMaxGameplayTimeSeconds (maxGameplayTimeSeconds),
+    mGameScore (0),
+    mRandom()
+{
+    ResizeStorage (rows, columns);
+    RestoreKeyframe (keyframe, grid);
+}
+
+
 void GameState::ResetGridToRandom (int rows, int columns)
 {
     if (rows == 0 || columns == 0) {
-        mRows = 0;
-        mColumns = 0;
-        printf ("GameState::ResetGridToRandom: empty game grid created.\n");
+        ResizeStorage (0, 0);
+        ClearTweens();
+        if (sIsLoggingEnabled) {
+            printf ("GameState::ResetGridToRandom: empty game grid created.\n");
+        }
         return;
     }
 
-    mRows = rows;
-    mColumns = columns;
-    mGrid.resize (rows * columns);
+    ResizeStorage (rows, columns);
+    ClearTweens();
     for (int i = 0; i < rows * columns; i++) {
         mGrid[i] =  GetRandomColor();
     }
-    printf ("GameState::ResetGridToRandom: %dx%d game grid created.\n", rows, columns);
+    if (sIsLoggingEnabled) {
+        printf ("GameState::ResetGridToRandom: %dx%d game grid created.\n", rows, columns);
+    }
 }		/* -----  end of function ResetGridToRandom  ----- */
 
 
@@ -125,9 +181,9 @@ void GameState::ResetGridToRandomNoNMatches (int rows, int columns, int n)
     bool hasMatches = true;
     while (hasMatches) {
         hasMatches = false;
-        std::vector<bool> matches = GetMatchesOfN  (n);
+        MarkMatchesOfN (n, mMatches);
         for (int index = 0; index<mRows*mColumns; index++) {
-            if (matches[index]) {
+            if (mMatches[index]) {
                 hasMatches = true;
                 mGrid[index] = GetRandomColor();
             }
@@ -136,34 +192,103 @@ void GameState::ResetGridToRandomNoNMatches (int rows, int columns, int n)
 }
 
 
+void GameState::ResizeStorage (int rows, int columns)
+{
+    // the grid and the 4 byte tween arrays come first so all of them stay aligned, flags need no alignment
+    const int tiles = rows * columns;
+    const size_t wordBytes = tiles * sizeof (Uint32);
+    const size_t size = tiles * sizeof (Color) + 5 * wordBytes + 2 * tiles;
+    if (mStorage.size() < size || mStorage.empty()) {
+        // vector storage comes from operator new, aligned for any type
+        mStorage.assign (size > 0 ? size : 1, 0);
+    }
+    mRows = rows;
+    mColumns = columns;
+    mGrid = reinterpret_cast<Color*>(&mStorage [0]);
+    Uint8* tweens = &mStorage [tiles * sizeof (Color)];
+    mTweenStartTimes = reinterpret_cast<Uint32*>(tweens);
+    mTweenDurations = reinterpret_cast<Uint32*>(tweens + wordBytes);
+    mTweenFromXs = reinterpret_cast<Sint32*>(tweens + 2 * wordBytes);
+    mTweenFromYs = reinterpret_cast<Sint32*>(tweens + 3 * wordBytes);
+    mSwapBackPartners = reinterpret_cast<int*>(tweens + 4 * wordBytes);
+    mMotions = tweens + 5 * wordBytes;
+    mMatches = mMotions + tiles;
+}
+
+
+void GameState::ClearTweens ()
+{
+    const int tiles = mRows * mColumns;
+    memset (mTweenStartTimes, 0, tiles * sizeof (Uint32));
+    memset (mTweenDurations, 0, tiles * sizeof (Uint32));
+    memset (mTweenFromXs, 0, tiles * sizeof (Sint32));
+    memset (mTweenFromYs, 0, tiles * sizeof (Sint32));
+    memset (mMotions, Resting, tiles);
+    for (int index = 0; index < tiles; index++) {
+        mSwapBackPartners [index] = -1;
+    }
+    for (int motion = 0; motion < MOTION_COUNT; motion++) {
+        mMovingTileCounts [motion] = 0;
+    }
+}
+
+
+void GameState::StartTween (int index, Motion motion, Uint32 duration, Uint32 headStart, Sint32 fromX, Sint32 fromY)
+{
+    mMovingTileCounts [mMotions [index]]--;
+    mMovingTileCounts [motion]++;
+    mMotions [index] = static_cast<Uint8>(motion);
+    mTweenStartTimes [index] = mGameTime - headStart;
+    mTweenDurations [index] = duration;
+    mTweenFromXs [index] = fromX;
+    mTweenFromYs [index] = fromY;
+    if (index == mTileDragData.mSelectedTileRow * mColumns + mTileDragData.mSelectedTileColumn) {
+        DeselectTile();
+    }
+    if (mTileDragData.mIsActive && index == mTileDragData.mDraggedTileRow * mColumns + mTileDragData.mDraggedTileColumn) {
+        mTileDragData.mIsActive = false;
+    }
+}
+
+
+void GameState::Reset (Uint32 seed)
+{
+    mTileDragData = TileDragData();
+    mIsGameOver = false;
+    mGameTime = 0;
+    mGameplayTime = 0;
+    mGameScore = 0;
+    mRandom = GameRandom (seed);
+    ResetGridToRandomNoNMatches (mRows, mColumns, mMinMatchSize);
+}
+
+
 bool GameState::SetDragStartLocation (glm::vec2 gridMouseDownLocation)
 {
-    if (Idle != mAnimationState) {
-        printf ("ERROR in GameState::SetDragStartLocation: cannot start a drag motion, animation state not Idle.\n");
+    if (mIsGameOver) {
+        printf ("ERROR in GameState::SetDragStartLocation: cannot start a drag motion, the game is over.\n");
         return false;
     }
-    if (mTileDragData.mIsActive) {
-        printf ("ERROR in GameState::SetDragStartLocation: cannot start a drag motion, a drag motion already taking place.\n");
+    if (!IsTileResting (GetRowOfGridCoordinates (gridMouseDownLocation), GetColumnOfGridCoordinates (gridMouseDownLocation))) {
+        printf ("ERROR in GameState::SetDragStartLocation: cannot start a drag motion, no resting tile at the location.\n");
         return false;
     }
     if (mTileDragData.mIsActive) {
-        printf ("ERROR in GameState::SetDragStartLocation: cannot start a drag motion, drag started outside of the grid.\n");
+        printf ("ERROR in GameState::SetDragStartLocation: cannot start a drag motion, a drag motion already taking place.\n");
         return false;
     }
     mTileDragData.mStartLocation = gridMouseDownLocation;
     mTileDragData.mIsActive = true;
     SetDragCurrentLocation (gridMouseDownLocation);
-    printf ("GameState::SetDragStartLocation (gridMouseDownLocation - x:%f y:%f).\n", gridMouseDownLocation.x, gridMouseDownLocation.y);
+    if (sIsLoggingEnabled) {
+        printf ("GameState::SetDragStartLocation (gridMouseDownLocation - x:%f y:%f).\n", gridMouseDownLocation.x, gridMouseDownLocation.y);
+    }
     return true;
 }
 
 
 bool GameState::SetDragCurrentLocation (glm::vec2 gridMouseCurrentLocation)
 {
-    if (Idle != mAnimationState) {
-        printf ("ERROR in GameState::SetDragCurrentLocation: pointless call, animation state not Idle.\n");
-        return false;
-    }
     if (!mTileDragData.mIsActive) {
         printf ("ERROR in GameState::SetDragCurrentLocation: pointless call, no drag motion taking place.\n");
         return false;
@@ -174,10 +299,6 @@ bool GameState::SetDragCurrentLocation (glm::vec2 gridMouseCurrentLocation)
 }
 
 void GameState::UpdateDragCache() {
-    if (Idle != mAnimationState) {
-        printf ("ERROR in GameState::SetDragCurrentLocation: pointless call, animation state not Idle.\n");
-        return;
-    }
     if (!mTileDragData.mIsActive) {
         printf ("ERROR in GameState::SetDragCurrentLocation: pointless call, no drag motion taking place.\n");
         return;
@@ -201,17 +322,18 @@ void GameState::UpdateDragCache() {
     if (mTileDragData.mDraggedTileRow == mRows-1 && dragDiff.y > 0.0f) {
         dragDiff.y = 0.0f;
     }
-    mTileDragData.mCurrentTileDisplacement = glm::vec3 (0.0f, 0.0f, 0.0f);
+    // the drag comes in grid coordinates, the game keeps the displacement in fixed point tiles
+    mTileDragData.mCurrentTileDisplacementX = 0;
+    mTileDragData.mCurrentTileDisplacementY = 0;
     // find out whether the dragged tile is moved more horizontally or vertically
     if (fabs (dragDiff.x) > fabs (dragDiff.y)) {
         mTileDragData.mReplacedTileRow = mTileDragData.mDraggedTileRow;
         if (dragDiff.x > 0) {
             mTileDragData.mReplacedTileColumn = mTileDragData.mDraggedTileColumn + 1;
-            mTileDragData.mCurrentTileDisplacement.x = fmin (dragDiff.x, 1.0f/static_cast<float>(mColumns));
         } else {
             mTileDragData.mReplacedTileColumn = mTileDragData.mDraggedTileColumn - 1;
-            mTileDragData.mCurrentTileDisplacement.x = fmax (dragDiff.x, -1.0f/static_cast<float>(mColumns));
         }
+        mTileDragData.mCurrentTileDisplacementX = ToTileDisplacement (dragDiff.x * static_cast<float>(mColumns));
     } else if (dragDiff.x == 0.0 && dragDiff.y == 0.0f){
             mTileDragData.mReplacedTileColumn = -1;
             mTileDragData.mReplacedTileRow = -1;
@@ -219,17 +341,16 @@ void GameState::UpdateDragCache() {
         mTileDragData.mReplacedTileColumn = mTileDragData.mDraggedTileColumn;
         if (dragDiff.y > 0) {
             mTileDragData.mReplacedTileRow = mTileDragData.mDraggedTileRow + 1;
-            mTileDragData.mCurrentTileDisplacement.y = fmin (dragDiff.y, 1.0f/static_cast<float>(mRows));
         } else {
             mTileDragData.mReplacedTileRow = mTileDragData.mDraggedTileRow - 1;
-            mTileDragData.mCurrentTileDisplacement.y = fmax (dragDiff.y, -1.0f/static_cast<float>(mRows));
         }
+        mTileDragData.mCurrentTileDisplacementY = ToTileDisplacement (dragDiff.y * static_cast<float>(mRows));
     }
 }
 
 
 int GameState::GetReplacedTileRow() const {
-    if (mTileDragData.mIsActive || mAnimationState == SwappingTiles || mTileDragData.mIsSwapBack) {
+    if (mTileDragData.mIsActive) {
         return mTileDragData.mReplacedTileRow;
     } else {
         return -1;
@@ -238,7 +359,7 @@ int GameState::GetReplacedTileRow() const {
 
 
 int GameState::GetReplacedTileColumn() const {
-    if (mTileDragData.mIsActive || mAnimationState == SwappingTiles || mTileDragData.mIsSwapBack) {
+    if (mTileDragData.mIsActive) {
         return mTileDragData.mReplacedTileColumn;
     } else {
         return -1;
@@ -247,7 +368,7 @@ int GameState::GetReplacedTileColumn() const {
 
 
 int GameState::GetDraggedTileRow() const {
-    if (mTileDragData.mIsActive || mAnimationState == SwappingTiles || mTileDragData.mIsSwapBack) {
+    if (mTileDragData.mIsActive) {
         return mTileDragData.mDraggedTileRow;
     } else {
         return -1;
@@ -256,7 +377,7 @@ int GameState::GetDraggedTileRow() const {
 
 
 int GameState::GetDraggedTileColumn() const {
-    if (mTileDragData.mIsActive || mAnimationState == SwappingTiles || mTileDragData.mIsSwapBack) {
+    if (mTileDragData.mIsActive) {
         return mTileDragData.mDraggedTileColumn;
     } else {
         return -1;
@@ -265,14 +386,26 @@ int GameState::GetDraggedTileColumn() const {
 
 
 glm::vec3 GameState::GetCurrentDraggedTileDisplacement() const {
-    if (mTileDragData.mIsActive || mAnimationState == SwappingTiles) {
-        return mTileDragData.mCurrentTileDisplacement;
+    if (mTileDragData.mIsActive) {
+        return glm::vec3 (static_cast<float>(mTileDragData.mCurrentTileDisplacementX) / (TILE_DISPLACEMENT_ONE * static_cast<float>(mColumns)),
+                static_cast<float>(mTileDragData.mCurrentTileDisplacementY) / (TILE_DISPLACEMENT_ONE * static_cast<float>(mRows)), 0.0f);
     } else {
         return glm::vec3 (0.0f, 0.0f, 0.0f);
     }
 }
 
 
+Sint32 GameState::GetDraggedTileProgress() const
+{
+    if (!mTileDragData.mIsActive) {
+        return 0;
+    }
+    const Sint32 progressX = abs (mTileDragData.mCurrentTileDisplacementX);
+    const Sint32 progressY = abs (mTileDragData.mCurrentTileDisplacementY);
+    return progressX > progressY ? progressX : progressY;
+}
+
+
 glm::vec2 GameState::GetDragStartLocation () const
 {
     if (!mTileDragData.mIsActive) {
@@ -291,21 +424,25 @@ glm::vec2 GameState::GetDragCurrentLocation () const
 }
 
 
-void GameState::SwapTiles (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationDuration, bool swapBack)
+bool GameState::SwapTiles (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationDuration, bool swapBack, Uint32 animationHeadStart)
 {
-    if (Idle != mAnimationState) {
-        printf ("WARNING: GameState::SwapTiles called while mAnimationState is not Idle. Swap not run.\n");
-        return;
+    if (!IsTileResting (tileARow, tileAColumn) || !IsTileResting (tileBRow, tileBColumn)) {
+        printf ("WARNING: GameState::SwapTiles called with tile (%d,%d) or (%d,%d) not resting. Swap not run.\n", tileARow, tileAColumn, tileBRow, tileBColumn);
+        return false;
     }
-    mTileDragData  = TileDragData();
-    mTileDragData.mDraggedTileRow = tileARow;
-    mTileDragData.mDraggedTileColumn = tileAColumn;
-    mTileDragData.mReplacedTileRow = tileBRow;
-    mTileDragData.mReplacedTileColumn = tileBColumn;
-    mTileDragData.mIsSwapBack = swapBack;
-    mAnimationState = SwappingTiles;
-    mAnimationDuration = animationDuration;
-    mTimeAnimationStart = mGameTime;
+    const int tileA = tileARow * mColumns + tileAColumn;
+    const int tileB = tileBRow * mColumns + tileBColumn;
+    const Color tileAColor = mGrid [tileA];
+    mGrid [tileA] = mGrid [tileB];
+    mGrid [tileB] = tileAColor;
+    // each tile slides from the other's place into its own
+    const Sint32 fromX = (tileBColumn - tileAColumn) * TILE_DISPLACEMENT_ONE;
+    const Sint32 fromY = (tileBRow - tileARow) * TILE_DISPLACEMENT_ONE;
+    StartTween (tileA, Swapping, animationDuration, animationHeadStart, fromX, fromY);
+    StartTween (tileB, Swapping, animationDuration, animationHeadStart, -fromX, -fromY);
+    mSwapBackPartners [tileA] = swapBack ? tileB : -1;
+    mSwapBackPartners [tileB] = swapBack ? tileA : -1;
+    return true;
 }
 
 
@@ -315,29 +452,29 @@ bool GameState::SwapDraggedAndReplacedTiles (Uint32 animationDuration, bool anim
         printf ("WARNING: GameState::SwapDraggedAndReplacedTiles called with no tile drag active.\n");
         return false;
     }
-    if (Idle != mAnimationState) {
-        printf ("WARNING: GameState::SwapDraggedAndReplacedTiles called while mAnimationState is not Idle.\n");
-        return false;
-    }
-    mTileDragData.mIsSwapBack = swapBack;
-    mAnimationState = SwappingTiles;
-    mAnimationDuration = animationDuration;
     mTileDragData.mIsActive = false;
 
+    const int draggedTile = mTileDragData.mDraggedTileRow * mColumns + mTileDragData.mDraggedTileColumn;
+    const int replacedTile = mTileDragData.mReplacedTileRow * mColumns + mTileDragData.mReplacedTileColumn;
     if (false == animateFromCurrentPositionOn) {
-        mTimeAnimationStart = mGameTime;
-        mTileDragData.mAnimationStartingTileDisplacement = mTileDragData.mCurrentTileDisplacement;
-    } else {
-        // find out what percentage of animation is already done
-        float displacementMaxX = 1.0f/static_cast<float>(mColumns);
-        float displacementMaxY = 1.0f/static_cast<float>(mRows);
-        float animationDone = fmax (fabs (mTileDragData.mCurrentTileDisplacement.x)/displacementMaxX, fabs (mTileDragData.mCurrentTileDisplacement.y)/displacementMaxY);
-        // move starting time so far back that current displacement would be reached with current time and animation duration
-        Uint32 elapsedAnimationTime = static_cast<Uint32>(static_cast<float>(animationDuration) * animationDone);
-        mTimeAnimationStart = mGameTime - elapsedAnimationTime;
-        mTileDragData.mAnimationStartingTileDisplacement = glm::vec3();
+        if (!SwapTiles (mTileDragData.mDraggedTileRow, mTileDragData.mDraggedTileColumn, mTileDragData.mReplacedTileRow, mTileDragData.mReplacedTileColumn,
+                animationDuration, swapBack)) {
+            return false;
+        }
+        // the tiles start where the drag left them
+        mTweenFromXs [replacedTile] += mTileDragData.mCurrentTileDisplacementX;
+        mTweenFromYs [replacedTile] += mTileDragData.mCurrentTileDisplacementY;
+        mTweenFromXs [draggedTile] -= mTileDragData.mCurrentTileDisplacementX;
+        mTweenFromYs [draggedTile] -= mTileDragData.mCurrentTileDisplacementY;
+        return true;
     }
-    return true;
+    // find out how much of the animation is already done, in fixed point like the displacement
+    const Uint64 animationDone = static_cast<Uint64>(abs (mTileDragData.mCurrentTileDisplacementX) > abs (mTileDragData.mCurrentTileDisplacementY) ?
+        abs (mTileDragData.mCurrentTileDisplacementX) : abs (mTileDragData.mCurrentTileDisplacementY));
+    // move starting time so far back that current displacement would be reached with current time and animation duration
+    Uint32 elapsedAnimationTime = static_cast<Uint32>(animationDuration * animationDone / TILE_DISPLACEMENT_ONE);
+    return SwapTiles (mTileDragData.mDraggedTileRow, mTileDragData.mDraggedTileColumn, mTileDragData.mReplacedTileRow, mTileDragData.mReplacedTileColumn,
+            animationDuration, swapBack, elapsedAnimationTime);
 }
 
 
@@ -347,157 +484,204 @@ void GameState::DeactivateDrag() {
 
 void GameState::Elapse (Uint32 deltaTime)
 {
+    const Uint32 previousGameTime = mGameTime;
     mGameTime+=deltaTime;
-    mGameplayTime+=deltaTime;
-    if (Idle != mAnimationState) {
-        // correct mGameplayTIme
-        int animationLeftover = mTimeAnimationStart + mAnimationDuration - mGameTime;
-        mGameplayTime -= deltaTime;
-        if (animationLeftover < 0) {
-            mGameplayTime += abs (animationLeftover);
-        }
-
-        DeselectTile();
-        float elapsedAnimation = mGameTime - mTimeAnimationStart;
-        float animationElapsedPercentage = fmin (1.0f, static_cast<float>(elapsedAnimation) / static_cast<float>(mAnimationDuration));
-        if (GameState::SwappingTiles == mAnimationState) {
-            glm::vec3 finalTileDisplacement = glm::vec3 (0.0f, 0.0f, 0.0f);
-            finalTileDisplacement.x = (mTileDragData.mReplacedTileColumn - mTileDragData.mDraggedTileColumn) * (1.0f / static_cast<float>(mColumns));
-            finalTileDisplacement.y = (mTileDragData.mReplacedTileRow - mTileDragData.mDraggedTileRow) * (1.0f / static_cast<float>(mRows));
-            mTileDragData.mCurrentTileDisplacement = mTileDragData.mAnimationStartingTileDisplacement + animationElapsedPercentage *
-                (finalTileDisplacement - mTileDragData.mAnimationStartingTileDisplacement);
-
-            if (animationElapsedPercentage >= 1.0f) {
-                Color draggedTileColor = mGrid[mTileDragData.mDraggedTileRow*mColumns+mTileDragData.mDraggedTileColumn];
-                Color replacedTileColor = mGrid[mTileDragData.mReplacedTileRow*mColumns+mTileDragData.mReplacedTileColumn];
-                mGrid [mTileDragData.mDraggedTileRow*mColumns+mTileDragData.mDraggedTileColumn] = replacedTileColor ;
-                mGrid [mTileDragData.mReplacedTileRow*mColumns+mTileDragData.mReplacedTileColumn] = draggedTileColor;
-                printf ("GameState::Elapse: SwappingTiles animation finished.\n");
-                mAnimationState = Idle;
-                NotifyGameStateGridChangeObservers ();
+    if (GetAnimationState() == Idle) {
+        mGameplayTime+=deltaTime;
+    } else {
+        // integers only, so every compiler and optimization level plays a game alike
+        Uint32 busyTime = 0;
+        bool isAnyTileSwappable = false;
+        bool isAnyTweenEnded = false;
+        for (int index = 0; index < mRows * mColumns; index++) {
+            if (Resting == mMotions [index]) {
+                isAnyTileSwappable = isAnyTileSwappable || DestroyedColor != mGrid [index];
+                continue;
             }
-        } else if (DestroyingTiles == mAnimationState) {
-            if (animationElapsedPercentage >= 1.0f) {
-                for (int counter = 0; counter < mGrid.size(); counter++) {
-                    if (mTilesBeingDestroyed [counter]) {
-                        mGrid [counter] = DestroyedColor;
-                    }
-                }
-                printf ("GameState::Elapse: DestroyingTiles animation finished.\n");
-                mAnimationState = Idle;
-                NotifyGameStateGridChangeObservers ();
+            // the board is busy until the last destroy or fall ends, the rest of the step is gameplay;
+            // swaps and swap backs never hold the clock, else a swap each second would stop it for good
+            if (Swapping != mMotions [index]) {
+                const Sint32 timeToEnd = static_cast<Sint32>(mTweenStartTimes [index] + mTweenDurations [index] - previousGameTime);
+                const Uint32 tweenBusyTime = timeToEnd < 0 ? 0 : (static_cast<Uint32>(timeToEnd) > deltaTime ? deltaTime : static_cast<Uint32>(timeToEnd));
+                busyTime = tweenBusyTime > busyTime ? tweenBusyTime : busyTime;
             }
-        } else if (CollapsingTiles == mAnimationState) {
-            if (animationElapsedPercentage >= 1.0f) {
-                printf ("GameState::Elapse: CollapsingTiles animation finished.\n");
-                mAnimationState = Idle;
-                NotifyGameStateGridChangeObservers ();
+            if (mGameTime - mTweenStartTimes [index] < mTweenDurations [index]) {
+                continue;
             }
+            if (Destroying == mMotions [index]) {
+                mGrid [index] = DestroyedColor;
+            }
+            mMovingTileCounts [mMotions [index]]--;
+            mMotions [index] = Resting;
+            mTweenFromXs [index] = 0;
+            mTweenFromYs [index] = 0;
+            isAnyTweenEnded = true;
+        }
+        // tweens end only at the end of a step, so a tile that can be swapped at its start can be all the way
+        mGameplayTime += isAnyTileSwappable ? deltaTime : deltaTime - busyTime;
+        if (isAnyTweenEnded) {
+            NotifyGameStateGridChangeObservers ();
         }
     }
     if (GetGameplayTimeLeft() == 0) {
-        mAnimationState = GameOver;
+        mIsGameOver = true;
     }
 }
 
 
 void GameState::AttachGameStateGridChangeObserver (IGameStateGridChangeObserver* gameStateGridChangeObserver)
 {
-    mGameStateGridChangeObservers.push_back (gameStateGridChangeObserver);
+    if (mGameStateGridChangeObserverCount == MAX_GRID_CHANGE_OBSERVERS) {
+        printf ("ERROR: GameState::AttachGameStateGridChangeObserver more than %d observers attached.\n", MAX_GRID_CHANGE_OBSERVERS);
+        assert (mGameStateGridChangeObserverCount < MAX_GRID_CHANGE_OBSERVERS);
+        return;
+    }
+    mGameStateGridChangeObservers [mGameStateGridChangeObserverCount++] = gameStateGridChangeObserver;
 }
 
 
 void GameState::NotifyGameStateGridChangeObservers ()
 {
-    for (std::vector<IGameStateGridChangeObserver*>::iterator iterator = mGameStateGridChangeObservers.begin();
-            iterator != mGameStateGridChangeObservers.end(); iterator++) {
-        (*iterator)->NotifyOfGameStateGridChange();
+    for (int index = 0; index < mGameStateGridChangeObserverCount; index++) {
+        mGameStateGridChangeObservers [index]->NotifyOfGameStateGridChange();
     }
 }
 
 
-bool GameState::DestroyTiles (std::vector<bool> tilesToDestroy, Uint32 animationDuration)
+bool GameState::DestroyTiles (const std::vector<bool>& tilesToDestroy, Uint32 animationDuration)
 {
-    if (tilesToDestroy.size() != mGrid.size()) {
+    if (tilesToDestroy.size() != static_cast<size_t>(mRows * mColumns)) {
         printf ("ERROR: GameState::DestroyTiles called with grid size different from that of GameState.\n");
         return false;
     }
-    if (Idle != mAnimationState) {
-        printf ("ERROR: GameState::DestroyTiles called while mAnimation state is not Idle.\n");
+    for (int index = 0; index < mRows * mColumns; index++) {
+        if (tilesToDestroy [index] && !IsMatchable (index)) {
+            printf ("ERROR: GameState::DestroyTiles called with tile %d not resting.\n", index);
+            return false;
+        }
+    }
+    for (int index = 0; index < mRows * mColumns; index++) {
+        if (tilesToDestroy [index]) {
+            StartTween (index, Destroying, animationDuration, 0, 0, 0);
+        }
+    }
+    return true;
+}
+
+
+bool GameState::CollapseColumn (int column, Uint32 animationDuration)
+{
+    if (!IsColumnResting (column)) {
+        printf ("ERROR: GameState::CollapseColumn called with tiles of column %d moving.\n", column);
         return false;
     }
-    if (mTileDragData.mIsActive) {
-        printf ("WARNING: GameState::DestroyTiles called while tile drag is active. Tile drag is reset.\n");
-        mTileDragData = TileDragData();
+    // from the bottom up every tile drops by the number of destroyed tiles below it, new tiles come after the top one
+    int fallRows = 0;
+    for (int currentRow = mRows - 1; currentRow > -1; currentRow--) {
+        while (currentRow - fallRows > -1 && DestroyedColor == mGrid [(currentRow - fallRows) * mColumns + column]) {
+            fallRows++;
+        }
+        if (fallRows == 0) {
+            continue;
+        }
+        const int index = currentRow * mColumns + column;
+        mGrid [index] = GetColorAtOrRandom (currentRow - fallRows, column);
+        // a tile that moves is not to swap back any longer
+        ResetSwapBack (index);
+        if (currentRow - fallRows > -1) {
+            ResetSwapBack ((currentRow - fallRows) * mColumns + column);
+        }
+        StartTween (index, Falling, animationDuration, 0, 0, -fallRows * TILE_DISPLACEMENT_ONE);
     }
-    mAnimationState = DestroyingTiles;
-    mTimeAnimationStart = mGameTime;
-    mAnimationDuration = animationDuration;
-    mTilesBeingDestroyed = tilesToDestroy;
     return true;
 }
 
 
-float GameState::GetAnimationPercentage() const
+GameState::TileTween GameState::GetTileTween (int index) const
 {
-    return static_cast<float>(mGameTime - mTimeAnimationStart) / mAnimationDuration;
+    TileTween tween;
+    tween.mMotion = static_cast<Motion>(mMotions [index]);
+    tween.mStartTime = mTweenStartTimes [index];
+    tween.mDuration = mTweenDurations [index];
+    tween.mFromX = mTweenFromXs [index];
+    tween.mFromY = mTweenFromYs [index];
+    return tween;
 }
 
 
-bool GameState::IsTileBeingDestroyed (int row, int column) const
+bool GameState::IsTileResting (int row, int column) const
 {
-    if (DestroyingTiles != mAnimationState) {
+    if (row < 0 || row >= mRows || column < 0 || column >= mColumns) {
         return false;
     }
-    return mTilesBeingDestroyed [row * mColumns + column];
+    return IsMatchable (row * mColumns + column);
 }
 
 
-bool GameState::CollapseColumns (std::vector<std::vector<int>> columnsToCollapse, Uint32 animationDuration)
+bool GameState::IsColumnResting (int column) const
 {
-    if (columnsToCollapse.size() != mColumns) {
-        printf ("ERROR: GameState::CollapseColumns called with number of columns mismatch.\n");
-        return false;
+    for (int row = 0; row < mRows; row++) {
+        if (Resting != mMotions [row * mColumns + column]) {
+            return false;
+        }
     }
-    if (Idle != mAnimationState) {
-        printf ("ERROR: GameState::CollapseColumns called while mAnimation state is not Idle.\n");
+    return true;
+}
+
+
+bool GameState::IsGameplayTimeRunning() const
+{
+    if (mIsGameOver) {
         return false;
     }
-    if (mTileDragData.mIsActive) {
-        printf ("WARNING: GameState::CollapseColumns called while tile drag is active. Tile drag is reset.\n");
-        mTileDragData = TileDragData();
+    if (mMovingTileCounts [Destroying] == 0 && mMovingTileCounts [Falling] == 0) {
+        return true;
     }
-    mAnimationState = CollapsingTiles;
-    for (int currentColumn = 0; currentColumn < mColumns; currentColumn++) {
-        for (int currentRow = columnsToCollapse[currentColumn][0]; currentRow > -1; currentRow--) {
-            mGrid [currentRow * mColumns + currentColumn] = GetColorAtOrRandom (currentRow - columnsToCollapse[currentColumn][1], currentColumn);
+    for (int index = 0; index < mRows * mColumns; index++) {
+        if (IsMatchable (index)) {
+            return true;
         }
     }
-    mTimeAnimationStart = mGameTime;
-    mAnimationDuration = animationDuration;
-    mColumnsToCollapse = columnsToCollapse;
-    return true;
+    return false;
 }
 
 
-std::vector<std::vector<int>> GameState::GetColumnsToCollapse() const
+Uint32 GameState::GetTimeToNextTweenEnd() const
 {
-    if (CollapsingTiles != mAnimationState) {
-        printf ("ERROR: GameState::GetColumnsToCollapse called while mAnimation state is not CollapsingTiles.\n");
+    Uint32 timeToEnd = 0xFFFFFFFF;
+    for (int index = 0; index < mRows * mColumns; index++) {
+        if (Resting == mMotions [index]) {
+            continue;
+        }
+        const Uint32 elapsed = mGameTime - mTweenStartTimes [index];
+        const Uint32 tweenTimeToEnd = elapsed < mTweenDurations [index] ? mTweenDurations [index] - elapsed : 0;
+        timeToEnd = tweenTimeToEnd < timeToEnd ? tweenTimeToEnd : timeToEnd;
     }
-    return mColumnsToCollapse;
+    return timeToEnd;
 }
 
 
-bool GameState::GetIsSwapBack() const
+Uint32 GameState::GetTimeToRest() const
 {
-    return mTileDragData.mIsSwapBack;
+    Uint32 timeToRest = 0;
+    for (int index = 0; index < mRows * mColumns; index++) {
+        if (Resting == mMotions [index]) {
+            continue;
+        }
+        const Uint32 elapsed = mGameTime - mTweenStartTimes [index];
+        const Uint32 tweenTimeToEnd = elapsed < mTweenDurations [index] ? mTweenDurations [index] - elapsed : 0;
+        timeToRest = tweenTimeToEnd > timeToRest ? tweenTimeToEnd : timeToRest;
+    }
+    return timeToRest;
 }
 
 
-void GameState::ResetIsSwapBack()
+void GameState::ResetSwapBack (int index)
 {
-    mTileDragData.mIsSwapBack = false;
+    if (mSwapBackPartners [index] != -1) {
+        mSwapBackPartners [mSwapBackPartners [index]] = -1;
+        mSwapBackPartners [index] = -1;
+    }
 }
 
 
@@ -553,8 +737,8 @@ int GameState::GetGameplayTimeLeft() const
     if (mMaxGameplayTimeSeconds * 1000 < mGameplayTime) {
         return 0;
     }
-    int secondsLeft = ceil (static_cast<float>(mMaxGameplayTimeSeconds * 1000 - mGameplayTime)/1000.0f);
-    return secondsLeft;
+    // rounded up in integers, the game ends when this reaches 0
+    return static_cast<int>((mMaxGameplayTimeSeconds * 1000 - mGameplayTime + 999) / 1000);
 }
 
 
@@ -562,3 +746,57 @@ void GameState::AddToScore (int points)
 {
     mGameScore+=points;
 }
+
+
+bool GameState::GetKeyframe (Keyframe& keyframe, Uint8* grid) const
+{
+    if (Idle != GetAnimationState() || mTileDragData.mIsActive) {
+        return false;
+    }
+    keyframe.mGameTime = mGameTime;
+    keyframe.mGameplayTime = mGameplayTime;
+    keyframe.mGameScore = mGameScore;
+    keyframe.mRandomState = mRandom.GetState();
+    for (int index = 0; index < mRows * mColumns; index++) {
+        grid [index] = static_cast<Uint8>(mGrid [index]);
+    }
+    return true;
+}
+
+
+void GameState::RestoreKeyframe (const Keyframe& keyframe, const Uint8* grid)
+{
+    mTileDragData = TileDragData();
+    mIsGameOver = false;
+    ClearTweens();
+    mGameTime = keyframe.mGameTime;
+    mGameplayTime = keyframe.mGameplayTime;
+    mGameScore = keyframe.mGameScore;
+    mRandom.SetState (keyframe.mRandomState);
+    for (int index = 0; index < mRows * mColumns; index++) {
+        mGrid [index] = static_cast<Color>(grid [index]);
+    }
+}
+
+
+void GameState::CopyStateFrom (const GameState& gameState)
+{
+    if (&gameState == this) {
+        return;
+    }
+    ResizeStorage (gameState.mRows, gameState.mColumns);
+    // the grid and the tweens are laid out the same way in both blocks, the match flags are scratch
+    const size_t usedBytes = gameState.mMatches - &gameState.mStorage [0];
+    memcpy (&mStorage [0], &gameState.mStorage [0], usedBytes);
+    mTileDragData = gameState.mTileDragData;
+    mMinMatchSize = gameState.mMinMatchSize;
+    mIsGameOver = gameState.mIsGameOver;
+    for (int motion = 0; motion < MOTION_COUNT; motion++) {
+        mMovingTileCounts [motion] = gameState.mMovingTileCounts [motion];
+    }
+    mGameTime = gameState.mGameTime;
+    mGameplayTime = gameState.mGameplayTime;
+    mMaxGameplayTimeSeconds = gameState.mMaxGameplayTimeSeconds;
+    mGameScore = gameState.mGameScore;
+    mRandom = gameState.mRandom;
+}
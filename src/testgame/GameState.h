@@ -5,6 +5,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/random.hpp>
 #include <vector>
+#include <GameRandom.h>
 
 
 #ifdef TARGET_MSVC
@@ -40,41 +41,112 @@ class GameState
         };
 
         /*!
-         * GameState animations such as switching two tiles, destroying two tiles or collapsing.
+         * What moves on the board as a whole, see GetAnimationState. Tiles move on their own, see Motion.
          */
         enum AnimationState {
-            Idle = 0,            ///< denotes game time is running and no animation is running
-            SwappingTiles = 1,   ///< denotes that an animation of swapping two tiles is running
-            DestroyingTiles = 2, ///< denotes an animation is running for matched tiles that they are being destroyed
-            CollapsingTiles = 3, ///< denotes an animation is running of destroyed tiles being covered by falling tiles from above
+            Idle = 0,            ///< denotes game time is running and no tile moves
+            SwappingTiles = 1,   ///< denotes that at least two tiles are being swapped
+            DestroyingTiles = 2, ///< denotes that matched tiles are being destroyed and none are swapped
+            CollapsingTiles = 3, ///< denotes that tiles fall into destroyed ones and none are swapped or destroyed
             GameOver = 4         ///< denotes the game is over (input and update will be ignored)
         };
 
+        /*!
+         * How a single tile moves. Every tile has a tween of its own, so swaps, destroys and falls run side by side.
+         */
+        enum Motion {
+            Resting = 0,         ///< the tile is at its place and can be swapped
+            Swapping = 1,        ///< the tile slides into its place from a neighbour's
+            Destroying = 2,      ///< the tile is matched, its place becomes DestroyedColor at the end
+            Falling = 3          ///< the tile falls into its place from further up, easing in
+        };
+
         /// how many colors of tiles can be on the board, also used for number of OpenGL texture objects to generate
         static const unsigned int sNUMBER_OF_TILE_COLORS;
+        /// how many kinds of Motion there are
+        static const int MOTION_COUNT = 4;
+        /// how many observers can be attached to a game at the same time
+        static const int MAX_GRID_CHANGE_OBSERVERS = 4;
+        /// a tile's width or height in the fixed point units tile displacements are kept in
+        static const Sint32 TILE_DISPLACEMENT_ONE = 1 << 16;
+
+
+        /*!
+         * The state of a resting game (Idle, no drag, no grid check pending) apart from the grid.
+         * Together with the grid it restores the game exactly, see GetKeyframe and RestoreKeyframe.
+         */
+        struct Keyframe {
+            Uint32 mGameTime;
+            Uint32 mGameplayTime;
+            Sint32 mGameScore;
+            Uint32 mRandomState;
+        };
+
+
+        /*!
+         * The tween of a tile, in game time so that every compiler and optimization level plays a game alike.
+         * The tile is drawn at its place plus an offset that goes from mFromX, mFromY to 0 over the tween.
+         */
+        struct TileTween {
+            Motion mMotion;
+            Uint32 mStartTime;      ///< game time the tween started at, earlier if it was given a head start
+            Uint32 mDuration;       ///< in miliseconds
+            Sint32 mFromX, mFromY;  ///< offset from the place at the start, TILE_DISPLACEMENT_ONE per tile
+        };
+
+
+        /*!
+         * Enables or disables informational logging (eg. about finished animations) of all GameState objects.
+         * Errors and warnings are always printed. Headless tools simulating many games disable it.
+         * @param isLoggingEnabled true to print informational messages, which is the default.
+         */
+        static void SetIsLoggingEnabled (bool isLoggingEnabled)
+        {
+            sIsLoggingEnabled = isLoggingEnabled;
+        }
 
 
         /* ====================  LIFECYCLE     ======================================= */
-        explicit GameState (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds) :  /* constructor */
+        /*!
+         * Creates a game with a random grid without matches.
+         * All tiles and tweens of the game live in one block, allocated here and reused by Reset.
+         * @param seed seeds the random tile colors, the same seed and the same moves give the same game.
+         */
+        explicit GameState (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds, Uint32 seed = 1) :  /* constructor */
 			mMinMatchSize (minMatchSize),
 			mTileDragData(),
 			mGameTime (0),
 			mGameplayTime (0),
-			mTilesBeingDestroyed(),
-			mColumnsToCollapse(),
-			mGrid(),
-			mAnimationState (Idle),
-			mGameStateGridChangeObservers(),
-			mTimeAnimationStart (0),
-			mAnimationDuration (0),
+			mTweenStartTimes (NULL),
+			mTweenDurations (NULL),
+			mTweenFromXs (NULL),
+			mTweenFromYs (NULL),
+			mSwapBackPartners (NULL),
+			mMotions (NULL),
+			mMatches (NULL),
+			mStorage(),
+			mGrid (NULL),
+			mIsGameOver (false),
+			mGameStateGridChangeObserverCount (0),
             mMaxGameplayTimeSeconds (maxGameplayTimeSeconds),
-            mGameScore (0)
+            mGameScore (0),
+            mRandom (seed)
         {
-            printf ("GameState::GameState: Creating a new GameState...\n");
+            if (sIsLoggingEnabled) {
+                printf ("GameState::GameState: Creating a new GameState...\n");
+            }
             ResetGridToRandomNoNMatches (rows, columns, mMinMatchSize);
         }
 
 
+        /*!
+         * Creates a game restored from a keyframe, without making a random grid first, see RestoreKeyframe.
+         * @param keyframe the state apart from the grid.
+         * @param grid rows * columns colors in row major order.
+         */
+        GameState (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds, const Keyframe& keyframe, const Uint8* grid);
+
+
         /* ====================  ACCESSORS     ======================================= */
         /*!
          * Retrieves the tile Color at given row and column.
@@ -91,7 +163,7 @@ class GameState
          * @param column The number of the column (zero-indexed).
          * @return The Color enum describing the color of the tile at given row and columns.
          */
-        Color GetColorAtOrRandom (int row, int column) const;
+        Color GetColorAtOrRandom (int row, int column);
 
 
         /*!
@@ -103,10 +175,10 @@ class GameState
 
 
         /*!
-         * Returns an enum of type Color of a linearly chosen random value other than NotAColor or DestroyedColor.
+         * Draws a color other than NotAColor or DestroyedColor from the game's seeded random generator.
          * @return Enum of type Color that is not NotAColor.
          */
-        static Color GetRandomColor();
+        Color GetRandomColor();
 
 
         /*!
@@ -139,12 +211,89 @@ class GameState
 
 
         /*!
-         * Returns the current state of animation on GameState.
-         * @return The enum of currently running animation (enum's value is Idle if no animation is currently running).
+         * Gets how many tiles of the same color in a row count as a match.
+         * @return The match size the grid was created with.
+         */
+        int GetMinMatchSize () const
+        {
+            return mMinMatchSize;
+        }
+
+
+        /*!
+         * Sums up what moves on the board, for callers that wait for it to rest or for the game to end.
+         * @return GameOver, Idle if no tile moves, else the first of SwappingTiles, DestroyingTiles and CollapsingTiles that runs.
          */
         AnimationState GetAnimationState() const
         {
-            return mAnimationState;
+            if (mIsGameOver) {
+                return GameOver;
+            }
+            if (mMovingTileCounts [Swapping] > 0) {
+                return SwappingTiles;
+            }
+            if (mMovingTileCounts [Destroying] > 0) {
+                return DestroyingTiles;
+            }
+            return mMovingTileCounts [Falling] > 0 ? CollapsingTiles : Idle;
+        }
+
+
+        /*!
+         * Counts the tiles that move a way.
+         * @param motion Swapping, Destroying or Falling.
+         * @return the number of tiles with a tween of that motion.
+         */
+        int GetMovingTileCount (Motion motion) const
+        {
+            return mMovingTileCounts [motion];
+        }
+
+
+        /*!
+         * Retrieves how the tile at an index moves.
+         * @param index the index of the tile, row * columns + column.
+         * @return the tween of the tile, with mMotion Resting if it does not move.
+         */
+        TileTween GetTileTween (int index) const;
+
+
+        /*!
+         * Answers whether a tile can be swapped or dragged: it is on the board, does not move and is not destroyed.
+         * @param row the row of the tile, may be outside the board.
+         * @param column the column of the tile, may be outside the board.
+         */
+        bool IsTileResting (int row, int column) const;
+
+
+        /*!
+         * Answers whether no tile of a column moves, so it can collapse.
+         */
+        bool IsColumnResting (int column) const;
+
+
+        /*!
+         * Gets how long until the next tween ends, see Elapse.
+         * @return time in miliseconds, 0 if a tween is due to end, the largest Uint32 if no tile moves.
+         */
+        Uint32 GetTimeToNextTweenEnd() const;
+
+
+        /*!
+         * Gets how long until the last running tween ends, if no further tween is started.
+         * @return time in miliseconds, 0 if no tile moves.
+         */
+        Uint32 GetTimeToRest() const;
+
+
+        /*!
+         * Retrieves the tile a swapped tile swaps back with if the swap makes no match, see SwapTiles.
+         * @param index the index of the swapped tile.
+         * @return the index of the other tile, -1 if the tile is not to swap back.
+         */
+        int GetSwapBackPartner (int index) const
+        {
+            return mSwapBackPartners [index];
         }
 
 
@@ -201,12 +350,19 @@ class GameState
 
 
         /*!
-         * Retrieves the displacement for dragged tile (equals -displacement for replaced tile).
-         * @return glm::vec3 with the x and y values containing the displacement.
+         * Retrieves the displacement for dragged tile (equals -displacement for replaced tile), for rendering.
+         * @return glm::vec3 with the x and y values containing the displacement in grid coordinates.
          */
         glm::vec3 GetCurrentDraggedTileDisplacement() const;
 
 
+        /*!
+         * Retrieves how far the dragged tile has moved towards the replaced tile, in fixed point.
+         * @return 0 to TILE_DISPLACEMENT_ONE, the latter meaning a whole tile; 0 if no drag is active.
+         */
+        Sint32 GetDraggedTileProgress() const;
+
+
         /*!
          * Map grid coordinates to corresponding row on the grid.
          * @param gridCoordinates glm::vec2 where x and y are elements of [0,1].
@@ -222,64 +378,80 @@ class GameState
 
 
         /*!
-         * Returns whether swap should be reversed if no matches are found.
-         * @return true if swap should be reversed at end of animation when no matches are found.
+         * Retrieves the selected tile's row.
+         * @return the row of the selected tile
+         */
+        int GetSelectedTileRow() const;
+
+
+        /*!
+         * Retrieves the selected tile's column.
+         * @return the column of the selected tile
          */
-        bool GetIsSwapBack() const;
+        int GetSelectedTileColumn() const;
 
 
         /*!
-         * Gets the current animation's progress.
-         * @return float from [0,1] with 0 meaning, the animation just started and 1 that it ended.
+         * Retrieves the leftover playable time until the game ends.
+         * @return the time left in seconds, rounded up.
          */
-        float GetAnimationPercentage() const;
+        int GetGameplayTimeLeft() const;
 
 
         /*!
-         * Answers whether a tile at location is being destroyed. Always returns false if no DestroyingTiles animation is running.
-         * @param row the row of the tile queried for.
-         * @param column the column of the tile queried for.
-         * @return true if the tile is being destroyed, false otherwise.
+         * Retrieves how many seconds of gameplay (time without animations) the game lasts.
+         * @return the game length in seconds.
          */
-        bool IsTileBeingDestroyed (int row, int column) const;
+        int GetMaxGameplayTimeSeconds() const
+        {
+            return mMaxGameplayTimeSeconds;
+        }
 
 
         /*!
-         * Retrieves the info marking columns for collapsing.
-         * @return the vector of mColumns vectors, each with 2 integers, one indicating the lowest hole in the column and the other its size.
+         * Retrieves the current score. It simply equals the number of destroyed tiles.
+         * @return current score.
          */
-        std::vector<std::vector<int>> GetColumnsToCollapse() const;
+        int GetScore() const
+        {
+            return mGameScore;
+        }
 
 
         /*!
-         * Retrieves the selected tile's row.
-         * @return the row of the selected tile
+         * Retrieves the time of the game, including animations.
+         * @return miliseconds elapsed since the game started.
          */
-        int GetSelectedTileRow() const;
+        Uint32 GetGameTime() const
+        {
+            return mGameTime;
+        }
 
 
         /*!
-         * Retrieves the selected tile's column.
-         * @return the column of the selected tile
+         * Retrieves the time of the game while tiles can be swapped, which runs out after mMaxGameplayTimeSeconds.
+         * @return miliseconds of gameplay since the game started.
          */
-        int GetSelectedTileColumn() const;
+        Uint32 GetGameplayTime() const
+        {
+            return mGameplayTime;
+        }
 
 
         /*!
-         * Retrieves the leftover playable time until the game ends.
-         * @return the time left in seconds, rounded up.
+         * Answers whether gameplay time runs: the game is not over and a tile can be swapped, or no destroy or fall holds
+         * the board, see Elapse.
          */
-        int GetGameplayTimeLeft() const;
+        bool IsGameplayTimeRunning() const;
 
 
         /*!
-         * Retrieves the current score. It simply equals the number of destroyed tiles.
-         * @return current score.
+         * Captures a resting game.
+         * @param keyframe output of the state apart from the grid.
+         * @param grid output of rows * columns colors in row major order.
+         * @return false (and nothing captured) if a tile moves or is dragged, or the game is over.
          */
-        int GetScore() const
-        {
-            return mGameScore;
-        }
+        bool GetKeyframe (Keyframe& keyframe, Uint8* grid) const;
 
 
         /* ====================  MUTATORS      ======================================= */
@@ -334,7 +506,7 @@ class GameState
 
 
         /*!
-         * Replaces the tile currently dragged.
+         * Replaces the tile currently dragged, see SwapTiles.
          * @param animationDuration time in miliseconds for the swapping animation to take.
          * @param animateFromCurrentPositionOn whether animation should be shortened based on how close to final position the tile already is.
          * @param swapBack if true, the grid at the end of swap should be checked for matches and swap is reversed if none are found.
@@ -344,15 +516,18 @@ class GameState
 
 
         /*!
-         * Runs animation to swap two given tiles.
+         * Swaps two resting tiles. The colors change places at once, the tiles slide into their new places with a
+         * Swapping tween each and are matched once they rest.
          * @param tileARow the row of tile A or first tile.
          * @param tileAColumn the column of tile A or first tile.
          * @param tileBRow the row of tile B or second tile.
          * @param tileBColumn the column of tile B or second tile.
          * @param animationDuration time in miliseconds for the swapping animation to take.
-         * @param swapBack if true, the grid at the end of swap should be checked for matches and swap is reversed if none are found.
+         * @param swapBack if true, each tile is made the other's swap back partner (see GetSwapBackPartner).
+         * @param animationHeadStart miliseconds of the animation to regard as already done, like a drag that moved the tile part of the way.
+         * @return false (and nothing swapped) if a tile is not resting.
          */
-        void SwapTiles (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationDuration, bool swapBack);
+        bool SwapTiles (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationDuration, bool swapBack, Uint32 animationHeadStart = 0);
 
 
         /*!
@@ -362,13 +537,16 @@ class GameState
 
 
         /*!
-         * Set swapback to false. Used to indicate swap caused a match.
+         * Clears the swap back partners of a tile and of its partner. Used to indicate swap caused a match.
+         * @param index the index of either tile.
          */
-        void ResetIsSwapBack();
+        void ResetSwapBack (int index);
 
 
         /*!
-         * Changes relevant variables based on mAnimationState.
+         * Advances the game time and ends the tweens due, in one pass over the tiles. The place of a destroyed tile
+         * becomes DestroyedColor, and the observers are notified once if any tween ended.
+         * Gameplay time runs while any tile can be swapped, and stops only while destroys or falls hold every tile.
          * @param deltaTime The amount of time by which to move the animation.
          */
         void Elapse (Uint32 deltaTime);
@@ -378,25 +556,46 @@ class GameState
          * Destroy tiles.
          * @param tilesToDestory vector of bool values, mGrid tiles with corresponding true value will be destroyed.
          * @param animationDuration the time the animation should take to destroy the tiles.
+         * @return false (and nothing destroyed) if a tile to destroy is not resting.
          */
-        bool DestroyTiles (std::vector<bool> tilesToDestory, Uint32 animationDuration);
+        bool DestroyTiles (const std::vector<bool>& tilesToDestory, Uint32 animationDuration);
 
 
         /*!
-         * Collapse the given columns.
-         * @param columnsToCollapse a vector of a vectors per column, each containing two integers: the first tells the number of row to collapse to, and the second how many tiles should be squished.
+         * Drops the tiles of a resting column into its DestroyedColor places, new random tiles fill it from the top.
+         * Every tile that moves gets a Falling tween from as high up as it falls.
+         * @param column the column to collapse.
          * @param animationDuration how long should the collapse animation take.
+         * @return false (and nothing collapsed) if a tile of the column moves.
          */
-        bool CollapseColumns (std::vector<std::vector<int>> columnsToCollapse, Uint32 animationDuration);
+        bool CollapseColumn (int column, Uint32 animationDuration);
 
 
         /*!
          * Adds an object implementing IGameStateGridChangeObserver interface to be notified whenever the grid is changed. (Eg. when two tiles are swapped.)
+         * At most MAX_GRID_CHANGE_OBSERVERS can be attached.
          * @param gameStateGridChangeObserver object implementing IGameStateGridChangeObserver interface.
          */
         void AttachGameStateGridChangeObserver (IGameStateGridChangeObserver* gameStateGridChangeObserver);
 
 
+        /*!
+         * Removes all observers, eg. before a pooled game is handed to another owner.
+         */
+        void DetachGameStateGridChangeObservers ()
+        {
+            mGameStateGridChangeObserverCount = 0;
+        }
+
+
+        /*!
+         * Starts a new game of the same size and rules in place, as if the game was created with the seed.
+         * Observers stay attached. Nothing is allocated.
+         * @param seed seeds the random tile colors of the new game.
+         */
+        void Reset (Uint32 seed);
+
+
         /*!
          * Sets tile at given row and column as selected.
          */
@@ -408,6 +607,24 @@ class GameState
          */
         void DeselectTile();
 
+
+        /*!
+         * Restores a game captured by GetKeyframe of a game with the same size and rules.
+         * The game is left with no tile moving, no drag or selection; observers are not notified.
+         * @param keyframe the state apart from the grid.
+         * @param grid rows * columns colors in row major order.
+         */
+        void RestoreKeyframe (const Keyframe& keyframe, const Uint8* grid);
+
+
+        /*!
+         * Makes this game an exact copy of another one, animations, drag and selection included, eg. to save and
+         * restore games for rollback. Observers are neither copied nor notified. Nothing is allocated once this game
+         * was as large as the other one.
+         * @param gameState the game to copy.
+         */
+        void CopyStateFrom (const GameState& gameState);
+
         /* ====================  OPERATORS     ======================================= */
 
     protected:
@@ -439,12 +656,51 @@ class GameState
         }
 
 
+        static bool sIsLoggingEnabled;      ///< whether informational messages are printed
+
+
         /*!
          * Notifies all mGameStateGridChangeObservers.
          */
         void NotifyGameStateGridChangeObservers();
 
 
+        /*!
+         * Points the grid and the tweens into mStorage, growing it only if the board is larger than before.
+         */
+        void ResizeStorage (int rows, int columns);
+
+
+        /*!
+         * Brings every tile to rest at its place.
+         */
+        void ClearTweens ();
+
+
+        /*!
+         * Starts the tween of a tile. A selected tile that starts to move is deselected, a dragged one is let go of.
+         * @param headStart miliseconds of the tween to regard as already done.
+         */
+        void StartTween (int index, Motion motion, Uint32 duration, Uint32 headStart, Sint32 fromX, Sint32 fromY);
+
+
+        /*!
+         * Answers whether a tile can be part of a match: it does not move and is not destroyed.
+         */
+        bool IsMatchable (int index) const
+        {
+            return Resting == mMotions [index] && DestroyedColor != mGrid [index];
+        }
+
+
+        /*!
+         * Marks the resting tiles in horizontal or vertical rows of n of the same color.
+         * @param matches output of rows * columns flags, cleared first.
+         */
+        template <class Flags>
+        void MarkMatchesOfN (int n, Flags& matches) const;
+
+
         // data for drag&drop and swap a tile
         struct TileDragData {
             TileDragData() {
@@ -458,43 +714,42 @@ class GameState
                 mReplacedTileColumn = -1;
                 mSelectedTileRow = -1;
                 mSelectedTileColumn = -1;
-                mCurrentTileDisplacement = glm::vec3 (0.0f, 0.0f, 0.0f);
-                // additional data for swap animation
-                mAnimationStartingTileDisplacement = glm::vec3 (0.0f, 0.0f, 0.0f);
-				mIsSwapBack = false;
+                mCurrentTileDisplacementX = 0;
+                mCurrentTileDisplacementY = 0;
             }
             // input data
             bool mIsActive;
             glm::vec2 mStartLocation;
             glm::vec2 mCurrentLocation;
-            // cache data inferred via call to UpdateDragCache
-            glm::vec3 mCurrentTileDisplacement;
+            // cache data inferred via call to UpdateDragCache, displacements in TILE_DISPLACEMENT_ONE per tile
+            Sint32 mCurrentTileDisplacementX, mCurrentTileDisplacementY;
             int mDraggedTileRow, mDraggedTileColumn;
             int mReplacedTileRow, mReplacedTileColumn;
             int mSelectedTileRow, mSelectedTileColumn;
-            // additional data for swap animation
-            glm::vec3 mAnimationStartingTileDisplacement;
-            bool mIsSwapBack;   ///< when true, GameStateLogic should run swapback on lack of matches after swap
         } mTileDragData;
 
-        // data for destroying tiles animation
-        std::vector<bool> mTilesBeingDestroyed;
-
-        // data for collapsing tiles animation
-        std::vector<std::vector<int>> mColumnsToCollapse;
+        // tweens of the tiles, an array per field and an element per tile, see TileTween
+        Uint32* mTweenStartTimes;
+        Uint32* mTweenDurations;
+        Sint32* mTweenFromXs;
+        Sint32* mTweenFromYs;
+        int* mSwapBackPartners;             ///< the index of the tile to swap back with on lack of matches, -1 if none
+        Uint8* mMotions;                    ///< a Motion per tile
+        Uint8* mMatches;                    ///< scratch flags for finding matches
 
         /* ====================  DATA MEMBERS  ======================================= */
-        std::vector<Color> mGrid;           ///< the board
+        std::vector<Uint8> mStorage;        ///< the block mGrid and the tween arrays are carved from
+        Color* mGrid;                       ///< the board
         int mRows, mColumns, mMinMatchSize; ///< determines the number of tiles on the board
-        AnimationState mAnimationState;     ///< current state of the GameState animation
+        bool mIsGameOver;
+        int mMovingTileCounts [MOTION_COUNT];   ///< tiles per Motion, the Resting count is not kept
         Uint32 mGameTime;                   ///< time elapsed playing this game (used for measuring animation progress)
-        Uint32 mGameplayTime;               ///< time elapsed playing this game - time spent on animations (used for measuring time left to play before game ends)
-        std::vector<class IGameStateGridChangeObserver*> mGameStateGridChangeObservers;
-        // animation data
-        Uint32 mTimeAnimationStart;
-        Uint32 mAnimationDuration;
+        Uint32 mGameplayTime;               ///< time elapsed playing this game while it is not held by destroys and falls, see Elapse (used for measuring time left to play before game ends)
+        class IGameStateGridChangeObserver* mGameStateGridChangeObservers [MAX_GRID_CHANGE_OBSERVERS];
+        int mGameStateGridChangeObserverCount;
         int mMaxGameplayTimeSeconds;
         int mGameScore;
+        GameRandom mRandom;                 ///< draws the colors of new tiles
 
 }; /* -----  end of class GameState  ----- */
 
@@ -0,0 +1,363 @@
+#include "GameStateBatch.h"
+#include <GameRandom.h>
+#include <JobSystem.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+// The block functions below work on BLOCK_SIZE boards at a time through local pointers.
+// Every inner loop runs over the boards of the block with a constant trip count and without branches,
+// which lets the compiler turn it into vector instructions (SSE2/AVX2/NEON) at -O2 and above.
+// Finished boards and the padding boards past mBoards simply take part with a zero mask.
+
+
+/*!
+ * Marks all tiles that are part of a row or column of at least minMatchSize equal colors.
+ * @param tiles the tiles of the first board of the block, cell c is at c * stride.
+ * @param matched output of cells * BLOCK_SIZE, 0xFF for matched tiles, 0 otherwise.
+ * @param hasMatch output of BLOCK_SIZE, 0xFF for boards with at least one match.
+ */
+static void FindMatchesInBlock (const Uint8* tiles, int stride, int rows, int columns, int minMatchSize, Uint8* matched, Uint8* hasMatch)
+{
+    const int BLOCK_SIZE = GameStateBatch::BLOCK_SIZE;
+    const int cells = rows * columns;
+    memset (matched, 0, static_cast<size_t>(cells) * BLOCK_SIZE);
+    Uint8 isWindowMatched [BLOCK_SIZE];
+
+    // every window of minMatchSize tiles in a row or column is compared at once for all boards,
+    // the union of equal colored windows is exactly the set of tiles in runs of minMatchSize or more
+    for (int direction = 0; direction < 2; direction++) {
+        const int cellStep = direction == 0 ? 1 : columns;
+        const int lastRow = direction == 0 ? rows : rows - minMatchSize + 1;
+        const int lastColumn = direction == 0 ? columns - minMatchSize + 1 : columns;
+        for (int row = 0; row < lastRow; row++) {
+            for (int column = 0; column < lastColumn; column++) {
+                const int firstCell = row * columns + column;
+                const Uint8* firstTiles = tiles + firstCell * stride;
+                for (int i = 0; i < BLOCK_SIZE; i++) {
+                    isWindowMatched [i] = static_cast<Uint8>(-(firstTiles [i] != 0));
+                }
+                for (int k = 1; k < minMatchSize; k++) {
+                    const Uint8* otherTiles = tiles + (firstCell + k * cellStep) * stride;
+                    for (int i = 0; i < BLOCK_SIZE; i++) {
+                        isWindowMatched [i] &= static_cast<Uint8>(-(otherTiles [i] == firstTiles [i]));
+                    }
+                }
+                for (int k = 0; k < minMatchSize; k++) {
+                    Uint8* cellMatched = matched + (firstCell + k * cellStep) * BLOCK_SIZE;
+                    for (int i = 0; i < BLOCK_SIZE; i++) {
+                        cellMatched [i] |= isWindowMatched [i];
+                    }
+                }
+            }
+        }
+    }
+
+    Uint8 isAnyMatched [BLOCK_SIZE];
+    memset (isAnyMatched, 0, sizeof (isAnyMatched));
+    for (int cell = 0; cell < cells; cell++) {
+        const Uint8* cellMatched = matched + cell * BLOCK_SIZE;
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            isAnyMatched [i] |= cellMatched [i];
+        }
+    }
+    memcpy (hasMatch, isAnyMatched, sizeof (isAnyMatched));
+}
+
+
+/*!
+ * Lets tiles fall into destroyed (0) tiles and refills the top of the columns with random colors.
+ * Boards without destroyed tiles are left unchanged and draw no random numbers.
+ * @param tiles the tiles of the first board of the block, cell c is at c * stride.
+ * @param randomStates BLOCK_SIZE GameRandom states.
+ */
+static void CollapseAndRefillBlock (Uint8* tiles, int stride, int rows, int columns, int colors, Uint32* randomStates)
+{
+    const int BLOCK_SIZE = GameStateBatch::BLOCK_SIZE;
+    Uint8 collapsed [GameStateBatch::MAX_SIDE][BLOCK_SIZE];
+    Uint8 holesBelow [BLOCK_SIZE];
+    Uint32 states [BLOCK_SIZE];
+    memcpy (states, randomStates, sizeof (states));
+
+    for (int column = 0; column < columns; column++) {
+        memset (collapsed, 0, sizeof (collapsed));
+        memset (holesBelow, 0, sizeof (holesBelow));
+        // a tile falls by the number of destroyed tiles below it; row 0 is the top of the board
+        for (int row = rows - 1; row >= 0; row--) {
+            const Uint8* rowTiles = tiles + (row * columns + column) * stride;
+            for (int targetRow = row; targetRow < rows; targetRow++) {
+                const Uint8 fallDistance = static_cast<Uint8>(targetRow - row);
+                Uint8* targetTiles = collapsed [targetRow];
+                for (int i = 0; i < BLOCK_SIZE; i++) {
+                    targetTiles [i] |= rowTiles [i] & static_cast<Uint8>(-(holesBelow [i] == fallDistance));
+                }
+            }
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                holesBelow [i] += rowTiles [i] == 0;
+            }
+        }
+        // the emptied top of the column is refilled with random colors, like GameState::GetColorAtOrRandom
+        for (int row = rows - 1; row >= 0; row--) {
+            Uint8* rowTiles = tiles + (row * columns + column) * stride;
+            const Uint8* collapsedTiles = collapsed [row];
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                const Uint32 nextState = GameRandom::Step (states [i]);
+                const Uint32 isHole = static_cast<Uint32>(-(collapsedTiles [i] == 0));
+                const Uint8 newTile = static_cast<Uint8>(1 + GameRandom::ToRange (nextState, colors));
+                states [i] = (nextState & isHole) | (states [i] & ~isHole);
+                rowTiles [i] = static_cast<Uint8>((newTile & isHole) | (collapsedTiles [i] & ~isHole));
+            }
+        }
+    }
+    memcpy (randomStates, states, sizeof (states));
+}
+
+
+GameStateBatch::GameStateBatch (int boards, int rows, int columns, int minMatchSize, int colors, int maxMoves) :
+    mBoards (boards),
+    mRows (rows),
+    mColumns (columns),
+    mMinMatchSize (minMatchSize),
+    mColors (colors),
+    mMaxMoves (maxMoves),
+    mStride ((boards + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE),
+    mCells (),
+    mRandomStates (),
+    mScores (),
+    mLastStepScores (),
+    mLastStepCascades (),
+    mMoveCounts (),
+    mIsFinished ()
+{
+    if (rows < 1 || rows > MAX_SIDE || columns < 1 || columns > MAX_SIDE) {
+        printf ("ERROR: GameStateBatch::GameStateBatch called with unsupported board size %dx%d.\n", rows, columns);
+        assert (0);
+    }
+    if (minMatchSize < 2 || colors < 2 || colors > 254) {
+        printf ("ERROR: GameStateBatch::GameStateBatch called with minMatchSize %d and colors %d.\n", minMatchSize, colors);
+        assert (0);
+    }
+    mCells.resize (static_cast<size_t>(mStride) * rows * columns, 0);
+    mRandomStates.resize (mStride, 1);
+    mScores.resize (mStride, 0);
+    mLastStepScores.resize (mStride, 0);
+    mLastStepCascades.resize (mStride, 0);
+    mMoveCounts.resize (mStride, 0);
+    mIsFinished.resize (mStride, 1);
+}
+
+
+void GameStateBatch::Reset (Uint32 seed)
+{
+    Uint8 isSelected [BLOCK_SIZE];
+    memset (isSelected, 0xFF, sizeof (isSelected));
+    for (int board = 0; board < mStride; board++) {
+        mRandomStates [board] = GameRandom::SeedToState (seed + static_cast<Uint32>(board));
+        mScores [board] = 0;
+        mLastStepScores [board] = 0;
+        mLastStepCascades [board] = 0;
+        mMoveCounts [board] = 0;
+        mIsFinished [board] = (board < mBoards && mMaxMoves > 0) ? 0 : 1;
+    }
+    for (int firstBoard = 0; firstBoard < mStride; firstBoard += BLOCK_SIZE) {
+        RandomizeBlock (firstBoard, isSelected);
+    }
+}
+
+
+void GameStateBatch::ResetBoard (int board, Uint32 seed)
+{
+    Uint8 isSelected [BLOCK_SIZE];
+    memset (isSelected, 0, sizeof (isSelected));
+    isSelected [board % BLOCK_SIZE] = 0xFF;
+    mRandomStates [board] = GameRandom::SeedToState (seed);
+    mScores [board] = 0;
+    mLastStepScores [board] = 0;
+    mLastStepCascades [board] = 0;
+    mMoveCounts [board] = 0;
+    mIsFinished [board] = mMaxMoves > 0 ? 0 : 1;
+    RandomizeBlock (board - board % BLOCK_SIZE, isSelected);
+}
+
+
+void GameStateBatch::ResetBoards (const Uint8* isSelected, const Uint32* seeds, int firstBlock, int endBlock)
+{
+    for (int block = firstBlock; block < endBlock; block++) {
+        const int firstBoard = block * BLOCK_SIZE;
+        Uint8 isBlockBoardSelected [BLOCK_SIZE];
+        bool isAnySelected = false;
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            const int board = firstBoard + i;
+            isBlockBoardSelected [i] = (board < mBoards && isSelected [board]) ? 0xFF : 0;
+            if (!isBlockBoardSelected [i]) {
+                continue;
+            }
+            isAnySelected = true;
+            mRandomStates [board] = GameRandom::SeedToState (seeds [board]);
+            mScores [board] = 0;
+            mLastStepScores [board] = 0;
+            mLastStepCascades [board] = 0;
+            mMoveCounts [board] = 0;
+            mIsFinished [board] = mMaxMoves > 0 ? 0 : 1;
+        }
+        if (isAnySelected) {
+            RandomizeBlock (firstBoard, isBlockBoardSelected);
+        }
+    }
+}
+
+
+void GameStateBatch::Step (const int* moves)
+{
+    StepBlocks (moves, 0, GetBlocks());
+}
+
+
+void GameStateBatch::Step (const int* moves, JobSystem& jobSystem)
+{
+    // a few blocks per job keep the scheduling overhead small compared to the work
+    jobSystem.ParallelFor (GetBlocks(), 4, [this, moves] (int firstBlock, int endBlock) {
+        StepBlocks (moves, firstBlock, endBlock);
+    });
+}
+
+
+void GameStateBatch::StepBlocks (const int* moves, int firstBlock, int endBlock)
+{
+    for (int block = firstBlock; block < endBlock; block++) {
+        StepBlock (moves, block * BLOCK_SIZE);
+    }
+}
+
+
+void GameStateBatch::RandomizeBlock (int firstBoard, const Uint8* isSelected)
+{
+    const int cells = mRows * mColumns;
+    const int stride = mStride;
+    const int colors = mColors;
+    Uint8* tiles = &mCells [firstBoard];
+    Uint32 states [BLOCK_SIZE];
+    memcpy (states, &mRandomStates [firstBoard], sizeof (states));
+
+    Uint8 reroll [BLOCK_SIZE];
+    memcpy (reroll, isSelected, sizeof (reroll));
+    Uint8 matched [MAX_CELLS * BLOCK_SIZE];
+    memset (matched, 0xFF, static_cast<size_t>(cells) * BLOCK_SIZE);
+    bool isAnyMatch = true;
+    while (isAnyMatch) {
+        // the first round rolls every tile of the selected boards, later rounds reroll only matched tiles,
+        // like GameState::ResetGridToRandomNoNMatches
+        for (int cell = 0; cell < cells; cell++) {
+            Uint8* cellTiles = tiles + cell * stride;
+            const Uint8* cellMatched = matched + cell * BLOCK_SIZE;
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                const Uint32 nextState = GameRandom::Step (states [i]);
+                const Uint32 isRolled = static_cast<Uint32>(-((cellMatched [i] & reroll [i]) != 0));
+                const Uint8 newTile = static_cast<Uint8>(1 + GameRandom::ToRange (nextState, colors));
+                states [i] = (nextState & isRolled) | (states [i] & ~isRolled);
+                cellTiles [i] = static_cast<Uint8>((newTile & isRolled) | (cellTiles [i] & ~isRolled));
+            }
+        }
+        Uint8 hasMatch [BLOCK_SIZE];
+        FindMatchesInBlock (tiles, stride, mRows, mColumns, mMinMatchSize, matched, hasMatch);
+        isAnyMatch = false;
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            reroll [i] &= hasMatch [i];
+            isAnyMatch = isAnyMatch || reroll [i];
+        }
+    }
+    memcpy (&mRandomStates [firstBoard], states, sizeof (states));
+}
+
+
+void GameStateBatch::StepBlock (const int* moves, int firstBoard)
+{
+    const int cells = mRows * mColumns;
+    const int stride = mStride;
+    Uint8* tiles = &mCells [firstBoard];
+    Uint8 isActive [BLOCK_SIZE];
+    Uint8 hasMatch [BLOCK_SIZE];
+    int swappedCellA [BLOCK_SIZE];
+    int swappedCellB [BLOCK_SIZE];
+    int scores [BLOCK_SIZE];
+    int cascades [BLOCK_SIZE];
+    Uint8 matched [MAX_CELLS * BLOCK_SIZE];
+
+    // moves differ per board, so the swap itself is a scalar gather and scatter
+    bool isAnyActive = false;
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        const int board = firstBoard + i;
+        isActive [i] = 0;
+        scores [i] = 0;
+        cascades [i] = 0;
+        if (board >= mBoards || mIsFinished [board] || moves [board] < 0) {
+            continue;
+        }
+        const int move = moves [board];
+        const int row = (move / 2) / MAX_SIDE;
+        const int column = (move / 2) % MAX_SIDE;
+        const bool isVertical = (move & 1) != 0;
+        const int otherRow = isVertical ? row + 1 : row;
+        const int otherColumn = isVertical ? column : column + 1;
+        if (row >= mRows || column >= mColumns || otherRow >= mRows || otherColumn >= mColumns) {
+            continue;
+        }
+        swappedCellA [i] = row * mColumns + column;
+        swappedCellB [i] = otherRow * mColumns + otherColumn;
+        std::swap (tiles [swappedCellA [i] * stride + i], tiles [swappedCellB [i] * stride + i]);
+        isActive [i] = 0xFF;
+        isAnyActive = true;
+        mMoveCounts [board]++;
+    }
+
+    bool isFirstRound = true;
+    while (isAnyActive) {
+        FindMatchesInBlock (tiles, stride, mRows, mColumns, mMinMatchSize, matched, hasMatch);
+        if (isFirstRound) {
+            // swaps that did not create a match are swapped back, like GameStateLogic::Update does
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                if (isActive [i] && !hasMatch [i]) {
+                    std::swap (tiles [swappedCellA [i] * stride + i], tiles [swappedCellB [i] * stride + i]);
+                }
+            }
+            isFirstRound = false;
+        }
+        isAnyActive = false;
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            isActive [i] &= hasMatch [i];
+            cascades [i] += isActive [i] & 1;
+            isAnyActive = isAnyActive || isActive [i];
+        }
+        if (!isAnyActive) {
+            break;
+        }
+        // destroy matched tiles of the active boards, every destroyed tile is a point
+        for (int cell = 0; cell < cells; cell++) {
+            Uint8* cellTiles = tiles + cell * stride;
+            const Uint8* cellMatched = matched + cell * BLOCK_SIZE;
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                const Uint8 isDestroyed = cellMatched [i] & isActive [i];
+                scores [i] += isDestroyed & 1;
+                cellTiles [i] &= static_cast<Uint8>(~isDestroyed);
+            }
+        }
+        CollapseAndRefillBlock (tiles, stride, mRows, mColumns, mColors, &mRandomStates [firstBoard]);
+    }
+
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        const int board = firstBoard + i;
+        mScores [board] += scores [i];
+        mLastStepScores [board] = scores [i];
+        mLastStepCascades [board] = cascades [i];
+        mIsFinished [board] = (board >= mBoards || mMoveCounts [board] >= mMaxMoves) ? 1 : 0;
+    }
+}
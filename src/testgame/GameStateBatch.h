@@ -0,0 +1,233 @@
+#pragma once
+#include <vector>
+
+class JobSystem;
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Steps many boards in lockstep using the rules of GameStateLogic without animations.
+ * Boards are stored as structure-of-arrays: the tiles of one cell position are contiguous across all boards,
+ * so matching, destroying, collapsing and refilling run as straight loops over boards that the compiler vectorizes.
+ * Tile values follow GameState::Color (1 to colors), 0 marks a destroyed tile while a step is resolved.
+ * A board is finished once it has used its move budget; finished boards are masked out of further steps.
+ */
+class GameStateBatch
+{
+    public:
+        /// the maximum number of rows or columns of a board
+        static const int MAX_SIDE = 16;
+        /// the maximum number of tiles on a board
+        static const int MAX_CELLS = MAX_SIDE * MAX_SIDE;
+        /// the number of boards resolved together, sized so the per block scratch stays in L1 cache
+        static const int BLOCK_SIZE = 64;
+        /// move value for boards that should not move this step
+        static const int NO_MOVE = -1;
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates boards in lockstep. Call Reset before the first Step.
+         * @param boards number of boards in the batch.
+         * @param rows rows of each board, at most MAX_SIDE.
+         * @param columns columns of each board, at most MAX_SIDE.
+         * @param minMatchSize how many tiles of same color in a row are a match, at least 2.
+         * @param colors number of tile colors, from 2 to 254.
+         * @param maxMoves move budget of a board after which it is finished.
+         */
+        GameStateBatch (int boards, int rows, int columns, int minMatchSize, int colors, int maxMoves);
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Encodes a swap of a tile with its right or lower neighbour as a move value for Step.
+         * @param row the row of the tile.
+         * @param column the column of the tile.
+         * @param isVertical swap with the tile below if true, with the tile to the right otherwise.
+         * @return the move value.
+         */
+        static int EncodeMove (int row, int column, bool isVertical)
+        {
+            return (row * MAX_SIDE + column) * 2 + (isVertical ? 1 : 0);
+        }
+
+        int GetBoards () const
+        {
+            return mBoards;
+        }
+
+        int GetRows () const
+        {
+            return mRows;
+        }
+
+        int GetColumns () const
+        {
+            return mColumns;
+        }
+
+        int GetColors () const
+        {
+            return mColors;
+        }
+
+
+        /*!
+         * Retrieves the tile color of a board.
+         * @return the GameState::Color value of the tile.
+         */
+        Uint8 GetColorAt (int board, int row, int column) const
+        {
+            return mCells [(row * mColumns + column) * mStride + board];
+        }
+
+
+        /*!
+         * Retrieves the tiles of one cell position (row * columns + column) of all boards.
+         * @return pointer to GetBoards() contiguous tile colors.
+         */
+        const Uint8* GetCellAcrossBoards (int cell) const
+        {
+            return &mCells [cell * mStride];
+        }
+
+
+        /*!
+         * Retrieves the total score of a board. Like GameState, every destroyed tile is worth a point.
+         */
+        int GetScore (int board) const
+        {
+            return mScores [board];
+        }
+
+
+        /*!
+         * Retrieves the points scored by the board during the last Step.
+         */
+        int GetLastStepScore (int board) const
+        {
+            return mLastStepScores [board];
+        }
+
+
+        /*!
+         * Retrieves how many destroy and collapse rounds the last move of the board caused.
+         */
+        int GetLastStepCascades (int board) const
+        {
+            return mLastStepCascades [board];
+        }
+
+
+        /*!
+         * Retrieves how many valid moves were applied to the board since its reset.
+         */
+        int GetMoveCount (int board) const
+        {
+            return mMoveCounts [board];
+        }
+
+
+        /*!
+         * Answers whether the board used up its move budget.
+         */
+        bool IsFinished (int board) const
+        {
+            return mIsFinished [board] != 0;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Resets all boards to random grids without matches.
+         * @param seed seed for the per board random generators, board i uses seed + i.
+         */
+        void Reset (Uint32 seed);
+
+
+        /*!
+         * Resets one board to a random grid without matches and clears its score and moves.
+         * @param board the board to reset.
+         * @param seed the seed for the random generator of the board.
+         */
+        void ResetBoard (int board, Uint32 seed);
+
+
+        /*!
+         * Resets the selected boards of blocks [firstBlock, endBlock) to random grids without matches,
+         * all selected boards of a block in one pass. Disjoint block ranges may be reset concurrently.
+         * @param isSelected GetBoards() values, non-zero for boards to reset, only the ones of the blocks are read.
+         * @param seeds GetBoards() seeds, only the ones of selected boards are read.
+         */
+        void ResetBoards (const Uint8* isSelected, const Uint32* seeds, int firstBlock, int endBlock);
+
+
+        /*!
+         * Applies one move to every board and resolves all resulting matches and collapses.
+         * Invalid moves, NO_MOVE and moves of finished boards are ignored. Swaps without a match are swapped back.
+         * @param moves GetBoards() move values made with EncodeMove or NO_MOVE.
+         */
+        void Step (const int* moves);
+
+
+        /*!
+         * Same as Step (moves), limited to the boards of blocks [firstBlock, endBlock). Block b holds boards [b * BLOCK_SIZE, (b + 1) * BLOCK_SIZE).
+         * Disjoint block ranges may be stepped concurrently from different threads.
+         * @param moves GetBoards() move values, only the ones of the blocks are read.
+         */
+        void StepBlocks (const int* moves, int firstBlock, int endBlock);
+
+
+        /*!
+         * Same as Step (moves), with the blocks spread over the workers of the job system. Returns when all boards are stepped.
+         * @param moves GetBoards() move values made with EncodeMove or NO_MOVE.
+         * @param jobSystem the job system to run the blocks on.
+         */
+        void Step (const int* moves, JobSystem& jobSystem);
+
+
+        /*!
+         * Retrieves the number of blocks the boards are split into for StepBlocks.
+         */
+        int GetBlocks () const
+        {
+            return mStride / BLOCK_SIZE;
+        }
+
+    private:
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Applies the moves and resolves the cascades for the BLOCK_SIZE boards starting at firstBoard.
+         */
+        void StepBlock (const int* moves, int firstBoard);
+
+
+        /*!
+         * Fills selected boards of a block with random tiles and rerolls matched tiles until no match is left.
+         * @param firstBoard the first board of the block.
+         * @param isSelected BLOCK_SIZE values, 0xFF for boards to randomize, 0 for boards to keep.
+         */
+        void RandomizeBlock (int firstBoard, const Uint8* isSelected);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mBoards, mRows, mColumns, mMinMatchSize, mColors, mMaxMoves;
+        int mStride;                        ///< mBoards rounded up to BLOCK_SIZE, the boards past mBoards are always finished
+        std::vector<Uint8> mCells;          ///< cell major: the tile of cell c on board b is at c * mStride + b
+        std::vector<Uint32> mRandomStates;  ///< one GameRandom state per board
+        std::vector<int> mScores;
+        std::vector<int> mLastStepScores;
+        std::vector<int> mLastStepCascades;
+        std::vector<int> mMoveCounts;
+        std::vector<Uint8> mIsFinished;
+
+}; /* -----  end of class GameStateBatch  ----- */
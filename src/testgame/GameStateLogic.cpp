@@ -1,7 +1,10 @@
 #include "GameStateLogic.h"
 #include <vector>
+#include <math.h>
 #include <stdio.h>
 #include <GameStateRenderer.h>
+#include <Replay.h>
+#include <AutosaveJournal.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -12,130 +15,259 @@ const Uint32 GameStateLogic::MIN_MATCH_SIZE = 3;
 /*!
  * Reacts to an input event.
  */
-void GameStateLogic::Input (SDL_Event& e, GameState& gameState) const
+void GameStateLogic::Input (SDL_Event& e, GameState& gameState)
 {
     if (gameState.GetAnimationState() == GameState::GameOver) {
         return;
     }
-    if (mIsToCheckGameGrid) {
-        // ignore input while game animations are running
+    if (e.type == SDL_MOUSEBUTTONUP && mBusyPressRow != -1) {
+        // the mouse went down on a moving tile, the swap or click waits until its tiles rest
+        BufferInput (e, gameState);
+        if (IsBufferedInputReady (gameState)) {
+            ApplyBufferedInput (gameState);
+        }
         return;
     }
     if (e.type == SDL_MOUSEMOTION) {
-        // only process mouse click if no animation is already running
-        if (GameState::Idle == gameState.GetAnimationState()) {
-            // ask gameState whether it has an active drag
-            if (gameState.IsDragActive()) {
-                // ask renderer for mouse up location in grid space based on screen space location
-                glm::vec2 gridCoordinates = GameStateRenderer::GetGridCoordinatesFromScreenLocation(e.motion.x, e.motion.y);
-                // save the current grid coordinates to gameState.
-                gameState.SetDragCurrentLocation (gridCoordinates);
-            }
-        }
-    } else if (e.type == SDL_MOUSEBUTTONDOWN) {
-        // only process mouse click if no animation is already running
-        if (GameState::Idle == gameState.GetAnimationState()) {
+        // ask gameState whether it has an active drag
+        if (gameState.IsDragActive()) {
             // ask renderer for mouse up location in grid space based on screen space location
             glm::vec2 gridCoordinates = GameStateRenderer::GetGridCoordinatesFromScreenLocation(e.motion.x, e.motion.y);
-            // store grid mousedown location on gameState and set drag motion to active
-            gameState.SetDragStartLocation (gridCoordinates);
+            // save the current grid coordinates to gameState.
+            gameState.SetDragCurrentLocation (gridCoordinates);
         }
+    } else if (e.type == SDL_MOUSEBUTTONDOWN) {
+        mBusyPressRow = -1;
+        mBusyPressColumn = -1;
+        // ask renderer for mouse up location in grid space based on screen space location
+        glm::vec2 gridCoordinates = GameStateRenderer::GetGridCoordinatesFromScreenLocation(e.motion.x, e.motion.y);
+        const int row = gameState.GetRowOfGridCoordinates (gridCoordinates);
+        const int column = gameState.GetColumnOfGridCoordinates (gridCoordinates);
+        if (row >= 0 && row < gameState.GetRows() && column >= 0 && column < gameState.GetColumns() && !gameState.IsTileResting (row, column)) {
+            // a moving tile takes no swap, Update applies what the player does with it
+            BufferInput (e, gameState);
+            return;
+        }
+        // store grid mousedown location on gameState and set drag motion to active
+        gameState.SetDragStartLocation (gridCoordinates);
     } else if (e.type == SDL_MOUSEBUTTONUP) {
-        // only process mouse click if no animation is already running
-        if (GameState::Idle == gameState.GetAnimationState()) {
-            if (gameState.IsDragActive()) {
-                glm::vec2 gridCoordinates = GameStateRenderer::GetGridCoordinatesFromScreenLocation(e.motion.x, e.motion.y);
-                gameState.SetDragCurrentLocation (gridCoordinates);
-                // align with game state whether the drag was such that two tiles should be switched
-                glm::vec3 currentTileDisplacement = gameState.GetCurrentDraggedTileDisplacement();
-                if (fabs(currentTileDisplacement.x) >= 1.0f/static_cast<float>(gameState.GetColumns())/2 ||
-                        fabs(currentTileDisplacement.y) >= 1.0f/static_cast<float>(gameState.GetRows())/2) {
-                    bool isSuccessful = gameState.SwapDraggedAndReplacedTiles(ANIMATION_DURATION_MILIS, true, true);
-
+        if (gameState.IsDragActive()) {
+            glm::vec2 gridCoordinates = GameStateRenderer::GetGridCoordinatesFromScreenLocation(e.motion.x, e.motion.y);
+            gameState.SetDragCurrentLocation (gridCoordinates);
+            // align with game state whether the drag was such that two tiles should be switched
+            if (gameState.GetDraggedTileProgress() >= GameState::TILE_DISPLACEMENT_ONE / 2) {
+                // the drag ends with the swap, so its tiles are taken first
+                const int draggedTileRow = gameState.GetDraggedTileRow();
+                const int draggedTileColumn = gameState.GetDraggedTileColumn();
+                const int replacedTileRow = gameState.GetReplacedTileRow();
+                const int replacedTileColumn = gameState.GetReplacedTileColumn();
+                bool isSuccessful = false;
+                if (!gameState.IsTileResting (replacedTileRow, replacedTileColumn)) {
+                    // the tile dragged onto moves, Update swaps once it rests
+                    mBufferedTileARow = draggedTileRow;
+                    mBufferedTileAColumn = draggedTileColumn;
+                    mBufferedTileBRow = replacedTileRow;
+                    mBufferedTileBColumn = replacedTileColumn;
                 } else {
-                    // check whether it is a click
-                    // it is a click if up is on the same tile as down
-                    int tileMouseDownRow = gameState.GetDraggedTileRow();
-                    int tileMouseDownColumn = gameState.GetDraggedTileColumn();
-                    int tileMouseUpRow = gameState.GetRowOfGridCoordinates(gridCoordinates);
-                    int tileMouseUpColumn = gameState.GetColumnOfGridCoordinates(gridCoordinates);
-                    if (tileMouseUpRow == tileMouseDownRow && tileMouseUpColumn == tileMouseDownColumn) {
-                        // check if selected to be tile is next to selected tile
-                        int currentlySelectedTileRow = gameState.GetSelectedTileRow();
-                        int currentlySelectedTileColumn = gameState.GetSelectedTileColumn();
-                        if ((currentlySelectedTileRow == tileMouseUpRow && abs(currentlySelectedTileColumn - tileMouseUpColumn) < 2) ||
- (currentlySelectedTileColumn == tileMouseUpColumn && abs(currentlySelectedTileRow - tileMouseUpRow) < 2)) {
-                            gameState.SwapTiles(tileMouseUpRow, tileMouseUpColumn, currentlySelectedTileRow, currentlySelectedTileColumn, ANIMATION_DURATION_MILIS, true);
-                        } else {
-                            // otherwise set this as selected
-                            gameState.SelectTile(tileMouseUpRow, tileMouseUpColumn);
-                        }
+                    isSuccessful = gameState.SwapDraggedAndReplacedTiles(ANIMATION_DURATION_MILIS, true, true);
+                }
+                if (isSuccessful) {
+                    const Uint32 animationHeadStart = gameState.GetGameTime() -
+                        gameState.GetTileTween (draggedTileRow * gameState.GetColumns() + draggedTileColumn).mStartTime;
+                    if (mReplayRecorder != NULL) {
+                        mReplayRecorder->RecordSwap (draggedTileRow, draggedTileColumn, replacedTileRow, replacedTileColumn, animationHeadStart, gameState);
+                    }
+                    if (mAutosaveJournal != NULL) {
+                        mAutosaveJournal->RecordSwap (draggedTileRow, draggedTileColumn, replacedTileRow, replacedTileColumn, animationHeadStart, gameState);
+                    }
+                }
+
+            } else {
+                // check whether it is a click
+                // it is a click if up is on the same tile as down
+                int tileMouseDownRow = gameState.GetDraggedTileRow();
+                int tileMouseDownColumn = gameState.GetDraggedTileColumn();
+                int tileMouseUpRow = gameState.GetRowOfGridCoordinates(gridCoordinates);
+                int tileMouseUpColumn = gameState.GetColumnOfGridCoordinates(gridCoordinates);
+                if (tileMouseUpRow == tileMouseDownRow && tileMouseUpColumn == tileMouseDownColumn) {
+                    // swap if selected to be tile is next to selected tile
+                    int currentlySelectedTileRow = gameState.GetSelectedTileRow();
+                    int currentlySelectedTileColumn = gameState.GetSelectedTileColumn();
+                    if (!RequestSwap (tileMouseUpRow, tileMouseUpColumn, currentlySelectedTileRow, currentlySelectedTileColumn, gameState)) {
+                        // otherwise set this as selected
+                        gameState.SelectTile(tileMouseUpRow, tileMouseUpColumn);
                     }
                 }
-                // deactivate drag because of mouse up event
-                gameState.DeactivateDrag();
             }
+            // deactivate drag because of mouse up event
+            gameState.DeactivateDrag();
         }
     }
 }		/* -----  end of function Input  ----- */
 
 
+void GameStateLogic::BufferInput (const SDL_Event& e, const GameState& gameState)
+{
+    if (e.type == SDL_MOUSEBUTTONDOWN) {
+        mBusyPressLocation = GameStateRenderer::GetGridCoordinatesFromScreenLocation (e.button.x, e.button.y);
+        mBusyPressRow = gameState.GetRowOfGridCoordinates (mBusyPressLocation);
+        mBusyPressColumn = gameState.GetColumnOfGridCoordinates (mBusyPressLocation);
+    } else if (e.type == SDL_MOUSEBUTTONUP && mBusyPressRow != -1) {
+        // a drag of at least half a tile swaps with the neighbour it points to, like a drag on a resting board
+        glm::vec2 gridCoordinates = GameStateRenderer::GetGridCoordinatesFromScreenLocation (e.button.x, e.button.y);
+        glm::vec2 dragTiles = (gridCoordinates - mBusyPressLocation) * glm::vec2 (gameState.GetColumns(), gameState.GetRows());
+        mBufferedTileARow = mBusyPressRow;
+        mBufferedTileAColumn = mBusyPressColumn;
+        mBufferedTileBRow = -1;
+        mBufferedTileBColumn = -1;
+        if (fabs (dragTiles.x) >= 0.5f || fabs (dragTiles.y) >= 0.5f) {
+            const bool isHorizontal = fabs (dragTiles.x) > fabs (dragTiles.y);
+            mBufferedTileBRow = mBusyPressRow + (isHorizontal ? 0 : (dragTiles.y > 0.0f ? 1 : -1));
+            mBufferedTileBColumn = mBusyPressColumn + (isHorizontal ? (dragTiles.x > 0.0f ? 1 : -1) : 0);
+        } else if (gameState.GetRowOfGridCoordinates (gridCoordinates) != mBusyPressRow ||
+                gameState.GetColumnOfGridCoordinates (gridCoordinates) != mBusyPressColumn) {
+            // neither a drag nor a click
+            mBufferedTileARow = -1;
+            mBufferedTileAColumn = -1;
+        }
+        mBusyPressRow = -1;
+        mBusyPressColumn = -1;
+    }
+}
+
+
+bool GameStateLogic::IsBufferedInputReady (const GameState& gameState) const
+{
+    if (!gameState.IsTileResting (mBufferedTileARow, mBufferedTileAColumn)) {
+        return false;
+    }
+    // a swap off the board is dropped right away
+    const bool isTileBOnBoard = mBufferedTileBRow >= 0 && mBufferedTileBRow < gameState.GetRows() &&
+        mBufferedTileBColumn >= 0 && mBufferedTileBColumn < gameState.GetColumns();
+    return !isTileBOnBoard || gameState.IsTileResting (mBufferedTileBRow, mBufferedTileBColumn);
+}
+
+
+void GameStateLogic::ApplyBufferedInput (GameState& gameState)
+{
+    const int tileARow = mBufferedTileARow;
+    const int tileAColumn = mBufferedTileAColumn;
+    const int tileBRow = mBufferedTileBRow;
+    const int tileBColumn = mBufferedTileBColumn;
+    mBufferedTileARow = -1;
+    mBufferedTileAColumn = -1;
+    if (tileARow == -1 || gameState.IsDragActive()) {
+        return;
+    }
+    if (tileBRow != -1) {
+        RequestSwap (tileARow, tileAColumn, tileBRow, tileBColumn, gameState);
+    } else if (!RequestSwap (tileARow, tileAColumn, gameState.GetSelectedTileRow(), gameState.GetSelectedTileColumn(), gameState)) {
+        // a click swaps with the selected tile next to it, or selects the tile
+        gameState.SelectTile (tileARow, tileAColumn);
+    }
+}
+
+
+bool GameStateLogic::RequestSwap (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, GameState& gameState, Uint32 animationHeadStart) const
+{
+    if (gameState.GetAnimationState() == GameState::GameOver) {
+        return false;
+    }
+    if (abs (tileARow - tileBRow) + abs (tileAColumn - tileBColumn) != 1) {
+        return false;
+    }
+    // off the board tiles never rest
+    if (!gameState.IsTileResting (tileARow, tileAColumn) || !gameState.IsTileResting (tileBRow, tileBColumn)) {
+        return false;
+    }
+    gameState.SwapTiles (tileARow, tileAColumn, tileBRow, tileBColumn, ANIMATION_DURATION_MILIS, true, animationHeadStart);
+    if (mReplayRecorder != NULL) {
+        mReplayRecorder->RecordSwap (tileARow, tileAColumn, tileBRow, tileBColumn, animationHeadStart, gameState);
+    }
+    if (mAutosaveJournal != NULL) {
+        mAutosaveJournal->RecordSwap (tileARow, tileAColumn, tileBRow, tileBColumn, animationHeadStart, gameState);
+    }
+    return true;
+}
+
+
 bool GameStateLogic::Update (Uint32 deltaTime, GameState& gameState)
 {
     bool isSuccessful = true;
 
-    gameState.Elapse (deltaTime);
-    if (gameState.GetAnimationState() == GameState::GameOver) {
-        return true;
-    }
-    while (mIsToCheckGameGrid) {
-        mIsToCheckGameGrid = false;
-        std::vector<bool> tilesToDestroy = gameState.GetMatchesOfN (MIN_MATCH_SIZE);
-        bool isToDestroy = false;
-        bool isToCollapse = false;
-        int counter = 0;
-        // analyse how GameStateLogic should react to the changed GameState's grid
-        while (counter < tilesToDestroy.size()) {
-            isToDestroy = isToDestroy || tilesToDestroy[counter];
-            if (gameState.GetColorAt(counter) == GameState::DestroyedColor) {
-                isToCollapse = true;
-            };
-            counter++;
+    // a swap made on moving tiles starts as soon as they rest
+    if (IsInputBuffered() && IsBufferedInputReady (gameState)) {
+        ApplyBufferedInput (gameState);
+    }
+    if (mReplayRecorder != NULL) {
+        mReplayRecorder->RecordUpdate (deltaTime, gameState, mIsToCheckGameGrid);
+    }
+    // the grid is checked at the very game time an animation ends, not at the end of the update
+    Uint32 timeLeft = deltaTime;
+    do {
+        const Uint32 timeToNextTweenEnd = gameState.GetTimeToNextTweenEnd();
+        const Uint32 elapsedTime = timeToNextTweenEnd < timeLeft ? timeToNextTweenEnd : timeLeft;
+        gameState.Elapse (elapsedTime);
+        timeLeft -= elapsedTime;
+        if (gameState.GetAnimationState() == GameState::GameOver) {
+            break;
         }
-        if (isToCollapse) {
-            int scoreToAdd = 0;
-            std::vector<std::vector<int>> columnsToCollapse;
-            columnsToCollapse.resize (gameState.GetColumns());
-            for (int currentColumn = 0; currentColumn < gameState.GetColumns(); currentColumn++) {
-                columnsToCollapse [currentColumn] = std::vector<int>{-1,1};
-
-                for (int currentRow = gameState.GetRows()-1; currentRow > -1; currentRow--) {
-                    if (gameState.GetColorAt(currentRow, currentColumn) == GameState::DestroyedColor) {
-                        scoreToAdd++;
-                        if (columnsToCollapse[currentColumn][0] == -1) {
-                            columnsToCollapse[currentColumn][0] = currentRow;
-                        } else {
-                            columnsToCollapse[currentColumn][1]++;
-                        }
-                    } else {
-                        if (columnsToCollapse[currentColumn][0] != -1) {
-                            currentRow = -1;
-                        }
-                    }
-                }
+        if (mIsToCheckGameGrid) {
+            mIsToCheckGameGrid = false;
+            isSuccessful = CheckGameGrid (gameState) && isSuccessful;
+        }
+    } while (timeLeft > 0);
+    if (mAutosaveJournal != NULL) {
+        mAutosaveJournal->RecordUpdate (gameState, mIsToCheckGameGrid);
+    }
+
+    return isSuccessful;
+}
 
+
+bool GameStateLogic::CheckGameGrid (GameState& gameState)
+{
+    bool isSuccessful = true;
+    // a column falls once its destroyed tiles are gone, whatever the other columns do
+    for (int currentColumn = 0; currentColumn < gameState.GetColumns(); currentColumn++) {
+        if (!gameState.IsColumnResting (currentColumn)) {
+            continue;
+        }
+        int destroyedTileCount = 0;
+        for (int currentRow = 0; currentRow < gameState.GetRows(); currentRow++) {
+            if (gameState.GetColorAt (currentRow, currentColumn) == GameState::DestroyedColor) {
+                destroyedTileCount++;
             }
-            isSuccessful = isSuccessful && gameState.CollapseColumns (columnsToCollapse, ANIMATION_DURATION_MILIS);
-            gameState.AddToScore(scoreToAdd);
-        } else if (isToDestroy) {
-            gameState.ResetIsSwapBack();
-            isSuccessful = isSuccessful && gameState.DestroyTiles (tilesToDestroy , ANIMATION_DURATION_MILIS);
-        } else if (gameState.GetIsSwapBack()) {
-            gameState.SwapTiles (gameState.GetDraggedTileRow(), gameState.GetDraggedTileColumn(), gameState.GetReplacedTileRow(), gameState.GetReplacedTileColumn(), ANIMATION_DURATION_MILIS, false);
-            gameState.ResetIsSwapBack();
+        }
+        if (destroyedTileCount > 0) {
+            isSuccessful = gameState.CollapseColumn (currentColumn, ANIMATION_DURATION_MILIS) && isSuccessful;
+            gameState.AddToScore (destroyedTileCount);
+        }
+    }
+    // only resting tiles match, the tiles in motion are checked again when they come to rest
+    std::vector<bool> tilesToDestroy = gameState.GetMatchesOfN (MIN_MATCH_SIZE);
+    for (size_t index = 0; index < tilesToDestroy.size(); index++) {
+        if (tilesToDestroy [index]) {
+            isSuccessful = gameState.DestroyTiles (tilesToDestroy, ANIMATION_DURATION_MILIS) && isSuccessful;
+            break;
+        }
+    }
+    // a swap that made no match goes back, one that did is not to
+    for (int index = 0; index < gameState.GetRows() * gameState.GetColumns(); index++) {
+        const int partner = gameState.GetSwapBackPartner (index);
+        if (partner < index) {
+            continue;
+        }
+        const GameState::Motion motion = gameState.GetTileTween (index).mMotion;
+        const GameState::Motion partnerMotion = gameState.GetTileTween (partner).mMotion;
+        if (GameState::Destroying == motion || GameState::Destroying == partnerMotion) {
+            gameState.ResetSwapBack (index);
+        } else if (GameState::Resting == motion && GameState::Resting == partnerMotion) {
+            gameState.ResetSwapBack (index);
+            gameState.SwapTiles (index / gameState.GetColumns(), index % gameState.GetColumns(),
+                    partner / gameState.GetColumns(), partner % gameState.GetColumns(), ANIMATION_DURATION_MILIS, false);
         }
     }
-
     return isSuccessful;
 }
 
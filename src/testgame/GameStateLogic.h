@@ -2,6 +2,9 @@
 #include <vector>
 #include <GameState.h>
 
+class ReplayRecorder;
+class AutosaveJournal;
+
 #ifdef TARGET_MSVC
     #include <SDL.h>
 #endif
@@ -17,25 +20,71 @@ class GameStateLogic : public IGameStateGridChangeObserver
 {
     public:
         /* ====================  LIFECYCLE     ======================================= */
-        GameStateLogic () :mIsToCheckGameGrid(false)
+        GameStateLogic () :mIsToCheckGameGrid(false), mReplayRecorder(NULL), mAutosaveJournal(NULL),
+            mBusyPressRow(-1), mBusyPressColumn(-1), mBufferedTileARow(-1), mBufferedTileAColumn(-1), mBufferedTileBRow(-1), mBufferedTileBColumn(-1)
         {
         }                            /* constructor */
 
 
         /* ====================  ACCESSORS     ======================================= */
 
+
+        /*!
+         * Retrieves how long each swap, destroy and fall animation of a tile takes.
+         * @return animation duration in miliseconds.
+         */
+        Uint32 GetAnimationDuration () const
+        {
+            return ANIMATION_DURATION_MILIS;
+        }
+
+
+        /*!
+         * Answers whether a grid change was signaled that the next Update still has to react to.
+         * @return true if Update has to check the grid for matches, collapses or a swap back.
+         */
+        bool IsGridCheckPending () const
+        {
+            return mIsToCheckGameGrid;
+        }
+
+
+        /*!
+         * Swaps two neighbouring tiles the way a player does by clicking them one after the other.
+         * Input and bots both go through here. The swap is animated and swapped back if it makes no match.
+         * @param gameState the game state to swap the tiles of.
+         * @param animationHeadStart miliseconds of the swap animation already done, as when a drag let the tiles go.
+         * @return true if the swap was started, false if the tiles are not resting neighbours or the game is over.
+         */
+        bool RequestSwap (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, GameState& gameState, Uint32 animationHeadStart = 0) const;
+
+
+        /*!
+         * Answers whether a swap or click made on moving tiles waits to be applied.
+         */
+        bool IsInputBuffered () const
+        {
+            return mBufferedTileARow != -1;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
         /*!
          * Reacts to an input event.
+         * Only the tiles in motion take no swap, the rest of the board plays on; the last swap (a drag or a click next
+         * to the selected tile) or click that starts on a moving tile is buffered instead, and the first Update that
+         * finds its tiles resting applies it, so a fast player does not lose moves.
          * @param e an sdl event object to react to
          * @param gameState the game state to react upon, the gameState may be modified based on the input.
          */
-       void Input (SDL_Event& e, GameState& gameState) const;
+        void Input (SDL_Event& e, GameState& gameState);
 
 
-        /* ====================  MUTATORS      ======================================= */
-
         /*!
          * Reacts to amount of time (in miliseconds) past since last call of the function.
+         * The time is cut where tile animations end and the grid is checked at each of those game times, so however
+         * the time is split into updates the same game is played.
          * @param deltaTime uint32 the amount of time since the function was last called.
          * @param gameState the game state to react upon, the gameState may be modified based on the input.
          * @return false if something goes wrong that requires code change, true otherwise.
@@ -43,6 +92,26 @@ class GameStateLogic : public IGameStateGridChangeObserver
         bool Update (Uint32 deltaTime, GameState& gameState);
 
 
+        /*!
+         * Reports every update and every swap started by a player or bot to a recorder.
+         * @param replayRecorder the recorder, NULL to stop recording.
+         */
+        void SetReplayRecorder (ReplayRecorder* replayRecorder)
+        {
+            mReplayRecorder = replayRecorder;
+        }
+
+
+        /*!
+         * Reports every swap started by a player or bot and the outcome of every update to an autosave journal.
+         * @param autosaveJournal the journal, NULL to stop journaling.
+         */
+        void SetAutosaveJournal (AutosaveJournal* autosaveJournal)
+        {
+            mAutosaveJournal = autosaveJournal;
+        }
+
+
         /*!
          * Overrides notify function; sets a flag for update to check whether grid change in GameState caused any matches.
          */
@@ -55,10 +124,30 @@ class GameStateLogic : public IGameStateGridChangeObserver
         /* ====================  DATA MEMBERS  ======================================= */
 
     private:
+        /* ====================  MUTATORS      ======================================= */
+        void BufferInput (const SDL_Event& e, const GameState& gameState);
+        bool IsBufferedInputReady (const GameState& gameState) const;
+        void ApplyBufferedInput (GameState& gameState);
+
+        /*!
+         * Collapses the columns whose destroyed tiles all came to rest, destroys the resting matches and swaps back
+         * the resting swaps that made none.
+         * @return false if GameState refused a change.
+         */
+        bool CheckGameGrid (GameState& gameState);
+
         /* ====================  DATA MEMBERS  ======================================= */
         static const Uint32 ANIMATION_DURATION_MILIS;
         static const Uint32 MIN_MATCH_SIZE;
         bool mIsToCheckGameGrid;
+        ReplayRecorder* mReplayRecorder;
+        AutosaveJournal* mAutosaveJournal;
+
+        // input on moving tiles
+        int mBusyPressRow, mBusyPressColumn;        ///< tile the mouse went down on, -1 if none
+        glm::vec2 mBusyPressLocation;               ///< in grid coordinates
+        int mBufferedTileARow, mBufferedTileAColumn;    ///< -1 if nothing is buffered
+        int mBufferedTileBRow, mBufferedTileBColumn;    ///< -1 if a click on tile A is buffered
 
 }; /* -----  end of class GameStateLogic  ----- */
 
@@ -0,0 +1,88 @@
+#include "GameStatePool.h"
+#include <stdio.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+GameStatePool::GameStatePool (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds) :
+    mRows (rows),
+    mColumns (columns),
+    mMinMatchSize (minMatchSize),
+    mMaxGameplayTimeSeconds (maxGameplayTimeSeconds),
+    mMaxFreeCount (0),
+    mCreatedCount (0)
+{
+}
+
+
+GameStatePool::~GameStatePool ()
+{
+    for (size_t index = 0; index < mFreeGameStates.size(); index++) {
+        delete mFreeGameStates [index];
+    }
+}
+
+
+GameState* GameStatePool::Acquire (Uint32 seed)
+{
+    if (mFreeGameStates.empty()) {
+        mCreatedCount++;
+        return new GameState (mRows, mColumns, mMinMatchSize, mMaxGameplayTimeSeconds, seed);
+    }
+    GameState* gameState = mFreeGameStates.back();
+    mFreeGameStates.pop_back();
+    gameState->Reset (seed);
+    return gameState;
+}
+
+
+GameState* GameStatePool::Acquire (const GameState::Keyframe& keyframe, const Uint8* grid)
+{
+    if (mFreeGameStates.empty()) {
+        mCreatedCount++;
+        return new GameState (mRows, mColumns, mMinMatchSize, mMaxGameplayTimeSeconds, keyframe, grid);
+    }
+    GameState* gameState = mFreeGameStates.back();
+    mFreeGameStates.pop_back();
+    gameState->RestoreKeyframe (keyframe, grid);
+    return gameState;
+}
+
+
+void GameStatePool::Release (GameState* gameState)
+{
+    if (gameState == NULL) {
+        return;
+    }
+    if (mMaxFreeCount > 0 && static_cast<int>(mFreeGameStates.size()) >= mMaxFreeCount) {
+        delete gameState;
+        return;
+    }
+    gameState->DetachGameStateGridChangeObservers();
+    mFreeGameStates.push_back (gameState);
+}
+
+
+void GameStatePool::SetMaxFreeCount (int maxFreeCount)
+{
+    mMaxFreeCount = maxFreeCount;
+    while (mMaxFreeCount > 0 && static_cast<int>(mFreeGameStates.size()) > mMaxFreeCount) {
+        delete mFreeGameStates.back();
+        mFreeGameStates.pop_back();
+    }
+}
+
+
+void GameStatePool::Reserve (int count)
+{
+    mFreeGameStates.reserve (count);
+    while (static_cast<int>(mFreeGameStates.size()) < count) {
+        mCreatedCount++;
+        mFreeGameStates.push_back (new GameState (mRows, mColumns, mMinMatchSize, mMaxGameplayTimeSeconds));
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+#include <GameState.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Recycles GameState objects of one board size and rule set. A released game keeps its storage block, so
+ * acquiring it again only resets it in place: once the pool has grown to the number of games in use at the
+ * same time, starting a game allocates nothing.
+ *
+ * The free games can be capped, so that a burst of released games (eg. games moved to a HibernationStore) is
+ * given back to the heap instead of staying in the pool.
+ *
+ * A pool belongs to one thread, it takes no locks. It owns the free games; an acquired game belongs to the caller
+ * until it is released, and every game has to be released before the pool is destroyed.
+ */
+class GameStatePool
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates an empty pool for games with the given rules.
+         */
+        GameStatePool (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds);
+        ~GameStatePool ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Retrieves the number of games created by the pool so far.
+         */
+        Uint64 GetCreatedCount () const
+        {
+            return mCreatedCount;
+        }
+
+        /*!
+         * Retrieves the number of released games waiting to be reused.
+         */
+        int GetFreeCount () const
+        {
+            return static_cast<int>(mFreeGameStates.size());
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Starts a new game, on a released GameState if there is one.
+         * @param seed seeds the random tile colors, as in the GameState constructor.
+         * @return a game without observers attached, owned by the pool until released.
+         */
+        GameState* Acquire (Uint32 seed);
+
+
+        /*!
+         * Brings back a game from a keyframe, on a released GameState if there is one. No random grid is made for it.
+         * @param keyframe the state apart from the grid, see GameState::RestoreKeyframe.
+         * @param grid rows * columns colors in row major order.
+         * @return a game without observers attached, owned by the pool until released.
+         */
+        GameState* Acquire (const GameState::Keyframe& keyframe, const Uint8* grid);
+
+
+        /*!
+         * Hands a game back to the pool, its observers are detached.
+         * @param gameState a game acquired from this pool, NULL is ignored.
+         */
+        void Release (GameState* gameState);
+
+
+        /*!
+         * Limits the number of free games kept, games released beyond it are deleted.
+         * @param maxFreeCount the limit, 0 (the default) for no limit.
+         */
+        void SetMaxFreeCount (int maxFreeCount);
+
+
+        /*!
+         * Creates games up front so that the first Acquire calls do not allocate either.
+         * @param count the number of free games to have at least.
+         */
+        void Reserve (int count);
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        GameStatePool (const GameStatePool&);
+        GameStatePool& operator= (const GameStatePool&);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mRows, mColumns, mMinMatchSize;
+        int mMaxGameplayTimeSeconds;
+        int mMaxFreeCount;                          ///< 0 for no limit
+        Uint64 mCreatedCount;
+        std::vector<GameState*> mFreeGameStates;
+
+}; /* -----  end of class GameStatePool  ----- */
@@ -88,6 +88,11 @@ GLuint GameStateRenderer::sTextureObjectNames_tileImages[] = { 0, 0, 0, 0, 0 };
 glm::mat4 GameStateRenderer::sHudMvMatrix_background = glm::mat4 (1);
 glm::mat4 GameStateRenderer::sHudMvMatrix_squareToGridPosition = glm::mat4 (1);
 
+// snapshot for rendering a GameState directly
+RenderSnapshot GameStateRenderer::sGameStateSnapshot;
+std::vector<float> GameStateRenderer::sTweenValues;
+std::vector<RenderSnapshot::TileAnimation> GameStateRenderer::sTileAnimations;
+
 
 // text rendering
 TTF_Font* GameStateRenderer::sTextFont = 0;
@@ -97,7 +102,7 @@ GLuint GameStateRenderer::sTextureObjectName_text = 0;
 glm::mat4 GameStateRenderer::sHudMvMatrix_squareToTextPosition = glm::mat4 (1);
 
 // defining functions
-bool GameStateRenderer::InitRenderer()
+bool GameStateRenderer::InitRenderer (JobSystem& jobSystem)
 {
     bool isSuccessful = true;
     printf ("GameStateRenderer::InitRenderer starting...\n");
@@ -132,14 +137,7 @@ bool GameStateRenderer::InitRenderer()
     }
     assert (glewInitReturnValue == GLEW_OK);
 
-    // init vsync
-    int swapIntervalReturnValue = SDL_GL_SetSwapInterval (1);
-
-    if (swapIntervalReturnValue  < 0)
-    {
-        isSuccessful = false;
-        printf ("swapIntervalReturnValue failed. SDL_ERROR: %s\n", SDL_GetError());
-    }
+    // the swap interval is up to the FramePacer, see TestGame::Init
 
 
     // init (head-up display) shader program
@@ -201,21 +199,45 @@ bool GameStateRenderer::InitRenderer()
     glBufferData (GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof (GLuint), sHudSquare_indices, GL_STATIC_DRAW);
 
 
+    // decode all images on the job system, SDL surfaces may be created on any thread
+    const int tileImageCount = sizeof (sFilePath_tileImages) / sizeof (sFilePath_tileImages[0]);
+    const int imageCount = 3 + tileImageCount;
+    const char* imageFilePaths [imageCount] = { sFilePath_BackGroundJpg, sFilePath_backgroundTransparent, sFilePath_SelectionPng };
+    SDL_Surface* imageSdlSurfaces [imageCount] = { NULL };
+    // SDL's error text is per thread, so a failed decode keeps the text of the thread that decoded it
+    std::string imageErrors [imageCount];
+    for (int i = 0; i < tileImageCount; i++) {
+        imageFilePaths [3 + i] = sFilePath_tileImages [i];
+    }
+    // the decoders are loaded once here, not lazily by the first IMG_Load of every worker at once
+    const int imageFlags = IMG_INIT_JPG | IMG_INIT_PNG;
+    if ((IMG_Init (imageFlags) & imageFlags) != imageFlags) {
+        printf ("IMG_Init failed to load the JPG and PNG decoders. SDL_ERROR: %s\n", IMG_GetError());
+    }
+    jobSystem.ParallelFor (imageCount, 1, [&imageFilePaths, &imageSdlSurfaces, &imageErrors] (int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            imageSdlSurfaces [i] = IMG_Load (imageFilePaths [i]);
+            if (imageSdlSurfaces [i] == NULL) {
+                imageErrors [i] = IMG_GetError();
+            }
+        }
+    });
+
     // load textures
-    SDL_Surface* backgroundSdlSurface = IMG_Load (sFilePath_BackGroundJpg);
+    SDL_Surface* backgroundSdlSurface = imageSdlSurfaces [0];
 	if (backgroundSdlSurface  == NULL) {
         isSuccessful = false;
-		printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_BackGroundJpg, SDL_GetError());
+		printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_BackGroundJpg, imageErrors [0].c_str());
 	}
-    SDL_Surface* backgroundTransparentSdlSurface = IMG_Load (sFilePath_backgroundTransparent);
+    SDL_Surface* backgroundTransparentSdlSurface = imageSdlSurfaces [1];
 	if (backgroundTransparentSdlSurface  == NULL) {
         isSuccessful = false;
-		printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_backgroundTransparent, SDL_GetError());
+		printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_backgroundTransparent, imageErrors [1].c_str());
 	}
-    SDL_Surface* selectionSurface = IMG_Load (sFilePath_SelectionPng);
+    SDL_Surface* selectionSurface = imageSdlSurfaces [2];
 	if (selectionSurface   == NULL) {
         isSuccessful = false;
-		printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_SelectionPng, SDL_GetError());
+		printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_SelectionPng, imageErrors [2].c_str());
 	}
 	assert (backgroundSdlSurface != NULL);
 	assert (backgroundTransparentSdlSurface != NULL);
@@ -243,10 +265,10 @@ bool GameStateRenderer::InitRenderer()
     // load the 5 tile images
     glGenTextures (5, sTextureObjectNames_tileImages);
     for (int i = 0; i<5; i++) {
-       SDL_Surface* tileImageSdlSurface = IMG_Load (sFilePath_tileImages[i]);
+       SDL_Surface* tileImageSdlSurface = imageSdlSurfaces [3 + i];
         if (tileImageSdlSurface  == NULL) {
             isSuccessful = false;
-            printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_tileImages[i], SDL_GetError());
+            printf ("IMG_Load failed for path: \"%s\". SDL_ERROR: %s\n", sFilePath_tileImages[i], imageErrors [3 + i].c_str());
         }
         assert (tileImageSdlSurface != NULL);
         glBindTexture (GL_TEXTURE_2D, sTextureObjectNames_tileImages[i]);
@@ -314,18 +336,25 @@ GLint GameStateRenderer::CompileShader (GLuint* shader, GLenum shaderType, const
 
 
 bool GameStateRenderer::Render (const GameState& gameState)
+{
+    sGameStateSnapshot.Capture (gameState, gameState, 0, 1);
+    return Render (sGameStateSnapshot, 1.0f);
+}
+
+
+bool GameStateRenderer::Render (const RenderSnapshot& snapshot, float interpolation)
 {
     bool isSuccessful = true;
     glClear (GL_COLOR_BUFFER_BIT);
     glDisable (GL_DEPTH_TEST);
 
     DrawBackground(false);
-    DrawGameState (gameState);
+    DrawSnapshot (snapshot, interpolation);
     DrawBackground(true);
 
     // render time left
-    int timeLeft = gameState.GetGameplayTimeLeft();
-    int score = gameState.GetScore();
+    int timeLeft = snapshot.GetGameplayTimeLeft();
+    int score = snapshot.GetScore();
     std::string scoreText = "Score: " + std::to_string (score);
     glm::vec3 translateText = glm::vec3 (0.0f, 0.0f, 0.0f);
     RenderText (glm::translate (sHudMvMatrix_squareToTextPosition, translateText), "TestGame", 8);
@@ -350,84 +379,41 @@ void GameStateRenderer::DrawBackground (bool transparent)
 }
 
 
-void GameStateRenderer::DrawGameState (const GameState& gameState)
+void GameStateRenderer::DrawSnapshot (const RenderSnapshot& snapshot, float interpolation)
 {
-    if (GameState::CollapsingTiles == gameState.GetAnimationState()) {
-        // move to separate function for this case to prevent bloating the code here further
-        DrawGameStateCollaping (gameState);
-        return;
-    }
-
-    int rows = gameState.GetRows();
-    int columns = gameState.GetColumns();
-    //ask gameState about tiles being dragged
-    int draggedTileRow = gameState.GetDraggedTileRow();
-    int draggedTileColumn = gameState.GetDraggedTileColumn();
-    int replacedTileRow = gameState.GetReplacedTileRow();
-    int replacedTileColumn = gameState.GetReplacedTileColumn();
-
-    // draw all tiles currently not being dragged nor replaced
-    for (int currentRow = 0; currentRow < rows; currentRow++) {
-        for (int currentColumn = 0; currentColumn < columns; currentColumn++) {
-            GameState::Color tileColor = gameState.GetColorAt (currentRow, currentColumn);
-            if (GameState::NotAColor == tileColor || GameState::DestroyedColor == tileColor) {
-                continue;
-            }
-            glm::mat4 tileLocationMatrix = glm::mat4 (1);
-            glm::vec3 scaling (1.0f/static_cast<float>(columns), 1.0f/static_cast<float>(rows), 1.0f);
-            glm::vec3 translation  = glm::vec3 (1.0f/static_cast<float>(columns) * currentColumn, 1.0f/static_cast<float>(rows) * currentRow, 1.0f);
-            if (currentRow == draggedTileRow && currentColumn == draggedTileColumn) {
-                continue;
-            }
-            if (currentRow == replacedTileRow && currentColumn == replacedTileColumn) {
-                continue;
-            }
-            translation.y = 1.0f - 1.0f/static_cast<float>(rows) - translation.y;
-            tileLocationMatrix = glm::translate (tileLocationMatrix, translation);
-            tileLocationMatrix = glm::scale (tileLocationMatrix, scaling);
-            if (gameState.IsTileBeingDestroyed (currentRow, currentColumn)) {
-                DrawHudSquareDestroyed (sHudMvMatrix_squareToGridPosition * tileLocationMatrix,
-                       sTextureObjectNames_tileImages[static_cast<int>(tileColor)-1],
-                       gameState.GetAnimationPercentage());
-            } else {
-                DrawHudSquare (sHudMvMatrix_squareToGridPosition * tileLocationMatrix,
-                       sTextureObjectNames_tileImages[static_cast<int>(tileColor)-1]);
-            }
-            if (GameState::Idle == gameState.GetAnimationState()) {
-                if (currentRow == gameState.GetSelectedTileRow() && currentColumn == gameState.GetSelectedTileColumn()) {
-                    DrawHudSquare (sHudMvMatrix_squareToGridPosition * tileLocationMatrix, sTextureObjectName_Selection);
-                }
-            }
-        }
-    }
-
-    // draw dragged and replaced tiles
-    if (gameState.IsDragActive() || gameState.GetAnimationState() == GameState::SwappingTiles) {
-        glm::mat4 tileLocationMatrix = glm::mat4 (1);
-        glm::vec3 scaling (1.0f/static_cast<float>(columns), 1.0f/static_cast<float>(rows), 1.0f);
-
-        if (replacedTileRow != -1 && replacedTileColumn != -1) {
-            glm::vec3 replacedTileTranslation  = glm::vec3 (1.0f/static_cast<float>(columns) * replacedTileColumn, 1.0f/static_cast<float>(rows) * replacedTileRow, 1.0f);
-            replacedTileTranslation -= gameState.GetCurrentDraggedTileDisplacement();
-            replacedTileTranslation.y = 1.0f - 1.0f/static_cast<float>(rows) - replacedTileTranslation.y;
-            tileLocationMatrix = glm::translate (glm::mat4 (1), replacedTileTranslation);
-            tileLocationMatrix = glm::scale (tileLocationMatrix, scaling);
-            GameState::Color tileColor = gameState.GetColorAt (replacedTileRow, replacedTileColumn);
-            if (GameState::NotAColor != tileColor && GameState::DestroyedColor != tileColor) {
-                DrawHudSquare (sHudMvMatrix_squareToGridPosition * tileLocationMatrix,
-                       sTextureObjectNames_tileImages[static_cast<int>(tileColor)-1]);
-            }
-        }
-
-        glm::vec3 draggedTileTranslation  = glm::vec3 (1.0f/static_cast<float>(columns) * draggedTileColumn, 1.0f/static_cast<float>(rows) * draggedTileRow, 1.0f);
-        draggedTileTranslation += gameState.GetCurrentDraggedTileDisplacement();
-        draggedTileTranslation.y = 1.0f - 1.0f/static_cast<float>(rows) - draggedTileTranslation.y;
-        tileLocationMatrix = glm::translate (glm::mat4 (1), draggedTileTranslation);
+    const float rows = static_cast<float>(snapshot.GetRows());
+    const float columns = static_cast<float>(snapshot.GetColumns());
+    const glm::vec3 scaling (1.0f/columns, 1.0f/rows, 1.0f);
+    const std::vector<RenderSnapshot::Tile>& tiles = snapshot.GetTiles();
+    // all tweens of the frame in one pass
+    snapshot.AnimateTiles (interpolation, sTweenValues, sTileAnimations);
+    for (size_t index = 0; index < tiles.size(); index++) {
+        const RenderSnapshot::Tile& tile = tiles [index];
+        const RenderSnapshot::TileAnimation& tileAnimation = sTileAnimations [index];
+        glm::vec3 translation = glm::vec3 (tile.mX + tileAnimation.mOffsetX, tile.mY + tileAnimation.mOffsetY, 1.0f);
+        translation.y = 1.0f - 1.0f/rows - translation.y;
+        glm::mat4 tileLocationMatrix = glm::translate (glm::mat4 (1), translation);
         tileLocationMatrix = glm::scale (tileLocationMatrix, scaling);
-        GameState::Color tileColor = gameState.GetColorAt (draggedTileRow, draggedTileColumn);
-        if (GameState::NotAColor != tileColor && GameState::DestroyedColor != tileColor) {
+        if (tile.mIsBeingDestroyed) {
+            DrawHudSquareDestroyed (sHudMvMatrix_squareToGridPosition * tileLocationMatrix,
+                   sTextureObjectNames_tileImages[tile.mColor-1],
+                   tileAnimation.mDestruction);
+        } else {
             DrawHudSquare (sHudMvMatrix_squareToGridPosition * tileLocationMatrix,
-                   sTextureObjectNames_tileImages[static_cast<int>(tileColor)-1]);
+                   sTextureObjectNames_tileImages[tile.mColor-1]);
+        }
+        if (tile.mIsSelected) {
+            DrawHudSquare (sHudMvMatrix_squareToGridPosition * tileLocationMatrix, sTextureObjectName_Selection);
+        }
+    }
+    // the hinted move, both tiles marked like a selection
+    int hintTileRows [2];
+    int hintTileColumns [2];
+    if (snapshot.GetHint (hintTileRows [0], hintTileColumns [0], hintTileRows [1], hintTileColumns [1])) {
+        for (int index = 0; index < 2; index++) {
+            const glm::vec3 translation (hintTileColumns [index] / columns, 1.0f - 1.0f/rows - hintTileRows [index] / rows, 1.0f);
+            const glm::mat4 tileLocationMatrix = glm::scale (glm::translate (glm::mat4 (1), translation), scaling);
+            DrawHudSquare (sHudMvMatrix_squareToGridPosition * tileLocationMatrix, sTextureObjectName_Selection);
         }
     }
 }
@@ -500,46 +486,6 @@ glm::vec2 GameStateRenderer::GetGridCoordinatesFromScreenLocation (int x, int y)
 
 
 
-void GameStateRenderer::DrawGameStateCollaping (const GameState& gameState)
-{
-    int rows = gameState.GetRows();
-    int columns = gameState.GetColumns();
-    float animationPercentage = gameState.GetAnimationPercentage();
-    std::vector<std::vector<int>> columnsToCollapse = gameState.GetColumnsToCollapse();
-
-
-    for (int currentColumn = 0; currentColumn < columns; currentColumn++) {
-        glm::vec3 collapseAdjustment = glm::vec3 (0.0f, 0.0f, 0.0f);
-        if (columnsToCollapse[currentColumn][0] != -1) {
-            float adjustment = static_cast<float>(columnsToCollapse[currentColumn][1]) * (1.0f/static_cast<float>(rows));
-            adjustment *= 1 - animationPercentage;
-            collapseAdjustment.y = -adjustment;
-        }
-
-
-        for (int currentRow = 0; currentRow < rows; currentRow++) {
-            GameState::Color tileColor = gameState.GetColorAt (currentRow, currentColumn);
-            if (GameState::NotAColor == tileColor || GameState::DestroyedColor == tileColor) {
-                continue;
-            }
-
-            glm::mat4 tileLocationMatrix = glm::mat4 (1);
-            glm::vec3 scaling (1.0f/static_cast<float>(columns), 1.0f/static_cast<float>(rows), 1.0f);
-            glm::vec3 translation  = glm::vec3 (1.0f/static_cast<float>(columns) * currentColumn, 1.0f/static_cast<float>(rows) * currentRow, 1.0f);
-            if (currentRow <= columnsToCollapse[currentColumn][0]) {
-                translation += collapseAdjustment;
-            }
-            translation.y = 1.0f - 1.0f/static_cast<float>(rows) - translation.y;
-            tileLocationMatrix = glm::translate (tileLocationMatrix, translation);
-            tileLocationMatrix = glm::scale (tileLocationMatrix, scaling);
-
-            DrawHudSquare (sHudMvMatrix_squareToGridPosition * tileLocationMatrix,
-                   sTextureObjectNames_tileImages[static_cast<int>(tileColor)-1]);
-        }
-    }
-}
-
-
 void GameStateRenderer::RenderText (glm::mat4 mvMatrix, const char* text, int textLength)
 {
     sTextSurface = TTF_RenderText_Blended (sTextFont, text, sSdlColorWhite);
@@ -6,6 +6,8 @@
 #include <assert.h>
 #include <stdio.h>
 #include <GameState.h>
+#include <JobSystem.h>
+#include <RenderSnapshot.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -32,12 +34,21 @@ class GameStateRenderer
 
         /*!
          * Renders the game state.
-         * Calls the appropriate draw functions to represent the input data based on its animation state and grid, drag, time, score variables.
+         * Captures a RenderSnapshot of it and renders that.
          * @param gameState the gameState to render.
          */
         static bool Render (const GameState& gameState);
 
 
+        /*!
+         * Renders a snapshot of the game state, the moment between its two captured steps given by interpolation.
+         * Only reads the snapshot, so the game can go on on another thread meanwhile.
+         * @param snapshot the snapshot to render.
+         * @param interpolation from 0 (the step before) to 1 (the last step), see RenderSnapshot::GetInterpolation.
+         */
+        static bool Render (const RenderSnapshot& snapshot, float interpolation);
+
+
         /*!
          * Accepts location in screen space and converts it into game board/grid location.
          * GameState and GameStateLogic should not need to know about the view and therefore the screen resolution.
@@ -56,8 +67,9 @@ class GameStateRenderer
          * Required before calling any other functions.
          * It initializes OpenGL context, reads the relevant asset files,
          * links the shader program and uploads buffer objects (vertices, elements, textures), prepares font.
+         * @param jobSystem decodes the image files in parallel; the OpenGL uploads stay on the calling thread.
          */
-        static bool InitRenderer ();
+        static bool InitRenderer (JobSystem& jobSystem);
 
 		static void DestroyRenderer() {
 			glDeleteProgram (sHudTexShaderProgram);
@@ -126,6 +138,10 @@ class GameStateRenderer
         // tile destruction animation
         static GLint         sHudTexShaderProgram_destroyUniLoc; ///< float uniform location showing destruction percentage for removing tiles animation
 
+        static RenderSnapshot sGameStateSnapshot;               ///< captured by Render (gameState)
+        static std::vector<float> sTweenValues;                 ///< scratch of DrawSnapshot
+        static std::vector<RenderSnapshot::TileAnimation> sTileAnimations;  ///< the tiles as DrawSnapshot draws them
+
         // text rendering
         static TTF_Font*     sTextFont;    ///< TrueType font object for generating a texture with text
         static SDL_Surface*  sTextSurface; ///< surface temporarely holding rendered text to be uploaded as a texture object
@@ -173,17 +189,11 @@ class GameStateRenderer
 
 
         /*!
-         *  Description:  Draws the current grid of the game state.
-         *  @param gameState the GameState to render.
-         */
-        static void DrawGameState (const GameState& gameState);
-
-
-        /*!
-         *  Description:  Draws the current grid of the game state with GameState::CollapsingTiles animation
-         *  @param gameState the GameState to render.
+         *  Description:  Draws the tiles of a snapshot.
+         *  @param snapshot the snapshot to render.
+         *  @param interpolation the moment between the two steps of the snapshot to draw.
          */
-        static void DrawGameStateCollaping (const GameState& gameState);
+        static void DrawSnapshot (const RenderSnapshot& snapshot, float interpolation);
 
 
         /*!
@@ -0,0 +1,193 @@
+#include "HibernationStore.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+
+// tiles packed into a byte, the colors of a resting grid are digits of base sNUMBER_OF_TILE_COLORS
+static const int TILES_PER_BYTE = 3;
+
+
+HibernationStore::HibernationStore (int rows, int columns) :
+    mRows (rows),
+    mColumns (columns),
+    mSlotSize (static_cast<Uint32>(sizeof (GameState::Keyframe) + sizeof (Uint32)) + static_cast<Uint32>(rows * columns + TILES_PER_BYTE - 1) / TILES_PER_BYTE),
+    mBlockSize (0),
+    mFile (-1),
+    mFirstFreeSlot (-1),
+    mCount (0),
+    mGrid (rows * columns + TILES_PER_BYTE - 1, 0)
+{
+    // a byte holds three colors, a free slot the index of the next
+    assert (GameState::sNUMBER_OF_TILE_COLORS * GameState::sNUMBER_OF_TILE_COLORS * GameState::sNUMBER_OF_TILE_COLORS <= 256);
+    assert (mSlotSize >= sizeof (int));
+    mBlockSize = static_cast<size_t>(SLOTS_PER_BLOCK) * mSlotSize;
+}
+
+
+HibernationStore::~HibernationStore ()
+{
+    FreeBlocks();
+#ifdef TARGET_UNIX
+    if (mFile >= 0) {
+        close (mFile);
+        unlink (mFilePath.c_str());
+    }
+#endif
+}
+
+
+void HibernationStore::FreeBlocks ()
+{
+    for (size_t block = 0; block < mBlocks.size(); block++) {
+#ifdef TARGET_UNIX
+        if (mFile >= 0) {
+            munmap (mBlocks [block], mBlockSize);
+            continue;
+        }
+#endif
+        delete[] mBlocks [block];
+    }
+    mBlocks.clear();
+    mFirstFreeSlot = -1;
+}
+
+
+bool HibernationStore::OpenFile (const char* filePath)
+{
+    assert (GetCount() == 0);
+#ifdef TARGET_UNIX
+    const int file = open (filePath, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (file < 0) {
+        printf ("ERROR: HibernationStore::OpenFile cannot create %s.\n", filePath);
+        return false;
+    }
+    FreeBlocks();
+    if (mFile >= 0) {
+        close (mFile);
+        unlink (mFilePath.c_str());
+    }
+    mFile = file;
+    mFilePath = filePath;
+    // every block is mapped at its own offset, which has to be a multiple of the page size
+    const size_t pageSize = static_cast<size_t>(sysconf (_SC_PAGESIZE));
+    mBlockSize = (static_cast<size_t>(SLOTS_PER_BLOCK) * mSlotSize + pageSize - 1) / pageSize * pageSize;
+    return true;
+#else
+    printf ("ERROR: HibernationStore::OpenFile is not supported on this platform, %s is not used.\n", filePath);
+    return false;
+#endif
+}
+
+
+bool HibernationStore::Grow ()
+{
+    Uint8* block = NULL;
+    if (mFile < 0) {
+        block = new Uint8 [mBlockSize];
+    } else {
+#ifdef TARGET_UNIX
+        // the blocks mapped before stay where they are
+        const off_t offset = static_cast<off_t>(mBlocks.size() * mBlockSize);
+        void* mapping = MAP_FAILED;
+        if (ftruncate (mFile, offset + static_cast<off_t>(mBlockSize)) == 0) {
+            mapping = mmap (NULL, mBlockSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, offset);
+        }
+        if (mapping == MAP_FAILED) {
+            printf ("ERROR: HibernationStore::Grow cannot map block %u of %s.\n", static_cast<unsigned>(mBlocks.size()), mFilePath.c_str());
+            return false;
+        }
+        block = static_cast<Uint8*>(mapping);
+#endif
+    }
+    mBlocks.push_back (block);
+    // the lowest slots are handed out first
+    const int firstSlot = static_cast<int>(mBlocks.size() - 1) * SLOTS_PER_BLOCK;
+    for (int slot = firstSlot + SLOTS_PER_BLOCK - 1; slot >= firstSlot; slot--) {
+        memcpy (GetSlot (slot), &mFirstFreeSlot, sizeof (mFirstFreeSlot));
+        mFirstFreeSlot = slot;
+    }
+    return true;
+}
+
+
+int HibernationStore::Store (const GameState& gameState, Uint32 seed)
+{
+    assert (gameState.GetRows() == mRows && gameState.GetColumns() == mColumns);
+    GameState::Keyframe keyframe;
+    if (!gameState.GetKeyframe (keyframe, &mGrid [0])) {
+        return -1;
+    }
+    for (int index = 0; index < mRows * mColumns; index++) {
+        if (mGrid [index] == GameState::NotAColor || mGrid [index] > GameState::sNUMBER_OF_TILE_COLORS) {
+            return -1;
+        }
+    }
+    if (mFirstFreeSlot < 0 && !Grow()) {
+        return -1;
+    }
+    const int slot = mFirstFreeSlot;
+    Uint8* bytes = GetSlot (slot);
+    memcpy (&mFirstFreeSlot, bytes, sizeof (mFirstFreeSlot));
+    mCount++;
+    memcpy (bytes, &keyframe, sizeof (keyframe));
+    bytes += sizeof (keyframe);
+    memcpy (bytes, &seed, sizeof (seed));
+    bytes += sizeof (seed);
+    const Uint8 base = static_cast<Uint8>(GameState::sNUMBER_OF_TILE_COLORS);
+    for (int index = mRows * mColumns; index < static_cast<int>(mGrid.size()); index++) {
+        mGrid [index] = 1;
+    }
+    for (int index = 0; index < mRows * mColumns; index += TILES_PER_BYTE) {
+        bytes [index / TILES_PER_BYTE] = static_cast<Uint8>((mGrid [index] - 1) + base * ((mGrid [index + 1] - 1) + base * (mGrid [index + 2] - 1)));
+    }
+    return slot;
+}
+
+
+void HibernationStore::Restore (int slot, GameState& gameState, Uint32& seed)
+{
+    assert (gameState.GetRows() == mRows && gameState.GetColumns() == mColumns);
+    GameState::Keyframe keyframe;
+    const Uint8* grid = Restore (slot, keyframe, seed);
+    gameState.RestoreKeyframe (keyframe, grid);
+}
+
+
+const Uint8* HibernationStore::Restore (int slot, GameState::Keyframe& keyframe, Uint32& seed)
+{
+    assert (slot >= 0 && static_cast<size_t>(slot) < mBlocks.size() * SLOTS_PER_BLOCK);
+    Uint8* bytes = GetSlot (slot);
+    memcpy (&keyframe, bytes, sizeof (keyframe));
+    memcpy (&seed, bytes + sizeof (keyframe), sizeof (seed));
+    const Uint8* grid = bytes + sizeof (keyframe) + sizeof (seed);
+    const Uint8 base = static_cast<Uint8>(GameState::sNUMBER_OF_TILE_COLORS);
+    for (int index = 0; index < mRows * mColumns; index += TILES_PER_BYTE) {
+        Uint8 digits = grid [index / TILES_PER_BYTE];
+        mGrid [index] = static_cast<Uint8>(1 + digits % base);
+        digits /= base;
+        mGrid [index + 1] = static_cast<Uint8>(1 + digits % base);
+        mGrid [index + 2] = static_cast<Uint8>(1 + digits / base);
+    }
+    Release (slot);
+    return &mGrid [0];
+}
+
+
+void HibernationStore::Release (int slot)
+{
+    assert (slot >= 0 && static_cast<size_t>(slot) < mBlocks.size() * SLOTS_PER_BLOCK);
+    memcpy (GetSlot (slot), &mFirstFreeSlot, sizeof (mFirstFreeSlot));
+    mFirstFreeSlot = slot;
+    mCount--;
+}
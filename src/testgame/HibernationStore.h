@@ -0,0 +1,121 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <GameState.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Keeps resting games out of their GameState objects. A hibernated game is a fixed-size slot holding its
+ * GameState::Keyframe, its seed and its grid packed at three tiles per byte, 42 bytes for an 8x8 board where the
+ * GameState with its vectors takes about 600. Slots are carved from blocks of SLOTS_PER_BLOCK, in memory or in a
+ * memory-mapped file the kernel may write out when memory gets short, so a store never holds more than a block of
+ * unused slots. Freed slots are reused, they are chained through their own first bytes.
+ *
+ * A store belongs to one thread, it takes no locks.
+ */
+class HibernationStore
+{
+    public:
+        static const int SLOTS_PER_BLOCK = 1024;
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates an empty store in memory for games with the given board size.
+         */
+        HibernationStore (int rows, int columns);
+        ~HibernationStore ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        Uint32 GetSlotSize () const
+        {
+            return mSlotSize;
+        }
+
+        /*!
+         * Retrieves the number of games hibernating.
+         */
+        int GetCount () const
+        {
+            return mCount;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Keeps the slots in a memory-mapped file instead of memory. Only possible while the store is empty.
+         * @param filePath the file, created or truncated; it is removed when the store is destroyed.
+         * @return false if the file cannot be created or mapped, the store then stays in memory.
+         */
+        bool OpenFile (const char* filePath);
+
+
+        /*!
+         * Stores a resting game.
+         * @param seed the seed the game was started with, kept with it.
+         * @return the slot of the game, -1 if the game is not resting (see GameState::GetKeyframe).
+         */
+        int Store (const GameState& gameState, Uint32 seed);
+
+
+        /*!
+         * Brings a game back and frees its slot.
+         * @param slot the slot returned by Store.
+         * @param gameState a game with the same board size, it becomes the stored game.
+         * @param seed set to the seed given to Store.
+         */
+        void Restore (int slot, GameState& gameState, Uint32& seed);
+
+
+        /*!
+         * Takes a game out and frees its slot, for a game to be created from it (see GameStatePool::Acquire).
+         * @param slot the slot returned by Store.
+         * @param keyframe set to the stored state apart from the grid.
+         * @param seed set to the seed given to Store.
+         * @return the rows * columns colors of the grid, valid until the store is used again.
+         */
+        const Uint8* Restore (int slot, GameState::Keyframe& keyframe, Uint32& seed);
+
+
+        /*!
+         * Frees a slot without restoring its game.
+         */
+        void Release (int slot);
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        HibernationStore (const HibernationStore&);
+        HibernationStore& operator= (const HibernationStore&);
+
+        /* ====================  MUTATORS      ======================================= */
+        Uint8* GetSlot (int slot)
+        {
+            return mBlocks [slot / SLOTS_PER_BLOCK] + static_cast<size_t>(slot % SLOTS_PER_BLOCK) * mSlotSize;
+        }
+
+        bool Grow ();
+        void FreeBlocks ();
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mRows, mColumns;
+        Uint32 mSlotSize;
+        size_t mBlockSize;                  ///< bytes of a block, a whole number of pages in a file
+        std::vector<Uint8*> mBlocks;        ///< allocated, or mapped from mFile one after the other
+        int mFile;                          ///< -1 when the slots are in memory
+        std::string mFilePath;
+        int mFirstFreeSlot;                 ///< -1 if every slot is taken, a free slot holds the next free one
+        int mCount;
+        std::vector<Uint8> mGrid;           ///< unpacked grid of the game being stored or restored
+
+}; /* -----  end of class HibernationStore  ----- */
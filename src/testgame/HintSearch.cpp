@@ -0,0 +1,140 @@
+#include "HintSearch.h"
+#include <assert.h>
+#include <stdio.h>
+#include <chrono>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+HintSearch::HintSearch (int depth, int budgetMicroseconds, Uint32 idleMilis) :
+    mDepth (depth),
+    mBudgetMicroseconds (budgetMicroseconds),
+    mIdleMilis (idleMilis),
+    mIsGridChanged (true),
+    mIsResting (false),
+    mRestStartGameplayTime (0),
+    mRestMilis (0),
+    mBoards(),
+    mLevel (0),
+    mIsSearchDone (false),
+    mBestMove (-1),
+    mBestPoints (0),
+    mNodes (0),
+    mCancelledSearches (0)
+{
+    if (depth < 1 || depth > MAX_DEPTH) {
+        printf ("ERROR: HintSearch::HintSearch called with depth %d, supported are 1 to %d.\n", depth, MAX_DEPTH);
+        assert (0);
+        mDepth = depth < 1 ? 1 : MAX_DEPTH;
+    }
+}
+
+
+bool HintSearch::GetHint (int& tileARow, int& tileAColumn, int& tileBRow, int& tileBColumn) const
+{
+    if (!mIsResting || mRestMilis < mIdleMilis || !mIsSearchDone || mBestMove < 0 || mIsGridChanged) {
+        return false;
+    }
+    GameBoard::DecodeMove (mBestMove, tileARow, tileAColumn, tileBRow, tileBColumn);
+    return true;
+}
+
+
+void HintSearch::Update (const GameState& gameState)
+{
+    // a selected or dragged tile is a player making a move, the hint would only be in the way
+    const bool isResting = GameState::Idle == gameState.GetAnimationState() && !gameState.IsDragActive() && gameState.GetSelectedTileRow() == -1;
+    if (!isResting) {
+        mIsResting = false;
+        return;
+    }
+    if (!mIsResting) {
+        mIsResting = true;
+        mRestStartGameplayTime = gameState.GetGameplayTime();
+    }
+    if (mIsGridChanged) {
+        Restart (gameState);
+    }
+    mRestMilis = gameState.GetGameplayTime() - mRestStartGameplayTime;
+    if (mIsSearchDone) {
+        return;
+    }
+    // a board at a time until the budget is used up, the last one may overrun it by the time of one move
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::microseconds (mBudgetMicroseconds);
+    do {
+        if (!SearchNextNode()) {
+            mIsSearchDone = true;
+            return;
+        }
+    } while (std::chrono::steady_clock::now() < end);
+}
+
+
+void HintSearch::NotifyOfGameStateGridChange()
+{
+    if (!mIsGridChanged && !mIsSearchDone) {
+        mCancelledSearches++;
+    }
+    mIsGridChanged = true;
+    mIsResting = false;
+}
+
+
+void HintSearch::Restart (const GameState& gameState)
+{
+    if (gameState.GetRows() > GameBoard::MAX_SIDE || gameState.GetColumns() > GameBoard::MAX_SIDE) {
+        printf ("ERROR: HintSearch::Restart called with a %dx%d game state, supported are up to %dx%d.\n",
+                gameState.GetRows(), gameState.GetColumns(), GameBoard::MAX_SIDE, GameBoard::MAX_SIDE);
+        mIsGridChanged = false;
+        mIsSearchDone = true;
+        mBestMove = -1;
+        return;
+    }
+    if (mBoards.empty() || mBoards [0].GetRows() != gameState.GetRows() || mBoards [0].GetColumns() != gameState.GetColumns()) {
+        mBoards.assign (mDepth + 1, GameBoard (gameState.GetRows(), gameState.GetColumns(), gameState.GetMinMatchSize(), GameState::sNUMBER_OF_TILE_COLORS));
+    }
+    mBoards [0].CopyFrom (gameState, gameState.GetGameTime());
+    mMoveCounts [0] = mBoards [0].GetMatchingMoves (mMoves [0]);
+    mNextMoves [0] = 0;
+    mPoints [0] = 0;
+    mLevel = 0;
+    mIsGridChanged = false;
+    mIsSearchDone = false;
+    mBestMove = -1;
+    mBestPoints = 0;
+    mNodes = 0;
+}
+
+
+bool HintSearch::SearchNextNode ()
+{
+    // back up from the levels whose moves are all applied
+    while (mNextMoves [mLevel] == mMoveCounts [mLevel]) {
+        if (mLevel == 0) {
+            return false;
+        }
+        mLevel--;
+    }
+    const int level = mLevel;
+    GameBoard& board = mBoards [level + 1];
+    board = mBoards [level];
+    mPoints [level + 1] = mPoints [level] + board.ApplyMove (mMoves [level][mNextMoves [level]++]);
+    mNodes++;
+    // a leaf is the end of a sequence, its points count for the root move it started with; equal points keep the first
+    const bool isLeaf = level + 1 == mDepth || (mMoveCounts [level + 1] = board.GetMatchingMoves (mMoves [level + 1])) == 0;
+    if (isLeaf) {
+        if (mBestMove < 0 || mPoints [level + 1] > mBestPoints) {
+            mBestMove = mMoves [0][mNextMoves [0] - 1];
+            mBestPoints = mPoints [level + 1];
+        }
+    } else {
+        mNextMoves [level + 1] = 0;
+        mLevel = level + 1;
+    }
+    return true;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <vector>
+#include <GameBoard.h>
+#include <GameState.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Looks for the best move of a resting game in the background and hints it once the player has not moved for a while.
+ *
+ * The search is an exhaustive depth-limited maximum over GameBoard, like BestMoveSearch, but iterative with an explicit
+ * stack, so it stops wherever its time is up and resumes there at the next Update: every Update searches for at most
+ * its budget of microseconds (plus one board at most), so it never makes a frame late however deep it looks. The
+ * refills are guessed with a generator of its own, GameState draws other colors, so the hint is the best move of the
+ * visible tiles rather than a sure thing.
+ *
+ * Attached to the GameState as a grid change observer, it drops the search the moment the grid changes and starts
+ * over on the new grid once the game rests again. The hint hides while the game does not rest, including while a
+ * tile is selected or dragged.
+ */
+class HintSearch : public IGameStateGridChangeObserver
+{
+    public:
+        /// the deepest supported search
+        static const int MAX_DEPTH = 4;
+
+        static const int DEFAULT_DEPTH = 3;
+        static const int DEFAULT_BUDGET_MICROSECONDS = 500;
+        static const Uint32 DEFAULT_IDLE_MILIS = 5000;
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * @param depth the number of moves to look ahead, from 1 to MAX_DEPTH.
+         * @param budgetMicroseconds how long each Update searches at most.
+         * @param idleMilis how much gameplay time the game rests before the hint is shown.
+         */
+        HintSearch (int depth = DEFAULT_DEPTH, int budgetMicroseconds = DEFAULT_BUDGET_MICROSECONDS, Uint32 idleMilis = DEFAULT_IDLE_MILIS);
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        int GetDepth () const
+        {
+            return mDepth;
+        }
+
+        int GetBudgetMicroseconds () const
+        {
+            return mBudgetMicroseconds;
+        }
+
+        Uint32 GetIdleMilis () const
+        {
+            return mIdleMilis;
+        }
+
+        /// true once the grid the game rests on is searched completely
+        bool IsSearchDone () const
+        {
+            return mIsSearchDone;
+        }
+
+        /// boards a move was applied to since the search started
+        Uint64 GetNodes () const
+        {
+            return mNodes;
+        }
+
+        /// how many searches were dropped unfinished because the grid changed
+        Uint64 GetCancelledSearches () const
+        {
+            return mCancelledSearches;
+        }
+
+
+        /*!
+         * Retrieves the move to hint.
+         * @return false if there is nothing to hint yet: the search is not done, found no swap that makes a match or the
+         *  game has not rested for long enough.
+         */
+        bool GetHint (int& tileARow, int& tileAColumn, int& tileBRow, int& tileBColumn) const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        void SetBudgetMicroseconds (int budgetMicroseconds)
+        {
+            mBudgetMicroseconds = budgetMicroseconds;
+        }
+
+
+        /*!
+         * Searches on for the budget if the game rests. Call it from the thread the game is updated on, after the update.
+         * @param gameState the game the observer is attached to.
+         */
+        void Update (const GameState& gameState);
+
+
+        /*!
+         * Overrides notify function; drops the search and the hint, the next Update starts over on the new grid.
+         */
+        void NotifyOfGameStateGridChange();
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        HintSearch (const HintSearch&);
+        HintSearch& operator= (const HintSearch&);
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Takes over the grid of a resting game as the root of a new search.
+         */
+        void Restart (const GameState& gameState);
+
+
+        /*!
+         * Applies the next move of the search to a board.
+         * @return false if the search is done.
+         */
+        bool SearchNextNode ();
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mDepth;
+        int mBudgetMicroseconds;
+        Uint32 mIdleMilis;
+        bool mIsGridChanged;                        ///< the search is of an old grid, set by the notification
+        bool mIsResting;                            ///< the game rested at the last Update
+        Uint32 mRestStartGameplayTime;              ///< the gameplay time the game started resting at
+        Uint32 mRestMilis;                          ///< how long the game had rested at the last Update
+
+        // the search stack: the board at each level, its matching moves and the next of them to apply
+        std::vector<GameBoard> mBoards;             ///< mDepth + 1 boards, the root first
+        int mMoves [MAX_DEPTH][GameBoard::MAX_MOVES];
+        int mMoveCounts [MAX_DEPTH];
+        int mNextMoves [MAX_DEPTH];
+        int mPoints [MAX_DEPTH + 1];                ///< points scored from the root to each level
+        int mLevel;                                 ///< the level whose moves are applied next
+        bool mIsSearchDone;
+        int mBestMove;                              ///< GameBoard move, -1 if none found yet
+        int mBestPoints;
+        Uint64 mNodes;
+        Uint64 mCancelledSearches;
+
+}; /* -----  end of class HintSearch  ----- */
@@ -0,0 +1,99 @@
+#include "Histogram.h"
+#include <assert.h>
+#include <math.h>
+
+
+// two-sided 95% quantile of the normal distribution
+static const double Z_95 = 1.959964;
+
+
+Histogram::Histogram (int binCount, double binWidth) :
+    mBins (binCount, 0),
+    mBinWidth (binWidth)
+{
+    assert (binCount > 0 && binWidth > 0.0);
+    Clear();
+}
+
+
+double Histogram::GetStandardDeviation () const
+{
+    if (mCount < 2) {
+        return 0.0;
+    }
+    const double mean = GetMean();
+    const double variance = (mSumOfSquares - mSum * mean) / (mCount - 1);
+    return variance > 0.0 ? sqrt (variance) : 0.0;
+}
+
+
+double Histogram::GetMeanConfidence () const
+{
+    return mCount > 0 ? Z_95 * GetStandardDeviation() / sqrt (static_cast<double>(mCount)) : 0.0;
+}
+
+
+double Histogram::GetPercentile (double percent) const
+{
+    if (mCount == 0) {
+        return 0.0;
+    }
+    const double rank = percent / 100.0 * mCount;
+    Uint64 below = 0;
+    for (size_t bin = 0; bin < mBins.size(); bin++) {
+        if (below + mBins [bin] >= rank && mBins [bin] > 0) {
+            const double value = (bin + (rank - below) / mBins [bin]) * mBinWidth;
+            // the bins are coarser than the exact extremes
+            return value < mMinimum ? mMinimum : (value > mMaximum ? mMaximum : value);
+        }
+        below += mBins [bin];
+    }
+    return mMaximum;
+}
+
+
+void Histogram::Merge (const Histogram& other)
+{
+    assert (other.mBins.size() == mBins.size() && other.mBinWidth == mBinWidth);
+    if (other.mCount == 0) {
+        return;
+    }
+    for (size_t bin = 0; bin < mBins.size(); bin++) {
+        mBins [bin] += other.mBins [bin];
+    }
+    mMinimum = mCount == 0 || other.mMinimum < mMinimum ? other.mMinimum : mMinimum;
+    mMaximum = mCount == 0 || other.mMaximum > mMaximum ? other.mMaximum : mMaximum;
+    mCount += other.mCount;
+    mSum += other.mSum;
+    mSumOfSquares += other.mSumOfSquares;
+}
+
+
+void Histogram::Clear ()
+{
+    for (size_t bin = 0; bin < mBins.size(); bin++) {
+        mBins [bin] = 0;
+    }
+    mCount = 0;
+    mSum = 0.0;
+    mSumOfSquares = 0.0;
+    mMinimum = 0.0;
+    mMaximum = 0.0;
+}
+
+
+void GetProportionConfidence (Uint64 successes, Uint64 trials, double& low, double& high)
+{
+    if (trials == 0) {
+        low = 0.0;
+        high = 1.0;
+        return;
+    }
+    const double n = static_cast<double>(trials);
+    const double p = successes / n;
+    const double z2 = Z_95 * Z_95;
+    const double center = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+    const double halfWidth = Z_95 * sqrt (p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+    low = center - halfWidth < 0.0 ? 0.0 : center - halfWidth;
+    high = center + halfWidth > 1.0 ? 1.0 : center + halfWidth;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Histogram of non-negative values in bins of equal width, plus the exact count, sum and sum of squares.
+ * It takes no locks: every thread fills its own histogram and they are merged once the threads are done.
+ */
+class Histogram
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates an empty histogram.
+         * @param binCount the number of bins, values past the last bin are counted in the last bin.
+         * @param binWidth the range of values of a bin.
+         */
+        Histogram (int binCount, double binWidth);
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        Uint64 GetCount () const
+        {
+            return mCount;
+        }
+
+        double GetMinimum () const
+        {
+            return mMinimum;
+        }
+
+        double GetMaximum () const
+        {
+            return mMaximum;
+        }
+
+        double GetMean () const
+        {
+            return mCount > 0 ? mSum / mCount : 0.0;
+        }
+
+        double GetStandardDeviation () const;
+
+
+        /*!
+         * Retrieves the half width of the 95% confidence interval of the mean (normal approximation).
+         */
+        double GetMeanConfidence () const;
+
+
+        /*!
+         * Estimates a percentile from the bins, interpolating linearly inside a bin.
+         * @param percent 0 to 100.
+         */
+        double GetPercentile (double percent) const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        void Add (double value)
+        {
+            int bin = static_cast<int>(value / mBinWidth);
+            bin = bin < 0 ? 0 : (bin >= static_cast<int>(mBins.size()) ? static_cast<int>(mBins.size()) - 1 : bin);
+            mBins [bin]++;
+            mMinimum = mCount == 0 || value < mMinimum ? value : mMinimum;
+            mMaximum = mCount == 0 || value > mMaximum ? value : mMaximum;
+            mCount++;
+            mSum += value;
+            mSumOfSquares += value * value;
+        }
+
+
+        /*!
+         * Adds the values of another histogram with the same bins.
+         */
+        void Merge (const Histogram& other);
+
+
+        void Clear ();
+
+    private:
+        /* ====================  DATA MEMBERS  ======================================= */
+        std::vector<Uint64> mBins;
+        double mBinWidth;
+        Uint64 mCount;
+        double mSum;
+        double mSumOfSquares;
+        double mMinimum;
+        double mMaximum;
+
+}; /* -----  end of class Histogram  ----- */
+
+
+/*!
+ * Retrieves the 95% confidence interval of a probability from successes out of trials (Wilson score interval).
+ */
+void GetProportionConfidence (Uint64 successes, Uint64 trials, double& low, double& high);
@@ -0,0 +1,80 @@
+#include "InputQueue.h"
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+InputQueue::InputQueue () :
+    mTail (0),
+    mCachedHead (0),
+    mIsMotionPending (false),
+    mCoalescedCount (0),
+    mDroppedCount (0),
+    mHead (0),
+    mCachedTail (0)
+{
+}
+
+
+void InputQueue::Push (const SDL_Event& e, Uint64 counter)
+{
+    if (e.type == SDL_MOUSEMOTION) {
+        mCoalescedCount += mIsMotionPending ? 1 : 0;
+        mIsMotionPending = true;
+        mPendingMotion.mEvent = e;
+        mPendingMotion.mCounter = counter;
+        return;
+    }
+    // the motion goes first, a button released somewhere has to see the drag up to there
+    EndFrame();
+    Enqueue (e, counter);
+}
+
+
+void InputQueue::EndFrame ()
+{
+    if (mIsMotionPending) {
+        mIsMotionPending = false;
+        Enqueue (mPendingMotion.mEvent, mPendingMotion.mCounter);
+    }
+}
+
+
+void InputQueue::Enqueue (const SDL_Event& e, Uint64 counter)
+{
+    const Uint32 tail = mTail.load (std::memory_order_relaxed);
+    if (tail - mCachedHead == CAPACITY) {
+        mCachedHead = mHead.load (std::memory_order_acquire);
+        if (tail - mCachedHead == CAPACITY) {
+            mDroppedCount++;
+            return;
+        }
+    }
+    Event& event = mEvents [tail & (CAPACITY - 1)];
+    event.mEvent = e;
+    event.mCounter = counter;
+    mTail.store (tail + 1, std::memory_order_release);
+}
+
+
+const InputQueue::Event* InputQueue::Peek ()
+{
+    const Uint32 head = mHead.load (std::memory_order_relaxed);
+    if (head == mCachedTail) {
+        mCachedTail = mTail.load (std::memory_order_acquire);
+        if (head == mCachedTail) {
+            return NULL;
+        }
+    }
+    return &mEvents [head & (CAPACITY - 1)];
+}
+
+
+void InputQueue::Pop ()
+{
+    mHead.store (mHead.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+}
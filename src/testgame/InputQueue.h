@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Hands input events from the thread that polls the window to the simulation thread, without locks.
+ *
+ * A fixed ring of CAPACITY events with one producer and one consumer: the producer only moves the tail, the consumer
+ * only moves the head. Every event carries the counter value (eg. SDL_GetPerformanceCounter) it was polled at, so the
+ * simulation can apply it before the first step that is due after it.
+ *
+ * Mouse motion is coalesced on the producer side: of a run of motion events polled in one frame only the last one is
+ * queued, when another event or EndFrame follows. The game only needs to know where the mouse is, so heavy mouse
+ * polling costs the simulation one drag update per frame. Should the ring ever be full, new events are dropped and
+ * counted.
+ */
+class InputQueue
+{
+    public:
+        static const int CAPACITY = 256;        ///< a power of two
+
+        struct Event {
+            Uint64 mCounter;                    ///< when the event was polled
+            SDL_Event mEvent;
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        InputQueue ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /// motion events replaced by a later one, producer thread
+        Uint64 GetCoalescedCount () const
+        {
+            return mCoalescedCount;
+        }
+
+        /// events dropped because the ring was full, producer thread
+        Uint64 GetDroppedCount () const
+        {
+            return mDroppedCount;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Queues an event, or holds it back if it is mouse motion. Producer thread.
+         * @param counter the counter value the event was polled at.
+         */
+        void Push (const SDL_Event& e, Uint64 counter);
+
+
+        /*!
+         * Queues the mouse motion held back, to be called after polling the events of a frame. Producer thread.
+         */
+        void EndFrame ();
+
+
+        /*!
+         * Looks at the oldest queued event. Consumer thread.
+         * @return the event, valid until Pop; NULL if the queue is empty.
+         */
+        const Event* Peek ();
+
+
+        /*!
+         * Removes the event Peek returned. Consumer thread.
+         */
+        void Pop ();
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        InputQueue (const InputQueue&);
+        InputQueue& operator= (const InputQueue&);
+
+        /* ====================  MUTATORS      ======================================= */
+        void Enqueue (const SDL_Event& e, Uint64 counter);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        Event mEvents [CAPACITY];
+        // producer side
+        std::atomic<Uint32> mTail;              ///< events pushed, wrapping
+        Uint32 mCachedHead;                     ///< the consumer's head as last seen, to rarely touch its cache line
+        bool mIsMotionPending;
+        Event mPendingMotion;
+        Uint64 mCoalescedCount;
+        Uint64 mDroppedCount;
+        char mProducerPadding [64];
+        // consumer side
+        std::atomic<Uint32> mHead;              ///< events popped, wrapping
+        Uint32 mCachedTail;
+
+}; /* -----  end of class InputQueue  ----- */
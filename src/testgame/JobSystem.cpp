@@ -0,0 +1,420 @@
+#include "JobSystem.h"
+#include <GameRandom.h>
+#include <assert.h>
+#include <stdio.h>
+#include <chrono>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+bool JobSystem::sIsLoggingEnabled = true;
+
+
+// the worker the current thread is, -1 for threads that are not workers of tJobSystem
+static thread_local JobSystem* tJobSystem = NULL;
+static thread_local int tWorkerIndex = -1;
+
+
+JobSystem::WorkStealingDeque::WorkStealingDeque () : mTop (0), mBottom (0)
+{
+    for (int i = 0; i < DEQUE_SIZE; i++) {
+        mJobs [i].store (NULL, std::memory_order_relaxed);
+    }
+}
+
+
+bool JobSystem::WorkStealingDeque::Push (Job* job)
+{
+    int bottom = mBottom.load (std::memory_order_relaxed);
+    int top = mTop.load (std::memory_order_acquire);
+    if (bottom - top >= DEQUE_SIZE) {
+        return false;
+    }
+    mJobs [bottom & (DEQUE_SIZE - 1)].store (job, std::memory_order_relaxed);
+    mBottom.store (bottom + 1, std::memory_order_release);
+    return true;
+}
+
+
+JobSystem::Job* JobSystem::WorkStealingDeque::Pop ()
+{
+    int bottom = mBottom.load (std::memory_order_relaxed) - 1;
+    mBottom.store (bottom, std::memory_order_seq_cst);
+    int top = mTop.load (std::memory_order_seq_cst);
+    if (top > bottom) {
+        // empty
+        mBottom.store (bottom + 1, std::memory_order_relaxed);
+        return NULL;
+    }
+    Job* job = mJobs [bottom & (DEQUE_SIZE - 1)].load (std::memory_order_relaxed);
+    if (top == bottom) {
+        // last job, race against thieves for it
+        if (!mTop.compare_exchange_strong (top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = NULL;
+        }
+        mBottom.store (bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+
+JobSystem::Job* JobSystem::WorkStealingDeque::Steal ()
+{
+    int top = mTop.load (std::memory_order_seq_cst);
+    int bottom = mBottom.load (std::memory_order_seq_cst);
+    if (top >= bottom) {
+        return NULL;
+    }
+    Job* job = mJobs [top & (DEQUE_SIZE - 1)].load (std::memory_order_relaxed);
+    if (!mTop.compare_exchange_strong (top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return NULL;
+    }
+    return job;
+}
+
+
+JobSystem::JobSystem (int workerCount, bool isCallerWorker) :
+    mWorkers(),
+    mIsRunning (true),
+    mSleepingWorkers (0),
+    mSleepMutex(),
+    mWakeCondition(),
+    mInboxMutex(),
+    mInbox(),
+    mInboxSize (0),
+    mForeignJobPool (JOB_POOL_SIZE),
+    mNextForeignPoolJob (0),
+    mIsCallerWorker (isCallerWorker),
+    mPreviousJobSystem (isCallerWorker ? tJobSystem : NULL),
+    mPreviousWorkerIndex (isCallerWorker ? tWorkerIndex : -1)
+{
+    if (workerCount <= 0) {
+        workerCount = static_cast<int>(std::thread::hardware_concurrency());
+        if (workerCount <= 0) {
+            workerCount = 1;
+        }
+    }
+    mInbox.reserve (JOB_POOL_SIZE);
+    for (int workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+        Worker* worker = new Worker();
+        worker->mNextPoolJob = 0;
+        worker->mRandomState = GameRandom::SeedToState (workerIndex);
+        worker->mStats.mExecutedJobs = 0;
+        worker->mStats.mStolenJobs = 0;
+        worker->mStats.mFailedSteals = 0;
+        worker->mStats.mIdleMicroseconds = 0;
+        mWorkers.push_back (worker);
+    }
+    if (mIsCallerWorker) {
+        tJobSystem = this;
+        tWorkerIndex = 0;
+    }
+    for (int workerIndex = mIsCallerWorker ? 1 : 0; workerIndex < workerCount; workerIndex++) {
+        mWorkers [workerIndex]->mThread = std::thread (&JobSystem::WorkerLoop, this, workerIndex);
+    }
+    if (sIsLoggingEnabled) {
+        printf ("JobSystem::JobSystem: started %d workers.\n", workerCount);
+    }
+}
+
+
+JobSystem::~JobSystem ()
+{
+    mIsRunning = false;
+    {
+        std::lock_guard<std::mutex> lock (mSleepMutex);
+        mWakeCondition.notify_all();
+    }
+    for (size_t workerIndex = mIsCallerWorker ? 1 : 0; workerIndex < mWorkers.size(); workerIndex++) {
+        mWorkers [workerIndex]->mThread.join();
+    }
+    for (size_t workerIndex = 0; workerIndex < mWorkers.size(); workerIndex++) {
+        delete mWorkers [workerIndex];
+    }
+    // the job system the constructing thread was a worker of before this one is again; if the thread still runs a
+    // job system it constructed later, that one goes back past this one when it is destroyed
+    if (tJobSystem == this) {
+        tJobSystem = mPreviousJobSystem;
+        tWorkerIndex = mPreviousWorkerIndex;
+    } else if (mIsCallerWorker) {
+        for (JobSystem* later = tJobSystem; later != NULL; later = later->mPreviousJobSystem) {
+            if (later->mPreviousJobSystem == this) {
+                later->mPreviousJobSystem = mPreviousJobSystem;
+                later->mPreviousWorkerIndex = mPreviousWorkerIndex;
+                break;
+            }
+        }
+    }
+}
+
+
+JobSystem::Job* JobSystem::CreateJob (JobFunction function, const void* context, int begin, int end, Job* parent)
+{
+    Job* job = NULL;
+    if (tJobSystem == this) {
+        Worker* worker = mWorkers [tWorkerIndex];
+        job = AllocateJob (worker->mJobPool, worker->mNextPoolJob);
+    } else {
+        std::lock_guard<std::mutex> lock (mInboxMutex);
+        job = AllocateJob (&mForeignJobPool [0], mNextForeignPoolJob);
+    }
+    job->mFunction = function;
+    job->mContext = context;
+    job->mBegin = begin;
+    job->mEnd = end;
+    job->mParent = parent;
+    job->mUnfinishedJobs.store (1, std::memory_order_relaxed);
+    job->mPendingDependencies.store (1, std::memory_order_relaxed);
+    job->mContinuationCount.store (0, std::memory_order_relaxed);
+    if (parent != NULL) {
+        parent->mUnfinishedJobs.fetch_add (1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+
+JobSystem::Job* JobSystem::AllocateJob (Job* jobPool, unsigned int& nextPoolJob)
+{
+    // the pool is used as a ring, slots of jobs that are still queued or running are skipped
+    for (int attempt = 0; attempt < JOB_POOL_SIZE; attempt++) {
+        Job* job = &jobPool [nextPoolJob++ & (JOB_POOL_SIZE - 1)];
+        if (IsFinished (job)) {
+            // claimed right away, the foreign pool is shared by threads that allocate one after the other
+            job->mUnfinishedJobs.store (1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    printf ("ERROR: JobSystem::AllocateJob: more than %d jobs of one thread are in flight.\n", JOB_POOL_SIZE);
+    assert (0);
+    return &jobPool [nextPoolJob++ & (JOB_POOL_SIZE - 1)];
+}
+
+
+bool JobSystem::AddDependency (Job* job, Job* prerequisite)
+{
+    int continuation = prerequisite->mContinuationCount.fetch_add (1, std::memory_order_relaxed);
+    if (continuation >= MAX_CONTINUATIONS) {
+        prerequisite->mContinuationCount.fetch_sub (1, std::memory_order_relaxed);
+        printf ("ERROR: JobSystem::AddDependency: a job can have at most %d dependent jobs.\n", MAX_CONTINUATIONS);
+        return false;
+    }
+    prerequisite->mContinuations [continuation] = job;
+    job->mPendingDependencies.fetch_add (1, std::memory_order_relaxed);
+    return true;
+}
+
+
+void JobSystem::Submit (Job* job)
+{
+    // the submit token is the last pending dependency unless prerequisites are still running
+    if (job->mPendingDependencies.fetch_sub (1, std::memory_order_acq_rel) == 1) {
+        Enqueue (job);
+    }
+}
+
+
+void JobSystem::Enqueue (Job* job)
+{
+    if (tJobSystem == this) {
+        if (!mWorkers [tWorkerIndex]->mDeque.Push (job)) {
+            // deque is full, run the job right here instead
+            Execute (job, tWorkerIndex);
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock (mInboxMutex);
+        mInbox.push_back (job);
+        mInboxSize.store (static_cast<int>(mInbox.size()), std::memory_order_release);
+    }
+    if (mSleepingWorkers.load (std::memory_order_acquire) > 0) {
+        mWakeCondition.notify_one();
+    }
+}
+
+
+JobSystem::Job* JobSystem::FindJob (int workerIndex)
+{
+    // threads that are not workers have no deque and no counters, they take from the inbox and steal
+    static thread_local Uint32 tForeignRandomState = 0x9e3779b9U;
+    Worker* worker = workerIndex >= 0 ? mWorkers [workerIndex] : NULL;
+    Job* job = worker != NULL ? worker->mDeque.Pop() : NULL;
+    if (job != NULL) {
+        return job;
+    }
+    if (mInboxSize.load (std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock (mInboxMutex);
+        if (!mInbox.empty()) {
+            job = mInbox.back();
+            mInbox.pop_back();
+            mInboxSize.store (static_cast<int>(mInbox.size()), std::memory_order_release);
+            return job;
+        }
+    }
+    const int workerCount = static_cast<int>(mWorkers.size());
+    if (workerCount > 1 || worker == NULL) {
+        // start at a random victim so thieves spread over the deques
+        Uint32& randomState = worker != NULL ? worker->mRandomState : tForeignRandomState;
+        randomState = GameRandom::Step (randomState);
+        int victim = GameRandom::ToRange (randomState, workerCount);
+        for (int attempt = 0; attempt < workerCount; attempt++, victim = (victim + 1) % workerCount) {
+            if (victim == workerIndex) {
+                continue;
+            }
+            job = mWorkers [victim]->mDeque.Steal();
+            if (job != NULL) {
+                if (worker != NULL) {
+                    worker->mStats.mStolenJobs.fetch_add (1, std::memory_order_relaxed);
+                }
+                return job;
+            }
+        }
+        if (worker != NULL) {
+            worker->mStats.mFailedSteals.fetch_add (1, std::memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+
+void JobSystem::Execute (Job* job, int workerIndex)
+{
+    job->mFunction (job->mContext, job->mBegin, job->mEnd);
+    if (workerIndex >= 0) {
+        mWorkers [workerIndex]->mStats.mExecutedJobs.fetch_add (1, std::memory_order_relaxed);
+    }
+    Finish (job);
+}
+
+
+void JobSystem::Finish (Job* job)
+{
+    // once the count reaches zero the slot may be reused right away, so everything needed afterwards is read first
+    Job* parent = job->mParent;
+    Job* continuations [MAX_CONTINUATIONS];
+    int continuationCount = job->mContinuationCount.load (std::memory_order_acquire);
+    for (int continuation = 0; continuation < continuationCount; continuation++) {
+        continuations [continuation] = job->mContinuations [continuation];
+    }
+    if (job->mUnfinishedJobs.fetch_sub (1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    for (int continuation = 0; continuation < continuationCount; continuation++) {
+        Job* dependent = continuations [continuation];
+        if (dependent->mPendingDependencies.fetch_sub (1, std::memory_order_acq_rel) == 1) {
+            Enqueue (dependent);
+        }
+    }
+    if (parent != NULL) {
+        Finish (parent);
+    }
+}
+
+
+void JobSystem::Wait (const Job* job)
+{
+    // threads that are not workers help as well, otherwise a system whose only worker is
+    // the constructing thread would never run the jobs of other threads
+    const int workerIndex = tJobSystem == this ? tWorkerIndex : -1;
+    while (!IsFinished (job)) {
+        Job* otherJob = FindJob (workerIndex);
+        if (otherJob != NULL) {
+            Execute (otherJob, workerIndex);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+static void RunNothing (const void* context, int begin, int end)
+{
+    (void)context;
+    (void)begin;
+    (void)end;
+}
+
+
+void JobSystem::SplitRange (const void* context, int begin, int end)
+{
+    const ParallelForData* data = static_cast<const ParallelForData*>(context);
+    // hand the upper halves to the deque and keep the lower half; thieves take the big halves from the top,
+    // while this worker only ever has about log2 (count / grainSize) jobs queued
+    while (end - begin > data->mGrainSize) {
+        int middle = begin + (end - begin) / 2;
+        data->mJobSystem->Submit (data->mJobSystem->CreateJob (&SplitRange, data, middle, end, data->mRoot));
+        end = middle;
+    }
+    data->mFunction (data->mContext, begin, end);
+}
+
+
+void JobSystem::ParallelFor (int count, int grainSize, JobFunction function, const void* context)
+{
+    if (count <= 0) {
+        return;
+    }
+    ParallelForData data;
+    data.mJobSystem = this;
+    data.mFunction = function;
+    data.mContext = context;
+    data.mGrainSize = grainSize < 1 ? 1 : grainSize;
+    data.mRoot = CreateJob (&RunNothing, NULL);
+    Submit (CreateJob (&SplitRange, &data, 0, count, data.mRoot));
+    // the root does no work itself, finishing it leaves it waiting for its children only
+    Finish (data.mRoot);
+    Wait (data.mRoot);
+}
+
+
+void JobSystem::WorkerLoop (int workerIndex)
+{
+    tJobSystem = this;
+    tWorkerIndex = workerIndex;
+    Worker* worker = mWorkers [workerIndex];
+    int failedAttempts = 0;
+    while (mIsRunning.load (std::memory_order_acquire)) {
+        Job* job = FindJob (workerIndex);
+        if (job != NULL) {
+            Execute (job, workerIndex);
+            failedAttempts = 0;
+            continue;
+        }
+        // spin briefly, then sleep; the timeout covers a wake up that raced with going to sleep
+        if (++failedAttempts < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::chrono::steady_clock::time_point sleepStart = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock (mSleepMutex);
+            mSleepingWorkers.fetch_add (1, std::memory_order_acq_rel);
+            if (mIsRunning.load (std::memory_order_acquire)) {
+                mWakeCondition.wait_for (lock, std::chrono::milliseconds (2));
+            }
+            mSleepingWorkers.fetch_sub (1, std::memory_order_acq_rel);
+        }
+        std::chrono::microseconds slept = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sleepStart);
+        worker->mStats.mIdleMicroseconds.fetch_add (static_cast<Uint64>(slept.count()), std::memory_order_relaxed);
+        failedAttempts = 0;
+    }
+}
+
+
+void JobSystem::PrintWorkerStats () const
+{
+    printf ("JobSystem worker stats:\n");
+    printf ("%8s %14s %12s %14s %12s\n", "worker", "executed", "stolen", "failed steals", "idle ms");
+    for (size_t workerIndex = 0; workerIndex < mWorkers.size(); workerIndex++) {
+        const WorkerStats& stats = mWorkers [workerIndex]->mStats;
+        printf ("%8d %14llu %12llu %14llu %12llu\n", static_cast<int>(workerIndex),
+                static_cast<unsigned long long>(stats.mExecutedJobs.load()),
+                static_cast<unsigned long long>(stats.mStolenJobs.load()),
+                static_cast<unsigned long long>(stats.mFailedSteals.load()),
+                static_cast<unsigned long long>(stats.mIdleMicroseconds.load() / 1000));
+    }
+}
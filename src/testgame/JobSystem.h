@@ -0,0 +1,245 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Work-stealing thread pool shared by everything that runs in parallel (batch simulation, bots, asset decoding).
+ * Every worker owns a deque: it pushes and pops jobs at the bottom without locks, idle workers steal from the top
+ * of other deques with a single compare-and-swap. The thread constructing the JobSystem is worker 0 unless it asks
+ * for threads of its own only; it runs jobs while it waits for them. Threads that are not workers may submit as well,
+ * their jobs go through a locked inbox, and they run jobs too while they wait.
+ * Jobs are taken from fixed per worker pools, so submitting does not allocate.
+ */
+class JobSystem
+{
+    public:
+        /// a job runs its function with its context over the index range [begin, end)
+        typedef void (*JobFunction) (const void* context, int begin, int end);
+
+        /// the number of jobs created by one thread that may be unfinished at the same time
+        static const int JOB_POOL_SIZE = 4096;
+        /// the capacity of every worker's deque, a full deque makes Submit run the job right away
+        static const int DEQUE_SIZE = 4096;
+        /// how many jobs may depend on a single job
+        static const int MAX_CONTINUATIONS = 8;
+
+        /*!
+         * A unit of work. Create it with CreateJob, optionally add dependencies, then Submit it.
+         */
+        struct Job {
+            JobFunction mFunction;
+            const void* mContext;
+            int mBegin, mEnd;
+            Job* mParent;                             ///< job that is only finished once this job is
+            std::atomic<int> mUnfinishedJobs;         ///< this job plus its unfinished children
+            std::atomic<int> mPendingDependencies;    ///< unfinished prerequisites plus one until Submit is called
+            std::atomic<int> mContinuationCount;
+            Job* mContinuations [MAX_CONTINUATIONS];  ///< jobs waiting for this job to finish
+        };
+
+        /*!
+         * Counters of one worker, updated by the worker and readable from any thread.
+         */
+        struct WorkerStats {
+            std::atomic<Uint64> mExecutedJobs;    ///< jobs the worker ran
+            std::atomic<Uint64> mStolenJobs;      ///< jobs the worker took from other deques
+            std::atomic<Uint64> mFailedSteals;    ///< steal attempts that found nothing or lost a race
+            std::atomic<Uint64> mIdleMicroseconds;///< time spent sleeping for lack of work
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Starts the workers. A calling thread that is a worker stays worker 0 until the JobSystem is destroyed, then it is
+         * again the worker of the JobSystem it was before, in whatever order its JobSystems are destroyed.
+         * Threads that do not wait for jobs, like a render loop or the host of a library, do better as no worker.
+         * @param workerCount the number of workers, 0 to use every hardware thread.
+         * @param isCallerWorker true to make the calling thread worker 0 and start workerCount - 1 threads,
+         *  false to start workerCount threads and leave the calling thread as it is.
+         */
+        explicit JobSystem (int workerCount = 0, bool isCallerWorker = true);
+        ~JobSystem ();
+
+
+        /*!
+         * Enables or disables the message every JobSystem prints when it starts its workers.
+         * Errors are always printed. Libraries loaded into other programs disable it.
+         * @param isLoggingEnabled true to print informational messages, which is the default.
+         */
+        static void SetIsLoggingEnabled (bool isLoggingEnabled)
+        {
+            sIsLoggingEnabled = isLoggingEnabled;
+        }
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        int GetWorkerCount () const
+        {
+            return static_cast<int>(mWorkers.size());
+        }
+
+
+        /*!
+         * Retrieves the counters of a worker.
+         */
+        const WorkerStats& GetWorkerStats (int worker) const
+        {
+            return mWorkers [worker]->mStats;
+        }
+
+
+        /*!
+         * Prints executed jobs, steals, failed steals and idle time of every worker.
+         */
+        void PrintWorkerStats () const;
+
+
+        /*!
+         * Answers whether the job and all its children are finished.
+         */
+        static bool IsFinished (const Job* job)
+        {
+            return job->mUnfinishedJobs.load (std::memory_order_acquire) == 0;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Takes a job from the pool of the calling thread. Slots of finished jobs are reused,
+         * so a job must not be waited for after the creating thread made JOB_POOL_SIZE more jobs.
+         * @param function the function to run.
+         * @param context passed to the function, must stay valid until the job is finished.
+         * @param begin first index passed to the function.
+         * @param end index past the last one passed to the function.
+         * @param parent optional job that is not finished until this job is.
+         * @return the job, to be submitted with Submit.
+         */
+        Job* CreateJob (JobFunction function, const void* context, int begin = 0, int end = 1, Job* parent = NULL);
+
+
+        /*!
+         * Makes job wait for prerequisite. Both jobs must not be submitted yet.
+         * @return false if prerequisite already has MAX_CONTINUATIONS dependents.
+         */
+        bool AddDependency (Job* job, Job* prerequisite);
+
+
+        /*!
+         * Queues the job; it runs as soon as all its prerequisites are finished.
+         */
+        void Submit (Job* job);
+
+
+        /*!
+         * Runs other jobs until the given job is finished.
+         */
+        void Wait (const Job* job);
+
+
+        /*!
+         * Splits [0, count) into ranges of at most grainSize indices, runs them on all workers and waits for them.
+         * @param count the number of indices.
+         * @param grainSize the maximum number of indices per job.
+         * @param function callable as function (int begin, int end).
+         */
+        template <class Function>
+        void ParallelFor (int count, int grainSize, const Function& function)
+        {
+            ParallelFor (count, grainSize, &InvokeRange<Function>, &function);
+        }
+
+
+        /*!
+         * ParallelFor for a plain job function.
+         */
+        void ParallelFor (int count, int grainSize, JobFunction function, const void* context);
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        JobSystem (const JobSystem&);
+        JobSystem& operator= (const JobSystem&);
+
+        /*!
+         * Fixed size Chase-Lev deque. Only the owning worker calls Push and Pop, any thread may call Steal.
+         */
+        class WorkStealingDeque
+        {
+            public:
+                WorkStealingDeque ();
+                bool Push (Job* job);
+                Job* Pop ();
+                Job* Steal ();
+            private:
+                std::atomic<int> mTop;
+                std::atomic<int> mBottom;
+                std::atomic<Job*> mJobs [DEQUE_SIZE];
+        };
+
+        struct Worker {
+            WorkStealingDeque mDeque;
+            Job mJobPool [JOB_POOL_SIZE];
+            unsigned int mNextPoolJob;
+            Uint32 mRandomState;        ///< picks steal victims
+            WorkerStats mStats;
+            std::thread mThread;
+        };
+
+        struct ParallelForData {
+            JobSystem* mJobSystem;
+            JobFunction mFunction;
+            const void* mContext;
+            int mGrainSize;
+            Job* mRoot;
+        };
+
+        /*!
+         * Job function of ParallelFor: splits its range until it is at most the grain size, then runs it.
+         */
+        static void SplitRange (const void* context, int begin, int end);
+
+        template <class Function>
+        static void InvokeRange (const void* context, int begin, int end)
+        {
+            (*static_cast<const Function*>(context)) (begin, end);
+        }
+
+        /* ====================  MUTATORS      ======================================= */
+        Job* AllocateJob (Job* jobPool, unsigned int& nextPoolJob);
+        void WorkerLoop (int workerIndex);
+        Job* FindJob (int workerIndex);
+        void Execute (Job* job, int workerIndex);
+        void Finish (Job* job);
+        void Enqueue (Job* job);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        static bool sIsLoggingEnabled;      ///< whether informational messages are printed
+
+        std::vector<Worker*> mWorkers;
+        std::atomic<bool> mIsRunning;
+        std::atomic<int> mSleepingWorkers;
+        std::mutex mSleepMutex;
+        std::condition_variable mWakeCondition;
+        std::mutex mInboxMutex;             ///< guards jobs and job pool of threads that are not workers
+        std::vector<Job*> mInbox;
+        std::atomic<int> mInboxSize;
+        std::vector<Job> mForeignJobPool;
+        unsigned int mNextForeignPoolJob;
+        bool mIsCallerWorker;                   ///< the constructing thread is worker 0
+        JobSystem* mPreviousJobSystem;          ///< the constructing thread's job system before, restored on destruction
+        int mPreviousWorkerIndex;               ///< the constructing thread's worker index in mPreviousJobSystem
+
+}; /* -----  end of class JobSystem  ----- */
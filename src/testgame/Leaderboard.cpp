@@ -0,0 +1,381 @@
+#include "Leaderboard.h"
+#include <Crc32.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+static const char MAGIC [8] = { 'T', 'M', 'S', 'C', 'O', 'R', 'E', 'S' };
+static const Uint32 VERSION = 1;
+// 1970-01-01 was a Thursday, weeks start on Monday
+static const Uint64 WEEK_START_DAY_OFFSET = 3;
+
+
+Leaderboard::Leaderboard () :
+    mFile (-1),
+    mFileSize (0),
+    mTruncatedBytes (0),
+    mCommitIntervalMilis (0),
+    mSubmittedCount (0),
+    mCommittedCount (0),
+    mIsClosing (false),
+    mIsFailed (false),
+    mIsBufferPending (false),
+    mRecordCount (0),
+    mCommitCount (0)
+{
+}
+
+
+Leaderboard::~Leaderboard ()
+{
+    Close();
+}
+
+
+Uint64 Leaderboard::GetTimeNow ()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+
+Uint32 Leaderboard::GetChecksum (const Record& record)
+{
+    return Crc32::Update (0, reinterpret_cast<const Uint8*>(&record) + sizeof (record.mChecksum), sizeof (Record) - sizeof (record.mChecksum));
+}
+
+
+Leaderboard::Record Leaderboard::MakeRecord (Uint32 rules, Sint32 score, Uint32 seed, Uint64 player, Uint64 time)
+{
+    Record record;
+    record.mRules = rules;
+    record.mScore = score;
+    record.mSeed = seed;
+    record.mTime = time != 0 ? time : GetTimeNow();
+    record.mPlayer = player;
+    record.mChecksum = GetChecksum (record);
+    return record;
+}
+
+
+Uint64 Leaderboard::GetIndexKey (Uint32 rules, Window window, Uint64 time)
+{
+    Uint64 period = 0;
+    if (window == Day) {
+        period = time / DAY_MILIS;
+    } else if (window == Week) {
+        period = (time / DAY_MILIS + WEEK_START_DAY_OFFSET) / 7;
+    }
+    return (static_cast<Uint64>(rules) << 32) | (static_cast<Uint64>(window) << 30) | (period & 0x3FFFFFFF);
+}
+
+
+int Leaderboard::GetTop (Uint32 rules, Window window, Uint64 time, int count, Record* records) const
+{
+    std::lock_guard<std::mutex> lock (mIndexMutex);
+    std::unordered_map<Uint64, TopList>::const_iterator iterator = mIndex.find (GetIndexKey (rules, window, time));
+    if (iterator == mIndex.end()) {
+        return 0;
+    }
+    const int copied = std::min (count, static_cast<int>(iterator->second.size()));
+    if (copied > 0) {
+        memcpy (records, iterator->second.data(), sizeof (Record) * copied);
+    }
+    return copied;
+}
+
+
+/*!
+ * Orders records best first: higher score, then earlier time.
+ */
+static bool IsBetter (const Leaderboard::Record& recordA, const Leaderboard::Record& recordB)
+{
+    return recordA.mScore > recordB.mScore || (recordA.mScore == recordB.mScore && recordA.mTime < recordB.mTime);
+}
+
+
+void Leaderboard::AddToIndex (const Record& record)
+{
+    for (int window = 0; window < WINDOW_COUNT; window++) {
+        TopList& topList = mIndex [GetIndexKey (record.mRules, static_cast<Window>(window), record.mTime)];
+        if (topList.size() == TOP_COUNT && !IsBetter (record, topList.back())) {
+            continue;
+        }
+        if (topList.capacity() == 0) {
+            topList.reserve (TOP_COUNT + 1);
+        }
+        topList.insert (std::upper_bound (topList.begin(), topList.end(), record, IsBetter), record);
+        if (topList.size() > TOP_COUNT) {
+            topList.pop_back();
+        }
+    }
+}
+
+
+bool Leaderboard::Open (const char* filePath, Uint32 commitIntervalMilis)
+{
+    Close();
+#ifdef TARGET_UNIX
+    mFile = open (filePath, O_RDWR | O_CREAT, 0644);
+    if (mFile < 0) {
+        printf ("ERROR: Leaderboard::Open cannot open %s.\n", filePath);
+        return false;
+    }
+    mFilePath = filePath;
+    mCommitIntervalMilis = commitIntervalMilis;
+    if (!Recover()) {
+        close (mFile);
+        mFile = -1;
+        return false;
+    }
+    mIsClosing = false;
+    mIsFailed = false;
+    mCommitThread = std::thread (&Leaderboard::RunCommits, this);
+    return true;
+#else
+    printf ("ERROR: Leaderboard::Open is not supported on this platform, %s is not used.\n", filePath);
+    return false;
+#endif
+}
+
+
+bool Leaderboard::Recover ()
+{
+#ifdef TARGET_UNIX
+    struct stat fileStatus;
+    if (fstat (mFile, &fileStatus) != 0) {
+        printf ("ERROR: Leaderboard::Recover cannot read the size of %s.\n", mFilePath.c_str());
+        return false;
+    }
+    const Uint64 fileSize = static_cast<Uint64>(fileStatus.st_size);
+    mIndex.clear();
+    mRecordCount = 0;
+    mTruncatedBytes = 0;
+    if (fileSize < sizeof (Header)) {
+        // new log, or one that crashed while its header was written
+        Header header;
+        memcpy (header.mMagic, MAGIC, sizeof (MAGIC));
+        header.mVersion = VERSION;
+        header.mRecordSize = sizeof (Record);
+        if (ftruncate (mFile, 0) != 0 || pwrite (mFile, &header, sizeof (header), 0) != sizeof (header) || fdatasync (mFile) != 0) {
+            printf ("ERROR: Leaderboard::Recover cannot write the header of %s.\n", mFilePath.c_str());
+            return false;
+        }
+        mTruncatedBytes = fileSize;
+        mFileSize = sizeof (header);
+        return true;
+    }
+
+    void* data = mmap (NULL, fileSize, PROT_READ, MAP_SHARED, mFile, 0);
+    if (data == MAP_FAILED) {
+        printf ("ERROR: Leaderboard::Recover cannot map %s.\n", mFilePath.c_str());
+        return false;
+    }
+    madvise (data, fileSize, MADV_SEQUENTIAL);
+    const Header& header = *static_cast<const Header*>(data);
+    if (memcmp (header.mMagic, MAGIC, sizeof (MAGIC)) != 0 || header.mVersion != VERSION || header.mRecordSize != sizeof (Record)) {
+        printf ("ERROR: Leaderboard::Recover %s is not a version %u leaderboard log.\n", mFilePath.c_str(), VERSION);
+        munmap (data, fileSize);
+        return false;
+    }
+    // the log ends at the first record that is not intact
+    const Record* records = reinterpret_cast<const Record*>(static_cast<const Uint8*>(data) + sizeof (Header));
+    const Uint64 maxRecordCount = (fileSize - sizeof (Header)) / sizeof (Record);
+    Uint64 recordCount = 0;
+    while (recordCount < maxRecordCount && GetChecksum (records [recordCount]) == records [recordCount].mChecksum) {
+        AddToIndex (records [recordCount]);
+        recordCount++;
+    }
+    munmap (data, fileSize);
+
+    mFileSize = sizeof (Header) + recordCount * sizeof (Record);
+    if (mFileSize < fileSize) {
+        printf ("WARNING: Leaderboard::Recover %s ends with %u damaged bytes, they are cut off.\n", mFilePath.c_str(),
+                static_cast<unsigned>(fileSize - mFileSize));
+        if (ftruncate (mFile, static_cast<off_t>(mFileSize)) != 0 || fdatasync (mFile) != 0) {
+            printf ("ERROR: Leaderboard::Recover cannot truncate %s.\n", mFilePath.c_str());
+            return false;
+        }
+        mTruncatedBytes = fileSize - mFileSize;
+    }
+    mRecordCount = recordCount;
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void Leaderboard::Close ()
+{
+    if (mFile < 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock (mQueueMutex);
+        mIsClosing = true;
+    }
+    mQueueCondition.notify_one();
+    mCommitThread.join();
+#ifdef TARGET_UNIX
+    close (mFile);
+#endif
+    mFile = -1;
+}
+
+
+Leaderboard::SubmitBuffer* Leaderboard::CreateSubmitBuffer ()
+{
+    std::lock_guard<std::mutex> lock (mQueueMutex);
+    mSubmitBuffers.push_back (std::unique_ptr<SubmitBuffer> (new SubmitBuffer (*this)));
+    return mSubmitBuffers.back().get();
+}
+
+
+void Leaderboard::SubmitBuffer::Submit (Uint32 rules, Sint32 score, Uint32 seed, Uint64 player, Uint64 time)
+{
+    const Record record = Leaderboard::MakeRecord (rules, score, seed, player, time);
+    bool isFirst;
+    {
+        std::lock_guard<std::mutex> lock (mMutex);
+        isFirst = mRecords.empty();
+        mRecords.push_back (record);
+    }
+    // the first score buffered since the last commit wakes the commit thread; it takes the queue lock for that,
+    // so the wake up cannot slip in between the commit thread's last look at the buffers and its going to sleep
+    if (isFirst && !mLeaderboard.mIsBufferPending.exchange (true)) {
+        std::lock_guard<std::mutex> lock (mLeaderboard.mQueueMutex);
+        mLeaderboard.mQueueCondition.notify_one();
+    }
+}
+
+
+Uint64 Leaderboard::Submit (Uint32 rules, Sint32 score, Uint32 seed, Uint64 player, Uint64 time)
+{
+    const Record record = MakeRecord (rules, score, seed, player, time);
+    Uint64 sequence;
+    bool isFirst;
+    {
+        std::lock_guard<std::mutex> lock (mQueueMutex);
+        if (mFile < 0 || mIsClosing || mIsFailed) {
+            return 0;
+        }
+        isFirst = mQueue.empty();
+        mQueue.push_back (record);
+        sequence = ++mSubmittedCount;
+    }
+    if (isFirst) {
+        mQueueCondition.notify_one();
+    }
+    return sequence;
+}
+
+
+bool Leaderboard::WaitForCommit (Uint64 sequence)
+{
+    std::unique_lock<std::mutex> lock (mQueueMutex);
+    while (mCommittedCount < sequence && !mIsFailed) {
+        mCommitCondition.wait (lock);
+    }
+    return mCommittedCount >= sequence;
+}
+
+
+bool Leaderboard::IsFailed () const
+{
+    std::lock_guard<std::mutex> lock (mQueueMutex);
+    return mIsFailed;
+}
+
+
+void Leaderboard::RunCommits ()
+{
+    std::vector<Record> batch;
+    std::unique_lock<std::mutex> lock (mQueueMutex);
+    while (true) {
+        while (mQueue.empty() && !mIsBufferPending.load() && !mIsClosing) {
+            mQueueCondition.wait (lock);
+        }
+        if (mQueue.empty() && !mIsBufferPending.load()) {
+            break;
+        }
+        // let more scores arrive, they share the sync
+        if (!mIsClosing && mCommitIntervalMilis > 0) {
+            mQueueCondition.wait_for (lock, std::chrono::milliseconds (mCommitIntervalMilis), [this] { return mIsClosing; });
+        }
+        batch.swap (mQueue);
+        const Uint64 batchEnd = mSubmittedCount;
+        // cleared first, a score buffered while the buffers are drained is either taken now or wakes the next round
+        mIsBufferPending.store (false);
+        for (size_t index = 0; index < mSubmitBuffers.size(); index++) {
+            SubmitBuffer& submitBuffer = *mSubmitBuffers [index];
+            std::lock_guard<std::mutex> bufferLock (submitBuffer.mMutex);
+            batch.insert (batch.end(), submitBuffer.mRecords.begin(), submitBuffer.mRecords.end());
+            submitBuffer.mRecords.clear();
+        }
+        if (mIsFailed) {
+            // queued before the failure was seen, they are dropped like the batch that failed
+            batch.clear();
+            continue;
+        }
+        if (batch.empty()) {
+            continue;
+        }
+        lock.unlock();
+
+        bool isCommitted = false;
+#ifdef TARGET_UNIX
+        const size_t size = batch.size() * sizeof (Record);
+        size_t written = 0;
+        while (written < size) {
+            const ssize_t result = pwrite (mFile, reinterpret_cast<const Uint8*>(batch.data()) + written, size - written,
+                    static_cast<off_t>(mFileSize + written));
+            if (result <= 0) {
+                // the records cannot be made durable, they are cut off again and not indexed
+                printf ("ERROR: Leaderboard::RunCommits cannot write %u scores to %s.\n", static_cast<unsigned>(batch.size()), mFilePath.c_str());
+                break;
+            }
+            written += static_cast<size_t>(result);
+        }
+        isCommitted = written == size && fdatasync (mFile) == 0;
+        mCommitCount.fetch_add (1);
+        if (written == size && !isCommitted) {
+            printf ("ERROR: Leaderboard::RunCommits cannot sync %u scores to %s.\n", static_cast<unsigned>(batch.size()), mFilePath.c_str());
+        }
+        if (!isCommitted && ftruncate (mFile, static_cast<off_t>(mFileSize)) != 0) {
+            // what was written of the batch stays, the next Open indexes whatever of it is intact
+            printf ("ERROR: Leaderboard::RunCommits cannot cut the failed scores off %s.\n", mFilePath.c_str());
+        }
+        if (isCommitted) {
+            mFileSize += size;
+            std::lock_guard<std::mutex> indexLock (mIndexMutex);
+            for (size_t index = 0; index < batch.size(); index++) {
+                AddToIndex (batch [index]);
+            }
+            mRecordCount.fetch_add (batch.size());
+        }
+#endif
+        batch.clear();
+
+        lock.lock();
+        // only durable scores count as committed, waiters of the others learn of the failure
+        if (isCommitted) {
+            mCommittedCount = batchEnd;
+        } else {
+            mIsFailed = true;
+        }
+        mCommitCondition.notify_all();
+    }
+}
@@ -0,0 +1,237 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Embedded leaderboard of final scores, kept in an append-only log file.
+ *
+ * The file starts with a Leaderboard::Header followed by fixed-size Records, each with a CRC-32 of its contents.
+ * Records are never changed once written. A record cut short or damaged by a crash ends the log: Open truncates the
+ * file after the last intact record.
+ *
+ * Submit only queues a score, a commit thread writes everything queued with one write and one fdatasync every
+ * commit interval (group commit), so one sync covers many scores. Threads that submit all the time, like the event
+ * loops of a GameServer, each take a SubmitBuffer of their own instead, so they do not contend for the queue. Committed scores go into an index in memory that
+ * keeps the TOP_COUNT best scores of every rules configuration and time window; Open rebuilds it by memory-mapping
+ * the log. Submit, WaitForCommit and GetTop can be called from any thread.
+ *
+ * Linux only.
+ */
+class Leaderboard
+{
+    public:
+        static const int TOP_COUNT = 100;           ///< scores kept per rules configuration and time window
+        static const Uint64 DAY_MILIS = 24 * 60 * 60 * 1000;
+
+        /// time windows of the index, a score counts in its day, its week (Monday to Sunday, UTC) and all time
+        enum Window {
+            AllTime = 0,
+            Day = 1,
+            Week = 2,
+            WINDOW_COUNT = 3
+        };
+
+        /// a score as stored in the log and returned by GetTop
+        struct Record {
+            Uint32 mChecksum;       ///< CRC-32 of the rest of the record
+            Uint32 mRules;          ///< see MakeRules
+            Sint32 mScore;
+            Uint32 mSeed;           ///< of the game, replays can be checked against it
+            Uint64 mTime;           ///< miliseconds since the Unix epoch
+            Uint64 mPlayer;
+        };
+
+        struct Header {
+            char mMagic [8];
+            Uint32 mVersion;
+            Uint32 mRecordSize;
+        };
+
+        /*!
+         * The scores of one submitting thread. Submit takes only the buffer's own lock, which the commit thread takes
+         * once per commit to drain the buffer, so threads with buffers of their own never wait for one another.
+         * Its scores are committed with the queued ones but cannot be waited for; scores submitted while the log is
+         * closed are committed once it is opened again, scores submitted after writing the log failed are dropped.
+         */
+        class SubmitBuffer
+        {
+            public:
+                /*!
+                 * Buffers a score to be committed. Does not wait for the disk.
+                 * @param time miliseconds since the Unix epoch, 0 for now.
+                 */
+                void Submit (Uint32 rules, Sint32 score, Uint32 seed, Uint64 player, Uint64 time = 0);
+
+            private:
+                friend class Leaderboard;
+
+                explicit SubmitBuffer (Leaderboard& leaderboard) : mLeaderboard (leaderboard)
+                {
+                }
+                SubmitBuffer (const SubmitBuffer&);
+                SubmitBuffer& operator= (const SubmitBuffer&);
+
+                Leaderboard& mLeaderboard;
+                std::mutex mMutex;              ///< guards mRecords
+                std::vector<Record> mRecords;
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        Leaderboard ();
+        ~Leaderboard ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Packs the rules of a game into the key its scores are ranked under.
+         */
+        static Uint32 MakeRules (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds)
+        {
+            return (static_cast<Uint32>(rows & 0xFF) << 24) | (static_cast<Uint32>(columns & 0xFF) << 16) |
+                (static_cast<Uint32>(minMatchSize & 0xF) << 12) | static_cast<Uint32>(maxGameplayTimeSeconds & 0xFFF);
+        }
+
+
+        /*!
+         * Retrieves the current time as stored in records.
+         */
+        static Uint64 GetTimeNow ();
+
+
+        /*!
+         * Copies the best scores of a rules configuration in a time window, best first; equal scores rank by time.
+         * @param time any time inside the window, ignored for AllTime.
+         * @param count the most records to copy, at most TOP_COUNT are kept.
+         * @param records output, room for count records.
+         * @return the number of records copied.
+         */
+        int GetTop (Uint32 rules, Window window, Uint64 time, int count, Record* records) const;
+
+
+        /// the number of intact records in the log, committed or read by Open
+        Uint64 GetRecordCount () const
+        {
+            return mRecordCount.load();
+        }
+
+        /// the number of fdatasync calls so far
+        Uint64 GetCommitCount () const
+        {
+            return mCommitCount.load();
+        }
+
+        /// bytes cut off the end of the log by Open
+        Uint64 GetTruncatedBytes () const
+        {
+            return mTruncatedBytes;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Opens or creates a log, rebuilds the index from it and starts the commit thread.
+         * @param commitIntervalMilis how long scores are collected before they are written and synced together.
+         * @return false if the file cannot be opened, is not a leaderboard log or cannot be repaired.
+         */
+        bool Open (const char* filePath, Uint32 commitIntervalMilis = 10);
+
+
+        /*!
+         * Commits the queued scores, stops the commit thread and closes the log.
+         */
+        void Close ();
+
+
+        /*!
+         * Creates a submission buffer for one thread.
+         * @return the buffer, it lives as long as the Leaderboard.
+         */
+        SubmitBuffer* CreateSubmitBuffer ();
+
+
+        /*!
+         * Queues a score to be committed. Does not wait for the disk.
+         * @param time miliseconds since the Unix epoch, 0 for now.
+         * @return the sequence number of the score, to wait for with WaitForCommit; 0 if the log is not open.
+         */
+        Uint64 Submit (Uint32 rules, Sint32 score, Uint32 seed, Uint64 player, Uint64 time = 0);
+
+
+        /*!
+         * Waits until a score is on disk and in the index, or until writing the log failed.
+         * @param sequence returned by Submit.
+         * @return false if the score will never be durable: a write or sync of the log failed.
+         */
+        bool WaitForCommit (Uint64 sequence);
+
+
+        /*!
+         * Answers whether a write or sync of the log failed. The log then takes no more scores until it is opened again:
+         * after a failed fdatasync the kernel may have dropped the pages, so a retry could report data durable that is not.
+         */
+        bool IsFailed () const;
+
+    private:
+        /// the best scores of one rules configuration in one window, best first
+        typedef std::vector<Record> TopList;
+
+        /* ====================  LIFECYCLE     ======================================= */
+        Leaderboard (const Leaderboard&);
+        Leaderboard& operator= (const Leaderboard&);
+
+        /* ====================  ACCESSORS     ======================================= */
+        static Uint32 GetChecksum (const Record& record);
+        static Record MakeRecord (Uint32 rules, Sint32 score, Uint32 seed, Uint64 player, Uint64 time);
+        static Uint64 GetIndexKey (Uint32 rules, Window window, Uint64 time);
+
+        /* ====================  MUTATORS      ======================================= */
+        bool Recover ();
+        void RunCommits ();
+        void AddToIndex (const Record& record);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mFile;
+        std::string mFilePath;
+        Uint64 mFileSize;                   ///< where the next record is written
+        Uint64 mTruncatedBytes;
+        Uint32 mCommitIntervalMilis;
+        std::thread mCommitThread;
+
+        // queue of submitted scores, guarded by mQueueMutex
+        mutable std::mutex mQueueMutex;
+        std::condition_variable mQueueCondition;    ///< a score was queued or the log is closing
+        std::condition_variable mCommitCondition;   ///< scores were committed
+        std::vector<Record> mQueue;
+        Uint64 mSubmittedCount;
+        Uint64 mCommittedCount;             ///< scores that are durable, counted in submission order
+        bool mIsClosing;
+        bool mIsFailed;                     ///< a write or sync failed, no score after mCommittedCount is committed
+        std::vector<std::unique_ptr<SubmitBuffer>> mSubmitBuffers;
+        std::atomic<bool> mIsBufferPending; ///< a buffer took a score since the commit thread last drained them
+
+        // index, guarded by mIndexMutex
+        mutable std::mutex mIndexMutex;
+        std::unordered_map<Uint64, TopList> mIndex;
+
+        std::atomic<Uint64> mRecordCount;
+        std::atomic<Uint64> mCommitCount;
+
+}; /* -----  end of class Leaderboard  ----- */
@@ -0,0 +1,214 @@
+#include "MctsBot.h"
+#include <GameRandom.h>
+#include <JobSystem.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/// weight of exploration against the mean points scaled to [0, 1]
+static const double EXPLORATION = 0.7;
+/// how many playouts a searcher runs between two looks at the clock
+static const int PLAYOUTS_PER_TIME_CHECK = 16;
+
+
+/*!
+ * State shared by the searchers of one Search call.
+ */
+struct MctsBot::SearchData {
+    const GameBoard* mBoard;
+    int mMaxPlayouts;
+    bool mIsTimeLimited;
+    std::chrono::steady_clock::time_point mDeadline;
+    Uint32 mSeed;
+    std::atomic<int> mStartedPlayouts;
+    std::atomic<int> mFinishedPlayouts;
+    std::atomic<Sint64> mPointScale;    ///< the most points a playout scored so far, normalizes the means
+    std::atomic<bool> mIsTimeUp;
+};
+
+
+MctsBot::MctsBot (JobSystem& jobSystem, int maxNodes, int rolloutDepth) :
+    mJobSystem (jobSystem),
+    mRolloutDepth (rolloutDepth),
+    mNodes (maxNodes > 1 ? maxNodes : 1),
+    mNodeCount (0)
+{
+}
+
+
+void MctsBot::InitNode (Node& node, int move)
+{
+    node.mMove = move;
+    node.mFirstChild = -1;
+    node.mChildCount.store (UNEXPANDED, std::memory_order_relaxed);
+    node.mVisits.store (0, std::memory_order_relaxed);
+    node.mTotalPoints.store (0, std::memory_order_relaxed);
+}
+
+
+MctsBot::SearchResult MctsBot::Search (const GameBoard& board, int maxPlayouts, Uint32 timeLimitMilis, Uint32 seed)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    SearchData searchData;
+    searchData.mBoard = &board;
+    searchData.mMaxPlayouts = maxPlayouts;
+    searchData.mIsTimeLimited = timeLimitMilis > 0;
+    searchData.mDeadline = start + std::chrono::milliseconds (timeLimitMilis);
+    searchData.mSeed = seed;
+    searchData.mStartedPlayouts.store (0);
+    searchData.mFinishedPlayouts.store (0);
+    searchData.mPointScale.store (1);
+    searchData.mIsTimeUp.store (false);
+
+    mNodeCount.store (1);
+    InitNode (mNodes [0], -1);
+    Expand (mNodes [0], board);
+
+    // one searcher per worker, each runs playouts until the shared budget is used up
+    mJobSystem.ParallelFor (mJobSystem.GetWorkerCount(), 1, [this, &searchData] (int firstSearcher, int endSearcher) {
+        for (int searcher = firstSearcher; searcher < endSearcher; searcher++) {
+            RunPlayouts (searchData, searcher);
+        }
+    });
+
+    SearchResult result;
+    result.mMove = -1;
+    result.mExpectedPoints = 0.0;
+    const Node& root = mNodes [0];
+    const int childCount = root.mChildCount.load (std::memory_order_acquire);
+    int bestVisits = -1;
+    for (int i = 0; i < childCount; i++) {
+        const Node& child = mNodes [root.mFirstChild + i];
+        const int visits = child.mVisits.load (std::memory_order_relaxed);
+        if (visits > bestVisits) {
+            bestVisits = visits;
+            result.mMove = child.mMove;
+            result.mExpectedPoints = visits > 0 ? static_cast<double>(child.mTotalPoints.load (std::memory_order_relaxed)) / visits : 0.0;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.mPlayouts = searchData.mFinishedPlayouts.load();
+    result.mNodes = mNodeCount.load() < static_cast<int>(mNodes.size()) ? mNodeCount.load() : static_cast<int>(mNodes.size());
+    result.mSeconds = elapsed.count();
+    result.mPlayoutsPerSecond = result.mSeconds > 0.0 ? result.mPlayouts / result.mSeconds : 0.0;
+    return result;
+}
+
+
+bool MctsBot::Expand (Node& node, const GameBoard& board)
+{
+    int expected = UNEXPANDED;
+    if (!node.mChildCount.compare_exchange_strong (expected, EXPANDING, std::memory_order_acquire)) {
+        return false;
+    }
+    int moves [GameBoard::MAX_MOVES];
+    const int moveCount = board.GetMatchingMoves (moves);
+    const int firstChild = mNodeCount.fetch_add (moveCount, std::memory_order_relaxed);
+    if (firstChild + moveCount > static_cast<int>(mNodes.size())) {
+        // the pool is exhausted, the node stays a leaf for the rest of the search
+        return false;
+    }
+    for (int i = 0; i < moveCount; i++) {
+        InitNode (mNodes [firstChild + i], moves [i]);
+    }
+    node.mFirstChild = firstChild;
+    node.mChildCount.store (moveCount, std::memory_order_release);
+    return true;
+}
+
+
+int MctsBot::SelectChild (const Node& node, Sint64 pointScale) const
+{
+    const int childCount = node.mChildCount.load (std::memory_order_acquire);
+    const double logParentVisits = log (static_cast<double>(node.mVisits.load (std::memory_order_relaxed) + 1));
+    int bestChild = node.mFirstChild;
+    double bestBound = -1.0;
+    for (int i = 0; i < childCount; i++) {
+        const Node& child = mNodes [node.mFirstChild + i];
+        const int visits = child.mVisits.load (std::memory_order_relaxed);
+        if (visits == 0) {
+            return node.mFirstChild + i;
+        }
+        const double mean = static_cast<double>(child.mTotalPoints.load (std::memory_order_relaxed)) / visits / pointScale;
+        const double bound = mean + EXPLORATION * sqrt (logParentVisits / visits);
+        if (bound > bestBound) {
+            bestBound = bound;
+            bestChild = node.mFirstChild + i;
+        }
+    }
+    return bestChild;
+}
+
+
+void MctsBot::RunPlayouts (SearchData& searchData, int searcher)
+{
+    GameRandom random (searchData.mSeed + 0x9e3779b9U * static_cast<Uint32>(searcher + 1));
+    int path [MAX_TREE_DEPTH + 1];
+    int pathPoints [MAX_TREE_DEPTH + 1];
+    int moves [GameBoard::MAX_MOVES];
+
+    while (!searchData.mIsTimeUp.load (std::memory_order_relaxed)) {
+        const int playout = searchData.mStartedPlayouts.fetch_add (1, std::memory_order_relaxed);
+        if (playout >= searchData.mMaxPlayouts) {
+            break;
+        }
+        if (searchData.mIsTimeLimited && playout % PLAYOUTS_PER_TIME_CHECK == 0 &&
+                std::chrono::steady_clock::now() >= searchData.mDeadline) {
+            searchData.mIsTimeUp.store (true, std::memory_order_relaxed);
+        }
+
+        GameBoard board = *searchData.mBoard;
+        board.SetRandomState (GameRandom::SeedToState (random.Next()));
+        const Sint64 pointScale = searchData.mPointScale.load (std::memory_order_relaxed);
+
+        // descend while the nodes have children, the visit counted on the way down is the virtual loss
+        int depth = 0;
+        path [0] = 0;
+        pathPoints [0] = 0;
+        mNodes [0].mVisits.fetch_add (1, std::memory_order_relaxed);
+        while (depth < MAX_TREE_DEPTH) {
+            Node& node = mNodes [path [depth]];
+            int childCount = node.mChildCount.load (std::memory_order_acquire);
+            if (childCount == UNEXPANDED && node.mVisits.load (std::memory_order_relaxed) > 1 && Expand (node, board)) {
+                childCount = node.mChildCount.load (std::memory_order_acquire);
+            }
+            if (childCount <= 0) {
+                break;
+            }
+            const int child = SelectChild (node, pointScale);
+            mNodes [child].mVisits.fetch_add (1, std::memory_order_relaxed);
+            depth++;
+            path [depth] = child;
+            pathPoints [depth] = board.ApplyMove (mNodes [child].mMove);
+        }
+
+        // random matching moves from the leaf on
+        Sint64 points = 0;
+        for (int step = 0; step < mRolloutDepth; step++) {
+            const int moveCount = board.GetMatchingMoves (moves);
+            if (moveCount == 0) {
+                break;
+            }
+            points += board.ApplyMove (moves [random.NextInt (moveCount)]);
+        }
+
+        // every node is credited with the points from its own move on
+        for (int i = depth; i >= 0; i--) {
+            points += pathPoints [i];
+            mNodes [path [i]].mTotalPoints.fetch_add (points, std::memory_order_relaxed);
+        }
+        Sint64 pointScaleSeen = searchData.mPointScale.load (std::memory_order_relaxed);
+        while (points > pointScaleSeen &&
+                !searchData.mPointScale.compare_exchange_weak (pointScaleSeen, points, std::memory_order_relaxed)) {
+        }
+        searchData.mFinishedPlayouts.fetch_add (1, std::memory_order_relaxed);
+    }
+}
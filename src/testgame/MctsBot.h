@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <GameBoard.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+class JobSystem;
+
+
+/*!
+ * Chooses swaps with Monte Carlo tree search over GameBoard.
+ * All workers of the JobSystem grow one shared tree (tree parallelism). A worker descending into a node counts
+ * a visit right away, which lowers the node's mean until its playout reports back (virtual loss) and so spreads
+ * the workers over different branches. Refills are random, so every playout samples its own refills from the root
+ * on (open loop): a node stands for a sequence of moves, not for a single board.
+ * Nodes come from a pool allocated once; a search that runs out of nodes keeps running playouts from its leaves.
+ */
+class MctsBot
+{
+    public:
+        /// the size of the node pool if none is given
+        static const int DEFAULT_MAX_NODES = 1 << 20;
+        /// how many random moves a playout makes after leaving the tree
+        static const int DEFAULT_ROLLOUT_DEPTH = 2;
+        /// the deepest a playout descends into the tree
+        static const int MAX_TREE_DEPTH = 32;
+
+        /*!
+         * The outcome of a search.
+         */
+        struct SearchResult {
+            int mMove;                  ///< the most visited move of the root, -1 if no swap makes a match
+            int mPlayouts;              ///< playouts run
+            int mNodes;                 ///< nodes taken from the pool
+            double mSeconds;            ///< wall time of the search
+            double mPlayoutsPerSecond;
+            double mExpectedPoints;     ///< mean points of the playouts through the chosen move
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates a bot and its node pool.
+         * @param jobSystem the job system running the playouts, it must outlive the bot.
+         * @param maxNodes the size of the node pool.
+         * @param rolloutDepth how many random moves a playout makes after leaving the tree.
+         */
+        MctsBot (JobSystem& jobSystem, int maxNodes = DEFAULT_MAX_NODES, int rolloutDepth = DEFAULT_ROLLOUT_DEPTH);
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Searches for the best move of the board on all workers. Stops at whichever limit is reached first.
+         * @param board the board to move on; its random state is not used, refills are sampled per playout.
+         * @param maxPlayouts the number of playouts to run.
+         * @param timeLimitMilis the time to search for, 0 for no limit.
+         * @param seed the seed for sampling refills and rollout moves.
+         * @return the chosen move and the search statistics.
+         */
+        SearchResult Search (const GameBoard& board, int maxPlayouts, Uint32 timeLimitMilis, Uint32 seed);
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        MctsBot (const MctsBot&);
+        MctsBot& operator= (const MctsBot&);
+
+        /// mChildCount values of nodes without children yet
+        static const int UNEXPANDED = -1;
+        static const int EXPANDING = -2;
+
+        struct Node {
+            int mMove;                      ///< the move leading to this node from its parent
+            int mFirstChild;                ///< pool index of the first child, the children are contiguous
+            std::atomic<int> mChildCount;   ///< UNEXPANDED, EXPANDING or the number of children
+            std::atomic<int> mVisits;       ///< finished playouts plus the ones still running through this node
+            std::atomic<Sint64> mTotalPoints;   ///< points of the finished playouts from this node's move on
+        };
+
+        struct SearchData;
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Runs playouts until the playout or time budget of the search is used up.
+         * @param searcher index of the calling searcher, picks its random seed.
+         */
+        void RunPlayouts (SearchData& searchData, int searcher);
+
+
+        /*!
+         * Creates the children of a node for the matching moves of board, if no other worker is doing it.
+         * @return false if the node is being expanded by another worker or the pool is exhausted.
+         */
+        bool Expand (Node& node, const GameBoard& board);
+
+
+        /*!
+         * Picks the child with the highest upper confidence bound, unvisited children first.
+         */
+        int SelectChild (const Node& node, Sint64 pointScale) const;
+
+
+        void InitNode (Node& node, int move);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        JobSystem& mJobSystem;
+        int mRolloutDepth;
+        std::vector<Node> mNodes;
+        std::atomic<int> mNodeCount;
+
+}; /* -----  end of class MctsBot  ----- */
@@ -0,0 +1,289 @@
+#include "PositionDataset.h"
+#include <GameBoard.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+    #include <windows.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+// the header is padded so the first chunk starts at a page boundary
+static const Uint32 HEADER_SIZE = 4096;
+
+
+/*!
+ * The bytes per position of a column, as the writer lays it out and the reader's accessors read it.
+ */
+static Uint32 GetColumnWidth (PositionDataset::Column column, Uint32 rows, Uint32 columns, Uint32 actionCount)
+{
+    switch (column) {
+        case PositionDataset::BoardColumn: return rows * columns;
+        case PositionDataset::LegalMovesColumn: return (actionCount + 7) / 8;
+        case PositionDataset::MoveScoresColumn: return actionCount * static_cast<Uint32>(sizeof (Sint16));
+        case PositionDataset::ChosenMoveColumn: return sizeof (Sint16);
+        case PositionDataset::GameColumn: return sizeof (Uint32);
+        default: return sizeof (Uint16);
+    }
+}
+
+
+/*!
+ * Checks that every column of every chunk the header describes lies inside a file of size bytes.
+ */
+static bool IsLayoutInside (const PositionDataset::Header& header, Uint64 size)
+{
+    if (header.mHeaderSize < sizeof (PositionDataset::Header) || header.mHeaderSize > size || header.mChunkRows == 0 ||
+            header.mChunkSize == 0 || header.mRows < 1 || header.mRows > static_cast<Uint32>(GameBoard::MAX_SIDE) ||
+            header.mColumns < 1 || header.mColumns > static_cast<Uint32>(GameBoard::MAX_SIDE) || header.mActionCount != header.mRows * header.mColumns * 2 ||
+            header.mChunkCount > (size - header.mHeaderSize) / header.mChunkSize ||
+            header.mPositionCount > header.mChunkCount * header.mChunkRows) {
+        return false;
+    }
+    for (int column = 0; column < PositionDataset::COLUMN_COUNT; column++) {
+        const PositionDataset::ColumnInfo& columnInfo = header.mColumnInfos [column];
+        if (columnInfo.mWidth < GetColumnWidth (static_cast<PositionDataset::Column>(column), header.mRows, header.mColumns, header.mActionCount) ||
+                columnInfo.mOffset + static_cast<Uint64>(header.mChunkRows) * columnInfo.mWidth > header.mChunkSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+PositionDatasetWriter::PositionDatasetWriter (int rows, int columns, int colors, int minMatchSize, int chunkRows) :
+    mFile (NULL),
+    mChunkPositions (0)
+{
+    assert (rows >= 1 && rows <= GameBoard::MAX_SIDE && columns >= 1 && columns <= GameBoard::MAX_SIDE && chunkRows > 0);
+    static_assert (sizeof (PositionDataset::Header) <= HEADER_SIZE, "dataset header does not fit");
+
+    memset (&mHeader, 0, sizeof (mHeader));
+    memcpy (mHeader.mMagic, PositionDataset::MAGIC, sizeof (mHeader.mMagic));
+    mHeader.mHeaderSize = HEADER_SIZE;
+    mHeader.mRows = rows;
+    mHeader.mColumns = columns;
+    mHeader.mColors = colors;
+    mHeader.mMinMatchSize = minMatchSize;
+    mHeader.mActionCount = rows * columns * 2;
+    mHeader.mChunkRows = (chunkRows + 7) / 8 * 8;
+
+    const char* names [PositionDataset::COLUMN_COUNT] = { "board", "legal_moves", "move_scores", "chosen_move", "game", "ply" };
+    Uint32 offset = 0;
+    for (int column = 0; column < PositionDataset::COLUMN_COUNT; column++) {
+        PositionDataset::ColumnInfo& columnInfo = mHeader.mColumnInfos [column];
+        strncpy (columnInfo.mName, names [column], sizeof (columnInfo.mName) - 1);
+        columnInfo.mWidth = GetColumnWidth (static_cast<PositionDataset::Column>(column), mHeader.mRows, mHeader.mColumns, mHeader.mActionCount);
+        columnInfo.mOffset = offset;
+        offset += columnInfo.mWidth * mHeader.mChunkRows;
+    }
+    mHeader.mChunkSize = offset;
+    mChunk.resize (mHeader.mChunkSize);
+}
+
+
+PositionDatasetWriter::~PositionDatasetWriter ()
+{
+    if (mFile != NULL) {
+        Close();
+    }
+}
+
+
+bool PositionDatasetWriter::Open (const char* filePath)
+{
+    assert (mFile == NULL);
+    mFile = fopen (filePath, "wb");
+    if (mFile == NULL) {
+        printf ("ERROR: PositionDatasetWriter::Open cannot create %s.\n", filePath);
+        return false;
+    }
+    // chunks are written whole, so the stdio buffer would only add a copy
+    setvbuf (mFile, NULL, _IONBF, 0);
+    mHeader.mPositionCount = 0;
+    mHeader.mChunkCount = 0;
+    mChunkPositions = 0;
+
+    std::vector<Uint8> header (HEADER_SIZE, 0);
+    memcpy (header.data(), &mHeader, sizeof (mHeader));
+    if (fwrite (header.data(), header.size(), 1, mFile) != 1) {
+        printf ("ERROR: PositionDatasetWriter::Open cannot write %s.\n", filePath);
+        fclose (mFile);
+        mFile = NULL;
+        return false;
+    }
+    return true;
+}
+
+
+bool PositionDatasetWriter::AddPosition (const GameBoard& board, const Sint16* moveScores, int chosenAction, Uint32 game, int ply)
+{
+    assert (mFile != NULL);
+    assert (board.GetRows() == static_cast<int>(mHeader.mRows) && board.GetColumns() == static_cast<int>(mHeader.mColumns));
+    const PositionDataset::ColumnInfo* columnInfos = mHeader.mColumnInfos;
+    Uint8* chunk = mChunk.data();
+    const Uint32 row = mChunkPositions;
+
+    memcpy (chunk + columnInfos [PositionDataset::BoardColumn].mOffset + row * columnInfos [PositionDataset::BoardColumn].mWidth,
+            board.GetTiles(), columnInfos [PositionDataset::BoardColumn].mWidth);
+
+    Uint8* legalMoves = chunk + columnInfos [PositionDataset::LegalMovesColumn].mOffset + row * columnInfos [PositionDataset::LegalMovesColumn].mWidth;
+    memset (legalMoves, 0, columnInfos [PositionDataset::LegalMovesColumn].mWidth);
+    for (Uint32 action = 0; action < mHeader.mActionCount; action++) {
+        legalMoves [action / 8] |= static_cast<Uint8>((moveScores [action] > 0 ? 1 : 0) << (action % 8));
+    }
+
+    memcpy (chunk + columnInfos [PositionDataset::MoveScoresColumn].mOffset + row * columnInfos [PositionDataset::MoveScoresColumn].mWidth,
+            moveScores, columnInfos [PositionDataset::MoveScoresColumn].mWidth);
+
+    const Sint16 chosenMove = static_cast<Sint16>(chosenAction);
+    memcpy (chunk + columnInfos [PositionDataset::ChosenMoveColumn].mOffset + row * sizeof (chosenMove), &chosenMove, sizeof (chosenMove));
+    memcpy (chunk + columnInfos [PositionDataset::GameColumn].mOffset + row * sizeof (game), &game, sizeof (game));
+    const Uint16 plyValue = static_cast<Uint16>(ply);
+    memcpy (chunk + columnInfos [PositionDataset::PlyColumn].mOffset + row * sizeof (plyValue), &plyValue, sizeof (plyValue));
+
+    mHeader.mPositionCount++;
+    if (++mChunkPositions == mHeader.mChunkRows) {
+        return WriteChunk();
+    }
+    return true;
+}
+
+
+bool PositionDatasetWriter::WriteChunk ()
+{
+    // the unused rows of a last, partial chunk are written as zeros
+    if (mChunkPositions < mHeader.mChunkRows) {
+        for (int column = 0; column < PositionDataset::COLUMN_COUNT; column++) {
+            const PositionDataset::ColumnInfo& columnInfo = mHeader.mColumnInfos [column];
+            memset (mChunk.data() + columnInfo.mOffset + mChunkPositions * columnInfo.mWidth, 0,
+                    (mHeader.mChunkRows - mChunkPositions) * columnInfo.mWidth);
+        }
+    }
+    mChunkPositions = 0;
+    mHeader.mChunkCount++;
+    if (fwrite (mChunk.data(), mChunk.size(), 1, mFile) != 1) {
+        printf ("ERROR: PositionDatasetWriter::WriteChunk failed to write chunk %llu.\n", static_cast<unsigned long long>(mHeader.mChunkCount - 1));
+        return false;
+    }
+    return true;
+}
+
+
+bool PositionDatasetWriter::Close ()
+{
+    assert (mFile != NULL);
+    bool isWritten = true;
+    if (mChunkPositions > 0) {
+        isWritten = WriteChunk();
+    }
+    // the header goes last so a file cut short by a crash never claims positions it does not hold
+    isWritten = isWritten && fseek (mFile, 0, SEEK_SET) == 0 && fwrite (&mHeader, sizeof (mHeader), 1, mFile) == 1;
+    isWritten = (fclose (mFile) == 0) && isWritten;
+    mFile = NULL;
+    if (!isWritten) {
+        printf ("ERROR: PositionDatasetWriter::Close failed to finish the file.\n");
+    }
+    return isWritten;
+}
+
+
+PositionDatasetReader::PositionDatasetReader () :
+    mData (NULL),
+    mSize (0),
+    mHeader (NULL),
+    mMapping (NULL)
+{
+}
+
+
+PositionDatasetReader::~PositionDatasetReader ()
+{
+    Close();
+}
+
+
+bool PositionDatasetReader::Open (const char* filePath)
+{
+    Close();
+#ifdef TARGET_MSVC
+    HANDLE file = CreateFileA (filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        printf ("ERROR: PositionDatasetReader::Open cannot open %s.\n", filePath);
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx (file, &fileSize);
+    HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingA (file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    CloseHandle (file);
+    if (mapping == NULL) {
+        printf ("ERROR: PositionDatasetReader::Open cannot map %s.\n", filePath);
+        return false;
+    }
+    mData = static_cast<const Uint8*>(MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == NULL) {
+        CloseHandle (mapping);
+        printf ("ERROR: PositionDatasetReader::Open cannot map %s.\n", filePath);
+        return false;
+    }
+    mMapping = mapping;
+    mSize = static_cast<Uint64>(fileSize.QuadPart);
+#endif
+#ifdef TARGET_UNIX
+    const int file = open (filePath, O_RDONLY);
+    if (file < 0) {
+        printf ("ERROR: PositionDatasetReader::Open cannot open %s.\n", filePath);
+        return false;
+    }
+    struct stat fileStatus;
+    void* data = MAP_FAILED;
+    if (fstat (file, &fileStatus) == 0 && fileStatus.st_size > 0) {
+        data = mmap (NULL, fileStatus.st_size, PROT_READ, MAP_SHARED, file, 0);
+    }
+    close (file);
+    if (data == MAP_FAILED) {
+        printf ("ERROR: PositionDatasetReader::Open cannot map %s.\n", filePath);
+        return false;
+    }
+    // positions are usually read front to back
+    madvise (data, fileStatus.st_size, MADV_SEQUENTIAL);
+    mData = static_cast<const Uint8*>(data);
+    mSize = static_cast<Uint64>(fileStatus.st_size);
+#endif
+
+    mHeader = reinterpret_cast<const PositionDataset::Header*>(mData);
+    if (mSize < sizeof (PositionDataset::Header) || memcmp (mHeader->mMagic, PositionDataset::MAGIC, sizeof (mHeader->mMagic)) != 0 ||
+            !IsLayoutInside (*mHeader, mSize)) {
+        printf ("ERROR: PositionDatasetReader::Open found no complete dataset in %s.\n", filePath);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+
+void PositionDatasetReader::Close ()
+{
+    if (mData == NULL) {
+        return;
+    }
+#ifdef TARGET_MSVC
+    UnmapViewOfFile (mData);
+    CloseHandle (static_cast<HANDLE>(mMapping));
+#endif
+#ifdef TARGET_UNIX
+    munmap (const_cast<Uint8*>(mData), mSize);
+#endif
+    mData = NULL;
+    mSize = 0;
+    mHeader = NULL;
+    mMapping = NULL;
+}
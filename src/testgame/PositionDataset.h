@@ -0,0 +1,218 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+class GameBoard;
+
+
+/*!
+ * Binary file of recorded positions, laid out so a reader can memory-map it and use it in place.
+ *
+ * The file starts with a PositionDataset::Header, followed by chunks of chunkRows positions. Inside a chunk every
+ * column is stored contiguously with a fixed width per position, so the value of a column for any position is at
+ *     headerSize + chunk * chunkSize + column.mOffset + (position % chunkRows) * column.mWidth
+ * The last chunk is padded to full size. All numbers are little-endian.
+ *
+ * Actions use the dense encoding of TileMatchEnv: action a swaps the tile at cell a / 2 (row major)
+ * with its right neighbour (a even) or the one below (a odd); actionCount is rows * columns * 2.
+ */
+namespace PositionDataset
+{
+    /// the columns of every dataset file, in file order
+    enum Column {
+        BoardColumn = 0,        ///< rows * columns bytes, GameState::Color of each tile in row major order
+        LegalMovesColumn = 1,   ///< (actionCount + 7) / 8 bytes, bit a set if action a makes a match
+        MoveScoresColumn = 2,   ///< actionCount Sint16, the immediate points of each action, 0 for illegal ones
+        ChosenMoveColumn = 3,   ///< Sint16, the action that was played, -1 if no action makes a match
+        GameColumn = 4,         ///< Uint32, the game the position is from
+        PlyColumn = 5,          ///< Uint16, the number of moves played in the game before the position
+        COLUMN_COUNT = 6
+    };
+
+    static const char MAGIC [8] = { 'T', 'M', 'D', 'A', 'T', 'A', '0', '1' };
+
+    struct ColumnInfo {
+        char mName [16];
+        Uint32 mWidth;      ///< bytes per position
+        Uint32 mOffset;     ///< bytes from the start of a chunk to the column's data
+    };
+
+    struct Header {
+        char mMagic [8];
+        Uint32 mHeaderSize;
+        Uint32 mRows, mColumns, mColors, mMinMatchSize;
+        Uint32 mActionCount;
+        Uint32 mChunkRows;      ///< positions per chunk, a multiple of 8 so every column stays 8 byte aligned
+        Uint32 mChunkSize;      ///< bytes per chunk
+        Uint64 mPositionCount;
+        Uint64 mChunkCount;
+        ColumnInfo mColumnInfos [COLUMN_COUNT];
+    };
+}
+
+
+/*!
+ * Appends positions to one dataset file. Positions are collected column by column in a chunk buffer
+ * that is written with a single large write when it is full. Not thread safe: use one writer (shard) per thread.
+ */
+class PositionDatasetWriter
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Prepares a writer, Open creates the file.
+         * @param chunkRows positions per chunk, rounded up to a multiple of 8.
+         */
+        PositionDatasetWriter (int rows, int columns, int colors, int minMatchSize, int chunkRows = 16384);
+        ~PositionDatasetWriter ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        Uint64 GetPositionCount () const
+        {
+            return mHeader.mPositionCount;
+        }
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Creates or truncates the file and writes a preliminary header.
+         * @return false if the file cannot be written.
+         */
+        bool Open (const char* filePath);
+
+
+        /*!
+         * Adds a position.
+         * @param board the board before the move.
+         * @param moveScores actionCount immediate points, 0 for actions that make no match.
+         * @param chosenAction the action played, -1 if none.
+         * @param game the game the position belongs to.
+         * @param ply the number of moves played in the game before the position.
+         * @return false if a full chunk could not be written.
+         */
+        bool AddPosition (const GameBoard& board, const Sint16* moveScores, int chosenAction, Uint32 game, int ply);
+
+
+        /*!
+         * Writes the last chunk and the final header and closes the file.
+         * @return false if writing failed.
+         */
+        bool Close ();
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        PositionDatasetWriter (const PositionDatasetWriter&);
+        PositionDatasetWriter& operator= (const PositionDatasetWriter&);
+
+        /* ====================  MUTATORS      ======================================= */
+        bool WriteChunk ();
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        PositionDataset::Header mHeader;
+        FILE* mFile;
+        std::vector<Uint8> mChunk;
+        Uint32 mChunkPositions;     ///< positions in mChunk
+
+}; /* -----  end of class PositionDatasetWriter  ----- */
+
+
+/*!
+ * Memory-maps a dataset file and hands out pointers into it; nothing is parsed or copied.
+ */
+class PositionDatasetReader
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+        PositionDatasetReader ();
+        ~PositionDatasetReader ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        const PositionDataset::Header& GetHeader () const
+        {
+            return *mHeader;
+        }
+
+        Uint64 GetPositionCount () const
+        {
+            return mHeader->mPositionCount;
+        }
+
+
+        /*!
+         * Retrieves the value of a column for a position.
+         * @return pointer to the column's mWidth bytes of the position.
+         */
+        const Uint8* GetValue (PositionDataset::Column column, Uint64 position) const
+        {
+            const Uint64 chunk = position / mHeader->mChunkRows;
+            const Uint64 row = position % mHeader->mChunkRows;
+            const PositionDataset::ColumnInfo& columnInfo = mHeader->mColumnInfos [column];
+            return mData + mHeader->mHeaderSize + chunk * mHeader->mChunkSize + columnInfo.mOffset + row * columnInfo.mWidth;
+        }
+
+        const Uint8* GetBoard (Uint64 position) const
+        {
+            return GetValue (PositionDataset::BoardColumn, position);
+        }
+
+        bool IsLegalMove (Uint64 position, int action) const
+        {
+            return (GetValue (PositionDataset::LegalMovesColumn, position) [action / 8] >> (action % 8)) & 1;
+        }
+
+        const Sint16* GetMoveScores (Uint64 position) const
+        {
+            return reinterpret_cast<const Sint16*>(GetValue (PositionDataset::MoveScoresColumn, position));
+        }
+
+        int GetChosenMove (Uint64 position) const
+        {
+            return *reinterpret_cast<const Sint16*>(GetValue (PositionDataset::ChosenMoveColumn, position));
+        }
+
+        Uint32 GetGame (Uint64 position) const
+        {
+            return *reinterpret_cast<const Uint32*>(GetValue (PositionDataset::GameColumn, position));
+        }
+
+        int GetPly (Uint64 position) const
+        {
+            return *reinterpret_cast<const Uint16*>(GetValue (PositionDataset::PlyColumn, position));
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Maps a dataset file, closing the previous one.
+         * @return false if the file cannot be mapped or is not a complete dataset file.
+         */
+        bool Open (const char* filePath);
+
+
+        void Close ();
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        PositionDatasetReader (const PositionDatasetReader&);
+        PositionDatasetReader& operator= (const PositionDatasetReader&);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        const Uint8* mData;
+        Uint64 mSize;
+        const PositionDataset::Header* mHeader;
+        void* mMapping;     ///< platform handle of the mapping
+
+}; /* -----  end of class PositionDatasetReader  ----- */
@@ -0,0 +1,186 @@
+#include "RenderSnapshot.h"
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+RenderSnapshot::RenderSnapshot () :
+    mRows (0),
+    mColumns (0),
+    mStepMilis (0.0f),
+    mScore (0),
+    mGameplayTimeLeft (0),
+    mMilisToTimerTick (-1),
+    mIsSettled (true),
+    mHintTileARow (-1),
+    mHintTileAColumn (-1),
+    mHintTileBRow (-1),
+    mHintTileBColumn (-1),
+    mStepCounter (0),
+    mStepCounterTicks (1)
+{
+}
+
+
+bool RenderSnapshot::IsSameDrawingAs (const RenderSnapshot& other) const
+{
+    if (mRows != other.mRows || mColumns != other.mColumns || mScore != other.mScore || mGameplayTimeLeft != other.mGameplayTimeLeft
+        || mTiles.size() != other.mTiles.size() || mStepMilis != other.mStepMilis || !mTimeline.IsSameAs (other.mTimeline)
+        || mHintTileARow != other.mHintTileARow || mHintTileAColumn != other.mHintTileAColumn
+        || mHintTileBRow != other.mHintTileBRow || mHintTileBColumn != other.mHintTileBColumn) {
+        return false;
+    }
+    for (size_t index = 0; index < mTiles.size(); index++) {
+        const Tile& tile = mTiles [index];
+        const Tile& otherTile = other.mTiles [index];
+        if (tile.mColor != otherTile.mColor || tile.mIsBeingDestroyed != otherTile.mIsBeingDestroyed || tile.mIsSelected != otherTile.mIsSelected
+            || tile.mX != otherTile.mX || tile.mY != otherTile.mY) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool RenderSnapshot::GetHint (int& tileARow, int& tileAColumn, int& tileBRow, int& tileBColumn) const
+{
+    if (mHintTileARow == -1) {
+        return false;
+    }
+    tileARow = mHintTileARow;
+    tileAColumn = mHintTileAColumn;
+    tileBRow = mHintTileBRow;
+    tileBColumn = mHintTileBColumn;
+    return true;
+}
+
+
+float RenderSnapshot::GetInterpolation (Uint64 counter) const
+{
+    if (counter <= mStepCounter) {
+        return 0.0f;
+    }
+    if (counter - mStepCounter >= mStepCounterTicks) {
+        return 1.0f;
+    }
+    return static_cast<float>(static_cast<double>(counter - mStepCounter) / static_cast<double>(mStepCounterTicks));
+}
+
+
+void RenderSnapshot::AnimateTiles (float interpolation, std::vector<float>& tweenValues, std::vector<TileAnimation>& tileAnimations) const
+{
+    const TileAnimation resting = {0.0f, 0.0f, 0.0f};
+    tileAnimations.assign (mTiles.size(), resting);
+    tweenValues.resize (mTimeline.GetTweenCount());
+    if (tweenValues.empty()) {
+        return;
+    }
+    mTimeline.Evaluate (mStepMilis * interpolation, &tweenValues [0]);
+    for (int tween = 0; tween < mTimeline.GetTweenCount(); tween++) {
+        TileAnimation& tileAnimation = tileAnimations [mTimeline.GetTarget (tween)];
+        const float value = tweenValues [tween];
+        switch (mTimeline.GetChannel (tween)) {
+            case OffsetX:
+                tileAnimation.mOffsetX += value;
+                break;
+            case OffsetY:
+                tileAnimation.mOffsetY += value;
+                break;
+            default:
+                tileAnimation.mDestruction += value;
+                break;
+        }
+    }
+}
+
+
+void RenderSnapshot::Capture (const GameState& gameState, const GameState& previousGameState, Uint64 stepCounter, Uint64 stepCounterTicks)
+{
+    mRows = gameState.GetRows();
+    mColumns = gameState.GetColumns();
+    mScore = gameState.GetScore();
+    mGameplayTimeLeft = gameState.GetGameplayTimeLeft();
+    // gameplay time runs while tiles can be swapped, the timer shows it rounded up to seconds
+    const Uint32 maxGameplayTime = static_cast<Uint32>(gameState.GetMaxGameplayTimeSeconds()) * 1000;
+    const bool isTimerRunning = gameState.IsGameplayTimeRunning() && gameState.GetGameplayTime() < maxGameplayTime;
+    mMilisToTimerTick = isTimerRunning ? static_cast<int>((maxGameplayTime - gameState.GetGameplayTime() - 1) % 1000 + 1) : -1;
+    mStepCounter = stepCounter;
+    mStepCounterTicks = stepCounterTicks > 0 ? stepCounterTicks : 1;
+    SetHint (-1, -1, -1, -1);
+    mTiles.clear();
+    mTimeline.Clear();
+
+    // tween times count from the step before
+    const Uint32 originGameTime = previousGameState.GetGameTime();
+    mStepMilis = static_cast<float>(static_cast<Sint32>(gameState.GetGameTime() - originGameTime));
+
+    const float tileWidth = 1.0f / static_cast<float>(mColumns);
+    const float tileHeight = 1.0f / static_cast<float>(mRows);
+    const float displacementOne = static_cast<float>(GameState::TILE_DISPLACEMENT_ONE);
+    Tile tile;
+
+    // a dragged tile follows the mouse, the tile it is dragged onto moves the other way unless it moves already
+    const int draggedTileRow = gameState.GetDraggedTileRow();
+    const int draggedTileColumn = gameState.GetDraggedTileColumn();
+    const int replacedTileRow = gameState.GetReplacedTileRow();
+    const int replacedTileColumn = gameState.GetReplacedTileColumn();
+    const glm::vec3 dragDisplacement = gameState.GetCurrentDraggedTileDisplacement();
+
+    // the tiles that stay in their place first, the swapped and dragged ones slide over them
+    for (int pass = 0; pass < 2; pass++) {
+        for (int row = 0; row < mRows; row++) {
+            for (int column = 0; column < mColumns; column++) {
+                GameState::Color color = gameState.GetColorAt (row, column);
+                if (GameState::NotAColor == color || GameState::DestroyedColor == color) {
+                    continue;
+                }
+                const GameState::TileTween tween = gameState.GetTileTween (row * mColumns + column);
+                const bool isDragged = row == draggedTileRow && column == draggedTileColumn;
+                const bool isReplaced = row == replacedTileRow && column == replacedTileColumn && GameState::Resting == tween.mMotion;
+                const bool isOnTop = isDragged || isReplaced || GameState::Swapping == tween.mMotion;
+                if (isOnTop != (pass == 1)) {
+                    continue;
+                }
+                tile.mColor = static_cast<Uint8>(color);
+                tile.mX = tileWidth * column;
+                tile.mY = tileHeight * row;
+                tile.mIsBeingDestroyed = GameState::Destroying == tween.mMotion;
+                tile.mIsSelected = GameState::Resting == tween.mMotion && row == gameState.GetSelectedTileRow() && column == gameState.GetSelectedTileColumn();
+                const int target = static_cast<int>(mTiles.size());
+                if (isDragged || isReplaced) {
+                    const float direction = isDragged ? 1.0f : -1.0f;
+                    mTimeline.Add (target, OffsetX, 0.0f, 0.0f, direction * dragDisplacement.x, direction * dragDisplacement.x, AnimationTimeline::Linear);
+                    mTimeline.Add (target, OffsetY, 0.0f, 0.0f, direction * dragDisplacement.y, direction * dragDisplacement.y, AnimationTimeline::Linear);
+                } else if (GameState::Resting != tween.mMotion) {
+                    const float start = static_cast<float>(static_cast<Sint32>(tween.mStartTime - originGameTime));
+                    const float duration = static_cast<float>(tween.mDuration);
+                    const AnimationTimeline::Easing easing = GameState::Falling == tween.mMotion ? AnimationTimeline::EaseIn : AnimationTimeline::Linear;
+                    if (tile.mIsBeingDestroyed) {
+                        mTimeline.Add (target, Destruction, start, duration, 0.0f, 1.0f, AnimationTimeline::Linear);
+                    }
+                    if (tween.mFromX != 0) {
+                        mTimeline.Add (target, OffsetX, start, duration, tween.mFromX / displacementOne * tileWidth, 0.0f, easing);
+                    }
+                    if (tween.mFromY != 0) {
+                        mTimeline.Add (target, OffsetY, start, duration, tween.mFromY / displacementOne * tileHeight, 0.0f, easing);
+                    }
+                }
+                mTiles.push_back (tile);
+            }
+        }
+    }
+    mIsSettled = mTimeline.GetEnd() <= 0.0f;
+}
+
+
+void RenderSnapshot::SetHint (int tileARow, int tileAColumn, int tileBRow, int tileBColumn)
+{
+    mHintTileARow = tileARow;
+    mHintTileAColumn = tileAColumn;
+    mHintTileBRow = tileBRow;
+    mHintTileBColumn = tileBColumn;
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <vector>
+#include <AnimationTimeline.h>
+#include <GameState.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Everything GameStateRenderer draws of a game, taken from it in one go so the game can go on while the snapshot is
+ * rendered, eg. on another thread (see TripleBuffer).
+ *
+ * The snapshot lists the tiles to draw in drawing order, each with its color and its place at rest, and the HUD
+ * values. Whatever moves is a tween on an AnimationTimeline: the offsets of swapped and falling tiles and the
+ * destruction of matched ones, each tile with its own start, duration and easing, all of them running at once. The
+ * times of the tweens count from the step before the game's last one, so the renderer can draw any moment between the
+ * two (see GetInterpolation and AnimateTiles) and animations stay smooth whatever the step and frame rates are.
+ *
+ * A snapshot whose tweens all end by the step before is settled: drawing it again shows nothing new until another
+ * snapshot or the next tick of the timer, see IsSettled and GetMilisToTimerTick.
+ */
+class RenderSnapshot
+{
+    public:
+        /*!
+         * A tile to draw. Places are in grid space, [0,1] from the left and from the top of the grid to the tile's
+         * corner.
+         */
+        struct Tile {
+            float mX, mY;                   ///< place at rest
+            Uint8 mColor;                   ///< a GameState::Color, never NotAColor nor DestroyedColor
+            bool mIsBeingDestroyed;
+            bool mIsSelected;
+        };
+
+        /*!
+         * How a tile is drawn at a moment, see AnimateTiles.
+         */
+        struct TileAnimation {
+            float mOffsetX, mOffsetY;       ///< from the place at rest, in grid space
+            float mDestruction;             ///< from 0 (not destroyed) to 1 (completely destroyed)
+        };
+
+        /// the value of a tile a tween moves, the channel of the tween
+        enum TweenChannel {
+            OffsetX,
+            OffsetY,
+            Destruction
+        };
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        RenderSnapshot ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        int GetRows () const
+        {
+            return mRows;
+        }
+
+        int GetColumns () const
+        {
+            return mColumns;
+        }
+
+        /// the tiles in drawing order, the swapped and dragged tiles last so they are drawn on top
+        const std::vector<Tile>& GetTiles () const
+        {
+            return mTiles;
+        }
+
+        /// the tweens of the tiles, their targets are indices into GetTiles, their times miliseconds from the step before
+        const AnimationTimeline& GetTimeline () const
+        {
+            return mTimeline;
+        }
+
+        int GetScore () const
+        {
+            return mScore;
+        }
+
+        int GetGameplayTimeLeft () const
+        {
+            return mGameplayTimeLeft;
+        }
+
+        /// the counter value the last step was due at
+        Uint64 GetStepCounter () const
+        {
+            return mStepCounter;
+        }
+
+        /// true if no tween runs after the step before, whatever the interpolation the snapshot is drawn the same
+        bool IsSettled () const
+        {
+            return mIsSettled;
+        }
+
+        /// miliseconds of gameplay until the timer shows another second, -1 while the timer stands still
+        int GetMilisToTimerTick () const
+        {
+            return mMilisToTimerTick;
+        }
+
+
+        /*!
+         * Retrieves the two tiles of the move hinted to the player, see HintSearch.
+         * @return false if no move is hinted.
+         */
+        bool GetHint (int& tileARow, int& tileAColumn, int& tileBRow, int& tileBColumn) const;
+
+
+        /*!
+         * Compares what two snapshots draw, their step counters aside.
+         * @return true if both draw the same tiles, hint, score and time left at every interpolation.
+         */
+        bool IsSameDrawingAs (const RenderSnapshot& other) const;
+
+
+        /*!
+         * Calculates which moment between the two captured steps to draw at a counter value.
+         * @param counter a value of the counter the step times were given in, eg. SDL_GetPerformanceCounter.
+         * @return 0 at the last step, approaching 1 a step later, clamped to [0,1].
+         */
+        float GetInterpolation (Uint64 counter) const;
+
+
+        /*!
+         * Evaluates all tweens at a moment in one pass over the timeline and sums them up per tile.
+         * @param interpolation from 0 (the step before) to 1 (the last step).
+         * @param tweenValues scratch, resized to the number of tweens.
+         * @param tileAnimations output, resized to the number of tiles, in the order of GetTiles.
+         */
+        void AnimateTiles (float interpolation, std::vector<float>& tweenValues, std::vector<TileAnimation>& tileAnimations) const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Captures a game. The tile list and the timeline are not allocated again once the snapshot held a grid as
+         * large.
+         * @param gameState the game after its last step.
+         * @param previousGameState the same game a step before, or gameState if there is no step to interpolate from.
+         * @param stepCounter the counter value the last step was due at.
+         * @param stepCounterTicks how much the counter advances per step.
+         */
+        void Capture (const GameState& gameState, const GameState& previousGameState, Uint64 stepCounter, Uint64 stepCounterTicks);
+
+
+        /*!
+         * Hints a move to the player, drawn like a selection on both tiles. Capture takes the hint away.
+         */
+        void SetHint (int tileARow, int tileAColumn, int tileBRow, int tileBColumn);
+
+    private:
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mRows;
+        int mColumns;
+        std::vector<Tile> mTiles;
+        AnimationTimeline mTimeline;
+        float mStepMilis;               ///< game time between the two captured steps
+        int mScore;
+        int mGameplayTimeLeft;
+        int mMilisToTimerTick;
+        bool mIsSettled;
+        int mHintTileARow, mHintTileAColumn;    ///< -1 if no move is hinted
+        int mHintTileBRow, mHintTileBColumn;
+        Uint64 mStepCounter;
+        Uint64 mStepCounterTicks;
+
+}; /* -----  end of class RenderSnapshot  ----- */
@@ -0,0 +1,449 @@
+#include "Replay.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+const Uint32 Replay::KEYFRAME_INTERVAL_MILIS = 1000;
+
+static const char REPLAY_MAGIC [8] = { 'T', 'M', 'R', 'E', 'P', 'L', 'A', 'Y' };
+static const Uint32 REPLAY_VERSION = 3;
+// the largest board a replay may have, as AutosaveJournal::Resume takes
+static const int MAX_SIDE = 64;
+
+// swap directions of the stream, from tile A to tile B
+static const int DIRECTION_ROWS [4] = { 0, 1, 0, -1 };
+static const int DIRECTION_COLUMNS [4] = { 1, 0, -1, 0 };
+
+
+/*!
+ * The start of a replay file, followed by the stream, the keyframe entries and the keyframe grids.
+ */
+struct ReplayFileHeader {
+    char mMagic [8];
+    Uint32 mVersion;
+    Sint32 mRows, mColumns, mMinMatchSize;
+    Sint32 mMaxGameplayTimeSeconds;
+    Uint32 mSeed;
+    Uint32 mUpdateCount;
+    Sint32 mFinalScore;
+    Uint32 mStreamSize;
+    Uint32 mKeyframeCount;
+};
+
+
+Replay::Replay () :
+    mRows (0),
+    mColumns (0),
+    mMinMatchSize (0),
+    mMaxGameplayTimeSeconds (0),
+    mSeed (0),
+    mUpdateCount (0),
+    mFinalScore (0)
+{
+}
+
+
+/*!
+ * Decodes a varint of a stream.
+ * @return false if the stream ends within the varint.
+ */
+static bool ReadVarint (const std::vector<Uint8>& stream, Uint32& streamOffset, Uint32& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && streamOffset < stream.size(); shift += 7) {
+        const Uint8 byte = stream [streamOffset++];
+        value |= static_cast<Uint32>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool Replay::ReadRecord (Uint32& streamOffset, Record& record) const
+{
+    Uint32 tag, value;
+    if (!ReadVarint (mStream, streamOffset, tag) || !ReadVarint (mStream, streamOffset, value)) {
+        return false;
+    }
+    record.mType = tag & 3;
+    if (record.mType == UPDATE_RECORD) {
+        record.mUpdates = tag >> 2;
+        record.mDeltaTimeChange = static_cast<Sint32>((value >> 1) ^ (0U - (value & 1)));
+        return true;
+    }
+    const Uint32 cell = (tag >> 2) / 4;
+    const int direction = static_cast<int>((tag >> 2) % 4);
+    // GameState::SwapTiles trusts its tiles, a malformed file must not swap off the board
+    if (cell >= static_cast<Uint32>(mRows * mColumns)) {
+        return false;
+    }
+    record.mTileARow = static_cast<int>(cell) / mColumns;
+    record.mTileAColumn = static_cast<int>(cell) % mColumns;
+    record.mTileBRow = record.mTileARow + DIRECTION_ROWS [direction];
+    record.mTileBColumn = record.mTileAColumn + DIRECTION_COLUMNS [direction];
+    if (record.mTileBRow < 0 || record.mTileBRow >= mRows || record.mTileBColumn < 0 || record.mTileBColumn >= mColumns) {
+        return false;
+    }
+    record.mAnimationHeadStart = value;
+    return ReadVarint (mStream, streamOffset, record.mGameplayTimeChange) && ReadVarint (mStream, streamOffset, record.mScoreChange);
+}
+
+
+int Replay::FindKeyframeOfUpdate (Uint32 updateIndex) const
+{
+    int low = 0;
+    int high = static_cast<int>(mKeyframes.size());
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (mKeyframes [middle].mUpdateIndex <= updateIndex) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low - 1;
+}
+
+
+int Replay::FindKeyframeOfTime (Uint32 gameTime) const
+{
+    int low = 0;
+    int high = static_cast<int>(mKeyframes.size());
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (mKeyframes [middle].mKeyframe.mGameTime <= gameTime) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low - 1;
+}
+
+
+bool Replay::AreKeyframesValid () const
+{
+    // players seek from the keyframe at or before any update, so the first one has to be at the start of the game
+    if (mKeyframes.empty() || mKeyframes [0].mUpdateIndex != 0 || mKeyframes [0].mStreamOffset != 0) {
+        return false;
+    }
+    for (size_t index = 0; index < mKeyframes.size(); index++) {
+        const KeyframeEntry& entry = mKeyframes [index];
+        if (entry.mStreamOffset > mStream.size() || entry.mUpdateIndex > mUpdateCount) {
+            return false;
+        }
+        for (int cell = 0; cell < mRows * mColumns; cell++) {
+            if (mKeyframeGrids [index * mRows * mColumns + cell] > GameState::sNUMBER_OF_TILE_COLORS) {
+                return false;
+            }
+        }
+        if (index == 0) {
+            continue;
+        }
+        // the searches by update and by time are binary searches
+        const KeyframeEntry& previous = mKeyframes [index - 1];
+        if (entry.mUpdateIndex < previous.mUpdateIndex || entry.mStreamOffset < previous.mStreamOffset
+            || entry.mKeyframe.mGameTime < previous.mKeyframe.mGameTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool Replay::Save (const char* filePath) const
+{
+    FILE* file = fopen (filePath, "wb");
+    if (file == NULL) {
+        printf ("ERROR: Replay::Save cannot create %s.\n", filePath);
+        return false;
+    }
+    ReplayFileHeader header;
+    memcpy (header.mMagic, REPLAY_MAGIC, sizeof (header.mMagic));
+    header.mVersion = REPLAY_VERSION;
+    header.mRows = mRows;
+    header.mColumns = mColumns;
+    header.mMinMatchSize = mMinMatchSize;
+    header.mMaxGameplayTimeSeconds = mMaxGameplayTimeSeconds;
+    header.mSeed = mSeed;
+    header.mUpdateCount = mUpdateCount;
+    header.mFinalScore = mFinalScore;
+    header.mStreamSize = static_cast<Uint32>(mStream.size());
+    header.mKeyframeCount = static_cast<Uint32>(mKeyframes.size());
+    bool isWritten = fwrite (&header, sizeof (header), 1, file) == 1;
+    isWritten = isWritten && (mStream.empty() || fwrite (mStream.data(), mStream.size(), 1, file) == 1);
+    isWritten = isWritten && (mKeyframes.empty() || fwrite (mKeyframes.data(), sizeof (KeyframeEntry) * mKeyframes.size(), 1, file) == 1);
+    isWritten = isWritten && (mKeyframeGrids.empty() || fwrite (mKeyframeGrids.data(), mKeyframeGrids.size(), 1, file) == 1);
+    isWritten = (fclose (file) == 0) && isWritten;
+    if (!isWritten) {
+        printf ("ERROR: Replay::Save failed to write %s.\n", filePath);
+    }
+    return isWritten;
+}
+
+
+bool Replay::Load (const char* filePath)
+{
+    FILE* file = fopen (filePath, "rb");
+    if (file == NULL) {
+        printf ("ERROR: Replay::Load cannot open %s.\n", filePath);
+        return false;
+    }
+    // the sizes in the header are checked against the file before anything is allocated for them
+    long fileSize = -1;
+    if (fseek (file, 0, SEEK_END) == 0) {
+        fileSize = ftell (file);
+    }
+    ReplayFileHeader header;
+    bool isRead = fileSize >= 0 && fseek (file, 0, SEEK_SET) == 0 && fread (&header, sizeof (header), 1, file) == 1 &&
+        memcmp (header.mMagic, REPLAY_MAGIC, sizeof (header.mMagic)) == 0 && header.mVersion == REPLAY_VERSION &&
+        header.mRows > 0 && header.mColumns > 0 && header.mRows <= MAX_SIDE && header.mColumns <= MAX_SIDE;
+    if (isRead) {
+        const Uint64 keyframesSize = static_cast<Uint64>(header.mKeyframeCount) * (sizeof (KeyframeEntry) + header.mRows * header.mColumns);
+        isRead = sizeof (header) + static_cast<Uint64>(header.mStreamSize) + keyframesSize <= static_cast<Uint64>(fileSize);
+    }
+    if (isRead) {
+        mRows = header.mRows;
+        mColumns = header.mColumns;
+        mMinMatchSize = header.mMinMatchSize;
+        mMaxGameplayTimeSeconds = header.mMaxGameplayTimeSeconds;
+        mSeed = header.mSeed;
+        mUpdateCount = header.mUpdateCount;
+        mFinalScore = header.mFinalScore;
+        mStream.resize (header.mStreamSize);
+        mKeyframes.resize (header.mKeyframeCount);
+        mKeyframeGrids.resize (static_cast<size_t>(header.mKeyframeCount) * mRows * mColumns);
+        isRead = (mStream.empty() || fread (mStream.data(), mStream.size(), 1, file) == 1) &&
+            (mKeyframes.empty() || fread (mKeyframes.data(), sizeof (KeyframeEntry) * mKeyframes.size(), 1, file) == 1) &&
+            (mKeyframeGrids.empty() || fread (mKeyframeGrids.data(), mKeyframeGrids.size(), 1, file) == 1);
+        isRead = isRead && AreKeyframesValid();
+    }
+    fclose (file);
+    if (!isRead) {
+        printf ("ERROR: Replay::Load found no complete replay in %s.\n", filePath);
+        *this = Replay();
+    }
+    return isRead;
+}
+
+
+ReplayRecorder::ReplayRecorder () :
+    mIsRecording (false),
+    mRunDeltaTime (0),
+    mRunLength (0),
+    mWrittenDeltaTime (0),
+    mLastKeyframeTime (0),
+    mLastSwapGameplayTime (0),
+    mLastSwapScore (0)
+{
+}
+
+
+void ReplayRecorder::Begin (const GameState& gameState, Uint32 seed)
+{
+    mReplay = Replay();
+    mReplay.mRows = gameState.GetRows();
+    mReplay.mColumns = gameState.GetColumns();
+    mReplay.mMinMatchSize = gameState.GetMinMatchSize();
+    mReplay.mMaxGameplayTimeSeconds = gameState.GetMaxGameplayTimeSeconds();
+    mReplay.mSeed = seed;
+    // most games fit without growing
+    mReplay.mStream.reserve (1 << 16);
+    mRunDeltaTime = 0;
+    mRunLength = 0;
+    mWrittenDeltaTime = 0;
+    mLastSwapGameplayTime = gameState.GetGameplayTime();
+    mLastSwapScore = gameState.GetScore();
+    mIsRecording = true;
+    // the new game is the first keyframe, so every update has a keyframe to seek from
+    TakeKeyframe (gameState);
+}
+
+
+void ReplayRecorder::RecordUpdate (Uint32 deltaTime, const GameState& gameState, bool isGridCheckPending)
+{
+    if (!mIsRecording || gameState.GetAnimationState() == GameState::GameOver) {
+        return;
+    }
+    if (gameState.GetGameTime() - mLastKeyframeTime >= Replay::KEYFRAME_INTERVAL_MILIS && !isGridCheckPending) {
+        TakeKeyframe (gameState);
+    }
+    if (mRunLength > 0 && deltaTime != mRunDeltaTime) {
+        FlushUpdateRun();
+    }
+    mRunDeltaTime = deltaTime;
+    mRunLength++;
+    mReplay.mUpdateCount++;
+}
+
+
+void ReplayRecorder::RecordSwap (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationHeadStart, const GameState& gameState)
+{
+    if (!mIsRecording) {
+        return;
+    }
+    int direction = 0;
+    while (direction < 4 && (tileBRow - tileARow != DIRECTION_ROWS [direction] || tileBColumn - tileAColumn != DIRECTION_COLUMNS [direction])) {
+        direction++;
+    }
+    if (direction == 4) {
+        printf ("ERROR: ReplayRecorder::RecordSwap called with tiles (%d,%d) and (%d,%d) that are not neighbours.\n",
+                tileARow, tileAColumn, tileBRow, tileBColumn);
+        return;
+    }
+    FlushUpdateRun();
+    const Uint32 cell = static_cast<Uint32>(tileARow * mReplay.mColumns + tileAColumn);
+    WriteVarint ((cell * 4 + direction) << 2 | Replay::SWAP_RECORD);
+    WriteVarint (animationHeadStart);
+    WriteVarint (gameState.GetGameplayTime() - mLastSwapGameplayTime);
+    WriteVarint (static_cast<Uint32>(gameState.GetScore() - mLastSwapScore));
+    mLastSwapGameplayTime = gameState.GetGameplayTime();
+    mLastSwapScore = gameState.GetScore();
+}
+
+
+void ReplayRecorder::Finish (const GameState& gameState)
+{
+    FlushUpdateRun();
+    mReplay.mFinalScore = gameState.GetScore();
+    mIsRecording = false;
+}
+
+
+void ReplayRecorder::TakeKeyframe (const GameState& gameState)
+{
+    Replay::KeyframeEntry entry;
+    const size_t gridOffset = mReplay.mKeyframeGrids.size();
+    mReplay.mKeyframeGrids.resize (gridOffset + mReplay.mRows * mReplay.mColumns);
+    if (!gameState.GetKeyframe (entry.mKeyframe, &mReplay.mKeyframeGrids [gridOffset])) {
+        // not resting, the next update tries again
+        mReplay.mKeyframeGrids.resize (gridOffset);
+        return;
+    }
+    // the keyframe has to start at a record boundary
+    FlushUpdateRun();
+    entry.mUpdateIndex = mReplay.mUpdateCount;
+    entry.mStreamOffset = static_cast<Uint32>(mReplay.mStream.size());
+    entry.mDeltaTime = mWrittenDeltaTime;
+    mReplay.mKeyframes.push_back (entry);
+    mLastKeyframeTime = gameState.GetGameTime();
+}
+
+
+void ReplayRecorder::WriteVarint (Uint32 value)
+{
+    while (value >= 0x80) {
+        mReplay.mStream.push_back (static_cast<Uint8>(value | 0x80));
+        value >>= 7;
+    }
+    mReplay.mStream.push_back (static_cast<Uint8>(value));
+}
+
+
+void ReplayRecorder::FlushUpdateRun ()
+{
+    if (mRunLength == 0) {
+        return;
+    }
+    const Sint32 difference = static_cast<Sint32>(mRunDeltaTime - mWrittenDeltaTime);
+    WriteVarint (mRunLength << 2 | Replay::UPDATE_RECORD);
+    WriteVarint ((static_cast<Uint32>(difference) << 1) ^ static_cast<Uint32>(difference >> 31));
+    mWrittenDeltaTime = mRunDeltaTime;
+    mRunLength = 0;
+}
+
+
+ReplayPlayer::ReplayPlayer (const Replay& replay) :
+    mReplay (replay),
+    mGameStateLogic(),
+    mGameState (new GameState (replay.GetRows(), replay.GetColumns(), replay.GetMinMatchSize(), replay.GetMaxGameplayTimeSeconds(), replay.GetSeed())),
+    mStreamOffset (0),
+    mUpdateIndex (0),
+    mRunDeltaTime (0),
+    mRunLeft (0)
+{
+    mGameState->AttachGameStateGridChangeObserver (&mGameStateLogic);
+}
+
+
+bool ReplayPlayer::Step ()
+{
+    if (IsFinished()) {
+        return false;
+    }
+    while (mRunLeft == 0) {
+        Replay::Record record;
+        if (!mReplay.ReadRecord (mStreamOffset, record)) {
+            printf ("ERROR: ReplayPlayer::Step found no valid record at update %u of %u.\n", mUpdateIndex, mReplay.GetUpdateCount());
+            return false;
+        }
+        if (record.mType == Replay::UPDATE_RECORD) {
+            mRunLeft = record.mUpdates;
+            mRunDeltaTime += record.mDeltaTimeChange;
+        } else {
+            mGameState->SwapTiles (record.mTileARow, record.mTileAColumn, record.mTileBRow, record.mTileBColumn,
+                    mGameStateLogic.GetAnimationDuration(), true, record.mAnimationHeadStart);
+        }
+    }
+    mRunLeft--;
+    mUpdateIndex++;
+    return mGameStateLogic.Update (mRunDeltaTime, *mGameState);
+}
+
+
+bool ReplayPlayer::SeekToUpdate (Uint32 updateIndex)
+{
+    if (updateIndex > mReplay.GetUpdateCount()) {
+        updateIndex = mReplay.GetUpdateCount();
+    }
+    // playing on is cheaper than restoring if no keyframe lies in between
+    const int keyframe = mReplay.FindKeyframeOfUpdate (updateIndex);
+    if (updateIndex < mUpdateIndex || (keyframe >= 0 && mReplay.GetKeyframe (keyframe).mUpdateIndex > mUpdateIndex)) {
+        RestoreKeyframe (keyframe);
+    }
+    while (mUpdateIndex < updateIndex) {
+        if (!Step()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool ReplayPlayer::SeekToTime (Uint32 gameTime)
+{
+    const int keyframe = mReplay.FindKeyframeOfTime (gameTime);
+    if (gameTime < mGameState->GetGameTime() || (keyframe >= 0 && mReplay.GetKeyframe (keyframe).mUpdateIndex > mUpdateIndex)) {
+        RestoreKeyframe (keyframe);
+    }
+    while (mGameState->GetGameTime() < gameTime && !IsFinished()) {
+        if (!Step()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void ReplayPlayer::RestoreKeyframe (int keyframe)
+{
+    // before the first keyframe, eg. a time before the game started, is the start
+    keyframe = keyframe < 0 ? 0 : keyframe;
+    const Replay::KeyframeEntry& entry = mReplay.GetKeyframe (keyframe);
+    mGameState->RestoreKeyframe (entry.mKeyframe, mReplay.GetKeyframeGrid (keyframe));
+    // a keyframe is never taken with a grid check pending
+    mGameStateLogic = GameStateLogic();
+    mStreamOffset = entry.mStreamOffset;
+    mUpdateIndex = entry.mUpdateIndex;
+    mRunDeltaTime = entry.mDeltaTime;
+    mRunLeft = 0;
+}
@@ -0,0 +1,339 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <GameState.h>
+#include <GameStateLogic.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * A recorded game: the GameState seed and rules, every GameStateLogic::Update time step and every accepted swap.
+ * Given the same seed, updates and swaps a GameState goes through exactly the same states, so this is all a replay needs.
+ *
+ * The updates and swaps are a stream of varint records, in the order they happened:
+ * - a run of updates: (count << 2 | UPDATE_RECORD), then the zigzag varint difference of the run's time step
+ *   to the time step of the previous run;
+ * - a swap: ((cell * 4 + direction) << 2 | SWAP_RECORD), then varints of the animation head start in miliseconds,
+ *   the gameplay time and the points scored since the previous swap (or the start of the game).
+ *   cell is tile A in row major order, direction the neighbour B (0 right, 1 below, 2 left, 3 above).
+ *   The gameplay times and scores are not needed to play the replay, they let ReplayVerifier check a game move by move.
+ * Steady time steps collapse into long runs; a time step that changes every update costs two bytes per update.
+ *
+ * Every KEYFRAME_INTERVAL_MILIS of game time the recorder stores a keyframe, a full copy of a resting GameState with
+ * the stream position of the next update. Seeking restores the closest keyframe before the target and replays from there.
+ */
+class Replay
+{
+    public:
+        /// where a keyframe is in the game and in the stream
+        struct KeyframeEntry {
+            Uint32 mUpdateIndex;        ///< updates done before the keyframe
+            Uint32 mStreamOffset;       ///< stream position of the record of that update
+            Uint32 mDeltaTime;          ///< time step of the update run before the stream position
+            GameState::Keyframe mKeyframe;
+        };
+
+        /// a decoded record of the stream
+        struct Record {
+            Uint32 mType;                   ///< UPDATE_RECORD or SWAP_RECORD
+            Uint32 mUpdates;                ///< update run: the number of updates
+            Sint32 mDeltaTimeChange;        ///< update run: the time step minus the time step of the previous run
+            int mTileARow, mTileAColumn;    ///< swap: the tiles, B is a neighbour of A but may be outside the board
+            int mTileBRow, mTileBColumn;
+            Uint32 mAnimationHeadStart;     ///< swap: miliseconds of the animation done when it started
+            Uint32 mGameplayTimeChange;     ///< swap: gameplay time since the previous swap
+            Uint32 mScoreChange;            ///< swap: points scored since the previous swap
+        };
+
+        static const Uint32 KEYFRAME_INTERVAL_MILIS;
+        static const Uint32 UPDATE_RECORD = 0;
+        static const Uint32 SWAP_RECORD = 1;
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+        Replay ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        int GetRows () const
+        {
+            return mRows;
+        }
+
+        int GetColumns () const
+        {
+            return mColumns;
+        }
+
+        int GetMinMatchSize () const
+        {
+            return mMinMatchSize;
+        }
+
+        int GetMaxGameplayTimeSeconds () const
+        {
+            return mMaxGameplayTimeSeconds;
+        }
+
+        Uint32 GetSeed () const
+        {
+            return mSeed;
+        }
+
+        Uint32 GetUpdateCount () const
+        {
+            return mUpdateCount;
+        }
+
+        /*!
+         * Retrieves the score the game ended with, as reported by the recording client.
+         */
+        int GetFinalScore () const
+        {
+            return mFinalScore;
+        }
+
+        const std::vector<Uint8>& GetStream () const
+        {
+            return mStream;
+        }
+
+        int GetKeyframeCount () const
+        {
+            return static_cast<int>(mKeyframes.size());
+        }
+
+        const KeyframeEntry& GetKeyframe (int keyframe) const
+        {
+            return mKeyframes [keyframe];
+        }
+
+        /*!
+         * Retrieves the rows * columns colors of a keyframe.
+         */
+        const Uint8* GetKeyframeGrid (int keyframe) const
+        {
+            return &mKeyframeGrids [keyframe * mRows * mColumns];
+        }
+
+
+        /*!
+         * Decodes the record at a stream position.
+         * @param streamOffset the position of the record, moved to the next record.
+         * @param record output of the decoded record.
+         * @return false at the end of the stream, if the record is cut off or if it swaps a tile off the board.
+         */
+        bool ReadRecord (Uint32& streamOffset, Record& record) const;
+
+
+        /*!
+         * Finds the last keyframe at or before an update.
+         * @return the keyframe index, -1 if there are no keyframes.
+         */
+        int FindKeyframeOfUpdate (Uint32 updateIndex) const;
+
+
+        /*!
+         * Finds the last keyframe at or before a game time.
+         * @return the keyframe index, -1 if there are no keyframes.
+         */
+        int FindKeyframeOfTime (Uint32 gameTime) const;
+
+
+        /*!
+         * Writes the replay to a file.
+         * @return false if the file cannot be written.
+         */
+        bool Save (const char* filePath) const;
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Reads a replay written by Save.
+         * @return false if the file cannot be read, is not a replay or its keyframes are inconsistent.
+         */
+        bool Load (const char* filePath);
+
+    private:
+        friend class ReplayRecorder;
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Checks the keyframes of a loaded file: at least one, the first at the start of the game, all within the
+         * stream and the updates, in order and with valid tile colors.
+         */
+        bool AreKeyframesValid () const;
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mRows, mColumns, mMinMatchSize;
+        int mMaxGameplayTimeSeconds;
+        Uint32 mSeed;
+        Uint32 mUpdateCount;
+        int mFinalScore;
+        std::vector<Uint8> mStream;
+        std::vector<KeyframeEntry> mKeyframes;
+        std::vector<Uint8> mKeyframeGrids;  ///< the grids of mKeyframes, one after the other
+
+}; /* -----  end of class Replay  ----- */
+
+
+/*!
+ * Records a game into a Replay. GameStateLogic reports every update and every swap it accepts,
+ * see GameStateLogic::SetReplayRecorder. Updates after the game is over are not recorded.
+ */
+class ReplayRecorder
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+        ReplayRecorder ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * The replay recorded so far; the last update run is only in it after Finish.
+         */
+        const Replay& GetReplay () const
+        {
+            return mReplay;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Starts recording a game that has just been created.
+         * @param gameState the new game, it becomes the first keyframe.
+         * @param seed the seed gameState was created with.
+         */
+        void Begin (const GameState& gameState, Uint32 seed);
+
+
+        /*!
+         * Records an update before GameStateLogic runs it.
+         * @param isGridCheckPending whether the update has to check the grid, keyframes are only taken when it does not.
+         */
+        void RecordUpdate (Uint32 deltaTime, const GameState& gameState, bool isGridCheckPending);
+
+
+        /*!
+         * Records a swap a player or bot started.
+         * @param animationHeadStart how much of the swap animation counts as done already.
+         * @param gameState the game the swap was started in.
+         */
+        void RecordSwap (int tileARow, int tileAColumn, int tileBRow, int tileBColumn, Uint32 animationHeadStart, const GameState& gameState);
+
+
+        /*!
+         * Completes the replay, after which it can be saved.
+         * @param gameState the recorded game, its score becomes the final score of the replay.
+         */
+        void Finish (const GameState& gameState);
+
+    private:
+        /* ====================  MUTATORS      ======================================= */
+        void TakeKeyframe (const GameState& gameState);
+        void WriteVarint (Uint32 value);
+        void FlushUpdateRun ();
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        Replay mReplay;
+        bool mIsRecording;
+        Uint32 mRunDeltaTime;       ///< time step of the pending update run
+        Uint32 mRunLength;          ///< updates in the pending run
+        Uint32 mWrittenDeltaTime;   ///< time step of the last run in the stream
+        Uint32 mLastKeyframeTime;
+        Uint32 mLastSwapGameplayTime;
+        int mLastSwapScore;
+
+}; /* -----  end of class ReplayRecorder  ----- */
+
+
+/*!
+ * Plays a Replay on its own GameState and GameStateLogic. Nothing is rendered, so fast-forwarding runs
+ * the updates as fast as the rules allow.
+ */
+class ReplayPlayer
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Creates the game of the replay, before its first update.
+         * @param replay the replay, it has to outlive the player.
+         */
+        explicit ReplayPlayer (const Replay& replay);
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        const GameState& GetGameState () const
+        {
+            return *mGameState;
+        }
+
+        /*!
+         * Retrieves the number of updates played so far.
+         */
+        Uint32 GetUpdateIndex () const
+        {
+            return mUpdateIndex;
+        }
+
+        bool IsFinished () const
+        {
+            return mUpdateIndex >= mReplay.GetUpdateCount();
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Runs the swaps before the next update and the update.
+         * @return false if the replay is finished or broken.
+         */
+        bool Step ();
+
+
+        /*!
+         * Moves to the state after a number of updates.
+         * @param updateIndex updates to have played, at most GetUpdateCount.
+         * @return false if the replay is broken.
+         */
+        bool SeekToUpdate (Uint32 updateIndex);
+
+
+        /*!
+         * Moves to the first update that reaches a game time, or to the end of the replay.
+         * @param gameTime game time in miliseconds, including animations.
+         * @return false if the replay is broken.
+         */
+        bool SeekToTime (Uint32 gameTime);
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        ReplayPlayer (const ReplayPlayer&);
+        ReplayPlayer& operator= (const ReplayPlayer&);
+
+        /* ====================  MUTATORS      ======================================= */
+        void RestoreKeyframe (int keyframe);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        const Replay& mReplay;
+        GameStateLogic mGameStateLogic;
+        std::unique_ptr<GameState> mGameState;
+        Uint32 mStreamOffset;
+        Uint32 mUpdateIndex;
+        Uint32 mRunDeltaTime;
+        Uint32 mRunLeft;            ///< updates left in the current run
+
+}; /* -----  end of class ReplayPlayer  ----- */
@@ -0,0 +1,139 @@
+#include "ReplayVerifier.h"
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <JobSystem.h>
+#include <Leaderboard.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+// the largest board a submission may have, to bound the work of a submission
+static const int MAX_SIDE = 64;
+// the largest match size and game length the rules key holds, see Leaderboard::MakeRules
+static const int MAX_MIN_MATCH_SIZE = 0xF;
+static const int MAX_GAMEPLAY_TIME_SECONDS = 0xFFF;
+
+
+bool ReplayVerifier::ReadSubmission (const Replay& replay, Submission& submission)
+{
+    submission.mSeed = replay.GetSeed();
+    submission.mRows = replay.GetRows();
+    submission.mColumns = replay.GetColumns();
+    submission.mMinMatchSize = replay.GetMinMatchSize();
+    submission.mMaxGameplayTimeSeconds = replay.GetMaxGameplayTimeSeconds();
+    submission.mFinalScore = replay.GetFinalScore();
+    submission.mMoves.clear();
+
+    Uint32 streamOffset = 0;
+    Uint32 gameTime = 0;
+    Uint32 deltaTime = 0;
+    Sint32 score = 0;
+    Replay::Record record;
+    while (streamOffset < replay.GetStream().size()) {
+        if (!replay.ReadRecord (streamOffset, record)) {
+            return false;
+        }
+        if (record.mType == Replay::UPDATE_RECORD) {
+            // the game time is the sum of the update times
+            deltaTime += record.mDeltaTimeChange;
+            gameTime += record.mUpdates * deltaTime;
+        } else {
+            score += static_cast<Sint32>(record.mScoreChange);
+            Move move;
+            move.mGameTime = gameTime;
+            move.mAnimationHeadStart = record.mAnimationHeadStart;
+            move.mScore = score;
+            move.mTileARow = static_cast<Sint8>(record.mTileARow);
+            move.mTileAColumn = static_cast<Sint8>(record.mTileAColumn);
+            move.mTileBRow = static_cast<Sint8>(record.mTileBRow);
+            move.mTileBColumn = static_cast<Sint8>(record.mTileBColumn);
+            submission.mMoves.push_back (move);
+        }
+    }
+    return true;
+}
+
+
+const char* ReplayVerifier::GetVerdictName (Verdict verdict)
+{
+    switch (verdict) {
+        case Valid: return "valid";
+        case TimeGoesBack: return "time goes back";
+        case TimeIsUp: return "time is up";
+        case IllegalMove: return "illegal move";
+        case ScoreMismatch: return "score mismatch";
+        case FinalScoreMismatch: return "final score mismatch";
+        case BadRules: return "bad rules";
+    }
+    return "unknown";
+}
+
+
+ReplayVerifier::Result ReplayVerifier::Verify (const Submission& submission, Uint32 rules)
+{
+    Result result;
+    result.mVerdict = Valid;
+    result.mFirstDivergentMove = -1;
+    result.mScore = 0;
+    // in range of the fields of the rules key first, so no claimed rule can wrap onto the expected one
+    if (submission.mRows < 1 || submission.mRows > MAX_SIDE || submission.mColumns < 1 || submission.mColumns > MAX_SIDE ||
+            submission.mMinMatchSize < 2 || submission.mMinMatchSize > MAX_MIN_MATCH_SIZE ||
+            submission.mMaxGameplayTimeSeconds < 1 || submission.mMaxGameplayTimeSeconds > MAX_GAMEPLAY_TIME_SECONDS ||
+            Leaderboard::MakeRules (submission.mRows, submission.mColumns, submission.mMinMatchSize, submission.mMaxGameplayTimeSeconds) != rules) {
+        result.mVerdict = BadRules;
+        return result;
+    }
+
+    GameState gameState (submission.mRows, submission.mColumns, submission.mMinMatchSize, submission.mMaxGameplayTimeSeconds, submission.mSeed);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    for (size_t moveIndex = 0; moveIndex < submission.mMoves.size(); moveIndex++) {
+        const Move& move = submission.mMoves [moveIndex];
+        result.mFirstDivergentMove = static_cast<int>(moveIndex);
+        if (move.mGameTime < gameState.GetGameTime()) {
+            result.mVerdict = TimeGoesBack;
+            return result;
+        }
+        gameStateLogic.Update (move.mGameTime - gameState.GetGameTime(), gameState);
+        result.mScore = gameState.GetScore();
+        if (gameState.GetAnimationState() == GameState::GameOver) {
+            result.mVerdict = TimeIsUp;
+            return result;
+        }
+        if (move.mScore != gameState.GetScore()) {
+            result.mVerdict = ScoreMismatch;
+            return result;
+        }
+        if (move.mAnimationHeadStart > gameStateLogic.GetAnimationDuration() ||
+                !gameStateLogic.RequestSwap (move.mTileARow, move.mTileAColumn, move.mTileBRow, move.mTileBColumn, gameState, move.mAnimationHeadStart)) {
+            result.mVerdict = IllegalMove;
+            return result;
+        }
+    }
+    // the animations of the last moves run to their end or until the time is up, as in the game
+    while (gameState.GetAnimationState() != GameState::Idle && gameState.GetAnimationState() != GameState::GameOver) {
+        gameStateLogic.Update (gameState.GetTimeToRest(), gameState);
+    }
+    result.mScore = gameState.GetScore();
+    result.mFirstDivergentMove = -1;
+    const int lastMoveScore = submission.mMoves.empty() ? 0 : submission.mMoves.back().mScore;
+    if (submission.mFinalScore > result.mScore || submission.mFinalScore < lastMoveScore) {
+        result.mVerdict = FinalScoreMismatch;
+    }
+    return result;
+}
+
+
+void ReplayVerifier::VerifyBatch (const Submission* submissions, int count, Uint32 rules, Result* results, JobSystem& jobSystem)
+{
+    jobSystem.ParallelFor (count, 8, [submissions, rules, results] (int begin, int end) {
+        for (int index = begin; index < end; index++) {
+            results [index] = Verify (submissions [index], rules);
+        }
+    });
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <Replay.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+class JobSystem;
+
+
+/*!
+ * Checks scores submitted by clients by re-simulating their games from the seed and the moves.
+ *
+ * The game is played on a GameState with its GameStateLogic, so the rules and the random refills are exactly those
+ * of the client. Between moves one update advances the game to the game time of the next move: GameStateLogic::Update
+ * plays the same game however the time is split, so the animations running meanwhile end exactly as they did on the
+ * client.
+ *
+ * A submission is valid if it was played with the rules expected, see Leaderboard::MakeRules, and every move
+ * - is made at a game time no earlier than the move before and before mMaxGameplayTimeSeconds of gameplay run out,
+ * - swaps two neighbouring tiles on the board that rest at that time,
+ * - is made with the score the re-simulation has at that point,
+ * and the final score is at least the score before the last move and at most the re-simulated final score
+ * (the game may end while the last move's tiles are still being destroyed).
+ */
+class ReplayVerifier
+{
+    public:
+        /// a move of a submission
+        struct Move {
+            Uint32 mGameTime;           ///< game miliseconds when the move was made
+            Uint32 mAnimationHeadStart; ///< miliseconds of the swap animation a drag already did
+            Sint32 mScore;              ///< the score when the move was made
+            Sint8 mTileARow, mTileAColumn;
+            Sint8 mTileBRow, mTileBColumn;
+        };
+
+        /// a game as a client submits it
+        struct Submission {
+            Uint32 mSeed;
+            int mRows, mColumns, mMinMatchSize;
+            int mMaxGameplayTimeSeconds;
+            int mFinalScore;            ///< the score claimed
+            std::vector<Move> mMoves;
+        };
+
+        enum Verdict {
+            Valid = 0,
+            TimeGoesBack = 1,           ///< a move is earlier than the one before
+            TimeIsUp = 2,               ///< a move is made after the gameplay time ran out
+            IllegalMove = 3,            ///< a move does not swap two neighbouring resting tiles on the board
+            ScoreMismatch = 4,          ///< the score at a move differs from the re-simulation
+            FinalScoreMismatch = 5,     ///< the claimed final score cannot have been reached
+            BadRules = 6                ///< the board size, match size or game length is not the one expected
+        };
+
+        struct Result {
+            Verdict mVerdict;
+            int mFirstDivergentMove;    ///< the move that failed, -1 for a valid submission or a wrong final score
+            int mScore;                 ///< the re-simulated score, up to the failed move
+        };
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Converts a recorded replay into the submission its client would send.
+         * @param submission output.
+         * @return false if the replay stream is broken.
+         */
+        static bool ReadSubmission (const Replay& replay, Submission& submission);
+
+
+        /*!
+         * Names a verdict for reports.
+         */
+        static const char* GetVerdictName (Verdict verdict);
+
+
+        /*!
+         * Re-simulates one submission.
+         * @param rules the key of the rules the game has to be played with, see Leaderboard::MakeRules.
+         */
+        static Result Verify (const Submission& submission, Uint32 rules);
+
+
+        /*!
+         * Re-simulates submissions on all workers of a job system.
+         * @param rules the key of the rules every game has to be played with, see Leaderboard::MakeRules.
+         * @param results output of one result per submission.
+         */
+        static void VerifyBatch (const Submission* submissions, int count, Uint32 rules, Result* results, JobSystem& jobSystem);
+
+}; /* -----  end of class ReplayVerifier  ----- */
@@ -0,0 +1,169 @@
+#include "SpectatorBroadcast.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/// frames written with one sendmsg at most
+static const int MAX_SEND_FRAMES = 16;
+
+
+SpectatorBroadcast::SpectatorBroadcast () :
+    mSubscriberCount (0),
+    mWaitingCount (0),
+    mSentFrameCount (0),
+    mSentBytes (0),
+    mSkipCount (0),
+    mDroppedFrameCount (0)
+{
+}
+
+
+SpectatorBroadcast::~SpectatorBroadcast ()
+{
+    for (size_t id = 0; id < mSubscribers.size(); id++) {
+        if (mSubscribers [id].mSocket >= 0) {
+            close (mSubscribers [id].mSocket);
+        }
+    }
+}
+
+
+int SpectatorBroadcast::AddSubscriber (int socket)
+{
+    fcntl (socket, F_SETFL, fcntl (socket, F_GETFL, 0) | O_NONBLOCK);
+    int id = static_cast<int>(mSubscribers.size());
+    if (!mFreeIds.empty()) {
+        id = mFreeIds.back();
+        mFreeIds.pop_back();
+    } else {
+        mSubscribers.push_back (Subscriber());
+        mSubscribers.back().mQueue.resize (QUEUE_FRAMES);
+    }
+    Subscriber& subscriber = mSubscribers [id];
+    subscriber.mSocket = socket;
+    subscriber.mIsWaitingForKeyframe = true;
+    subscriber.mQueueStart = 0;
+    subscriber.mQueueCount = 0;
+    subscriber.mSentBytes = 0;
+    mSubscriberCount++;
+    mWaitingCount++;
+    return id;
+}
+
+
+void SpectatorBroadcast::RemoveSubscriber (int id)
+{
+    if (id < 0 || id >= static_cast<int>(mSubscribers.size()) || mSubscribers [id].mSocket < 0) {
+        printf ("ERROR: SpectatorBroadcast::RemoveSubscriber called with unknown subscriber %d.\n", id);
+        return;
+    }
+    Subscriber& subscriber = mSubscribers [id];
+    close (subscriber.mSocket);
+    subscriber.mSocket = -1;
+    mWaitingCount -= subscriber.mIsWaitingForKeyframe ? 1 : 0;
+    for (int index = 0; index < subscriber.mQueueCount; index++) {
+        subscriber.mQueue [(subscriber.mQueueStart + index) % QUEUE_FRAMES].reset();
+    }
+    subscriber.mQueueCount = 0;
+    mFreeIds.push_back (id);
+    mSubscriberCount--;
+}
+
+
+void SpectatorBroadcast::Publish (const SpectatorFramePtr& frame)
+{
+    for (size_t id = 0; id < mSubscribers.size(); id++) {
+        Subscriber& subscriber = mSubscribers [id];
+        if (subscriber.mSocket < 0) {
+            continue;
+        }
+        if (subscriber.mIsWaitingForKeyframe) {
+            if (!frame->mIsKeyframe) {
+                mDroppedFrameCount++;
+                continue;
+            }
+            subscriber.mIsWaitingForKeyframe = false;
+            mWaitingCount--;
+        } else if (subscriber.mQueueCount == QUEUE_FRAMES) {
+            // the frame being sent has to go out whole, the ones after it are dropped
+            const int keptCount = subscriber.mSentBytes > 0 ? 1 : 0;
+            for (int index = keptCount; index < subscriber.mQueueCount; index++) {
+                subscriber.mQueue [(subscriber.mQueueStart + index) % QUEUE_FRAMES].reset();
+            }
+            mDroppedFrameCount += subscriber.mQueueCount - keptCount;
+            subscriber.mQueueCount = keptCount;
+            mSkipCount++;
+            if (!frame->mIsKeyframe) {
+                subscriber.mIsWaitingForKeyframe = true;
+                mWaitingCount++;
+                mDroppedFrameCount++;
+                continue;
+            }
+        }
+        subscriber.mQueue [(subscriber.mQueueStart + subscriber.mQueueCount) % QUEUE_FRAMES] = frame;
+        subscriber.mQueueCount++;
+    }
+}
+
+
+void SpectatorBroadcast::Flush ()
+{
+    for (size_t id = 0; id < mSubscribers.size(); id++) {
+        if (mSubscribers [id].mSocket >= 0 && mSubscribers [id].mQueueCount > 0) {
+            Send (static_cast<int>(id));
+        }
+    }
+}
+
+
+void SpectatorBroadcast::Send (int id)
+{
+    Subscriber& subscriber = mSubscribers [id];
+    while (subscriber.mQueueCount > 0) {
+        iovec parts [MAX_SEND_FRAMES];
+        int partCount = 0;
+        for (; partCount < subscriber.mQueueCount && partCount < MAX_SEND_FRAMES; partCount++) {
+            const std::vector<Uint8>& bytes = subscriber.mQueue [(subscriber.mQueueStart + partCount) % QUEUE_FRAMES]->mBytes;
+            const size_t offset = partCount == 0 ? subscriber.mSentBytes : 0;
+            parts [partCount].iov_base = const_cast<Uint8*>(bytes.data() + offset);
+            parts [partCount].iov_len = bytes.size() - offset;
+        }
+        msghdr message;
+        memset (&message, 0, sizeof (message));
+        message.msg_iov = parts;
+        message.msg_iovlen = partCount;
+        ssize_t sent = sendmsg (subscriber.mSocket, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                // the spectator is gone
+                RemoveSubscriber (id);
+            }
+            return;
+        }
+        mSentBytes += sent;
+        for (int part = 0; part < partCount && sent > 0; part++) {
+            if (static_cast<size_t>(sent) < parts [part].iov_len) {
+                subscriber.mSentBytes += sent;
+                return;
+            }
+            sent -= parts [part].iov_len;
+            subscriber.mQueue [subscriber.mQueueStart].reset();
+            subscriber.mQueueStart = (subscriber.mQueueStart + 1) % QUEUE_FRAMES;
+            subscriber.mQueueCount--;
+            subscriber.mSentBytes = 0;
+            mSentFrameCount++;
+        }
+    }
+}
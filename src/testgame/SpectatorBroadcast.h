@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <SpectatorStream.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Sends the frames of a SpectatorEncoder to many subscribers over stream sockets (local or TCP).
+ *
+ * Every subscriber has a ring of up to QUEUE_FRAMES frames not sent yet. The ring holds shared pointers to the
+ * encoded frames, so publishing a frame to 10000 subscribers copies nothing but a pointer each, and the sockets
+ * are written straight from the shared bytes with writev. Publish only queues, Flush writes: flushing every few
+ * ticks instead of every tick sends several frames per system call, for spectators a few ticks late do not matter.
+ *
+ * A subscriber whose ring is full is too slow to keep up: its queued frames are dropped (but for the one being
+ * sent, so the stream stays whole) and it skips ahead to the next keyframe, which IsKeyframeWanted asks the encoder
+ * for. New subscribers start with a keyframe as well.
+ *
+ * Not thread safe, one broadcast is meant to be driven by one thread. Linux only.
+ */
+class SpectatorBroadcast
+{
+    public:
+        static const int QUEUE_FRAMES = 64;
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        SpectatorBroadcast ();
+        ~SpectatorBroadcast ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Answers whether a subscriber waits for a keyframe, so the encoder should send one soon.
+         */
+        bool IsKeyframeWanted () const
+        {
+            return mWaitingCount > 0;
+        }
+
+        int GetSubscriberCount () const
+        {
+            return mSubscriberCount;
+        }
+
+        /// frames handed to the sockets, a frame counts once per subscriber
+        Uint64 GetSentFrameCount () const
+        {
+            return mSentFrameCount;
+        }
+
+        Uint64 GetSentBytes () const
+        {
+            return mSentBytes;
+        }
+
+        /// times a subscriber fell behind and skipped ahead to a keyframe
+        Uint64 GetSkipCount () const
+        {
+            return mSkipCount;
+        }
+
+        /// frames not sent to subscribers that were behind or waited for a keyframe
+        Uint64 GetDroppedFrameCount () const
+        {
+            return mDroppedFrameCount;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Adds a subscriber. The broadcast owns the socket from then on and makes it non-blocking.
+         * @param socket a connected stream socket.
+         * @return the id of the subscriber.
+         */
+        int AddSubscriber (int socket);
+
+
+        /*!
+         * Removes a subscriber and closes its socket. Subscribers whose socket fails are removed by the broadcast.
+         */
+        void RemoveSubscriber (int id);
+
+
+        /*!
+         * Queues a frame for every subscriber, Flush sends it.
+         */
+        void Publish (const SpectatorFramePtr& frame);
+
+
+        /*!
+         * Sends the queued frames, as much as the sockets take; the rest waits for the next Flush.
+         */
+        void Flush ();
+
+    private:
+        struct Subscriber {
+            int mSocket;                    ///< -1 if the slot is free
+            bool mIsWaitingForKeyframe;
+            std::vector<SpectatorFramePtr> mQueue;  ///< a ring of QUEUE_FRAMES frames
+            int mQueueStart;
+            int mQueueCount;
+            size_t mSentBytes;              ///< of the first frame in the queue
+        };
+
+        /* ====================  LIFECYCLE     ======================================= */
+        SpectatorBroadcast (const SpectatorBroadcast&);
+        SpectatorBroadcast& operator= (const SpectatorBroadcast&);
+
+        /* ====================  MUTATORS      ======================================= */
+        void Send (int id);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        std::vector<Subscriber> mSubscribers;   ///< by id
+        std::vector<int> mFreeIds;
+        int mSubscriberCount;
+        int mWaitingCount;
+        Uint64 mSentFrameCount;
+        Uint64 mSentBytes;
+        Uint64 mSkipCount;
+        Uint64 mDroppedFrameCount;
+
+}; /* -----  end of class SpectatorBroadcast  ----- */
@@ -0,0 +1,259 @@
+#include "SpectatorStream.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Quantizes a displacement in grid coordinates to 1/32767 of the board.
+ */
+static Sint16 QuantizeDisplacement (float displacement)
+{
+    displacement = displacement < -1.0f ? -1.0f : (displacement > 1.0f ? 1.0f : displacement);
+    return static_cast<Sint16>(displacement * 32767.0f + (displacement < 0.0f ? -0.5f : 0.5f));
+}
+
+
+SpectatorEncoder::SpectatorEncoder () :
+    mNextFrame (0),
+    mTick (0),
+    mLastKeyframeTick (0),
+    mIsKeyframeDue (true),
+    mKeyframeCount (0),
+    mKeyframeBytes (0),
+    mDeltaCount (0),
+    mDeltaBytes (0)
+{
+}
+
+
+Uint32 SpectatorEncoder::GetGridChecksum (const Uint8* grid, int cellCount)
+{
+    Uint32 checksum = 2166136261U;
+    for (int index = 0; index < cellCount; index++) {
+        checksum = (checksum ^ grid [index]) * 16777619U;
+    }
+    return checksum;
+}
+
+
+void SpectatorEncoder::Restart ()
+{
+    mIsKeyframeDue = true;
+}
+
+
+std::shared_ptr<SpectatorFrame> SpectatorEncoder::GetFreeFrame ()
+{
+    // frames are released in about the order they were made, so the search rarely goes far
+    for (size_t count = 0; count < mFrames.size(); count++) {
+        std::shared_ptr<SpectatorFrame>& frame = mFrames [mNextFrame];
+        mNextFrame = (mNextFrame + 1) % mFrames.size();
+        if (frame.use_count() == 1) {
+            return frame;
+        }
+    }
+    mFrames.push_back (std::make_shared<SpectatorFrame>());
+    mNextFrame = 0;
+    return mFrames.back();
+}
+
+
+SpectatorFramePtr SpectatorEncoder::Encode (const GameState& gameState, bool isKeyframeWanted)
+{
+    const int cellCount = gameState.GetRows() * gameState.GetColumns();
+    const Uint32 ticksSinceKeyframe = mTick - mLastKeyframeTick;
+    const bool isKeyframe = mIsKeyframeDue || mGrid.size() != static_cast<size_t>(cellCount) || ticksSinceKeyframe >= KEYFRAME_INTERVAL_TICKS ||
+        (isKeyframeWanted && ticksSinceKeyframe >= MIN_KEYFRAME_INTERVAL_TICKS);
+
+    std::shared_ptr<SpectatorFrame> frame = GetFreeFrame();
+    std::vector<Uint8>& bytes = frame->mBytes;
+    bytes.resize (sizeof (SpectatorFrameHeader));
+    SpectatorFrameHeader header;
+    memset (&header, 0, sizeof (header));
+    header.mCellCount = 0;
+    if (isKeyframe) {
+        mGrid.resize (cellCount);
+        for (int index = 0; index < cellCount; index++) {
+            mGrid [index] = static_cast<Uint8>(gameState.GetColorAt (index));
+        }
+        bytes.insert (bytes.end(), mGrid.begin(), mGrid.end());
+        header.mCellCount = static_cast<Uint16>(cellCount);
+        mMotions.assign (cellCount, GameState::Resting);
+        mTweenStartTimes.assign (cellCount, 0);
+        mLastKeyframeTick = mTick;
+        mIsKeyframeDue = false;
+    } else {
+        for (int index = 0; index < cellCount; index++) {
+            const Uint8 color = static_cast<Uint8>(gameState.GetColorAt (index));
+            if (color != mGrid [index]) {
+                mGrid [index] = color;
+                bytes.push_back (static_cast<Uint8>(index & 0xFF));
+                bytes.push_back (static_cast<Uint8>(index >> 8));
+                bytes.push_back (color);
+                header.mCellCount++;
+            }
+        }
+    }
+
+    // a tween is sent when it starts, and in keyframes for spectators that join during it
+    header.mTweenCount = 0;
+    for (int index = 0; index < cellCount; index++) {
+        const GameState::TileTween tween = gameState.GetTileTween (index);
+        if (GameState::Resting == tween.mMotion) {
+            mMotions [index] = GameState::Resting;
+            continue;
+        }
+        if (!isKeyframe && tween.mMotion == mMotions [index] && tween.mStartTime == mTweenStartTimes [index]) {
+            continue;
+        }
+        mMotions [index] = static_cast<Uint8>(tween.mMotion);
+        mTweenStartTimes [index] = tween.mStartTime;
+        const Uint32 startAge = gameState.GetGameTime() - tween.mStartTime;
+        SpectatorTween spectatorTween;
+        spectatorTween.mIndex = static_cast<Uint16>(index);
+        spectatorTween.mMotion = static_cast<Uint8>(tween.mMotion);
+        spectatorTween.mPadding = 0;
+        spectatorTween.mStartAge = static_cast<Uint16>(startAge < 0xFFFF ? startAge : 0xFFFF);
+        spectatorTween.mDuration = static_cast<Uint16>(tween.mDuration < 0xFFFF ? tween.mDuration : 0xFFFF);
+        spectatorTween.mFromX = static_cast<Sint16>(tween.mFromX / (GameState::TILE_DISPLACEMENT_ONE / 256));
+        spectatorTween.mFromY = static_cast<Sint16>(tween.mFromY / (GameState::TILE_DISPLACEMENT_ONE / 256));
+        const size_t tweenStart = bytes.size();
+        bytes.resize (tweenStart + sizeof (spectatorTween));
+        memcpy (&bytes [tweenStart], &spectatorTween, sizeof (spectatorTween));
+        header.mTweenCount++;
+    }
+
+    header.mSize = static_cast<Uint32>(bytes.size());
+    header.mTick = mTick;
+    header.mGameTime = gameState.GetGameTime();
+    header.mGameplayTime = gameState.GetGameplayTime();
+    header.mScore = gameState.GetScore();
+    header.mGridChecksum = GetGridChecksum (mGrid.data(), cellCount);
+    const glm::vec3 displacement = gameState.GetCurrentDraggedTileDisplacement();
+    header.mDragDisplacementX = QuantizeDisplacement (displacement.x);
+    header.mDragDisplacementY = QuantizeDisplacement (displacement.y);
+    header.mType = isKeyframe ? SpectatorFrameHeader::KEYFRAME : SpectatorFrameHeader::DELTA;
+    header.mAnimationState = static_cast<Uint8>(gameState.GetAnimationState());
+    header.mRows = static_cast<Uint8>(gameState.GetRows());
+    header.mColumns = static_cast<Uint8>(gameState.GetColumns());
+    header.mDraggedTileRow = static_cast<Sint8>(gameState.GetDraggedTileRow());
+    header.mDraggedTileColumn = static_cast<Sint8>(gameState.GetDraggedTileColumn());
+    header.mReplacedTileRow = static_cast<Sint8>(gameState.GetReplacedTileRow());
+    header.mReplacedTileColumn = static_cast<Sint8>(gameState.GetReplacedTileColumn());
+    memcpy (bytes.data(), &header, sizeof (header));
+
+    frame->mIsKeyframe = isKeyframe;
+    frame->mTick = mTick;
+    if (isKeyframe) {
+        mKeyframeCount++;
+        mKeyframeBytes += bytes.size();
+    } else {
+        mDeltaCount++;
+        mDeltaBytes += bytes.size();
+    }
+    mTick++;
+    return frame;
+}
+
+
+SpectatorView::SpectatorView () :
+    mIsSynchronized (false),
+    mMismatchCount (0)
+{
+    memset (&mHeader, 0, sizeof (mHeader));
+}
+
+
+bool SpectatorView::Apply (const Uint8* bytes, size_t size)
+{
+    SpectatorFrameHeader header;
+    if (size < sizeof (header)) {
+        mIsSynchronized = false;
+        return false;
+    }
+    memcpy (&header, bytes, sizeof (header));
+    const int cellCount = header.mRows * header.mColumns;
+    const size_t cellBytes = header.mType == SpectatorFrameHeader::KEYFRAME ? static_cast<size_t>(cellCount) : header.mCellCount * 3U;
+    const size_t tweenBytes = header.mTweenCount * sizeof (SpectatorTween);
+    if (header.mSize != size || sizeof (header) + cellBytes + tweenBytes != size ||
+            (header.mType == SpectatorFrameHeader::KEYFRAME && header.mCellCount != cellCount)) {
+        printf ("ERROR: SpectatorView::Apply got a broken frame of %u bytes.\n", static_cast<unsigned int>(size));
+        mIsSynchronized = false;
+        return false;
+    }
+
+    // a delta only applies on top of the frame right before it
+    const Uint8* payload = bytes + sizeof (header);
+    if (header.mType == SpectatorFrameHeader::KEYFRAME) {
+        mGrid.assign (payload, payload + cellCount);
+        mMotions.assign (cellCount, GameState::Resting);
+        mTweenStartTimes.assign (cellCount, 0);
+        mTweenDurations.assign (cellCount, 0);
+        mTweenStartOffsets.assign (cellCount, glm::vec2 (0.0f, 0.0f));
+    } else if (!mIsSynchronized || header.mTick != mHeader.mTick + 1 || header.mRows != mHeader.mRows || header.mColumns != mHeader.mColumns) {
+        mIsSynchronized = false;
+        return false;
+    } else {
+        for (int entry = 0; entry < header.mCellCount; entry++) {
+            const int index = payload [entry * 3] | (payload [entry * 3 + 1] << 8);
+            if (index >= cellCount) {
+                mIsSynchronized = false;
+                return false;
+            }
+            mGrid [index] = payload [entry * 3 + 2];
+        }
+    }
+    payload += cellBytes;
+    for (int tween = 0; tween < header.mTweenCount; tween++) {
+        SpectatorTween spectatorTween;
+        memcpy (&spectatorTween, payload + tween * sizeof (spectatorTween), sizeof (spectatorTween));
+        if (spectatorTween.mIndex >= cellCount || spectatorTween.mMotion >= GameState::MOTION_COUNT) {
+            mIsSynchronized = false;
+            return false;
+        }
+        mMotions [spectatorTween.mIndex] = spectatorTween.mMotion;
+        mTweenStartTimes [spectatorTween.mIndex] = header.mGameTime - spectatorTween.mStartAge;
+        mTweenDurations [spectatorTween.mIndex] = spectatorTween.mDuration;
+        mTweenStartOffsets [spectatorTween.mIndex] = glm::vec2 (spectatorTween.mFromX / 256.0f, spectatorTween.mFromY / 256.0f);
+    }
+    mHeader = header;
+    mIsSynchronized = SpectatorEncoder::GetGridChecksum (mGrid.data(), cellCount) == header.mGridChecksum;
+    if (!mIsSynchronized) {
+        mMismatchCount++;
+    }
+    return mIsSynchronized;
+}
+
+
+GameState::Motion SpectatorView::GetTileMotion (int row, int column) const
+{
+    const int index = row * mHeader.mColumns + column;
+    if (mHeader.mGameTime - mTweenStartTimes [index] >= mTweenDurations [index]) {
+        return GameState::Resting;
+    }
+    return static_cast<GameState::Motion>(mMotions [index]);
+}
+
+
+float SpectatorView::GetTileProgress (int row, int column) const
+{
+    const int index = row * mHeader.mColumns + column;
+    const Uint32 elapsed = mHeader.mGameTime - mTweenStartTimes [index];
+    if (GameState::Resting == mMotions [index] || elapsed >= mTweenDurations [index]) {
+        return 1.0f;
+    }
+    return static_cast<float>(elapsed) / static_cast<float>(mTweenDurations [index]);
+}
+
+
+glm::vec2 SpectatorView::GetTileStartOffset (int row, int column) const
+{
+    return mTweenStartOffsets [row * mHeader.mColumns + column];
+}
@@ -0,0 +1,256 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <GameState.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * The start of every frame of a spectator stream, in host byte order like GameServerMessage. It is followed by
+ * the cells: every color of the grid in a keyframe, or an (index, color) entry of 3 bytes per changed cell in a
+ * delta. Then come mTweenCount SpectatorTweens, one per tile whose animation started since the frame before, and one
+ * per moving tile in a keyframe.
+ */
+struct SpectatorFrameHeader {
+    static const Uint8 KEYFRAME = 1;            ///< the whole board, a spectator can start from it
+    static const Uint8 DELTA = 2;               ///< the changes since the frame of the tick before
+
+    Uint32 mSize;                   ///< of the frame, header included
+    Uint32 mTick;                   ///< counts the frames of the stream
+    Uint32 mGameTime;
+    Uint32 mGameplayTime;
+    Sint32 mScore;
+    Uint32 mGridChecksum;           ///< of the grid after the frame, see SpectatorEncoder::GetGridChecksum
+    Uint16 mTweenCount;             ///< tweens following the cells
+    Sint16 mDragDisplacementX;      ///< of the dragged tile in 1/32767 of the board
+    Sint16 mDragDisplacementY;
+    Uint16 mCellCount;              ///< cells following the header
+    Uint8 mType;
+    Uint8 mAnimationState;
+    Uint8 mRows, mColumns;
+    Sint8 mDraggedTileRow, mDraggedTileColumn;
+    Sint8 mReplacedTileRow, mReplacedTileColumn;
+    Uint8 mPadding [4];
+};
+
+
+/// the animation of a tile in a spectator frame, see GameState::TileTween
+struct SpectatorTween {
+    Uint16 mIndex;                  ///< of the tile in the grid
+    Uint8 mMotion;                  ///< a GameState::Motion
+    Uint8 mPadding;
+    Uint16 mStartAge;               ///< miliseconds the tween has run at the game time of the frame
+    Uint16 mDuration;
+    Sint16 mFromX, mFromY;          ///< offset the tile starts from in 1/256 tile, it eases to its place
+};
+
+
+/// an encoded frame, shared by every subscriber it is sent to
+struct SpectatorFrame {
+    bool mIsKeyframe;
+    Uint32 mTick;
+    std::vector<Uint8> mBytes;      ///< header and payload
+};
+
+typedef std::shared_ptr<const SpectatorFrame> SpectatorFramePtr;
+
+
+/*!
+ * Encodes a running game into a stream for spectators, once per tick however many spectators there are.
+ *
+ * The grid only changes where a swap starts, where Elapse finishes a destroy animation and where CollapseColumn moves
+ * tiles down, so a delta frame carries the cells that differ from the previous frame and the tile animations that
+ * started since, next to the drag displacement that changes every tick. The spectator works out how far every
+ * animation got from the game time of the frame. A delta of a resting board is just the header.
+ *
+ * Frames are handed out as shared pointers, so fanning one out to thousands of subscribers costs a reference count
+ * each. A frame is reused once nobody refers to it any longer, so encoding does not allocate after the first
+ * seconds. Keyframes are sent every KEYFRAME_INTERVAL_TICKS, and sooner when subscribers that fell behind wait
+ * for one (see SpectatorBroadcast).
+ */
+class SpectatorEncoder
+{
+    public:
+        static const Uint32 KEYFRAME_INTERVAL_TICKS = 120;
+        static const Uint32 MIN_KEYFRAME_INTERVAL_TICKS = 15;  ///< keyframes asked for come no closer than this
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        SpectatorEncoder ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Hashes the colors of a grid (FNV-1a), to check that a spectator put together the right board.
+         */
+        static Uint32 GetGridChecksum (const Uint8* grid, int cellCount);
+
+
+        Uint64 GetKeyframeCount () const
+        {
+            return mKeyframeCount;
+        }
+
+        Uint64 GetKeyframeBytes () const
+        {
+            return mKeyframeBytes;
+        }
+
+        Uint64 GetDeltaCount () const
+        {
+            return mDeltaCount;
+        }
+
+        Uint64 GetDeltaBytes () const
+        {
+            return mDeltaBytes;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Encodes the next frame of the stream.
+         * @param gameState the game after this tick's update.
+         * @param isKeyframeWanted whether subscribers wait for a keyframe, see SpectatorBroadcast::IsKeyframeWanted.
+         * @return the frame, a keyframe at the start of the stream, after Restart and when one is due.
+         */
+        SpectatorFramePtr Encode (const GameState& gameState, bool isKeyframeWanted);
+
+
+        /*!
+         * Makes the next frame a keyframe, eg. when the stream switches to another game.
+         */
+        void Restart ();
+
+    private:
+        /* ====================  LIFECYCLE     ======================================= */
+        SpectatorEncoder (const SpectatorEncoder&);
+        SpectatorEncoder& operator= (const SpectatorEncoder&);
+
+        /* ====================  MUTATORS      ======================================= */
+        std::shared_ptr<SpectatorFrame> GetFreeFrame ();
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        std::vector<std::shared_ptr<SpectatorFrame>> mFrames;  ///< every frame made so far, reused once unreferenced
+        size_t mNextFrame;                  ///< where the search for a free frame goes on
+        std::vector<Uint8> mGrid;           ///< as of the last frame
+        Uint32 mTick;
+        Uint32 mLastKeyframeTick;
+        bool mIsKeyframeDue;
+        std::vector<Uint8> mMotions;        ///< of every tile as of the last frame
+        std::vector<Uint32> mTweenStartTimes;   ///< game times the tweens of the last frame started at
+        Uint64 mKeyframeCount;
+        Uint64 mKeyframeBytes;
+        Uint64 mDeltaCount;
+        Uint64 mDeltaBytes;
+
+}; /* -----  end of class SpectatorEncoder  ----- */
+
+
+/*!
+ * A spectator's copy of a streamed game, put together from the frames. It starts from a keyframe; a delta that
+ * does not follow the frame before it, or after which the board checksum differs, leaves the view waiting for
+ * the next keyframe.
+ */
+class SpectatorView
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        SpectatorView ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Answers whether the view shows the game as of its last frame.
+         */
+        bool IsSynchronized () const
+        {
+            return mIsSynchronized;
+        }
+
+        Uint32 GetTick () const
+        {
+            return mHeader.mTick;
+        }
+
+        int GetRows () const
+        {
+            return mHeader.mRows;
+        }
+
+        int GetColumns () const
+        {
+            return mHeader.mColumns;
+        }
+
+        GameState::Color GetColorAt (int row, int column) const
+        {
+            return static_cast<GameState::Color>(mGrid [row * mHeader.mColumns + column]);
+        }
+
+        int GetScore () const
+        {
+            return mHeader.mScore;
+        }
+
+        GameState::AnimationState GetAnimationState () const
+        {
+            return static_cast<GameState::AnimationState>(mHeader.mAnimationState);
+        }
+
+        /// of the dragged tile in grid coordinates, the replaced tile moves the other way
+        glm::vec2 GetDragDisplacement () const
+        {
+            return glm::vec2 (mHeader.mDragDisplacementX / 32767.0f, mHeader.mDragDisplacementY / 32767.0f);
+        }
+
+        /// how a tile moves at the game time of the last frame
+        GameState::Motion GetTileMotion (int row, int column) const;
+
+        /// progress of the tile's animation from 0 to 1, 1 for a resting tile
+        float GetTileProgress (int row, int column) const;
+
+        /// where the tile's animation started in tiles from its place, the tile eases from there to its place
+        glm::vec2 GetTileStartOffset (int row, int column) const;
+
+        /// frames after which the board did not match the sender's
+        Uint64 GetMismatchCount () const
+        {
+            return mMismatchCount;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Applies the next frame of the stream.
+         * @param bytes a whole frame, starting with its SpectatorFrameHeader.
+         * @param size the size of the frame.
+         * @return false if the frame is broken or could not be applied, the view then waits for a keyframe.
+         */
+        bool Apply (const Uint8* bytes, size_t size);
+
+    private:
+        /* ====================  DATA MEMBERS  ======================================= */
+        SpectatorFrameHeader mHeader;       ///< of the last frame applied
+        std::vector<Uint8> mGrid;
+        // the last tween of every tile
+        std::vector<Uint8> mMotions;
+        std::vector<Uint32> mTweenStartTimes;   ///< game time
+        std::vector<Uint32> mTweenDurations;
+        std::vector<glm::vec2> mTweenStartOffsets;  ///< in tiles
+        bool mIsSynchronized;
+        Uint64 mMismatchCount;
+
+}; /* -----  end of class SpectatorView  ----- */
@@ -4,6 +4,7 @@
 #include <GameStateRenderer.h>
 #include <GameStateLogic.h>
 #include <GameState.h>
+#include <chrono>
 #include <time.h>
 
 #ifdef TARGET_MSVC
@@ -14,23 +15,59 @@
 #endif
 
 
-TestGame::TestGame () : mGameStateLogic()
+const Uint32 TestGame::BOT_THINK_TIME_MILIS = 100;
+const int TestGame::BOT_MAX_PLAYOUTS = 1 << 20;
+const char* TestGame::REPLAY_FILE_PATH = "last_game.tmr";
+const char* TestGame::AUTOSAVE_FILE_PATH = "autosave.tmj";
+const Uint32 TestGame::SIMULATION_STEP_MILIS = 8;
+const int TestGame::MAX_CATCH_UP_STEPS = 25;
+
+
+TestGame::TestGame () : mJobSystem (0, false), mMctsBot(), mBotBoard(), mBotSearchSeed (0), mBotSearchResult(),
+    mBotSearchJob (NULL), mIsBotPlaying (false), mGameStateLogic(), mIsReplayRecorded (false),
+    mFixedTimestep (SIMULATION_STEP_MILIS, MAX_CATCH_UP_STEPS), mSoundMovingTileCounts (), mIsSoundGameOver (false),
+    mIsSimulationRunning (false),
+    mIsRenderSnapshotStale (true), mWakeEventType (0), mIsWakeEventPending (false), mIsRedrawNeeded (true)
 {
 }
 
 
-bool TestGame::Input()
+bool TestGame::Input (int timeoutMilis)
 {
     SDL_Event e;
 
-    while (SDL_PollEvent (&e) != 0){
-        mGameStateLogic.Input (e, *mGameState);
+    // wait for the first event if asked to, take whatever else is queued
+    int isEvent;
+    if (timeoutMilis == 0) {
+        isEvent = SDL_PollEvent (&e);
+    } else if (timeoutMilis < 0) {
+        isEvent = SDL_WaitEvent (&e);
+    } else {
+        isEvent = SDL_WaitEventTimeout (&e, timeoutMilis);
+    }
+    for (; isEvent != 0; isEvent = SDL_PollEvent (&e)) {
+        // a new snapshot to draw, not input
+        if (e.type == mWakeEventType) {
+            mIsWakeEventPending = false;
+            continue;
+        }
+        // the window was exposed or resized, draw it even if the game did not change
+        if (e.type == SDL_WINDOWEVENT) {
+            mIsRedrawNeeded = true;
+        }
+        // F2 prints how busy the job system workers are
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F2) {
+            mJobSystem.PrintWorkerStats();
+        }
         // quit if user presses Alt+F4 or closes the window
         if (e.type == SDL_QUIT){
             return false;
         }
+        // the game is the simulation thread's, it takes the events at its next update
+        mInputQueue.Push (e, SDL_GetPerformanceCounter());
     }
-    return true;
+    mInputQueue.EndFrame();
+    return mIsSimulationRunning;
 }
 
 
@@ -38,17 +75,48 @@ void TestGame::Start()
 {
     Init();
 
+    PublishRenderSnapshot();
+    mIsSimulationRunning = true;
+    mSimulationThread = std::thread (&TestGame::RunSimulation, this);
+    const bool isIdleAllowed = mFramePacer.IsIdleAllowed();
     bool isLooping = true;
     while (isLooping) {
-        isLooping &= Input();
-        isLooping &= Update();
-        isLooping &= GameStateRenderer::Render (*mGameState);
+        // once a settled snapshot is drawn, nothing changes on screen until an event, a new snapshot or the timer ticks
+        const RenderSnapshot& drawnSnapshot = mRenderSnapshots.GetReadBuffer();
+        const bool isIdle = isIdleAllowed && !mIsRedrawNeeded && drawnSnapshot.IsSettled();
+        isLooping &= Input (isIdle ? drawnSnapshot.GetMilisToTimerTick() : 0);
+        mIsRedrawNeeded |= mRenderSnapshots.Acquire();
+        const RenderSnapshot& snapshot = mRenderSnapshots.GetReadBuffer();
+        if (isIdleAllowed && !mIsRedrawNeeded && snapshot.IsSettled()) {
+            mFramePacer.Pause();
+            continue;
+        }
+        isLooping &= GameStateRenderer::Render (snapshot, snapshot.GetInterpolation (SDL_GetPerformanceCounter()));
+        mFramePacer.EndFrame();
+        mIsRedrawNeeded = false;
     }
+    mIsSimulationRunning = false;
+    mSimulationThread.join();
 }		/* -----  end of function Start();  ----- */
 
 
 TestGame::~TestGame ()
 {
+    mIsSimulationRunning = false;
+    if (mSimulationThread.joinable()) {
+        mSimulationThread.join();
+    }
+    mAutosaveJournal.Close();
+    if (mGameState && mIsReplayRecorded) {
+        mReplayRecorder.Finish (*mGameState);
+        if (mReplayRecorder.GetReplay().Save (REPLAY_FILE_PATH)) {
+            printf ("TestGame::~TestGame: replay saved to %s.\n", REPLAY_FILE_PATH);
+        }
+    }
+    mAudioMixer.Close();
+    mJobSystem.PrintWorkerStats();
+    mFramePacer.PrintStats();
+    mAudioMixer.PrintStats();
 	GameStateRenderer::DestroyRenderer();
     SDL_Quit();
 }
@@ -67,13 +135,41 @@ bool TestGame::Init()
 		printf ("SDL_INIT failed. SDL_ERROR: %s\n", SDL_GetError());
 	}
 	assert (sdlInitReturn >= 0);
+    mWakeEventType = SDL_RegisterEvents (1);
+    if (mWakeEventType == static_cast<Uint32>(-1)) {
+        isSuccessful = false;
+        printf ("ERROR: TestGame::Init: no SDL event type left to wake the render thread with.\n");
+    }
 
-    isSuccessful = isSuccessful && GameStateRenderer::InitRenderer();
-    // create a new game
+    // without sound the game plays on silently
+    mAudioMixer.Open();
 
-    mGameState.reset (new GameState (8, 8, 3, 60));
-    mGameState->AttachGameStateGridChangeObserver (&mGameStateLogic);
-    mTimeAtLastFrame = SDL_GetTicks();
+    isSuccessful = isSuccessful && GameStateRenderer::InitRenderer (mJobSystem);
+    if (isSuccessful) {
+        mFramePacer.ApplySwapInterval();
+    }
+    // continue the game of the last run if it did not end, create a new game otherwise
+    Uint32 seed;
+    if (mAutosaveJournal.Resume (AUTOSAVE_FILE_PATH, mGameStateLogic, mGameState, seed)) {
+        printf ("TestGame::Init: resumed the game from %s.\n", AUTOSAVE_FILE_PATH);
+    } else {
+        seed = static_cast<Uint32>(time (NULL));
+        mGameState.reset (new GameState (8, 8, 3, 60, seed));
+        mGameState->AttachGameStateGridChangeObserver (&mGameStateLogic);
+        mReplayRecorder.Begin (*mGameState, seed);
+        mGameStateLogic.SetReplayRecorder (&mReplayRecorder);
+        mIsReplayRecorded = true;
+        mAutosaveJournal.Start (AUTOSAVE_FILE_PATH, *mGameState, seed);
+    }
+    mGameStateLogic.SetAutosaveJournal (&mAutosaveJournal);
+    mGameState->AttachGameStateGridChangeObserver (&mHintSearch);
+    mPreviousGameState.reset (new GameState (mGameState->GetRows(), mGameState->GetColumns(), mGameState->GetMinMatchSize(), 0));
+    mPreviousGameState->CopyStateFrom (*mGameState);
+    for (int motion = 0; motion < GameState::MOTION_COUNT; motion++) {
+        mSoundMovingTileCounts [motion] = mGameState->GetMovingTileCount (static_cast<GameState::Motion>(motion));
+    }
+    mIsSoundGameOver = GameState::GameOver == mGameState->GetAnimationState();
+    mFixedTimestep.Start (SDL_GetPerformanceCounter(), SDL_GetPerformanceFrequency());
 
     if (isSuccessful) {
         printf ("TestGame::Init DONE.\n");
@@ -88,10 +184,192 @@ bool TestGame::Update()
 {
     bool isSuccessful = true;
 
-    Uint32 timeAtThisFrame = SDL_GetTicks();
-    Uint32 deltaTime = timeAtThisFrame - mTimeAtLastFrame;
-    mTimeAtLastFrame = timeAtThisFrame;
-    isSuccessful = isSuccessful && mGameStateLogic.Update (deltaTime, *mGameState);
+    isSuccessful = isSuccessful && Simulate();
+    if ((mIsBotPlaying || mBotSearchJob != NULL) && !PlayBotMove()) {
+        printf ("TestGame::Update: bot found no swap that makes a match, bot stopped.\n");
+        mIsBotPlaying = false;
+    }
+    PlaySounds();
+    // what is left of the step goes to the hint, a slice of the search at a time
+    mHintSearch.Update (*mGameState);
+    if (mIsRenderSnapshotStale) {
+        PublishRenderSnapshot();
+    }
 
     return isSuccessful;
 }		/* -----  end of function 'Update'  ----- */
+
+
+bool TestGame::PlayBotMove()
+{
+    // the search runs on the workers while the game steps on, its move is played once it is done
+    if (mBotSearchJob != NULL) {
+        if (!JobSystem::IsFinished (mBotSearchJob)) {
+            return true;
+        }
+        mBotSearchJob = NULL;
+        // F3 may have stopped the bot meanwhile
+        if (!mIsBotPlaying) {
+            return true;
+        }
+        const MctsBot::SearchResult& result = mBotSearchResult;
+        if (result.mMove < 0) {
+            return false;
+        }
+        // the move is of the grid searched; if the game does not accept a swap now or the grid changed, search again
+        if (!IsBotSwapAccepted()) {
+            return true;
+        }
+        GameBoard board (mGameState->GetRows(), mGameState->GetColumns(), mGameState->GetMinMatchSize(), GameState::sNUMBER_OF_TILE_COLORS);
+        board.CopyFrom (*mGameState, 0);
+        for (int row = 0; row < board.GetRows(); row++) {
+            for (int column = 0; column < board.GetColumns(); column++) {
+                if (board.GetColorAt (row, column) != mBotBoard->GetColorAt (row, column)) {
+                    return true;
+                }
+            }
+        }
+        int tileARow, tileAColumn, tileBRow, tileBColumn;
+        GameBoard::DecodeMove (result.mMove, tileARow, tileAColumn, tileBRow, tileBColumn);
+        printf ("TestGame::PlayBotMove: swapping (%d,%d) with (%d,%d), %d playouts at %.0f playouts/s, %.1f points expected.\n",
+                tileARow, tileAColumn, tileBRow, tileBColumn, result.mPlayouts, result.mPlayoutsPerSecond, result.mExpectedPoints);
+        mGameStateLogic.RequestSwap (tileARow, tileAColumn, tileBRow, tileBColumn, *mGameState);
+        return true;
+    }
+    // the bot moves only when a player's click would be accepted
+    if (!mIsBotPlaying || !IsBotSwapAccepted()) {
+        return true;
+    }
+    mBotBoard->CopyFrom (*mGameState, SDL_GetTicks());
+    mBotSearchSeed = SDL_GetTicks();
+    mBotSearchJob = mJobSystem.CreateJob (&TestGame::RunBotSearch, this);
+    mJobSystem.Submit (mBotSearchJob);
+    return true;
+}
+
+
+bool TestGame::IsBotSwapAccepted() const
+{
+    return mGameState->GetAnimationState() == GameState::Idle && !mGameStateLogic.IsGridCheckPending() && !mGameState->IsDragActive();
+}
+
+
+void TestGame::RunBotSearch (const void* context, int begin, int end)
+{
+    (void)begin;
+    (void)end;
+    TestGame* game = static_cast<TestGame*>(const_cast<void*>(context));
+    game->mBotSearchResult = game->mMctsBot->Search (*game->mBotBoard, BOT_MAX_PLAYOUTS, BOT_THINK_TIME_MILIS, game->mBotSearchSeed);
+}
+
+
+bool TestGame::Simulate()
+{
+    bool isSuccessful = true;
+    int stepCount = mFixedTimestep.Advance (SDL_GetPerformanceCounter());
+    for (int step = 0; step < stepCount && isSuccessful; step++) {
+        // the input of a step is what happened before it was due
+        ApplyInput (mFixedTimestep.GetStepCounter() - (stepCount - 1 - step) * mFixedTimestep.GetStepCounterTicks());
+        mPreviousGameState->CopyStateFrom (*mGameState);
+        isSuccessful = mGameStateLogic.Update (mFixedTimestep.GetStepMilis(), *mGameState);
+        PlaySounds();
+        mIsRenderSnapshotStale = true;
+    }
+    ApplyInput (~0ULL);
+    return isSuccessful;
+}
+
+
+void TestGame::PlaySounds()
+{
+    // every area of the board plays its own animations, a sound is due where more tiles start moving a way
+    int movingTileCounts [GameState::MOTION_COUNT];
+    for (int motion = 0; motion < GameState::MOTION_COUNT; motion++) {
+        movingTileCounts [motion] = mGameState->GetMovingTileCount (static_cast<GameState::Motion>(motion));
+    }
+    if (movingTileCounts [GameState::Swapping] > mSoundMovingTileCounts [GameState::Swapping]) {
+        mAudioMixer.Play (AudioMixer::Swap);
+    }
+    if (movingTileCounts [GameState::Destroying] > mSoundMovingTileCounts [GameState::Destroying]) {
+        // matches made as falling tiles land
+        mAudioMixer.Play (movingTileCounts [GameState::Falling] < mSoundMovingTileCounts [GameState::Falling] ? AudioMixer::Cascade : AudioMixer::Match);
+    }
+    const bool isGameOver = GameState::GameOver == mGameState->GetAnimationState();
+    if (isGameOver && !mIsSoundGameOver) {
+        mAudioMixer.Play (AudioMixer::GameOver);
+    }
+    for (int motion = 0; motion < GameState::MOTION_COUNT; motion++) {
+        mSoundMovingTileCounts [motion] = movingTileCounts [motion];
+    }
+    mIsSoundGameOver = isGameOver;
+}
+
+
+void TestGame::ApplyInput (Uint64 counter)
+{
+    for (const InputQueue::Event* event = mInputQueue.Peek(); event != NULL && event->mCounter <= counter; event = mInputQueue.Peek()) {
+        SDL_Event e = event->mEvent;
+        mInputQueue.Pop();
+        mGameStateLogic.Input (e, *mGameState);
+        // F3 lets the bot play instead of the player or hands the game back
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+            mIsBotPlaying = !mIsBotPlaying;
+            if (mIsBotPlaying && !mMctsBot) {
+                mMctsBot.reset (new MctsBot (mJobSystem));
+                mBotBoard.reset (new GameBoard (mGameState->GetRows(), mGameState->GetColumns(), mGameState->GetMinMatchSize(), GameState::sNUMBER_OF_TILE_COLORS));
+            }
+            printf ("TestGame::ApplyInput: bot %s.\n", mIsBotPlaying ? "playing" : "stopped");
+        }
+        mIsRenderSnapshotStale = true;
+    }
+}
+
+
+void TestGame::PublishRenderSnapshot()
+{
+    RenderSnapshot& snapshot = mRenderSnapshots.GetWriteBuffer();
+    snapshot.Capture (*mGameState, *mPreviousGameState, mFixedTimestep.GetStepCounter(), mFixedTimestep.GetStepCounterTicks());
+    int tileARow, tileAColumn, tileBRow, tileBColumn;
+    if (mHintSearch.GetHint (tileARow, tileAColumn, tileBRow, tileBColumn)) {
+        snapshot.SetHint (tileARow, tileAColumn, tileBRow, tileBColumn);
+    }
+    mIsRenderSnapshotStale = false;
+    // a resting board steps without changing what is drawn, the write buffer is taken again by the next capture
+    if (snapshot.IsSameDrawingAs (mPublishedRenderSnapshot)) {
+        return;
+    }
+    mPublishedRenderSnapshot = snapshot;
+    mRenderSnapshots.Publish();
+    // one wake event queued at most, the render thread takes the latest snapshot anyway
+    if (!mIsWakeEventPending.exchange (true)) {
+        SDL_Event e;
+        SDL_zero (e);
+        e.type = mWakeEventType;
+        if (SDL_PushEvent (&e) < 1) {
+            mIsWakeEventPending = false;
+        }
+    }
+}
+
+
+void TestGame::RunSimulation()
+{
+    const Uint64 counterFrequency = SDL_GetPerformanceFrequency();
+    while (mIsSimulationRunning) {
+        if (!Update()) {
+            mIsSimulationRunning = false;
+            break;
+        }
+        // sleep until the next step is due
+        const Uint64 nextStepCounter = mFixedTimestep.GetStepCounter() + mFixedTimestep.GetStepCounterTicks();
+        const Uint64 counter = SDL_GetPerformanceCounter();
+        if (nextStepCounter > counter) {
+            std::this_thread::sleep_for (std::chrono::microseconds ((nextStepCounter - counter) * 1000000 / counterFrequency));
+        }
+    }
+    // the bot's search uses members of the game, it ends before the game is destroyed
+    if (mBotSearchJob != NULL) {
+        mJobSystem.Wait (mBotSearchJob);
+        mBotSearchJob = NULL;
+    }
+}
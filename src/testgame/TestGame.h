@@ -1,8 +1,21 @@
 #pragma once
+#include <AudioMixer.h>
+#include <AutosaveJournal.h>
+#include <FixedTimestep.h>
+#include <FramePacer.h>
 #include <GameStateLogic.h>
+#include <InputQueue.h>
 #include <GameState.h>
+#include <HintSearch.h>
+#include <JobSystem.h>
+#include <MctsBot.h>
+#include <RenderSnapshot.h>
+#include <Replay.h>
+#include <TripleBuffer.h>
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <thread>
 
 #ifdef TARGET_MSVC
     #include <SDL.h>
@@ -14,7 +27,20 @@
 
 /*!
  * This is the main application code.
- * It holds the main game loop.
+ * It holds the main game loop, on two threads: the thread that calls Start handles the window's events and renders,
+ * a simulation thread runs the game. Input events are handed to the simulation thread through an InputQueue, each
+ * applied before the first step due after it was polled. The simulation thread publishes a RenderSnapshot of the
+ * game after every change through a TripleBuffer; the render thread only ever reads snapshots.
+ * A slow frame therefore never delays the game or its input, and the game steps more often than the display shows.
+ * Snapshots that draw the same as the last one are not published. While the snapshot drawn last is settled, the
+ * render thread sleeps in SDL_WaitEventTimeout until an event, the next tick of the timer or a wake event the
+ * simulation thread pushes with a new snapshot, and draws nothing, so a resting game costs next to no CPU.
+ * How the frames are paced is up to the FramePacer, set from the command line; uncapped, every frame is drawn.
+ * Between steps the simulation thread searches the best move in time slices of a few hundred microseconds with a
+ * HintSearch, and the snapshot shows it once the player has not moved for a few seconds. F3 lets an MctsBot play: its
+ * search runs as a job on the workers and the simulation thread steps and publishes on until the move is found.
+ * Swaps, matches, cascades and the end of the game play a sound: the simulation thread hands them to the AudioMixer's
+ * callback without locks.
  */
 class TestGame
 {
@@ -25,17 +51,43 @@ class TestGame
 
         /* ====================  ACCESSORS     ======================================= */
 
+        /*!
+         * The thread pool shared by all parallel work of the application.
+         */
+        JobSystem& GetJobSystem ()
+        {
+            return mJobSystem;
+        }
+
+        /*!
+         * The pacing of the frames, to be set before Start.
+         */
+        FramePacer& GetFramePacer ()
+        {
+            return mFramePacer;
+        }
+
+        /*!
+         * The search of the move hinted to an idle player, to be set up before Start.
+         */
+        HintSearch& GetHintSearch ()
+        {
+            return mHintSearch;
+        }
+
         /* ====================  MUTATORS      ======================================= */
 
         /*!
-         * Handle menu level input, pass game input onto GameStateLogic.
+         * Handle menu level input, hand game input over to the simulation thread. Render thread.
+         * @param timeoutMilis how long to wait for the first event, 0 to only poll, -1 to wait for one however long.
          * @return true if the game loop is to continue running.
          */
-        bool Input ();
+        bool Input (int timeoutMilis);
 
 
         /*!
-         * Handle menu level update, pass game update onto GameStateLogic.
+         * Handle menu level update, pass game input and update onto GameStateLogic and publish a snapshot of the
+         * game if it changed. Simulation thread.
          * @return false if there's a problem or if the application is exited, true otherwise.
          */
         bool Update ();
@@ -60,11 +112,103 @@ class TestGame
         /* ====================  DATA MEMBERS  ======================================= */
 
     private:
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Answers whether the game accepts a swap now, as it would a player's click.
+         */
+        bool IsBotSwapAccepted () const;
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Starts a search of the bot on the workers once the game accepts a swap, and swaps the move it found through
+         * GameStateLogic when it is done, if the bot still plays and the grid is still the one searched.
+         * The game steps on while the bot thinks, so thinking costs the bot gameplay time like it does a player.
+         * @return false if the bot found no swap that makes a match, true otherwise.
+         */
+        bool PlayBotMove ();
+
+
+        /*!
+         * Job function searching the bot's move of mBotBoard into mBotSearchResult.
+         * @param context the TestGame.
+         */
+        static void RunBotSearch (const void* context, int begin, int end);
+
+
+        /*!
+         * Simulates the fixed steps due since the last call, keeping the state before the last step to render from.
+         * @return false if there's a problem, true otherwise.
+         */
+        bool Simulate ();
+
+
+        /*!
+         * Plays the sound of the animation the game started since the last call, if any. Simulation thread.
+         */
+        void PlaySounds ();
+
+
+        /*!
+         * Passes the queued input events polled up to a counter value on to GameStateLogic.
+         * @param counter a SDL_GetPerformanceCounter value.
+         */
+        void ApplyInput (Uint64 counter);
+
+
+        /*!
+         * Captures the game into the write buffer of mRenderSnapshots and publishes it, unless it draws the same as the
+         * snapshot published last. Wakes the render thread if it waits for events.
+         */
+        void PublishRenderSnapshot ();
+
+
+        /*!
+         * The simulation thread: updates the game whenever a step is due, until mIsSimulationRunning is cleared.
+         */
+        void RunSimulation ();
+
         /* ====================  DATA MEMBERS  ======================================= */
 
+        static const Uint32 BOT_THINK_TIME_MILIS;
+        static const int BOT_MAX_PLAYOUTS;          ///< playouts per bot move at most, BOT_THINK_TIME_MILIS usually ends it first
+        static const char* REPLAY_FILE_PATH;
+        static const char* AUTOSAVE_FILE_PATH;
+        static const Uint32 SIMULATION_STEP_MILIS;  ///< the game time every update simulates, whatever the frame rate
+        static const int MAX_CATCH_UP_STEPS;        ///< updates simulated at most per frame after a stall
+
+        JobSystem mJobSystem;   ///< created first, so it is destroyed after everything that may still run jobs; no worker runs on
+                                ///< the render thread, which never waits for jobs
+        std::unique_ptr<MctsBot> mMctsBot;  ///< created the first time F3 lets the bot play, its node pool is large
+        std::unique_ptr<GameBoard> mBotBoard;           ///< the grid the bot searches, created with mMctsBot
+        Uint32 mBotSearchSeed;
+        MctsBot::SearchResult mBotSearchResult;         ///< written by the search job, read once it is finished
+        JobSystem::Job* mBotSearchJob;                  ///< the search running on the workers, NULL if none
+        bool mIsBotPlaying;     ///< toggled with F3
         GameStateLogic mGameStateLogic;
+        ReplayRecorder mReplayRecorder;     ///< records the game, saved to REPLAY_FILE_PATH on exit
+        bool mIsReplayRecorded;             ///< false for a resumed game, a replay starts with a new game
+        AutosaveJournal mAutosaveJournal;   ///< keeps the game in AUTOSAVE_FILE_PATH, resumed on the next start
         std::unique_ptr<GameState> mGameState;
-        Uint32 mTimeAtLastFrame;
+        std::unique_ptr<GameState> mPreviousGameState;  ///< one step before mGameState, rendered in between
+        FixedTimestep mFixedTimestep;
+        TripleBuffer<RenderSnapshot> mRenderSnapshots;  ///< from the simulation thread to the render thread
+        RenderSnapshot mPublishedRenderSnapshot;        ///< a copy of the snapshot published last, simulation thread
+        HintSearch mHintSearch;                         ///< simulation thread
+        AudioMixer mAudioMixer;                         ///< played from the simulation thread
+        int mSoundMovingTileCounts [GameState::MOTION_COUNT];  ///< the moving tiles PlaySounds saw last
+        bool mIsSoundGameOver;                          ///< whether PlaySounds saw the game end
+
+        // threads
+        std::thread mSimulationThread;
+        std::atomic<bool> mIsSimulationRunning;
+        InputQueue mInputQueue;                         ///< from the render thread to the simulation thread
+        bool mIsRenderSnapshotStale;                    ///< the game changed since the last snapshot, simulation thread
+        Uint32 mWakeEventType;                          ///< the SDL event type the simulation thread wakes the render thread with
+        std::atomic<bool> mIsWakeEventPending;          ///< a wake event is queued and not yet polled
+        bool mIsRedrawNeeded;                           ///< the window needs drawing whatever the snapshot, render thread
+        FramePacer mFramePacer;                         ///< render thread
 
 
 }; /* -----  end of class TestGame  ----- */
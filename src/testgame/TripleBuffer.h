@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+
+
+/*!
+ * Hands the latest value from one writer thread to one reader thread without locks and without either ever waiting.
+ *
+ * There are three buffers: the writer fills its own, the reader reads its own and the third is the latest published
+ * one. Publish swaps the writer's buffer with the third one and Acquire swaps the reader's buffer with it, if one was
+ * published since. Both swaps are a single atomic exchange of an index, so the writer can publish far more often than
+ * the reader reads (values in between are overwritten) and neither ever sees a buffer the other is using.
+ *
+ * The buffers are reused, so a value that keeps its capacity (eg. a std::vector) is not allocated again.
+ */
+template <class Value>
+class TripleBuffer
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        TripleBuffer () : mWriteIndex (0), mLatestIndex (1), mReadIndex (2)
+        {
+        }
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * The value the reader acquired last; before the first Acquire, a default constructed one. Reader only.
+         */
+        const Value& GetReadBuffer () const
+        {
+            return mBuffers [mReadIndex];
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * The buffer to fill before Publish. It holds a value published before, not necessarily the last one. Writer only.
+         */
+        Value& GetWriteBuffer ()
+        {
+            return mBuffers [mWriteIndex];
+        }
+
+
+        /*!
+         * Makes the write buffer the latest value and gives the writer another buffer. Writer only.
+         */
+        void Publish ()
+        {
+            mWriteIndex = mLatestIndex.exchange (mWriteIndex | IS_FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+
+        /*!
+         * Takes the latest value as the read buffer, if one was published since the last Acquire. Reader only.
+         * @return true if the read buffer changed.
+         */
+        bool Acquire ()
+        {
+            if ((mLatestIndex.load (std::memory_order_relaxed) & IS_FRESH) == 0) {
+                return false;
+            }
+            mReadIndex = mLatestIndex.exchange (mReadIndex, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+    private:
+        static const int INDEX_MASK = 3;
+        static const int IS_FRESH = 4;      ///< set on the latest index while the reader has not taken it
+
+        /* ====================  LIFECYCLE     ======================================= */
+        TripleBuffer (const TripleBuffer&);
+        TripleBuffer& operator= (const TripleBuffer&);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        // the indices are kept on separate cache lines, so the threads do not slow each other down
+        Value mBuffers [3];
+        int mWriteIndex;                    ///< writer thread side
+        char mWritePadding [64];
+        std::atomic<int> mLatestIndex;
+        char mLatestPadding [64];
+        int mReadIndex;                     ///< reader thread side
+
+}; /* -----  end of class TripleBuffer  ----- */
@@ -0,0 +1,168 @@
+#include "VersusLink.h"
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+VersusLink::VersusLink () :
+    mSocket (-1),
+    mLatencyMilis (0),
+    mJitterMilis (0),
+    mLossThreshold (0),
+    mRandom (static_cast<Uint32>(std::chrono::steady_clock::now().time_since_epoch().count())),
+    mAckedFrameCount (0),
+    mRemoteFrame (0),
+    mRemoteFrameAdvantage (0),
+    mSentCount (0),
+    mDroppedCount (0),
+    mReceivedCount (0)
+{
+}
+
+
+VersusLink::~VersusLink ()
+{
+    Close();
+}
+
+
+bool VersusLink::Open (Uint16 localPort, Uint16 remotePort)
+{
+    Close();
+    mSocket = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    sockaddr_in localAddress;
+    memset (&localAddress, 0, sizeof (localAddress));
+    localAddress.sin_family = AF_INET;
+    localAddress.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    localAddress.sin_port = htons (localPort);
+    sockaddr_in remoteAddress = localAddress;
+    remoteAddress.sin_port = htons (remotePort);
+    // connected, so packets from anyone but the remote peer are not received
+    if (mSocket < 0 || bind (mSocket, reinterpret_cast<sockaddr*>(&localAddress), sizeof (localAddress)) != 0 ||
+            connect (mSocket, reinterpret_cast<sockaddr*>(&remoteAddress), sizeof (remoteAddress)) != 0) {
+        printf ("ERROR: VersusLink::Open cannot use port %u: %s\n", localPort, strerror (errno));
+        Close();
+        return false;
+    }
+    mDelayedPackets.clear();
+    mAckedFrameCount = 0;
+    mRemoteFrame = 0;
+    mRemoteFrameAdvantage = 0;
+    return true;
+}
+
+
+void VersusLink::Close ()
+{
+    if (mSocket >= 0) {
+        close (mSocket);
+        mSocket = -1;
+    }
+}
+
+
+void VersusLink::SetConditions (Uint32 latencyMilis, Uint32 jitterMilis, double lossPercent)
+{
+    mLatencyMilis = latencyMilis;
+    mJitterMilis = jitterMilis;
+    lossPercent = lossPercent < 0.0 ? 0.0 : (lossPercent > 100.0 ? 100.0 : lossPercent);
+    mLossThreshold = static_cast<Uint32>(lossPercent / 100.0 * 4294967295.0);
+}
+
+
+int VersusLink::GetFramesToWait (const VersusSession& versusSession) const
+{
+    // both advantages are equally out of date, they differ only if one peer is really ahead
+    const Sint32 frameAdvantage = static_cast<Sint32>(versusSession.GetFrame() - mRemoteFrame);
+    const Sint32 difference = frameAdvantage - mRemoteFrameAdvantage;
+    return difference >= 2 ? difference / 2 : 0;
+}
+
+
+void VersusLink::Exchange (VersusSession& versusSession)
+{
+    if (mSocket < 0) {
+        return;
+    }
+    VersusPacket packet;
+    while (true) {
+        const ssize_t size = recv (mSocket, &packet, sizeof (packet), 0);
+        if (size < 0) {
+            // ECONNREFUSED while the remote peer is not there yet, EAGAIN when nothing is left
+            if (errno == ECONNREFUSED) {
+                continue;
+            }
+            break;
+        }
+        const size_t headerSize = offsetof (VersusPacket, mInputs);
+        if (static_cast<size_t>(size) < headerSize || packet.mMagic != VersusPacket::MAGIC || packet.mInputCount > VersusPacket::MAX_INPUTS ||
+                static_cast<size_t>(size) != headerSize + packet.mInputCount * sizeof (VersusInput)) {
+            continue;
+        }
+        mReceivedCount++;
+        // packets may come out of date, only newer news counts
+        if (packet.mFrame >= mRemoteFrame) {
+            mRemoteFrame = packet.mFrame;
+            mRemoteFrameAdvantage = packet.mFrameAdvantage;
+        }
+        mAckedFrameCount = packet.mAckFrameCount > mAckedFrameCount ? packet.mAckFrameCount : mAckedFrameCount;
+        for (Uint32 index = 0; index < packet.mInputCount; index++) {
+            versusSession.AddRemoteInput (packet.mFirstFrame + index, packet.mInputs [index]);
+        }
+    }
+
+    packet.mMagic = VersusPacket::MAGIC;
+    packet.mFrame = versusSession.GetFrame();
+    packet.mFrameAdvantage = static_cast<Sint32>(versusSession.GetFrame() - mRemoteFrame);
+    packet.mAckFrameCount = versusSession.GetRemoteFrameCount();
+    packet.mFirstFrame = mAckedFrameCount;
+    packet.mInputCount = 0;
+    for (Uint32 frame = mAckedFrameCount; frame < versusSession.GetLocalFrameCount() && packet.mInputCount < VersusPacket::MAX_INPUTS; frame++) {
+        packet.mInputs [packet.mInputCount++] = versusSession.GetLocalInput (frame);
+    }
+    const size_t size = offsetof (VersusPacket, mInputs) + packet.mInputCount * sizeof (VersusInput);
+    if (mLatencyMilis == 0 && mJitterMilis == 0 && mLossThreshold == 0) {
+        Send (packet, size);
+        return;
+    }
+
+    if (mLossThreshold > 0 && mRandom.Next() < mLossThreshold) {
+        mDroppedCount++;
+    } else {
+        DelayedPacket delayedPacket;
+        delayedPacket.mSendTime = std::chrono::steady_clock::now() + std::chrono::milliseconds (mLatencyMilis +
+                (mJitterMilis > 0 ? mRandom.NextInt (static_cast<int>(mJitterMilis) + 1) : 0));
+        // a packet never overtakes the one before it
+        if (!mDelayedPackets.empty() && delayedPacket.mSendTime < mDelayedPackets.back().mSendTime) {
+            delayedPacket.mSendTime = mDelayedPackets.back().mSendTime;
+        }
+        delayedPacket.mPacket = packet;
+        delayedPacket.mSize = size;
+        mDelayedPackets.push_back (delayedPacket);
+    }
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    while (!mDelayedPackets.empty() && mDelayedPackets.front().mSendTime <= now) {
+        Send (mDelayedPackets.front().mPacket, mDelayedPackets.front().mSize);
+        mDelayedPackets.pop_front();
+    }
+}
+
+
+void VersusLink::Send (const VersusPacket& packet, size_t size)
+{
+    // a full socket buffer or a peer that is gone loses the packet, the next one repeats it
+    if (send (mSocket, &packet, size, MSG_DONTWAIT | MSG_NOSIGNAL) == static_cast<ssize_t>(size)) {
+        mSentCount++;
+    }
+}
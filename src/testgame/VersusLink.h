@@ -0,0 +1,136 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <GameRandom.h>
+#include <VersusSession.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * A datagram between two versus peers. Every packet repeats all local inputs the other peer has not acknowledged,
+ * so a lost packet costs nothing but the time until the next one arrives.
+ */
+struct VersusPacket {
+    static const Uint32 MAGIC = 0x54565331;     ///< 'TVS1'
+    static const int MAX_INPUTS = 64;
+
+    Uint32 mMagic;
+    Uint32 mFrame;                  ///< the frame the sender simulates next
+    Sint32 mFrameAdvantage;         ///< how many frames the sender is ahead of the receiver, as the sender sees it
+    Uint32 mAckFrameCount;          ///< how many inputs of the receiver the sender has
+    Uint32 mFirstFrame;             ///< of mInputs
+    Uint32 mInputCount;
+    VersusInput mInputs [MAX_INPUTS];
+};
+
+
+/*!
+ * Connects the VersusSession of two peers over UDP. Exchange sends the unacknowledged local inputs once per frame and
+ * hands the inputs that arrived to the session.
+ *
+ * For testing on one machine, latency, jitter and loss can be added to the packets this peer sends: a lost packet is
+ * dropped, the others wait in a queue until their time comes.
+ *
+ * Exchange also keeps the peers in step: a peer that runs ahead of the other one makes the remote inputs arrive
+ * later and later, so GetFramesToWait tells it to skip frames until both are equally far from each other's inputs.
+ *
+ * Linux only.
+ */
+class VersusLink
+{
+    public:
+        /* ====================  LIFECYCLE     ======================================= */
+
+        VersusLink ();
+        ~VersusLink ();
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Retrieves how many frames this peer should wait to let the remote peer catch up, 0 to go on.
+         */
+        int GetFramesToWait (const VersusSession& versusSession) const;
+
+        Uint64 GetSentCount () const
+        {
+            return mSentCount;
+        }
+
+        Uint64 GetDroppedCount () const
+        {
+            return mDroppedCount;
+        }
+
+        Uint64 GetReceivedCount () const
+        {
+            return mReceivedCount;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Opens a UDP socket on the loopback interface.
+         * @param localPort the port of this peer.
+         * @param remotePort the port of the other peer.
+         * @return false if the port cannot be bound.
+         */
+        bool Open (Uint16 localPort, Uint16 remotePort);
+
+
+        void Close ();
+
+
+        /*!
+         * Adds latency and loss to the packets sent from now on.
+         * @param latencyMilis how long every packet is held back.
+         * @param jitterMilis up to this much is added to the latency of a packet at random, packets stay in order.
+         * @param lossPercent the chance of a packet to be dropped.
+         */
+        void SetConditions (Uint32 latencyMilis, Uint32 jitterMilis, double lossPercent);
+
+
+        /*!
+         * Sends the local inputs the remote peer still misses, sends the held back packets that are due and hands the
+         * inputs that arrived to the session. Called once per frame, even while waiting.
+         */
+        void Exchange (VersusSession& versusSession);
+
+    private:
+        /// a packet held back by the added latency
+        struct DelayedPacket {
+            std::chrono::steady_clock::time_point mSendTime;
+            VersusPacket mPacket;
+            size_t mSize;
+        };
+
+        /* ====================  LIFECYCLE     ======================================= */
+        VersusLink (const VersusLink&);
+        VersusLink& operator= (const VersusLink&);
+
+        /* ====================  MUTATORS      ======================================= */
+        void Send (const VersusPacket& packet, size_t size);
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        int mSocket;
+        Uint32 mLatencyMilis;
+        Uint32 mJitterMilis;
+        Uint32 mLossThreshold;              ///< random values below it are dropped
+        GameRandom mRandom;
+        std::deque<DelayedPacket> mDelayedPackets;
+        Uint32 mAckedFrameCount;            ///< local inputs the remote peer confirmed
+        Uint32 mRemoteFrame;                ///< the frame the remote peer simulated next, as last heard
+        Sint32 mRemoteFrameAdvantage;       ///< as last heard
+        Uint64 mSentCount;
+        Uint64 mDroppedCount;
+        Uint64 mReceivedCount;
+
+}; /* -----  end of class VersusLink  ----- */
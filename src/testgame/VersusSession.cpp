@@ -0,0 +1,169 @@
+#include "VersusSession.h"
+#include <stdio.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+VersusSession::VersusSession (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds, Uint32 seed, int localPlayer, int inputDelayFrames) :
+    mLocalPlayer (localPlayer),
+    mInputDelayFrames (inputDelayFrames > 0 ? inputDelayFrames : 0),
+    mFrame (0),
+    mRollbackFrame (0),
+    mRemoteGameOverFrame (NOT_OVER),
+    mRollbackCount (0),
+    mResimulatedFrameCount (0),
+    mMaxRollbackFrames (0)
+{
+    if (localPlayer < 0 || localPlayer >= PLAYER_COUNT) {
+        printf ("ERROR: VersusSession::VersusSession called with player %d, player 0 is used.\n", localPlayer);
+        mLocalPlayer = 0;
+    }
+    // both players get the same board
+    for (int player = 0; player < PLAYER_COUNT; player++) {
+        mPlayers [player].mGameState.reset (new GameState (rows, columns, minMatchSize, maxGameplayTimeSeconds, seed));
+        mPlayers [player].mGameState->AttachGameStateGridChangeObserver (&mPlayers [player].mGameStateLogic);
+    }
+    for (int slot = 0; slot <= MAX_ROLLBACK_FRAMES; slot++) {
+        mSavedFrames [slot].mGameState.reset (new GameState (rows, columns, minMatchSize, maxGameplayTimeSeconds, seed));
+        mSavedFrames [slot].mFrame = 0;
+    }
+}
+
+
+Uint64 VersusSession::GetChecksum (const GameState& gameState)
+{
+    Uint64 checksum = 14695981039346656037ULL;
+    for (int index = 0; index < gameState.GetRows() * gameState.GetColumns(); index++) {
+        checksum = (checksum ^ gameState.GetColorAt (index)) * 1099511628211ULL;
+    }
+    const Uint32 values [5] = { static_cast<Uint32>(gameState.GetScore()), gameState.GetGameTime(), gameState.GetGameplayTime(),
+        static_cast<Uint32>(gameState.GetAnimationState()), gameState.GetTimeToRest() };
+    for (int index = 0; index < 5; index++) {
+        checksum = (checksum ^ values [index]) * 1099511628211ULL;
+    }
+    return checksum;
+}
+
+
+bool VersusSession::IsFinished () const
+{
+    return mPlayers [0].mGameState->GetAnimationState() == GameState::GameOver &&
+        mPlayers [1].mGameState->GetAnimationState() == GameState::GameOver && mRemoteGameOverFrame < GetRemoteFrameCount() && mRollbackFrame == mFrame;
+}
+
+
+void VersusSession::SetLocalInput (const VersusInput& input)
+{
+    std::vector<VersusInput>& inputs = mPlayers [mLocalPlayer].mInputs;
+    const Uint32 frame = mFrame + mInputDelayFrames;
+    while (inputs.size() < frame) {
+        inputs.push_back (VersusInput());
+    }
+    // the input of a frame is final once scheduled, it may have been sent already
+    if (inputs.size() == frame) {
+        inputs.push_back (input);
+    }
+}
+
+
+bool VersusSession::AddRemoteInput (Uint32 frame, const VersusInput& input)
+{
+    std::vector<VersusInput>& inputs = mPlayers [1 - mLocalPlayer].mInputs;
+    if (frame != inputs.size()) {
+        return false;
+    }
+    inputs.push_back (input);
+    // the frame was simulated predicting no input
+    if (frame < mFrame && input.IsSwap() && frame < mRollbackFrame) {
+        mRollbackFrame = frame;
+    }
+    return true;
+}
+
+
+bool VersusSession::AdvanceFrame ()
+{
+    if (!CanAdvance()) {
+        return false;
+    }
+    if (mRollbackFrame < mFrame) {
+        Rollback();
+    }
+    // frames SetLocalInput was not called for get no input, they are final from now on
+    std::vector<VersusInput>& localInputs = mPlayers [mLocalPlayer].mInputs;
+    while (localInputs.size() <= mFrame + mInputDelayFrames) {
+        localInputs.push_back (VersusInput());
+    }
+
+    Player& remote = mPlayers [1 - mLocalPlayer];
+    SavedFrame& savedFrame = mSavedFrames [mFrame % (MAX_ROLLBACK_FRAMES + 1)];
+    savedFrame.mGameState->CopyStateFrom (*remote.mGameState);
+    savedFrame.mGameStateLogic = remote.mGameStateLogic;
+    savedFrame.mFrame = mFrame;
+    Simulate (mPlayers [mLocalPlayer], mFrame, localInputs [mFrame]);
+    SimulateRemote (mFrame);
+    mFrame++;
+    mRollbackFrame = mFrame;
+    return true;
+}
+
+
+void VersusSession::Simulate (Player& player, Uint32 frame, const VersusInput& input)
+{
+    // a finished board stays as it ended, whatever the frame count
+    if (player.mGameState->GetAnimationState() == GameState::GameOver) {
+        return;
+    }
+    if (input.IsSwap()) {
+        // refused swaps are refused on both peers alike
+        player.mGameStateLogic.RequestSwap (input.mTileARow, input.mTileAColumn, input.mTileBRow, input.mTileBColumn, *player.mGameState);
+    }
+    player.mGameStateLogic.Update (GetFrameMilis (frame), *player.mGameState);
+}
+
+
+void VersusSession::SimulateRemote (Uint32 frame)
+{
+    Player& remote = mPlayers [1 - mLocalPlayer];
+    Simulate (remote, frame, frame < remote.mInputs.size() ? remote.mInputs [frame] : VersusInput());
+    // the result is final once the inputs up to this frame are known
+    if (mRemoteGameOverFrame == NOT_OVER && remote.mGameState->GetAnimationState() == GameState::GameOver) {
+        mRemoteGameOverFrame = frame;
+    }
+}
+
+
+void VersusSession::Rollback ()
+{
+    Player& remote = mPlayers [1 - mLocalPlayer];
+    const SavedFrame& rollbackFrame = mSavedFrames [mRollbackFrame % (MAX_ROLLBACK_FRAMES + 1)];
+    if (rollbackFrame.mFrame != mRollbackFrame) {
+        printf ("ERROR: VersusSession::Rollback frame %u is no longer saved, the remote board is off.\n", mRollbackFrame);
+        mRollbackFrame = mFrame;
+        return;
+    }
+    remote.mGameState->CopyStateFrom (*rollbackFrame.mGameState);
+    remote.mGameStateLogic = rollbackFrame.mGameStateLogic;
+    if (remote.mGameState->GetAnimationState() != GameState::GameOver) {
+        mRemoteGameOverFrame = NOT_OVER;
+    }
+    for (Uint32 frame = mRollbackFrame; frame < mFrame; frame++) {
+        // the saved states after the changed input change as well
+        if (frame > mRollbackFrame) {
+            SavedFrame& savedFrame = mSavedFrames [frame % (MAX_ROLLBACK_FRAMES + 1)];
+            savedFrame.mGameState->CopyStateFrom (*remote.mGameState);
+            savedFrame.mGameStateLogic = remote.mGameStateLogic;
+        }
+        SimulateRemote (frame);
+    }
+    const Uint32 frameCount = mFrame - mRollbackFrame;
+    mRollbackCount++;
+    mResimulatedFrameCount += frameCount;
+    mMaxRollbackFrames = frameCount > mMaxRollbackFrames ? frameCount : mMaxRollbackFrames;
+    mRollbackFrame = mFrame;
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <GameState.h>
+#include <GameStateLogic.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * The input of one player for one frame: a swap of two neighbouring tiles, or nothing.
+ */
+struct VersusInput {
+    Sint8 mTileARow, mTileAColumn;          ///< mTileARow is -1 if the player does nothing
+    Sint8 mTileBRow, mTileBColumn;
+
+    VersusInput () : mTileARow (-1), mTileAColumn (-1), mTileBRow (-1), mTileBColumn (-1)
+    {
+    }
+
+    bool IsSwap () const
+    {
+        return mTileARow >= 0;
+    }
+
+    bool operator== (const VersusInput& input) const
+    {
+        return mTileARow == input.mTileARow && mTileAColumn == input.mTileAColumn && mTileBRow == input.mTileBRow && mTileBColumn == input.mTileBColumn;
+    }
+};
+
+
+/*!
+ * Two-player versus game with rollback: both boards run on both peers from the same seed and only inputs are
+ * exchanged. Frames have fixed times (60 per second), so a board is a function of its inputs alone.
+ *
+ * A local input is scheduled inputDelayFrames ahead, which hides that much latency. When the remote input of a frame
+ * is still missing, the frame is simulated predicting that the remote player does nothing. If the input then turns
+ * out to be a swap, the remote board is restored to the state saved at the start of that frame and simulated again
+ * up to the present, all inside the next AdvanceFrame. The states of the last MAX_ROLLBACK_FRAMES frames are kept
+ * in a ring of GameStates copied with GameState::CopyStateFrom, so saving and restoring do not allocate; a peer
+ * that gets that far ahead of the remote inputs has to wait (CanAdvance).
+ *
+ * The boards do not affect each other, the player with the higher score when both games are over wins. Only the
+ * remote board is ever rolled back, the local one always has every input.
+ */
+class VersusSession
+{
+    public:
+        static const int PLAYER_COUNT = 2;
+        static const int MAX_ROLLBACK_FRAMES = 30;
+        static const int FRAMES_PER_SECOND = 60;
+
+
+        /* ====================  LIFECYCLE     ======================================= */
+
+        /*!
+         * Starts a versus game; both peers have to use the same rules and seed.
+         * @param localPlayer 0 or 1, the player of this peer; the other peer is the other player.
+         * @param inputDelayFrames how many frames after SetLocalInput the input is played.
+         */
+        VersusSession (int rows, int columns, int minMatchSize, int maxGameplayTimeSeconds, Uint32 seed, int localPlayer, int inputDelayFrames);
+
+
+        /* ====================  ACCESSORS     ======================================= */
+
+        /*!
+         * Retrieves the game time a frame advances, 16 or 17 miliseconds so that 60 frames are a second.
+         */
+        static Uint32 GetFrameMilis (Uint32 frame)
+        {
+            return (frame + 1) * 1000 / FRAMES_PER_SECOND - frame * 1000 / FRAMES_PER_SECOND;
+        }
+
+
+        /*!
+         * Hashes everything the rules look at, to compare boards between peers.
+         */
+        static Uint64 GetChecksum (const GameState& gameState);
+
+
+        int GetLocalPlayer () const
+        {
+            return mLocalPlayer;
+        }
+
+        /// the board of a player, the remote one may rest on predicted inputs
+        const GameState& GetGameState (int player) const
+        {
+            return *mPlayers [player].mGameState;
+        }
+
+        /// the frame AdvanceFrame simulates next
+        Uint32 GetFrame () const
+        {
+            return mFrame;
+        }
+
+        /// the number of frames the remote inputs are known for, counting from frame 0
+        Uint32 GetRemoteFrameCount () const
+        {
+            return static_cast<Uint32>(mPlayers [1 - mLocalPlayer].mInputs.size());
+        }
+
+        /// the number of frames the local inputs are scheduled for, counting from frame 0
+        Uint32 GetLocalFrameCount () const
+        {
+            return static_cast<Uint32>(mPlayers [mLocalPlayer].mInputs.size());
+        }
+
+        /*!
+         * Retrieves a scheduled local input, eg. to send it to the remote peer.
+         * @param frame less than GetLocalFrameCount.
+         */
+        const VersusInput& GetLocalInput (Uint32 frame) const
+        {
+            return mPlayers [mLocalPlayer].mInputs [frame];
+        }
+
+        /*!
+         * Answers whether the next frame can be simulated without predicting more than MAX_ROLLBACK_FRAMES frames.
+         */
+        bool CanAdvance () const
+        {
+            return mFrame < GetRemoteFrameCount() + MAX_ROLLBACK_FRAMES;
+        }
+
+        /*!
+         * Answers whether both games are over on inputs that are all known, so the result is final.
+         */
+        bool IsFinished () const;
+
+        /// the number of rollbacks so far
+        Uint64 GetRollbackCount () const
+        {
+            return mRollbackCount;
+        }
+
+        /// the number of frames simulated again by rollbacks so far
+        Uint64 GetResimulatedFrameCount () const
+        {
+            return mResimulatedFrameCount;
+        }
+
+        /// the most frames one rollback simulated again
+        Uint32 GetMaxRollbackFrames () const
+        {
+            return mMaxRollbackFrames;
+        }
+
+
+        /* ====================  MUTATORS      ======================================= */
+
+        /*!
+         * Schedules the local input for frame GetFrame() + inputDelayFrames. Called once per frame before AdvanceFrame;
+         * frames it is not called for get no input.
+         */
+        void SetLocalInput (const VersusInput& input);
+
+
+        /*!
+         * Hands over a remote input. Inputs have to come in frame order, an input for a frame that is already known is
+         * ignored and one after a missing frame is refused, so the sender can repeat unacknowledged inputs freely.
+         * @return true if the input was the next one missing.
+         */
+        bool AddRemoteInput (Uint32 frame, const VersusInput& input);
+
+
+        /*!
+         * Rolls the remote board back and forth if inputs arrived for frames already simulated, then simulates the
+         * next frame of both boards.
+         * @return false if the next frame cannot be simulated yet, see CanAdvance.
+         */
+        bool AdvanceFrame ();
+
+    private:
+        /// a board, its logic and the inputs of its player
+        struct Player {
+            std::unique_ptr<GameState> mGameState;
+            GameStateLogic mGameStateLogic;
+            std::vector<VersusInput> mInputs;   ///< by frame, known ones only
+        };
+
+        /// the remote board at the start of a frame
+        struct SavedFrame {
+            std::unique_ptr<GameState> mGameState;
+            GameStateLogic mGameStateLogic;
+            Uint32 mFrame;
+        };
+
+        /* ====================  LIFECYCLE     ======================================= */
+        VersusSession (const VersusSession&);
+        VersusSession& operator= (const VersusSession&);
+
+        static const Uint32 NOT_OVER = 0xFFFFFFFF;
+
+        /* ====================  MUTATORS      ======================================= */
+        void SimulateRemote (Uint32 frame);
+        void Simulate (Player& player, Uint32 frame, const VersusInput& input);
+        void Rollback ();
+
+        /* ====================  DATA MEMBERS  ======================================= */
+        Player mPlayers [PLAYER_COUNT];
+        SavedFrame mSavedFrames [MAX_ROLLBACK_FRAMES + 1];
+        int mLocalPlayer;
+        int mInputDelayFrames;
+        Uint32 mFrame;
+        Uint32 mRollbackFrame;              ///< the first frame a late remote input changed, mFrame if none
+        Uint32 mRemoteGameOverFrame;        ///< the frame the remote game ended in, NOT_OVER if it did not
+        Uint64 mRollbackCount;
+        Uint64 mResimulatedFrameCount;
+        Uint32 mMaxRollbackFrames;
+
+}; /* -----  end of class VersusSession  ----- */
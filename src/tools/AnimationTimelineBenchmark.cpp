@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <AnimationTimeline.h>
+#include <GameRandom.h>
+
+
+/*!
+ * Measures how fast AnimationTimeline evaluates many tweens running at the same time.
+ *
+ * It fills a timeline with tweens of random starts, durations, values and easings, like the falls, swaps and
+ * destructions of many boards at once, and evaluates them all once a frame over a second of frames. It does the same
+ * the way one animation was stepped before, an array of structures with a branch per easing and per clamp, and prints
+ * the time per pass and per tween of both and whether their values agree.
+ *
+ * usage: AnimationTimelineBenchmark [tweens] [passes]
+ */
+
+
+/// a tween the way the game kept an animation: all fields together, the easing as a kind to branch on
+struct Tween {
+    float mStart;
+    float mDuration;
+    float mFrom;
+    float mTo;
+    AnimationTimeline::Easing mEasing;
+};
+
+
+static void EvaluateTweens (const std::vector<Tween>& tweens, float time, float* values)
+{
+    for (size_t index = 0; index < tweens.size(); index++) {
+        const Tween& tween = tweens [index];
+        float t = 1.0f;
+        if (tween.mDuration > 0.0f) {
+            t = (time - tween.mStart) / tween.mDuration;
+            if (t < 0.0f) {
+                t = 0.0f;
+            } else if (t > 1.0f) {
+                t = 1.0f;
+            }
+        }
+        float eased = t;
+        switch (tween.mEasing) {
+            case AnimationTimeline::EaseIn:
+                eased = t * t;
+                break;
+            case AnimationTimeline::EaseOut:
+                eased = t * (2.0f - t);
+                break;
+            default:
+                break;
+        }
+        values [index] = tween.mFrom + (tween.mTo - tween.mFrom) * eased;
+    }
+}
+
+
+int main (int argc, char* argv[])
+{
+    const int tweenCount = argc > 1 ? atoi (argv [1]) : 65536;
+    const int passes = argc > 2 ? atoi (argv [2]) : 1000;
+    if (tweenCount < 1 || passes < 1) {
+        printf ("usage: AnimationTimelineBenchmark [tweens] [passes]\n");
+        return EXIT_FAILURE;
+    }
+
+    GameRandom random (3);
+    AnimationTimeline timeline;
+    std::vector<Tween> tweens;
+    for (int index = 0; index < tweenCount; index++) {
+        Tween tween;
+        tween.mStart = static_cast<float>(random.NextInt (1000));
+        tween.mDuration = static_cast<float>(random.NextInt (400));
+        tween.mFrom = static_cast<float>(random.NextInt (16)) - 8.0f;
+        tween.mTo = static_cast<float>(random.NextInt (16)) - 8.0f;
+        tween.mEasing = static_cast<AnimationTimeline::Easing>(random.NextInt (3));
+        tweens.push_back (tween);
+        timeline.Add (index, 0, tween.mStart, tween.mDuration, tween.mFrom, tween.mTo, tween.mEasing);
+    }
+    std::vector<float> values (tweenCount);
+    std::vector<float> timelineValues (tweenCount);
+    const float frameMilis = 1400.0f / passes;
+
+    // the sums keep the passes from being optimized away
+    double sum = 0.0;
+    const std::chrono::steady_clock::time_point structuresStart = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        EvaluateTweens (tweens, pass * frameMilis, values.data());
+        sum += values [pass % tweenCount];
+    }
+    const double structuresNanoseconds = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - structuresStart).count();
+
+    double timelineSum = 0.0;
+    const std::chrono::steady_clock::time_point timelineStart = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        timeline.Evaluate (pass * frameMilis, timelineValues.data());
+        timelineSum += timelineValues [pass % tweenCount];
+    }
+    const double timelineNanoseconds = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - timelineStart).count();
+
+    // both at the same time for the comparison: the multiplication by an inverse duration rounds a little differently
+    float maxDifference = 0.0f;
+    for (int pass = 0; pass < passes; pass += passes / 10 + 1) {
+        EvaluateTweens (tweens, pass * frameMilis, values.data());
+        timeline.Evaluate (pass * frameMilis, timelineValues.data());
+        for (int index = 0; index < tweenCount; index++) {
+            const float difference = values [index] > timelineValues [index] ? values [index] - timelineValues [index] : timelineValues [index] - values [index];
+            maxDifference = difference > maxDifference ? difference : maxDifference;
+        }
+    }
+
+    printf ("%d tweens, %d passes (checksums %.3f, %.3f):\n", tweenCount, passes, sum, timelineSum);
+    printf ("  array of structures, branching:  %9.1f us a pass, %6.3f ns a tween\n", structuresNanoseconds / passes / 1000.0,
+            structuresNanoseconds / passes / tweenCount);
+    printf ("  AnimationTimeline, one pass:     %9.1f us a pass, %6.3f ns a tween, %.1fx\n", timelineNanoseconds / passes / 1000.0,
+            timelineNanoseconds / passes / tweenCount, structuresNanoseconds / timelineNanoseconds);
+    printf ("  largest difference between the values: %g\n", maxDifference);
+    return maxDifference < 1e-3f ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <AudioMixer.h>
+#include <GameRandom.h>
+#include <Histogram.h>
+
+#ifdef TARGET_MSVC
+    #include <SDL.h>
+#endif
+#ifdef TARGET_UNIX
+    #include <SDL2/SDL.h>
+#endif
+
+
+/*!
+ * Measures the latency of the game's sounds from the event to the mixed sample, without sound hardware.
+ *
+ * It plays through AudioMixer on SDL's dummy audio driver, which calls the audio callback once a buffer's time like a
+ * device does and throws the samples away. A thread standing in for the simulation plays a random sound of the game
+ * every 2 to 20 ms, for a few seconds per buffer size. It prints the latency from Play to the callback that mixed the
+ * sound's first sample, the time a buffer adds before the sample is heard, and what Play costs the playing thread.
+ *
+ * usage: AudioLatencyBenchmark [seconds per buffer size]
+ */
+
+
+static void RunBufferFrames (int bufferFrames, int seconds)
+{
+    AudioMixer audioMixer;
+    if (!audioMixer.Open (bufferFrames)) {
+        return;
+    }
+    GameRandom random (5);
+    Histogram playTimes (10000, 0.01);
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds (seconds);
+    int plays = 0;
+    std::thread simulation ([&] () {
+        while (std::chrono::steady_clock::now() < end) {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            audioMixer.Play (static_cast<AudioMixer::Sound>(random.NextInt (AudioMixer::SOUND_COUNT)));
+            playTimes.Add (std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - start).count());
+            plays++;
+            std::this_thread::sleep_for (std::chrono::microseconds (2000 + random.NextInt (18000)));
+        }
+    });
+    simulation.join();
+    // a buffer more for the last sounds to be mixed
+    std::this_thread::sleep_for (std::chrono::milliseconds (1 + 2000 * bufferFrames / AudioMixer::SAMPLE_RATE));
+    audioMixer.Close();
+
+    const Histogram& latencies = audioMixer.GetEventLatencies();
+    printf ("  %5d frames (%5.2f ms a buffer): %d played, %llu mixed, %llu dropped, event to mixed sample p50 %6.3f ms, p99 %6.3f ms, max %6.3f ms; Play p99 %.2f us\n",
+            audioMixer.GetBufferFrames(), 1000.0 * audioMixer.GetBufferFrames() / AudioMixer::SAMPLE_RATE, plays,
+            static_cast<unsigned long long>(latencies.GetCount()), static_cast<unsigned long long>(audioMixer.GetDroppedCount()),
+            latencies.GetPercentile (50), latencies.GetPercentile (99), latencies.GetMaximum(), playTimes.GetPercentile (99));
+}
+
+
+int main (int argc, char* argv[])
+{
+    const int seconds = argc > 1 ? atoi (argv [1]) : 3;
+    if (seconds < 1) {
+        printf ("usage: AudioLatencyBenchmark [seconds per buffer size]\n");
+        return EXIT_FAILURE;
+    }
+    // no sound hardware needed, the dummy driver runs the callback on time all the same
+    SDL_setenv ("SDL_AUDIODRIVER", "dummy", 1);
+    if (SDL_Init (SDL_INIT_AUDIO) < 0) {
+        printf ("SDL_Init failed. SDL_ERROR: %s\n", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    // the figures are only comparable on the driver they claim
+    const char* driver = SDL_GetCurrentAudioDriver();
+    if (driver == NULL || SDL_strcmp (driver, "dummy") != 0) {
+        printf ("ERROR: AudioLatencyBenchmark: SDL runs the audio driver %s, not dummy.\n", driver != NULL ? driver : "(none)");
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+    SDL_version version;
+    SDL_GetVersion (&version);
+    printf ("sounds at random every 2 to 20 ms for %d s, SDL %d.%d.%d %s audio driver:\n", seconds,
+            version.major, version.minor, version.patch, driver);
+    const int bufferFrames[] = {256, 512, 1024, 2048};
+    for (size_t index = 0; index < sizeof (bufferFrames) / sizeof (bufferFrames [0]); index++) {
+        RunBufferFrames (bufferFrames [index], seconds);
+    }
+    SDL_Quit();
+    return EXIT_SUCCESS;
+}
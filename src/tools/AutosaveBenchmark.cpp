@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <AutosaveJournal.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <Histogram.h>
+
+
+/*!
+ * Measures what the autosave journal costs the game loop and whether a game survives the process being killed.
+ *
+ * First plays the same game of random swaps with and without a journal and prints the update times. Then forks
+ * children that play the game with a journal faster than real time and kills them with SIGKILL at a random moment;
+ * the parent resumes every journal and checks the game against the states the game really went through, printing
+ * the resume time and how much game time the crash lost.
+ *
+ * usage: AutosaveBenchmark [crash trials] [sync interval miliseconds] [journal file]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int GAMEPLAY_SECONDS = 3600;
+static const int SWAP_ONE_IN = 20;          ///< chance per resting update that the player swaps
+static const int DEFAULT_TRIALS = 20;
+static const int DEFAULT_SYNC_INTERVAL_MILIS = 100;
+static const int SPEEDUP = 8;               ///< how much faster than real time the crashing children play
+static const int MIN_KILL_MILIS = 50;
+static const int MAX_KILL_MILIS = 500;
+static const Uint32 SEED = 12345;
+
+
+/*!
+ * What the game looked like after an update or a swap.
+ */
+struct Checkpoint {
+    int mAnimationState;
+    int mScore;
+    Uint64 mGridHash;
+};
+
+
+static Checkpoint MakeCheckpoint (const GameState& gameState)
+{
+    Checkpoint checkpoint;
+    checkpoint.mAnimationState = gameState.GetAnimationState();
+    checkpoint.mScore = gameState.GetScore();
+    checkpoint.mGridHash = 14695981039346656037ULL;
+    for (int index = 0; index < gameState.GetRows() * gameState.GetColumns(); index++) {
+        checkpoint.mGridHash = (checkpoint.mGridHash ^ gameState.GetColorAt (index)) * 1099511628211ULL;
+    }
+    return checkpoint;
+}
+
+
+/*!
+ * Plays the benchmark game, the same every time.
+ * @param updateCount how many updates to play, the game stops earlier when it is over.
+ * @param autosaveJournal journals the game if not NULL.
+ * @param updateMicroseconds receives the time of every update if not NULL.
+ * @param checkpoints receives every state the game went through by game time if not NULL.
+ * @param progress receives the game time after every update if not NULL.
+ * @param frameMicroseconds how long to sleep between updates, 0 not to sleep.
+ */
+static void PlayGame (Uint32 updateCount, AutosaveJournal* autosaveJournal, Histogram* updateMicroseconds,
+        std::unordered_multimap<Uint32, Checkpoint>* checkpoints, std::atomic<Uint32>* progress, int frameMicroseconds)
+{
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, SEED);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    if (autosaveJournal != NULL) {
+        gameStateLogic.SetAutosaveJournal (autosaveJournal);
+    }
+    if (checkpoints != NULL) {
+        checkpoints->insert (std::make_pair (gameState.GetGameTime(), MakeCheckpoint (gameState)));
+    }
+    GameRandom random (1);
+    for (Uint32 update = 0; update < updateCount && gameState.GetAnimationState() != GameState::GameOver; update++) {
+        if (gameState.GetAnimationState() == GameState::Idle && !gameStateLogic.IsGridCheckPending() && random.NextInt (SWAP_ONE_IN) == 0) {
+            const bool isVertical = random.NextInt (2) == 1;
+            const int row = random.NextInt (isVertical ? ROWS - 1 : ROWS);
+            const int column = random.NextInt (isVertical ? COLUMNS : COLUMNS - 1);
+            if (gameStateLogic.RequestSwap (row, column, isVertical ? row + 1 : row, isVertical ? column : column + 1, gameState) && checkpoints != NULL) {
+                checkpoints->insert (std::make_pair (gameState.GetGameTime(), MakeCheckpoint (gameState)));
+            }
+        }
+        // frame times of a 60 Hz display measured in whole miliseconds
+        const Uint32 deltaTime = 16 + random.NextInt (2);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        gameStateLogic.Update (deltaTime, gameState);
+        if (updateMicroseconds != NULL) {
+            updateMicroseconds->Add (std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - start).count());
+        }
+        if (checkpoints != NULL) {
+            checkpoints->insert (std::make_pair (gameState.GetGameTime(), MakeCheckpoint (gameState)));
+        }
+        if (progress != NULL) {
+            progress->store (gameState.GetGameTime());
+        }
+        if (frameMicroseconds > 0) {
+            std::this_thread::sleep_for (std::chrono::microseconds (frameMicroseconds));
+        }
+    }
+}
+
+
+/*!
+ * Answers whether a resumed game is one of the states the benchmark game went through.
+ */
+static bool IsKnownState (const std::unordered_multimap<Uint32, Checkpoint>& checkpoints, const GameState& gameState)
+{
+    const Checkpoint checkpoint = MakeCheckpoint (gameState);
+    std::pair<std::unordered_multimap<Uint32, Checkpoint>::const_iterator, std::unordered_multimap<Uint32, Checkpoint>::const_iterator> range =
+        checkpoints.equal_range (gameState.GetGameTime());
+    for (std::unordered_multimap<Uint32, Checkpoint>::const_iterator iterator = range.first; iterator != range.second; ++iterator) {
+        if (iterator->second.mAnimationState == checkpoint.mAnimationState && iterator->second.mScore == checkpoint.mScore &&
+                iterator->second.mGridHash == checkpoint.mGridHash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*!
+ * Main function of the autosave benchmark.
+ * @param argc up to 3 arguments: the number of crash trials (default DEFAULT_TRIALS), the sync interval
+ *  (default DEFAULT_SYNC_INTERVAL_MILIS) and the journal file (default 'autosave_benchmark.tmj', removed at the end).
+ * @return returns 0 if every killed game was resumed to a state it went through.
+ */
+int main (int argc, char* argv[])
+{
+    const int trialCount = argc > 1 ? atoi (argv [1]) : DEFAULT_TRIALS;
+    const int syncIntervalMilis = argc > 2 ? atoi (argv [2]) : DEFAULT_SYNC_INTERVAL_MILIS;
+    const char* filePath = argc > 3 ? argv [3] : "autosave_benchmark.tmj";
+    if (trialCount < 0 || syncIntervalMilis < 1) {
+        printf ("usage: AutosaveBenchmark [crash trials] [sync interval miliseconds] [journal file]\n");
+        return EXIT_FAILURE;
+    }
+    GameState::SetIsLoggingEnabled (false);
+
+    // the whole game with and without a journal
+    const Uint32 updateCount = GAMEPLAY_SECONDS * 60;
+    Histogram plainMicroseconds (10000, 0.01);
+    PlayGame (updateCount, NULL, &plainMicroseconds, NULL, NULL, 0);
+    Histogram journaledMicroseconds (10000, 0.01);
+    AutosaveJournal autosaveJournal;
+    {
+        GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, SEED);
+        if (!autosaveJournal.Start (filePath, gameState, SEED, static_cast<Uint32>(syncIntervalMilis))) {
+            return EXIT_FAILURE;
+        }
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    PlayGame (updateCount, &autosaveJournal, &journaledMicroseconds, NULL, NULL, 0);
+    autosaveJournal.Sync();
+    const double journaledSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    const Uint64 syncCount = autosaveJournal.GetSyncCount();
+    autosaveJournal.Close();
+    printf ("%u updates without journal: mean %.2f us, p50 %.2f us, p99 %.2f us, max %.1f us\n", updateCount, plainMicroseconds.GetMean(),
+            plainMicroseconds.GetPercentile (50.0), plainMicroseconds.GetPercentile (99.0), plainMicroseconds.GetMaximum());
+    printf ("%u updates with journal:    mean %.2f us, p50 %.2f us, p99 %.2f us, max %.1f us, %llu syncs in %.2f s\n", updateCount,
+            journaledMicroseconds.GetMean(), journaledMicroseconds.GetPercentile (50.0), journaledMicroseconds.GetPercentile (99.0),
+            journaledMicroseconds.GetMaximum(), static_cast<unsigned long long>(syncCount), journaledSeconds);
+
+    // the states a crashing game can be resumed to
+    std::unordered_multimap<Uint32, Checkpoint> checkpoints;
+    const Uint32 trialUpdateCount = (MAX_KILL_MILIS * 2 * SPEEDUP) / 16;
+    PlayGame (trialUpdateCount, NULL, NULL, &checkpoints, NULL, 0);
+
+    std::atomic<Uint32>* progress = static_cast<std::atomic<Uint32>*>(mmap (NULL, sizeof (std::atomic<Uint32>), PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (progress == MAP_FAILED) {
+        printf ("ERROR: AutosaveBenchmark cannot map the progress of the children.\n");
+        return EXIT_FAILURE;
+    }
+    GameRandom random (static_cast<Uint32>(time (NULL)));
+    Histogram resumeMicroseconds (10000, 1.0);
+    Histogram lostMilis (10000, 1.0);
+    int resumedCount = 0;
+    int knownCount = 0;
+    for (int trial = 0; trial < trialCount; trial++) {
+        unlink (filePath);
+        progress->store (0);
+        const pid_t child = fork();
+        if (child < 0) {
+            printf ("ERROR: AutosaveBenchmark cannot fork.\n");
+            return EXIT_FAILURE;
+        }
+        if (child == 0) {
+            AutosaveJournal childJournal;
+            GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, SEED);
+            if (childJournal.Start (filePath, gameState, SEED, static_cast<Uint32>(syncIntervalMilis))) {
+                PlayGame (trialUpdateCount, &childJournal, NULL, NULL, progress, 16000 / SPEEDUP);
+            }
+            // not reached unless the game is too short for the kill
+            _exit (EXIT_FAILURE);
+        }
+        std::this_thread::sleep_for (std::chrono::milliseconds (MIN_KILL_MILIS + random.NextInt (MAX_KILL_MILIS - MIN_KILL_MILIS + 1)));
+        kill (child, SIGKILL);
+        waitpid (child, NULL, 0);
+        const Uint32 reachedGameTime = progress->load();
+
+        GameStateLogic gameStateLogic;
+        std::unique_ptr<GameState> gameState;
+        Uint32 seed;
+        start = std::chrono::steady_clock::now();
+        const bool isResumed = autosaveJournal.Resume (filePath, gameStateLogic, gameState, seed, static_cast<Uint32>(syncIntervalMilis));
+        resumeMicroseconds.Add (std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - start).count());
+        if (isResumed) {
+            resumedCount++;
+            knownCount += IsKnownState (checkpoints, *gameState) ? 1 : 0;
+            lostMilis.Add (reachedGameTime > gameState->GetGameTime() ? reachedGameTime - gameState->GetGameTime() : 0);
+            autosaveJournal.Close();
+        }
+    }
+    munmap (progress, sizeof (std::atomic<Uint32>));
+    if (trialCount > 0) {
+        printf ("%d kills: %d resumed, %d to a state the game went through; resume mean %.0f us, max %.0f us; game time lost at %dx speed: "
+                "mean %.0f ms, max %.0f ms\n", trialCount, resumedCount, knownCount, resumeMicroseconds.GetMean(), resumeMicroseconds.GetMaximum(),
+                SPEEDUP, lostMilis.GetMean(), lostMilis.GetMaximum());
+    }
+    if (argc <= 3) {
+        unlink (filePath);
+        unlink ((std::string (filePath) + ".tmp").c_str());
+    }
+    return resumedCount == trialCount && knownCount == trialCount ? EXIT_SUCCESS : EXIT_FAILURE;
+}				/* ----------  end of function main  ---------- */
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <GameStateBatch.h>
+#include <GameRandom.h>
+
+
+/*!
+ * Headless benchmark comparing GameStateBatch against stepping one GameState (driven by its GameStateLogic) at a time.
+ * Both sides apply the same number of random adjacent swaps to 8x8 boards with 5 colors and a minimum match of 3.
+ * Build with optimizations (CMAKE_BUILD_TYPE=Release) for meaningful numbers.
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int MOVES_PER_MEASUREMENT = 1 << 18;
+static const int GAME_SECONDS = 24 * 3600;          ///< gameplay time runs through animations, so no board ends early
+
+
+/*!
+ * Draws a random in-bounds swap of a tile with its right or lower neighbour.
+ */
+static void DrawRandomSwap (GameRandom& random, int& row, int& column, bool& isVertical)
+{
+    isVertical = random.NextInt (2) == 1;
+    row = random.NextInt (isVertical ? ROWS - 1 : ROWS);
+    column = random.NextInt (isVertical ? COLUMNS : COLUMNS - 1);
+}
+
+
+/*!
+ * Steps boards GameState objects one after another.
+ * @return the elapsed seconds.
+ */
+static double RunGameStates (int boards, int steps, int& totalScore)
+{
+    std::vector<std::unique_ptr<GameState>> gameStates (boards);
+    std::vector<std::unique_ptr<GameStateLogic>> gameStateLogics (boards);
+    for (int board = 0; board < boards; board++) {
+        gameStates [board].reset (new GameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAME_SECONDS, board));
+        gameStateLogics [board].reset (new GameStateLogic());
+        gameStates [board]->AttachGameStateGridChangeObserver (gameStateLogics [board].get());
+    }
+
+    GameRandom random (1);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        for (int board = 0; board < boards; board++) {
+            GameState& gameState = *gameStates [board];
+            GameStateLogic& gameStateLogic = *gameStateLogics [board];
+            int row, column;
+            bool isVertical;
+            DrawRandomSwap (random, row, column, isVertical);
+            const Uint32 animationDuration = gameStateLogic.GetAnimationDuration();
+            gameState.SwapTiles (row, column, isVertical ? row + 1 : row, isVertical ? column : column + 1, animationDuration, true);
+            // feed the time until the board rests per update, so every animation completes
+            while (gameState.GetAnimationState() != GameState::GameOver &&
+                    (gameState.GetAnimationState() != GameState::Idle || gameStateLogic.IsGridCheckPending())) {
+                gameStateLogic.Update (gameState.GetTimeToRest(), gameState);
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    totalScore = 0;
+    for (int board = 0; board < boards; board++) {
+        totalScore += gameStates [board]->GetScore();
+    }
+    return elapsed.count();
+}
+
+
+/*!
+ * Steps all boards of a GameStateBatch together.
+ * @return the elapsed seconds.
+ */
+static double RunBatch (int boards, int steps, int& totalScore)
+{
+    GameStateBatch gameStateBatch (boards, ROWS, COLUMNS, MIN_MATCH_SIZE, GameState::sNUMBER_OF_TILE_COLORS, steps);
+    gameStateBatch.Reset (1);
+    std::vector<int> moves (boards);
+
+    GameRandom random (1);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        for (int board = 0; board < boards; board++) {
+            int row, column;
+            bool isVertical;
+            DrawRandomSwap (random, row, column, isVertical);
+            moves [board] = GameStateBatch::EncodeMove (row, column, isVertical);
+        }
+        gameStateBatch.Step (moves.data());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    totalScore = 0;
+    for (int board = 0; board < boards; board++) {
+        totalScore += gameStateBatch.GetScore (board);
+    }
+    return elapsed.count();
+}
+
+
+int main (int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    GameState::SetIsLoggingEnabled (false);
+
+    const int batchSizes[] = { 64, 1024, 16384 };
+    printf ("%8s %8s %16s %16s %9s %12s %12s\n", "boards", "steps", "GameState mv/s", "batch mv/s", "speedup", "score/mv GS", "score/mv B");
+    for (int sizeIndex = 0; sizeIndex < 3; sizeIndex++) {
+        const int boards = batchSizes [sizeIndex];
+        const int steps = MOVES_PER_MEASUREMENT / boards;
+        const double moves = static_cast<double>(boards) * steps;
+
+        int gameStateScore = 0;
+        int batchScore = 0;
+        double gameStateSeconds = RunGameStates (boards, steps, gameStateScore);
+        double batchSeconds = RunBatch (boards, steps, batchScore);
+
+        printf ("%8d %8d %16.0f %16.0f %8.1fx %12.3f %12.3f\n", boards, steps,
+                moves / gameStateSeconds, moves / batchSeconds, gameStateSeconds / batchSeconds,
+                gameStateScore / moves, batchScore / moves);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <GameBoard.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <JobSystem.h>
+#include <PositionDataset.h>
+
+
+/*!
+ * Plays games on 8x8 boards on all cores and records every position with its legal moves, the immediate score
+ * of each move and the move played into one PositionDataset shard per worker. Moves are chosen greedily,
+ * with a random legal move one time in EXPLORATION_ONE_IN so the data covers more than the greedy line.
+ * Afterwards every shard is mapped with PositionDatasetReader and checked.
+ *
+ * usage: DatasetGenerator [output prefix] [games] [moves per game]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int DEFAULT_GAMES = 10000;
+static const int DEFAULT_MOVES_PER_GAME = 50;
+static const int EXPLORATION_ONE_IN = 10;
+static const Uint32 SEED = 1;
+
+
+/*!
+ * Converts a dense dataset action to a GameBoard move.
+ */
+static int ActionToMove (int action)
+{
+    return GameBoard::EncodeMove ((action / 2) / COLUMNS, (action / 2) % COLUMNS, (action & 1) != 0);
+}
+
+
+/*!
+ * Plays games [firstGame, endGame) and writes their positions.
+ * @return false if the shard could not be written.
+ */
+static bool PlayGames (PositionDatasetWriter& writer, int firstGame, int endGame, int movesPerGame)
+{
+    const int actionCount = ROWS * COLUMNS * 2;
+    std::vector<Sint16> moveScores (actionCount);
+    GameBoard board (ROWS, COLUMNS, MIN_MATCH_SIZE, GameState::sNUMBER_OF_TILE_COLORS);
+    GameBoard child (ROWS, COLUMNS, MIN_MATCH_SIZE, GameState::sNUMBER_OF_TILE_COLORS);
+    GameRandom random (SEED + static_cast<Uint32>(firstGame) * 7919);
+    for (int game = firstGame; game < endGame; game++) {
+        board.Reset (SEED + static_cast<Uint32>(game));
+        for (int ply = 0; ply < movesPerGame; ply++) {
+            int legalMoves = 0;
+            int bestAction = -1;
+            for (int action = 0; action < actionCount; action++) {
+                moveScores [action] = 0;
+                const int move = ActionToMove (action);
+                if (board.IsMatchingMove (move)) {
+                    child = board;
+                    moveScores [action] = static_cast<Sint16>(child.ApplyMove (move));
+                    legalMoves++;
+                    if (bestAction < 0 || moveScores [action] > moveScores [bestAction]) {
+                        bestAction = action;
+                    }
+                }
+            }
+            int chosenAction = bestAction;
+            if (legalMoves > 1 && random.NextInt (EXPLORATION_ONE_IN) == 0) {
+                int legalMove = random.NextInt (legalMoves);
+                for (chosenAction = 0; moveScores [chosenAction] == 0 || legalMove-- > 0; chosenAction++) {
+                }
+            }
+            if (!writer.AddPosition (board, moveScores.data(), chosenAction, static_cast<Uint32>(game), ply)) {
+                return false;
+            }
+            if (chosenAction < 0) {
+                break;  // deadlocked board
+            }
+            board.ApplyMove (ActionToMove (chosenAction));
+        }
+    }
+    return true;
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const char* outputPrefix = argc > 1 ? argv [1] : "positions";
+    const int games = argc > 2 ? atoi (argv [2]) : DEFAULT_GAMES;
+    const int movesPerGame = argc > 3 ? atoi (argv [3]) : DEFAULT_MOVES_PER_GAME;
+    if (games < 1 || movesPerGame < 1 || movesPerGame > 65535) {
+        printf ("usage: DatasetGenerator [output prefix] [games] [moves per game]\n");
+        return EXIT_FAILURE;
+    }
+
+    JobSystem jobSystem;
+    const int shards = jobSystem.GetWorkerCount();
+    std::vector<std::vector<char> > shardPaths (shards, std::vector<char> (1024));
+    std::vector<Uint8> isShardWritten (shards, 0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // one job per shard, so every writer is used by one thread only
+    jobSystem.ParallelFor (shards, 1, [&] (int firstShard, int endShard) {
+        for (int shard = firstShard; shard < endShard; shard++) {
+            snprintf (shardPaths [shard].data(), shardPaths [shard].size(), "%s_%03d.tmd", outputPrefix, shard);
+            PositionDatasetWriter writer (ROWS, COLUMNS, GameState::sNUMBER_OF_TILE_COLORS, MIN_MATCH_SIZE);
+            if (writer.Open (shardPaths [shard].data())) {
+                const bool isPlayed = PlayGames (writer, games * shard / shards, games * (shard + 1) / shards, movesPerGame);
+                isShardWritten [shard] = writer.Close() && isPlayed;
+            }
+        }
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // read every shard back in place and check that the recorded moves agree with their scores
+    Uint64 positions = 0;
+    Uint64 badPositions = 0;
+    Uint64 chosenPoints = 0;
+    bool isComplete = true;
+    start = std::chrono::steady_clock::now();
+    for (int shard = 0; shard < shards; shard++) {
+        PositionDatasetReader reader;
+        if (!isShardWritten [shard] || !reader.Open (shardPaths [shard].data())) {
+            isComplete = false;
+            continue;
+        }
+        const int actionCount = static_cast<int>(reader.GetHeader().mActionCount);
+        for (Uint64 position = 0; position < reader.GetPositionCount(); position++) {
+            const Sint16* moveScores = reader.GetMoveScores (position);
+            const int chosenMove = reader.GetChosenMove (position);
+            if (chosenMove >= 0) {
+                badPositions += !reader.IsLegalMove (position, chosenMove) || moveScores [chosenMove] <= 0;
+                chosenPoints += moveScores [chosenMove];
+            }
+            for (int action = 0; action < actionCount; action++) {
+                badPositions += reader.IsLegalMove (position, action) != (moveScores [action] > 0) ? 1 : 0;
+            }
+        }
+        positions += reader.GetPositionCount();
+    }
+    std::chrono::duration<double> readElapsed = std::chrono::steady_clock::now() - start;
+
+    printf ("%d games in %d shards: %llu positions, %.0f positions/s written, %.0f positions/s read, %.2f points per move, %llu bad values\n",
+            games, shards, static_cast<unsigned long long>(positions), positions / elapsed.count(), positions / readElapsed.count(),
+            positions > 0 ? static_cast<double>(chosenPoints) / positions : 0.0, static_cast<unsigned long long>(badPositions));
+    return isComplete && badPositions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
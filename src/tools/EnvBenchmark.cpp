@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <GameRandom.h>
+#include <TileMatchEnv.h>
+
+
+/*!
+ * Drives the TileMatchEnv C interface the way a training loop does, with random actions,
+ * and prints board steps per second, mean reward and finished episodes.
+ */
+
+
+static const int BOARDS = 4096;
+static const int STEPS = 256;
+
+
+int main (int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    TileMatchEnv* env = env_create (BOARDS, 1);
+    if (env == NULL) {
+        return EXIT_FAILURE;
+    }
+    const int actionCount = env_get_action_count (env);
+    const size_t boardObservationSize = static_cast<size_t>(env_get_colors (env)) * env_get_rows (env) * env_get_columns (env);
+    std::vector<unsigned char> observations (boardObservationSize * BOARDS);
+    std::vector<float> rewards (BOARDS);
+    std::vector<unsigned char> dones (BOARDS);
+    std::vector<int> actions (BOARDS);
+
+    env_reset (env, observations.data());
+    GameRandom random (1);
+    double totalReward = 0.0;
+    int episodes = 0;
+    double seconds = 0.0;
+    for (int step = 0; step < STEPS; step++) {
+        for (int board = 0; board < BOARDS; board++) {
+            actions [board] = random.NextInt (actionCount);
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        env_step (env, actions.data(), observations.data(), rewards.data(), dones.data());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        seconds += elapsed.count();
+        for (int board = 0; board < BOARDS; board++) {
+            totalReward += rewards [board];
+            episodes += dones [board];
+        }
+    }
+
+    // every tile has to be set in exactly one color plane
+    int badTiles = 0;
+    const int cells = env_get_rows (env) * env_get_columns (env);
+    for (int board = 0; board < BOARDS; board++) {
+        for (int cell = 0; cell < cells; cell++) {
+            int planes = 0;
+            for (int color = 0; color < env_get_colors (env); color++) {
+                planes += observations [board * boardObservationSize + color * cells + cell];
+            }
+            badTiles += planes != 1;
+        }
+    }
+    printf ("%d boards x %d steps: %.0f board steps/s, mean reward %.3f, %d episodes finished, %d bad observation tiles\n",
+            BOARDS, STEPS, static_cast<double>(BOARDS) * STEPS / seconds, totalReward / (static_cast<double>(BOARDS) * STEPS), episodes, badTiles);
+    env_destroy (env);
+    return badTiles == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <FixedTimestep.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+
+
+/*!
+ * Plays the same seeded game through the game loop's fixed timestep under made up frame times (a steady 60 Hz and
+ * 144 Hz display, jittery frames and frames with long hitches) and checks that every one ends with the same board and
+ * score. The bot decides once per simulation step, so what it does depends on the steps only. For comparison it plays
+ * the game again feeding the frame times straight into the game, as the game loop did before, which gives a
+ * different game for every display. Finally it runs the fixed step simulation as fast as it can and prints how much
+ * faster than real time that is.
+ *
+ * usage: FixedTimestepBenchmark [gameplay seconds]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const Uint32 SEED = 4242;
+static const Uint32 STEP_MILIS = 8;             ///< TestGame::SIMULATION_STEP_MILIS
+static const int MAX_CATCH_UP_STEPS = 25;       ///< TestGame::MAX_CATCH_UP_STEPS
+static const Uint64 COUNTER_FREQUENCY = 10000000;   ///< a 100 ns counter, like the performance counter on Windows
+static const int SWAP_ONE_IN = 20;              ///< chance per resting step that the bot swaps
+
+
+enum FramePattern {
+    Steady60Hz,
+    Steady144Hz,
+    Jittery,
+    Hitches,
+    FRAME_PATTERN_COUNT
+};
+
+
+static const char* FRAME_PATTERN_NAMES [FRAME_PATTERN_COUNT] = {"60 Hz", "144 Hz", "jittery", "hitches"};
+
+
+/*!
+ * Makes up the counter ticks of the next frame.
+ */
+static Uint64 NextFrameTicks (FramePattern pattern, Uint64 frameIndex, GameRandom& random)
+{
+    switch (pattern) {
+        case Steady60Hz:
+            return COUNTER_FREQUENCY / 60;
+        case Steady144Hz:
+            return COUNTER_FREQUENCY / 144;
+        case Jittery:
+            // 4 to 40 ms
+            return COUNTER_FREQUENCY / 250 + random.Next() % (COUNTER_FREQUENCY * 36 / 1000);
+        case Hitches:
+            // a half-second stall every few seconds, longer than the catch-up cap
+            return frameIndex % 300 == 299 ? COUNTER_FREQUENCY / 2 : COUNTER_FREQUENCY / 60;
+        default:
+            return COUNTER_FREQUENCY / 60;
+    }
+}
+
+
+/*!
+ * Lets the bot swap a random pair if the game takes a swap now.
+ */
+static void PlayBotStep (GameRandom& botRandom, GameStateLogic& gameStateLogic, GameState& gameState)
+{
+    if (gameState.GetAnimationState() != GameState::Idle || gameStateLogic.IsGridCheckPending() || botRandom.NextInt (SWAP_ONE_IN) != 0) {
+        return;
+    }
+    const bool isVertical = botRandom.NextInt (2) == 1;
+    const int row = botRandom.NextInt (isVertical ? ROWS - 1 : ROWS);
+    const int column = botRandom.NextInt (isVertical ? COLUMNS : COLUMNS - 1);
+    gameStateLogic.RequestSwap (row, column, isVertical ? row + 1 : row, isVertical ? column : column + 1, gameState);
+}
+
+
+static Uint64 HashGame (const GameState& gameState)
+{
+    Uint64 hash = 14695981039346656037ULL;
+    for (int index = 0; index < gameState.GetRows() * gameState.GetColumns(); index++) {
+        hash = (hash ^ gameState.GetColorAt (index)) * 1099511628211ULL;
+    }
+    return (hash ^ static_cast<Uint64>(gameState.GetScore())) * 1099511628211ULL;
+}
+
+
+struct GameResult {
+    Uint64 mHash;
+    int mScore;
+    Uint64 mFrames;
+    Uint64 mSteps;
+    Uint64 mDroppedSteps;
+    double mRealSeconds;        ///< of made up frame time
+    bool mIsInterpolationValid;
+};
+
+
+/*!
+ * Plays a game to its end with the fixed timestep, the way TestGame's loop does.
+ */
+static GameResult PlayFixedStep (FramePattern pattern, int gameplaySeconds)
+{
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, gameplaySeconds, SEED);
+    GameState previousGameState (ROWS, COLUMNS, MIN_MATCH_SIZE, gameplaySeconds, SEED);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    GameRandom botRandom (1);
+    GameRandom frameRandom (static_cast<Uint32>(pattern) + 1);
+    FixedTimestep fixedTimestep (STEP_MILIS, MAX_CATCH_UP_STEPS);
+    Uint64 counter = 1000;
+    fixedTimestep.Start (counter, COUNTER_FREQUENCY);
+    GameResult result = GameResult();
+    result.mIsInterpolationValid = true;
+    while (gameState.GetAnimationState() != GameState::GameOver) {
+        counter += NextFrameTicks (pattern, result.mFrames, frameRandom);
+        result.mFrames++;
+        const int stepCount = fixedTimestep.Advance (counter);
+        // the steps left in the frame the game ended in are not simulated
+        for (int step = 0; step < stepCount && gameState.GetAnimationState() != GameState::GameOver; step++) {
+            PlayBotStep (botRandom, gameStateLogic, gameState);
+            previousGameState.CopyStateFrom (gameState);
+            gameStateLogic.Update (fixedTimestep.GetStepMilis(), gameState);
+            result.mSteps++;
+        }
+        const float interpolation = fixedTimestep.GetInterpolation();
+        result.mIsInterpolationValid &= interpolation >= 0.0f && interpolation < 1.0f;
+    }
+    result.mHash = HashGame (gameState);
+    result.mScore = gameState.GetScore();
+    result.mDroppedSteps = fixedTimestep.GetDroppedStepCount();
+    result.mRealSeconds = static_cast<double>(counter - 1000) / COUNTER_FREQUENCY;
+    return result;
+}
+
+
+/*!
+ * Plays a game to its end feeding the frame times in whole miliseconds (SDL_GetTicks) straight into the game.
+ */
+static GameResult PlayVariableStep (FramePattern pattern, int gameplaySeconds)
+{
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, gameplaySeconds, SEED);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    GameRandom botRandom (1);
+    GameRandom frameRandom (static_cast<Uint32>(pattern) + 1);
+    Uint64 counter = 1000;
+    Uint32 ticksAtLastFrame = 0;
+    GameResult result = GameResult();
+    result.mIsInterpolationValid = true;
+    while (gameState.GetAnimationState() != GameState::GameOver) {
+        counter += NextFrameTicks (pattern, result.mFrames, frameRandom);
+        result.mFrames++;
+        const Uint32 ticks = static_cast<Uint32>((counter - 1000) * 1000 / COUNTER_FREQUENCY);
+        PlayBotStep (botRandom, gameStateLogic, gameState);
+        gameStateLogic.Update (ticks - ticksAtLastFrame, gameState);
+        ticksAtLastFrame = ticks;
+        result.mSteps++;
+    }
+    result.mHash = HashGame (gameState);
+    result.mScore = gameState.GetScore();
+    result.mRealSeconds = static_cast<double>(counter - 1000) / COUNTER_FREQUENCY;
+    return result;
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const int gameplaySeconds = argc > 1 ? atoi (argv [1]) : 60;
+    if (gameplaySeconds < 1) {
+        printf ("usage: FixedTimestepBenchmark [gameplay seconds]\n");
+        return EXIT_FAILURE;
+    }
+    printf ("%d s games of %dx%d, fixed steps of %u ms, at most %d steps per frame\n", gameplaySeconds, ROWS, COLUMNS, STEP_MILIS, MAX_CATCH_UP_STEPS);
+
+    int failures = 0;
+    GameResult fixedResults [FRAME_PATTERN_COUNT];
+    for (int pattern = 0; pattern < FRAME_PATTERN_COUNT; pattern++) {
+        const GameResult& result = fixedResults [pattern] = PlayFixedStep (static_cast<FramePattern>(pattern), gameplaySeconds);
+        printf ("fixed step,    %-8s: hash %016llx, score %6d, %7llu frames, %7llu steps, %5llu dropped, %.1f s real time\n", FRAME_PATTERN_NAMES [pattern],
+                static_cast<unsigned long long>(result.mHash), result.mScore, static_cast<unsigned long long>(result.mFrames),
+                static_cast<unsigned long long>(result.mSteps), static_cast<unsigned long long>(result.mDroppedSteps), result.mRealSeconds);
+        if (result.mHash != fixedResults [0].mHash || result.mSteps != fixedResults [0].mSteps) {
+            printf ("ERROR: the game under %s frames differs from the game under %s frames.\n", FRAME_PATTERN_NAMES [pattern], FRAME_PATTERN_NAMES [0]);
+            failures++;
+        }
+        if (!result.mIsInterpolationValid) {
+            printf ("ERROR: an interpolation factor under %s frames was out of [0,1).\n", FRAME_PATTERN_NAMES [pattern]);
+            failures++;
+        }
+    }
+
+    int differingCount = 0;
+    for (int pattern = 0; pattern < FRAME_PATTERN_COUNT; pattern++) {
+        const GameResult result = PlayVariableStep (static_cast<FramePattern>(pattern), gameplaySeconds);
+        printf ("variable step, %-8s: hash %016llx, score %6d, %7llu frames\n", FRAME_PATTERN_NAMES [pattern],
+                static_cast<unsigned long long>(result.mHash), result.mScore, static_cast<unsigned long long>(result.mFrames));
+        differingCount += result.mHash != fixedResults [0].mHash ? 1 : 0;
+    }
+    printf ("%d of %d variable step games differ from the fixed step game\n", differingCount, FRAME_PATTERN_COUNT);
+
+    // unthrottled: every frame hands out the most steps there are
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, gameplaySeconds, SEED);
+    GameState previousGameState (ROWS, COLUMNS, MIN_MATCH_SIZE, gameplaySeconds, SEED);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    GameRandom botRandom (1);
+    Uint64 steps = 0;
+    while (gameState.GetAnimationState() != GameState::GameOver) {
+        PlayBotStep (botRandom, gameStateLogic, gameState);
+        previousGameState.CopyStateFrom (gameState);
+        gameStateLogic.Update (STEP_MILIS, gameState);
+        steps++;
+    }
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    if (HashGame (gameState) != fixedResults [0].mHash) {
+        printf ("ERROR: the unthrottled game differs from the game under %s frames.\n", FRAME_PATTERN_NAMES [0]);
+        failures++;
+    }
+    printf ("unthrottled: %llu steps in %.3f s, %.0f steps/s, %.0fx faster than real time\n", static_cast<unsigned long long>(steps), seconds.count(),
+            steps / seconds.count(), steps * STEP_MILIS / 1000.0 / seconds.count());
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <FramePacer.h>
+#include <GameRandom.h>
+#include <Histogram.h>
+
+
+/*!
+ * Measures the frame pacing of FramePacer with a made up renderer that burns between 1 and 4 ms of CPU a frame.
+ *
+ * It caps the frames at 60 and at 144 per second, once sleeping until every frame is due, the simple way, and once
+ * with FramePacer, which sleeps until shortly before and spins the rest, then runs uncapped. It prints the frames per
+ * second reached and the frame time percentiles and standard deviation: the closer the frame times are to the cap's,
+ * the smoother the game moves.
+ *
+ * usage: FramePacerBenchmark [frames per run]
+ */
+
+
+static const int MIN_RENDER_MICROSECONDS = 1000;
+static const int MAX_RENDER_MICROSECONDS = 4000;
+
+
+/// a frame of the made up renderer
+static void Render (GameRandom& random)
+{
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()
+        + std::chrono::microseconds (MIN_RENDER_MICROSECONDS + random.NextInt (MAX_RENDER_MICROSECONDS - MIN_RENDER_MICROSECONDS));
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+
+static void PrintFrameTimes (const char* name, const Histogram& frameTimes)
+{
+    printf ("  %-24s %8.1f fps, frame time p50 %6.3f ms, p99 %6.3f ms, max %6.3f ms, standard deviation %6.3f ms\n", name,
+            frameTimes.GetCount() > 0 ? 1000.0 / frameTimes.GetMean() : 0.0, frameTimes.GetPercentile (50), frameTimes.GetPercentile (99),
+            frameTimes.GetMaximum(), frameTimes.GetStandardDeviation());
+}
+
+
+/*!
+ * Caps the frames by sleeping until each is due, without FramePacer.
+ */
+static void RunSleepCapped (int framesPerSecond, int frames)
+{
+    GameRandom random (1);
+    Histogram frameTimes (10000, 0.01);
+    const std::chrono::steady_clock::duration frameTime = std::chrono::nanoseconds (1000000000 / framesPerSecond);
+    std::chrono::steady_clock::time_point lastFrameEnd = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point due = lastFrameEnd + frameTime;
+    for (int frame = 0; frame < frames; frame++) {
+        Render (random);
+        std::this_thread::sleep_until (due);
+        due += frameTime;
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        frameTimes.Add (std::chrono::duration<double, std::milli> (now - lastFrameEnd).count());
+        lastFrameEnd = now;
+    }
+    PrintFrameTimes ("sleep only:", frameTimes);
+}
+
+
+static void RunFramePacer (FramePacer::Mode mode, int framesPerSecond, int frames)
+{
+    GameRandom random (1);
+    FramePacer framePacer;
+    framePacer.SetMode (mode, framesPerSecond);
+    for (int frame = 0; frame < frames; frame++) {
+        Render (random);
+        framePacer.EndFrame();
+    }
+    PrintFrameTimes (FramePacer::Capped == mode ? "FramePacer, sleep+spin:" : "FramePacer, uncapped:", framePacer.GetFrameTimes());
+}
+
+
+int main (int argc, char* argv[])
+{
+    const int frames = argc > 1 ? atoi (argv [1]) : 600;
+    if (frames < 2) {
+        printf ("usage: FramePacerBenchmark [frames per run]\n");
+        return EXIT_FAILURE;
+    }
+    const int caps[] = {60, 144};
+    for (size_t cap = 0; cap < sizeof (caps) / sizeof (caps [0]); cap++) {
+        printf ("capped at %d fps (%.3f ms a frame), %d frames:\n", caps [cap], 1000.0 / caps [cap], frames);
+        RunSleepCapped (caps [cap], frames);
+        RunFramePacer (FramePacer::Capped, caps [cap], frames);
+    }
+    printf ("uncapped, %d frames:\n", frames);
+    RunFramePacer (FramePacer::Uncapped, 0, frames);
+    return EXIT_SUCCESS;
+}
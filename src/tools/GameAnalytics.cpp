@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <GameBoard.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <Histogram.h>
+#include <JobSystem.h>
+
+
+/*!
+ * Plays seeded games for every combination of board size, number of colors and minimum match size on all cores and
+ * prints the distributions of final score, cascades per move and moves per game, the deadlock frequency and a
+ * difficulty estimate, each with its 95% confidence interval.
+ *
+ * The player picks a random matching move, so the numbers describe the rules rather than a strategy. A game ends
+ * after MOVES_PER_GAME moves or when no move makes a match (a deadlock). The difficulty is the share of the
+ * MOVES_PER_GAME moves lost to deadlocks: 0 when every game is played to the end, 1 when no move is possible.
+ * All configurations play the same seeds. Every job fills its own histograms; they are merged after the jobs finish.
+ *
+ * usage: GameAnalytics [games per configuration] [moves per game]
+ */
+
+
+static const int BOARD_SIDES [] = { 6, 8, 10 };
+static const int COLORS [] = { 4, 5, 6, 7 };
+static const int MIN_MATCH_SIZES [] = { 3, 4 };
+static const int DEFAULT_GAMES = 2000;
+static const int DEFAULT_MOVES_PER_GAME = 100;
+static const int SCORE_BIN_WIDTH = 4;
+static const int MAX_CASCADES = 32;
+static const Uint32 SEED = 1;
+
+
+/*!
+ * The distributions of one configuration, filled by one job.
+ */
+struct GameStatistics
+{
+    explicit GameStatistics (int movesPerGame) :
+        mScores (1024, SCORE_BIN_WIDTH),
+        mCascades (MAX_CASCADES, 1),
+        mMoves (movesPerGame + 1, 1),
+        mMatchingMoves (GameBoard::MAX_MOVES + 1, 1),
+        mDeadlocks (0)
+    {
+    }
+
+    void Merge (const GameStatistics& other)
+    {
+        mScores.Merge (other.mScores);
+        mCascades.Merge (other.mCascades);
+        mMoves.Merge (other.mMoves);
+        mMatchingMoves.Merge (other.mMatchingMoves);
+        mDeadlocks += other.mDeadlocks;
+    }
+
+    Histogram mScores;          ///< final score per game
+    Histogram mCascades;        ///< destroy and collapse rounds per move
+    Histogram mMoves;           ///< moves per game
+    Histogram mMatchingMoves;   ///< moves making a match per position
+    Uint64 mDeadlocks;          ///< games ended by a deadlock
+};
+
+
+/*!
+ * Plays games [firstGame, endGame) of a configuration.
+ */
+static void PlayGames (int side, int colors, int minMatchSize, int firstGame, int endGame, int movesPerGame, GameStatistics& statistics)
+{
+    GameBoard board (side, side, minMatchSize, colors);
+    int moves [GameBoard::MAX_MOVES];
+    for (int game = firstGame; game < endGame; game++) {
+        board.Reset (SEED + static_cast<Uint32>(game));
+        GameRandom random (SEED + static_cast<Uint32>(game) * 7919);
+        bool isDeadlocked = false;
+        while (board.GetMoveCount() < movesPerGame) {
+            const int moveCount = board.GetMatchingMoves (moves);
+            statistics.mMatchingMoves.Add (moveCount);
+            if (moveCount == 0) {
+                isDeadlocked = true;
+                break;
+            }
+            board.ApplyMove (moves [random.NextInt (moveCount)]);
+            statistics.mCascades.Add (board.GetLastCascades());
+        }
+        statistics.mScores.Add (board.GetScore());
+        statistics.mMoves.Add (board.GetMoveCount());
+        statistics.mDeadlocks += isDeadlocked ? 1 : 0;
+    }
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const int games = argc > 1 ? atoi (argv [1]) : DEFAULT_GAMES;
+    const int movesPerGame = argc > 2 ? atoi (argv [2]) : DEFAULT_MOVES_PER_GAME;
+    if (games < 1 || movesPerGame < 1) {
+        printf ("usage: GameAnalytics [games per configuration] [moves per game]\n");
+        return EXIT_FAILURE;
+    }
+
+    JobSystem jobSystem;
+    // a few jobs per worker keep the workers busy when games take different times
+    const int shards = jobSystem.GetWorkerCount() * 4 < games ? jobSystem.GetWorkerCount() * 4 : games;
+    std::vector<GameStatistics> shardStatistics (shards, GameStatistics (movesPerGame));
+    printf ("%d games per configuration, at most %d moves per game, 95%% confidence intervals\n", games, movesPerGame);
+    printf ("%6s %6s %5s | %15s %5s %5s %5s | %13s %4s | %14s | %17s | %8s | %13s\n", "board", "colors", "match",
+            "score", "p10", "p50", "p90", "cascades", "p99", "moves", "deadlocks", "matching", "difficulty");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Uint64 totalMoves = 0;
+    for (size_t sideIndex = 0; sideIndex < sizeof (BOARD_SIDES) / sizeof (BOARD_SIDES [0]); sideIndex++) {
+        for (size_t colorsIndex = 0; colorsIndex < sizeof (COLORS) / sizeof (COLORS [0]); colorsIndex++) {
+            for (size_t matchIndex = 0; matchIndex < sizeof (MIN_MATCH_SIZES) / sizeof (MIN_MATCH_SIZES [0]); matchIndex++) {
+                const int side = BOARD_SIDES [sideIndex];
+                const int colors = COLORS [colorsIndex];
+                const int minMatchSize = MIN_MATCH_SIZES [matchIndex];
+                jobSystem.ParallelFor (shards, 1, [&] (int firstShard, int endShard) {
+                    for (int shard = firstShard; shard < endShard; shard++) {
+                        shardStatistics [shard] = GameStatistics (movesPerGame);
+                        PlayGames (side, colors, minMatchSize, games * shard / shards, games * (shard + 1) / shards, movesPerGame, shardStatistics [shard]);
+                    }
+                });
+                GameStatistics statistics (movesPerGame);
+                for (int shard = 0; shard < shards; shard++) {
+                    statistics.Merge (shardStatistics [shard]);
+                }
+                totalMoves += statistics.mCascades.GetCount();
+
+                double deadlocksLow, deadlocksHigh;
+                GetProportionConfidence (statistics.mDeadlocks, games, deadlocksLow, deadlocksHigh);
+                const double difficulty = 1.0 - statistics.mMoves.GetMean() / movesPerGame;
+                const double difficultyConfidence = statistics.mMoves.GetMeanConfidence() / movesPerGame;
+                printf ("%3dx%-2d %6d %5d | %7.1f +-%5.1f %5.0f %5.0f %5.0f | %5.2f +-%4.2f %4.0f | %6.1f +-%5.1f | %5.1f%% [%4.1f,%5.1f] | %8.1f | %5.3f +-%5.3f\n",
+                        side, side, colors, minMatchSize,
+                        statistics.mScores.GetMean(), statistics.mScores.GetMeanConfidence(), statistics.mScores.GetPercentile (10),
+                        statistics.mScores.GetPercentile (50), statistics.mScores.GetPercentile (90),
+                        statistics.mCascades.GetMean(), statistics.mCascades.GetMeanConfidence(), statistics.mCascades.GetPercentile (99),
+                        statistics.mMoves.GetMean(), statistics.mMoves.GetMeanConfidence(),
+                        100.0 * statistics.mDeadlocks / games, 100.0 * deadlocksLow, 100.0 * deadlocksHigh,
+                        statistics.mMatchingMoves.GetMean(), difficulty, difficultyConfidence);
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf ("%llu moves in %.1f s on %d workers\n", static_cast<unsigned long long>(totalMoves), elapsed.count(), jobSystem.GetWorkerCount());
+    return EXIT_SUCCESS;
+}
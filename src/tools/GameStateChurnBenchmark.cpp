@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStatePool.h>
+
+
+/*!
+ * Keeps LIVE_GAMES games running and replaces random ones with new games, the way a server starts and ends
+ * games, first with new and delete and then with a GameStatePool. Prints the time and the heap allocations per
+ * new game, and checks that a recycled game starts exactly like a newly constructed one with the same seed.
+ *
+ * usage: GameStateChurnBenchmark [new games]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int GAMEPLAY_SECONDS = 60;
+static const int LIVE_GAMES = 1000;
+static const int DEFAULT_NEW_GAMES = 1000000;
+
+
+// every heap allocation of the program, counted by the replaced operator new
+static std::atomic<Uint64> sAllocationCount (0);
+
+
+void* operator new (size_t size)
+{
+    sAllocationCount.fetch_add (1, std::memory_order_relaxed);
+    void* memory = malloc (size > 0 ? size : 1);
+    if (memory == NULL) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+
+void operator delete (void* memory) noexcept
+{
+    free (memory);
+}
+
+
+/*!
+ * Checks that two games have the same grid, score and random state.
+ */
+static bool IsSameGame (const GameState& gameStateA, const GameState& gameStateB)
+{
+    GameState::Keyframe keyframeA, keyframeB;
+    Uint8 gridA [ROWS * COLUMNS], gridB [ROWS * COLUMNS];
+    if (!gameStateA.GetKeyframe (keyframeA, gridA) || !gameStateB.GetKeyframe (keyframeB, gridB)) {
+        return false;
+    }
+    for (int index = 0; index < ROWS * COLUMNS; index++) {
+        if (gridA [index] != gridB [index]) {
+            return false;
+        }
+    }
+    return keyframeA.mGameTime == keyframeB.mGameTime && keyframeA.mGameplayTime == keyframeB.mGameplayTime &&
+        keyframeA.mGameScore == keyframeB.mGameScore && keyframeA.mRandomState == keyframeB.mRandomState;
+}
+
+
+static void PrintResult (const char* name, int newGames, double seconds, Uint64 allocations)
+{
+    printf ("%-16s %10.0f games/s %8.1f ns/game %8.3f allocations/game\n", name, newGames / seconds,
+            seconds * 1e9 / newGames, static_cast<double>(allocations) / newGames);
+}
+
+
+/*!
+ * Main function of the churn benchmark.
+ * @param argc up to 1 argument: the number of games started in each run (default DEFAULT_NEW_GAMES).
+ * @return returns 0 if every recycled game matched a new one, 1 otherwise.
+ */
+int main (int argc, char* argv[])
+{
+    const int newGames = argc > 1 ? atoi (argv [1]) : DEFAULT_NEW_GAMES;
+    if (newGames < 1) {
+        printf ("usage: GameStateChurnBenchmark [new games]\n");
+        return EXIT_FAILURE;
+    }
+    GameState::SetIsLoggingEnabled (false);
+    printf ("%d live %dx%d games, %d games started per run\n", LIVE_GAMES, ROWS, COLUMNS, newGames);
+
+    // new and delete
+    {
+        std::vector<GameState*> gameStates (LIVE_GAMES);
+        for (int index = 0; index < LIVE_GAMES; index++) {
+            gameStates [index] = new GameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, index);
+        }
+        GameRandom random (1);
+        const Uint64 startAllocations = sAllocationCount.load();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int game = 0; game < newGames; game++) {
+            const int index = random.NextInt (LIVE_GAMES);
+            delete gameStates [index];
+            gameStates [index] = new GameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, random.Next());
+        }
+        const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+        PrintResult ("new/delete", newGames, seconds, sAllocationCount.load() - startAllocations);
+        for (int index = 0; index < LIVE_GAMES; index++) {
+            delete gameStates [index];
+        }
+    }
+
+    // pool
+    int mismatchCount = 0;
+    {
+        GameStatePool gameStatePool (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS);
+        gameStatePool.Reserve (LIVE_GAMES);
+        std::vector<GameState*> gameStates (LIVE_GAMES);
+        for (int index = 0; index < LIVE_GAMES; index++) {
+            gameStates [index] = gameStatePool.Acquire (index);
+        }
+        GameRandom random (1);
+        const Uint64 startAllocations = sAllocationCount.load();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int game = 0; game < newGames; game++) {
+            const int index = random.NextInt (LIVE_GAMES);
+            gameStatePool.Release (gameStates [index]);
+            gameStates [index] = gameStatePool.Acquire (random.Next());
+        }
+        const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+        PrintResult ("GameStatePool", newGames, seconds, sAllocationCount.load() - startAllocations);
+        printf ("pool created %d games for %d live ones\n", static_cast<int>(gameStatePool.GetCreatedCount()), LIVE_GAMES);
+
+        // a recycled game has to be indistinguishable from a new one
+        for (int index = 0; index < LIVE_GAMES; index++) {
+            const Uint32 seed = random.Next();
+            gameStatePool.Release (gameStates [index]);
+            gameStates [index] = gameStatePool.Acquire (seed);
+            GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, seed);
+            if (!IsSameGame (*gameStates [index], gameState)) {
+                mismatchCount++;
+            }
+        }
+        printf ("recycled games differing from new ones: %d of %d\n", mismatchCount, LIVE_GAMES);
+        for (int index = 0; index < LIVE_GAMES; index++) {
+            gameStatePool.Release (gameStates [index]);
+        }
+    }
+    return mismatchCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}				/* ----------  end of function main  ---------- */
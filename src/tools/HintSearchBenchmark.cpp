@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <GameBoard.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <Histogram.h>
+#include <HintSearch.h>
+
+
+/*!
+ * Measures what the hint search costs the simulation thread of TestGame.
+ *
+ * It plays games of 8 ms steps, the player swapping the hinted move (or the first matching one while there is none)
+ * whenever the game has rested for a while. Two HintSearch observe the same game: one searching in slices of the
+ * budget every step, as the game does, and one searching each grid at once. It prints the time the searches take per
+ * step, which is how late they would make a step or frame, how many steps a sliced search spreads over, how many
+ * searches the moves dropped and whether both searches hint the same moves.
+ *
+ * usage: HintSearchBenchmark [budget microseconds] [depth] [games]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const Uint32 STEP_MILIS = 8;                 ///< TestGame::SIMULATION_STEP_MILIS
+static const int GAME_SECONDS = 60;
+
+
+/// microseconds an Update takes
+static double TimeUpdate (HintSearch& hintSearch, const GameState& gameState)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    hintSearch.Update (gameState);
+    return std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - start).count();
+}
+
+
+/*!
+ * Plays the games with a player who moves once the game rested for moveMilis.
+ */
+static void RunGames (int budgetMicroseconds, int depth, int games, Uint32 moveMilis)
+{
+    Histogram slicedTimes (100000, 1.0);
+    Histogram wholeTimes (100000, 1.0);
+    Histogram stepsPerSearch (10000, 1.0);
+    Uint64 searches = 0;
+    Uint64 cancelledSearches = 0;
+    Uint64 sameHints = 0;
+    Uint64 comparedHints = 0;
+    for (int game = 0; game < games; game++) {
+        GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAME_SECONDS, 100 + game);
+        GameStateLogic gameStateLogic;
+        HintSearch slicedSearch (depth, budgetMicroseconds, 0);
+        HintSearch wholeSearch (depth, 1000000000, 0);
+        gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+        gameState.AttachGameStateGridChangeObserver (&slicedSearch);
+        gameState.AttachGameStateGridChangeObserver (&wholeSearch);
+        Uint32 restStartGameplayTime = 0;
+        bool isResting = false;
+        int searchSteps = 0;
+        while (gameState.GetAnimationState() != GameState::GameOver) {
+            gameStateLogic.Update (STEP_MILIS, gameState);
+            // a step searched if it applied moves or finished a search
+            const bool wasSlicedSearchDone = slicedSearch.IsSearchDone();
+            const Uint64 slicedNodes = slicedSearch.GetNodes();
+            const double slicedTime = TimeUpdate (slicedSearch, gameState);
+            const bool isSlicedSearchFinished = !wasSlicedSearchDone && slicedSearch.IsSearchDone();
+            if (slicedSearch.GetNodes() != slicedNodes || isSlicedSearchFinished) {
+                slicedTimes.Add (slicedTime);
+                searchSteps++;
+            }
+            const bool wasWholeSearchDone = wholeSearch.IsSearchDone();
+            const Uint64 wholeNodes = wholeSearch.GetNodes();
+            const double wholeTime = TimeUpdate (wholeSearch, gameState);
+            if (wholeSearch.GetNodes() != wholeNodes || (!wasWholeSearchDone && wholeSearch.IsSearchDone())) {
+                wholeTimes.Add (wholeTime);
+            }
+            if (isSlicedSearchFinished) {
+                stepsPerSearch.Add (searchSteps);
+                searches++;
+                int rowA, columnA, rowB, columnB;
+                int wholeRowA, wholeColumnA, wholeRowB, wholeColumnB;
+                const bool isHinted = slicedSearch.GetHint (rowA, columnA, rowB, columnB);
+                if (isHinted == wholeSearch.GetHint (wholeRowA, wholeColumnA, wholeRowB, wholeColumnB)) {
+                    sameHints += !isHinted || (rowA == wholeRowA && columnA == wholeColumnA && rowB == wholeRowB && columnB == wholeColumnB);
+                }
+                comparedHints++;
+            }
+            if (slicedSearch.IsSearchDone()) {
+                searchSteps = 0;
+            }
+
+            const bool isIdle = gameState.GetAnimationState() == GameState::Idle && !gameStateLogic.IsGridCheckPending();
+            if (!isIdle) {
+                isResting = false;
+                continue;
+            }
+            if (!isResting) {
+                isResting = true;
+                restStartGameplayTime = gameState.GetGameplayTime();
+            }
+            if (gameState.GetGameplayTime() - restStartGameplayTime < moveMilis) {
+                continue;
+            }
+            int rowA, columnA, rowB, columnB;
+            if (!slicedSearch.GetHint (rowA, columnA, rowB, columnB)) {
+                GameBoard board (ROWS, COLUMNS, MIN_MATCH_SIZE, GameState::sNUMBER_OF_TILE_COLORS);
+                board.CopyFrom (gameState, 1);
+                int moves [GameBoard::MAX_MOVES];
+                if (board.GetMatchingMoves (moves) == 0) {
+                    continue;
+                }
+                GameBoard::DecodeMove (moves [0], rowA, columnA, rowB, columnB);
+            }
+            gameStateLogic.RequestSwap (rowA, columnA, rowB, columnB, gameState);
+        }
+        cancelledSearches += slicedSearch.GetCancelledSearches();
+    }
+    printf ("  a move after %4u ms of rest: %llu searches done, %llu dropped, %llu of %llu hints the same searched at once\n", moveMilis,
+            static_cast<unsigned long long>(searches), static_cast<unsigned long long>(cancelledSearches),
+            static_cast<unsigned long long>(sameHints), static_cast<unsigned long long>(comparedHints));
+    printf ("    sliced:   %6.0f us a step p50, %6.0f us p99, %6.0f us max, %.1f steps a search on average\n",
+            slicedTimes.GetPercentile (50), slicedTimes.GetPercentile (99), slicedTimes.GetMaximum(), stepsPerSearch.GetMean());
+    printf ("    at once:  %6.0f us a step p50, %6.0f us p99, %6.0f us max\n",
+            wholeTimes.GetPercentile (50), wholeTimes.GetPercentile (99), wholeTimes.GetMaximum());
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const int budgetMicroseconds = argc > 1 ? atoi (argv [1]) : HintSearch::DEFAULT_BUDGET_MICROSECONDS;
+    const int depth = argc > 2 ? atoi (argv [2]) : HintSearch::DEFAULT_DEPTH;
+    const int games = argc > 3 ? atoi (argv [3]) : 3;
+    if (budgetMicroseconds < 1 || depth < 1 || depth > HintSearch::MAX_DEPTH || games < 1) {
+        printf ("usage: HintSearchBenchmark [budget microseconds] [depth, 1 to %d] [games]\n", HintSearch::MAX_DEPTH);
+        return EXIT_FAILURE;
+    }
+    printf ("%d games of %d s, depth %d, a budget of %d us a step of %u ms:\n", games, GAME_SECONDS, depth, budgetMicroseconds, STEP_MILIS);
+    RunGames (budgetMicroseconds, depth, games, 1000);
+    RunGames (budgetMicroseconds, depth, games, 40);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <FixedTimestep.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <RenderSnapshot.h>
+#include <TripleBuffer.h>
+
+
+/*!
+ * Measures what a resting game costs with the game loop of TestGame.
+ *
+ * The simulation thread steps a game every 8 ms and a render thread draws its snapshots on a made up 60 Hz display,
+ * each frame burning RENDER_MICROSECONDS of CPU like the game's draw calls and text rendering do before waiting for
+ * the vertical blank. A player swaps a pair every few seconds and does nothing in between. This runs once drawing
+ * every frame, as the game did, and once the way the game does now: snapshots that draw the same are not published
+ * and the render thread sleeps, like in SDL_WaitEventTimeout, until a new snapshot wakes it or the timer ticks. It
+ * prints the frames drawn and the CPU time used.
+ *
+ * usage: IdleLoopBenchmark [seconds] [seconds between moves]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const Uint32 STEP_MILIS = 8;                 ///< TestGame::SIMULATION_STEP_MILIS
+static const int MAX_CATCH_UP_STEPS = 25;           ///< TestGame::MAX_CATCH_UP_STEPS
+static const Uint64 FRAME_NANOSECONDS = 1000000000 / 60;
+static const Uint64 RENDER_MICROSECONDS = 2000;
+static const Uint64 NANOSECONDS_PER_SECOND = 1000000000;
+
+
+static std::chrono::steady_clock::time_point sStart = std::chrono::steady_clock::now();
+
+
+/// the counter of the tool, nanoseconds since it started
+static Uint64 GetCounter ()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - sStart).count();
+}
+
+
+static void SleepUntil (Uint64 counter)
+{
+    const Uint64 now = GetCounter();
+    if (counter > now) {
+        std::this_thread::sleep_for (std::chrono::nanoseconds (counter - now));
+    }
+}
+
+
+/*!
+ * The wake events of the SDL event queue: the render thread waits with a timeout, the simulation thread wakes it.
+ */
+class WakeEvents
+{
+    public:
+        WakeEvents () : mIsPending (false) {}
+
+        void Push ()
+        {
+            std::lock_guard<std::mutex> lock (mMutex);
+            mIsPending = true;
+            mCondition.notify_one();
+        }
+
+        /// @param timeoutMilis -1 to wait however long
+        void Wait (int timeoutMilis)
+        {
+            std::unique_lock<std::mutex> lock (mMutex);
+            if (timeoutMilis < 0) {
+                mCondition.wait (lock, [this] () { return mIsPending; });
+            } else {
+                mCondition.wait_for (lock, std::chrono::milliseconds (timeoutMilis), [this] () { return mIsPending; });
+            }
+            mIsPending = false;
+        }
+
+    private:
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mIsPending;
+};
+
+
+/// a frame of the made up renderer: burns the CPU a draw costs, then waits for the vertical blank
+static void Render (Uint64 frameStartCounter)
+{
+    const Uint64 drawnCounter = frameStartCounter + RENDER_MICROSECONDS * 1000;
+    while (GetCounter() < drawnCounter) {
+    }
+    SleepUntil ((GetCounter() / FRAME_NANOSECONDS + 1) * FRAME_NANOSECONDS);
+}
+
+
+/*!
+ * Runs the game loop for a while.
+ * @param isIdleMode false to draw every frame, as the game did.
+ */
+static void RunLoop (bool isIdleMode, int seconds, int moveSeconds)
+{
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, 3600, 31);
+    GameState previousGameState (ROWS, COLUMNS, MIN_MATCH_SIZE, 3600, 31);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    GameRandom random (7);
+    FixedTimestep fixedTimestep (STEP_MILIS, MAX_CATCH_UP_STEPS);
+    TripleBuffer<RenderSnapshot> snapshots;
+    RenderSnapshot publishedSnapshot;
+    WakeEvents wakeEvents;
+    std::atomic<bool> isRunning (true);
+    std::atomic<int> publishes (0);
+
+    const std::clock_t startClock = std::clock();
+    const Uint64 startCounter = GetCounter();
+    fixedTimestep.Start (startCounter, NANOSECONDS_PER_SECOND);
+    std::thread simulation ([&] () {
+        Uint64 nextMoveCounter = startCounter + moveSeconds * NANOSECONDS_PER_SECOND;
+        while (isRunning.load (std::memory_order_relaxed)) {
+            const int stepCount = fixedTimestep.Advance (GetCounter());
+            for (int step = 0; step < stepCount; step++) {
+                if (GetCounter() >= nextMoveCounter && gameState.GetAnimationState() == GameState::Idle && !gameStateLogic.IsGridCheckPending()) {
+                    nextMoveCounter += moveSeconds * NANOSECONDS_PER_SECOND;
+                    const int row = random.NextInt (ROWS - 1);
+                    const int column = random.NextInt (COLUMNS);
+                    gameStateLogic.RequestSwap (row, column, row + 1, column, gameState);
+                }
+                previousGameState.CopyStateFrom (gameState);
+                gameStateLogic.Update (STEP_MILIS, gameState);
+            }
+            if (stepCount > 0) {
+                RenderSnapshot& snapshot = snapshots.GetWriteBuffer();
+                snapshot.Capture (gameState, previousGameState, fixedTimestep.GetStepCounter(), fixedTimestep.GetStepCounterTicks());
+                if (!isIdleMode || !snapshot.IsSameDrawingAs (publishedSnapshot)) {
+                    publishedSnapshot = snapshot;
+                    snapshots.Publish();
+                    publishes++;
+                    wakeEvents.Push();
+                }
+            }
+            SleepUntil (fixedTimestep.GetStepCounter() + fixedTimestep.GetStepCounterTicks());
+        }
+    });
+
+    const Uint64 endCounter = startCounter + seconds * NANOSECONDS_PER_SECOND;
+    Uint64 frames = 0;
+    Uint64 wakes = 0;
+    bool isRedrawNeeded = true;
+    for (Uint64 counter = GetCounter(); counter < endCounter; counter = GetCounter()) {
+        const RenderSnapshot& drawnSnapshot = snapshots.GetReadBuffer();
+        if (isIdleMode && !isRedrawNeeded && drawnSnapshot.IsSettled()) {
+            // never past the end of the run
+            const int timeoutMilis = drawnSnapshot.GetMilisToTimerTick();
+            const int endMilis = static_cast<int>((endCounter - counter) / 1000000) + 1;
+            wakeEvents.Wait (timeoutMilis < 0 || timeoutMilis > endMilis ? endMilis : timeoutMilis);
+            wakes++;
+        }
+        isRedrawNeeded |= snapshots.Acquire();
+        const RenderSnapshot& snapshot = snapshots.GetReadBuffer();
+        if (isIdleMode && !isRedrawNeeded && snapshot.IsSettled()) {
+            continue;
+        }
+        Render (GetCounter());
+        frames++;
+        isRedrawNeeded = false;
+    }
+    isRunning = false;
+    simulation.join();
+    const double cpuSeconds = static_cast<double>(std::clock() - startClock) / CLOCKS_PER_SEC;
+    const double wallSeconds = (GetCounter() - startCounter) / 1e9;
+    printf ("%-24s %llu frames drawn, %d snapshots published, %llu waits, %.2f s CPU in %.2f s (%.1f%% of a core), %d moves, score %d\n",
+            isIdleMode ? "idle mode:" : "every frame (before):", static_cast<unsigned long long>(frames), publishes.load(),
+            static_cast<unsigned long long>(wakes), cpuSeconds, wallSeconds, 100.0 * cpuSeconds / wallSeconds, seconds / moveSeconds, gameState.GetScore());
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const int seconds = argc > 1 ? atoi (argv [1]) : 10;
+    const int moveSeconds = argc > 2 ? atoi (argv [2]) : 5;
+    if (seconds < 1 || moveSeconds < 1) {
+        printf ("usage: IdleLoopBenchmark [seconds] [seconds between moves]\n");
+        return EXIT_FAILURE;
+    }
+    printf ("%d s of a game resting but for a swap every %d s, drawing costs %llu us a frame at 60 Hz:\n", seconds, moveSeconds,
+            static_cast<unsigned long long>(RENDER_MICROSECONDS));
+    RunLoop (false, seconds, moveSeconds);
+    RunLoop (true, seconds, moveSeconds);
+    return EXIT_SUCCESS;
+}
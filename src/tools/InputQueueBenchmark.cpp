@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <GameStateRenderer.h>
+#include <InputQueue.h>
+
+
+/*!
+ * Measures the input path of the game.
+ *
+ * First a producer thread pushes the events of a 1000 Hz mouse polled at 60 frames per second (16 motion events and
+ * now and then a click per frame) into an InputQueue while a consumer thread takes them out, checking that no event
+ * is reordered or lost and that motion is coalesced to one event per frame.
+ *
+ * Then a fast scripted player drags a pair of tiles that makes a match every 150 ms, faster than a swap and its
+ * destroy and collapse animations take, for a minute. Once with the input dropped while the board is busy, as the game
+ * did, once with GameStateLogic buffering it. It prints how many of the player's moves became swaps and matches.
+ *
+ * Last a player swaps a pair that makes no match every 400 ms, so some tiles always swap back, and the game has to
+ * end once its gameplay time is up all the same.
+ *
+ * usage: InputQueueBenchmark [frames]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const Uint32 STEP_MILIS = 8;                 ///< TestGame::SIMULATION_STEP_MILIS
+static const int MOTIONS_PER_FRAME = 16;            ///< a 1000 Hz mouse at 60 frames per second
+static const int CLICK_ONE_IN = 8;                  ///< chance per frame of a click
+static const Uint32 MOVE_INTERVAL_MILIS = 150;      ///< how often the scripted player moves
+static const Uint32 DRAG_MILIS = 60;                ///< from button down to button up
+static const Uint32 GAME_MILIS = 60000;
+static const Uint32 STALL_INTERVAL_MILIS = 400;     ///< how often the stalling player swaps without a match
+static const int STALL_GAME_SECONDS = 20;           ///< the gameplay time of the stalled game
+
+
+/*!
+ * Pushes frames of events while another thread pops them.
+ * @return the number of errors found.
+ */
+static int MeasureQueue (int frames)
+{
+    InputQueue inputQueue;
+    int errors = 0;
+    Uint64 poppedMotions = 0;
+    Uint64 poppedClicks = 0;
+    std::atomic<bool> isDone (false);
+    std::thread consumer ([&] () {
+        Sint32 lastMotionX = -1;
+        Uint64 lastCounter = 0;
+        while (true) {
+            const bool isLast = isDone.load (std::memory_order_acquire);
+            for (const InputQueue::Event* event = inputQueue.Peek(); event != NULL; event = inputQueue.Peek()) {
+                errors += event->mCounter < lastCounter ? 1 : 0;
+                lastCounter = event->mCounter;
+                if (event->mEvent.type == SDL_MOUSEMOTION) {
+                    // the x of a motion counts the motion events pushed
+                    errors += event->mEvent.motion.x <= lastMotionX ? 1 : 0;
+                    lastMotionX = event->mEvent.motion.x;
+                    poppedMotions++;
+                } else {
+                    // clicks carry the motion count before them, every motion before the click is seen first
+                    errors += event->mEvent.button.x != lastMotionX ? 1 : 0;
+                    poppedClicks++;
+                }
+                inputQueue.Pop();
+            }
+            if (isLast) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    GameRandom random (3);
+    Sint32 motionCount = 0;
+    Uint64 pushedClicks = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        const int clickAt = random.NextInt (CLICK_ONE_IN) == 0 ? random.NextInt (MOTIONS_PER_FRAME) : -1;
+        for (int motion = 0; motion < MOTIONS_PER_FRAME; motion++) {
+            SDL_Event e;
+            e.type = SDL_MOUSEMOTION;
+            e.motion.x = motionCount++;
+            e.motion.y = 0;
+            inputQueue.Push (e, static_cast<Uint64>(frame) * MOTIONS_PER_FRAME + motion);
+            if (motion == clickAt) {
+                e.type = SDL_MOUSEBUTTONDOWN;
+                e.button.x = motionCount - 1;
+                e.button.y = 0;
+                inputQueue.Push (e, static_cast<Uint64>(frame) * MOTIONS_PER_FRAME + motion);
+                pushedClicks++;
+            }
+        }
+        inputQueue.EndFrame();
+        // one frame of events a time, like the game between two polls
+        if (frame % 64 == 63) {
+            std::this_thread::yield();
+        }
+    }
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    isDone.store (true, std::memory_order_release);
+    consumer.join();
+    const Uint64 pushedEvents = static_cast<Uint64>(motionCount) + pushedClicks;
+    errors += poppedClicks + inputQueue.GetDroppedCount() < pushedClicks ? 1 : 0;
+    printf ("queue: %llu events pushed in %.3f s (%.0f/s), %llu motions coalesced into %llu, %llu clicks, %llu dropped, %d errors\n",
+            static_cast<unsigned long long>(pushedEvents), seconds.count(), pushedEvents / seconds.count(),
+            static_cast<unsigned long long>(motionCount), static_cast<unsigned long long>(poppedMotions),
+            static_cast<unsigned long long>(poppedClicks), static_cast<unsigned long long>(inputQueue.GetDroppedCount()), errors);
+    return errors;
+}
+
+
+/*!
+ * The screen location of the middle of a tile, GameStateRenderer::GetGridCoordinatesFromScreenLocation reversed.
+ */
+static void GetTileScreenLocation (int row, int column, int& x, int& y)
+{
+    const glm::vec2 origin = GameStateRenderer::GetGridCoordinatesFromScreenLocation (0, 0);
+    const glm::vec2 far = GameStateRenderer::GetGridCoordinatesFromScreenLocation (1000, 1000);
+    const glm::vec2 perPixel = (far - origin) / 1000.0f;
+    x = static_cast<int>(((column + 0.5f) / COLUMNS - origin.x) / perPixel.x + 0.5f);
+    y = static_cast<int>(((row + 0.5f) / ROWS - origin.y) / perPixel.y + 0.5f);
+}
+
+
+/*!
+ * Whether the tile at row, column would be part of a match of MIN_MATCH_SIZE if it had the given color.
+ */
+static bool IsMatchWith (const GameState& gameState, int row, int column, GameState::Color color, int otherRow, int otherColumn)
+{
+    // the colors around the tile, the other tile of the swap has moved away
+    GameState::Color around [2 * MIN_MATCH_SIZE - 1];
+    for (int axis = 0; axis < 2; axis++) {
+        for (int offset = 1 - MIN_MATCH_SIZE; offset < MIN_MATCH_SIZE; offset++) {
+            const int aroundRow = axis == 0 ? row + offset : row;
+            const int aroundColumn = axis == 0 ? column : column + offset;
+            const bool isOnGrid = aroundRow >= 0 && aroundRow < ROWS && aroundColumn >= 0 && aroundColumn < COLUMNS;
+            around [offset + MIN_MATCH_SIZE - 1] = offset == 0 ? color
+                : (!isOnGrid || (aroundRow == otherRow && aroundColumn == otherColumn)) ? GameState::NotAColor
+                : gameState.GetColorAt (aroundRow, aroundColumn);
+        }
+        int run = 0;
+        for (int index = 0; index < 2 * MIN_MATCH_SIZE - 1; index++) {
+            run = around [index] == color ? run + 1 : 0;
+            if (run == MIN_MATCH_SIZE) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+/*!
+ * Looks for a swap of neighbours that makes a match, the first one found from a random tile on.
+ * @return false if there is none.
+ */
+static bool FindMatchingSwap (const GameState& gameState, GameRandom& random, int& row, int& column, bool& isVertical)
+{
+    const int start = random.NextInt (ROWS * COLUMNS);
+    for (int tile = 0; tile < ROWS * COLUMNS; tile++) {
+        row = (start + tile) / COLUMNS % ROWS;
+        column = (start + tile) % COLUMNS;
+        for (int direction = 0; direction < 2; direction++) {
+            isVertical = direction == 1;
+            const int otherRow = isVertical ? row + 1 : row;
+            const int otherColumn = isVertical ? column : column + 1;
+            if (otherRow >= ROWS || otherColumn >= COLUMNS) {
+                continue;
+            }
+            const GameState::Color color = gameState.GetColorAt (row, column);
+            const GameState::Color otherColor = gameState.GetColorAt (otherRow, otherColumn);
+            if (color != otherColor && (IsMatchWith (gameState, otherRow, otherColumn, color, row, column)
+                                        || IsMatchWith (gameState, row, column, otherColor, otherRow, otherColumn))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+/*!
+ * Looks for a swap of resting neighbours that makes no match, the first one found from a random tile on.
+ * @return false if there is none.
+ */
+static bool FindNonMatchingSwap (const GameState& gameState, GameRandom& random, int& row, int& column, bool& isVertical)
+{
+    const int start = random.NextInt (ROWS * COLUMNS);
+    for (int tile = 0; tile < ROWS * COLUMNS; tile++) {
+        row = (start + tile) / COLUMNS % ROWS;
+        column = (start + tile) % COLUMNS;
+        for (int direction = 0; direction < 2; direction++) {
+            isVertical = direction == 1;
+            const int otherRow = isVertical ? row + 1 : row;
+            const int otherColumn = isVertical ? column : column + 1;
+            if (otherRow >= ROWS || otherColumn >= COLUMNS
+                || !gameState.IsTileResting (row, column) || !gameState.IsTileResting (otherRow, otherColumn)) {
+                continue;
+            }
+            const GameState::Color color = gameState.GetColorAt (row, column);
+            const GameState::Color otherColor = gameState.GetColorAt (otherRow, otherColumn);
+            if (color != otherColor && !IsMatchWith (gameState, otherRow, otherColumn, color, row, column)
+                && !IsMatchWith (gameState, row, column, otherColor, otherRow, otherColumn)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+struct ScriptedEvent {
+    Uint32 mGameTime;
+    SDL_Event mEvent;
+};
+
+
+/*!
+ * Plays a game with a player dragging a matching pair every MOVE_INTERVAL_MILIS, as seen on the board at the time.
+ * @param isBuffered false to drop the input while the board is busy, as the game did.
+ */
+static void PlayFastPlayer (bool isBuffered)
+{
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, 3600, 99);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    GameRandom random (5);
+    std::vector<ScriptedEvent> events;
+    size_t nextEvent = 0;
+    Uint32 nextMoveTime = MOVE_INTERVAL_MILIS;
+    int moves = 0;
+    int swaps = 0;
+    int matches = 0;
+    int droppedEvents = 0;
+    int lastSwappingTileCount = 0;
+    int lastDestroyingTileCount = 0;
+    while (gameState.GetGameTime() < GAME_MILIS) {
+        // the player's next drag
+        if (gameState.GetGameTime() >= nextMoveTime) {
+            nextMoveTime += MOVE_INTERVAL_MILIS;
+            int row = 0;
+            int column = 0;
+            bool isVertical = false;
+            if (!FindMatchingSwap (gameState, random, row, column, isVertical)) {
+                row = random.NextInt (ROWS - 1);
+                column = random.NextInt (COLUMNS);
+                isVertical = true;
+            }
+            ScriptedEvent event;
+            event.mGameTime = gameState.GetGameTime();
+            event.mEvent.type = SDL_MOUSEBUTTONDOWN;
+            GetTileScreenLocation (row, column, event.mEvent.button.x, event.mEvent.button.y);
+            events.push_back (event);
+            event.mGameTime += DRAG_MILIS / 2;
+            event.mEvent.type = SDL_MOUSEMOTION;
+            GetTileScreenLocation (isVertical ? row + 1 : row, isVertical ? column : column + 1, event.mEvent.motion.x, event.mEvent.motion.y);
+            events.push_back (event);
+            event.mGameTime += DRAG_MILIS / 2;
+            event.mEvent.type = SDL_MOUSEBUTTONUP;
+            GetTileScreenLocation (isVertical ? row + 1 : row, isVertical ? column : column + 1, event.mEvent.button.x, event.mEvent.button.y);
+            events.push_back (event);
+            moves++;
+        }
+        for (; nextEvent < events.size() && events [nextEvent].mGameTime <= gameState.GetGameTime(); nextEvent++) {
+            const bool isBusy = gameStateLogic.IsGridCheckPending() || gameState.GetAnimationState() != GameState::Idle;
+            if (isBusy && !isBuffered) {
+                droppedEvents++;
+                continue;
+            }
+            gameStateLogic.Input (events [nextEvent].mEvent, gameState);
+        }
+        gameStateLogic.Update (STEP_MILIS, gameState);
+        // a swap or a match starts more tiles moving that way, swap backs follow a swap without a rise
+        swaps += gameState.GetMovingTileCount (GameState::Swapping) > lastSwappingTileCount ? 1 : 0;
+        matches += gameState.GetMovingTileCount (GameState::Destroying) > lastDestroyingTileCount ? 1 : 0;
+        lastSwappingTileCount = gameState.GetMovingTileCount (GameState::Swapping);
+        lastDestroyingTileCount = gameState.GetMovingTileCount (GameState::Destroying);
+    }
+    printf ("%-28s %d moves, %d swaps started, %d matched, %d events dropped, score %d\n",
+            isBuffered ? "buffered while busy:" : "dropped while busy (before):", moves, swaps, matches, droppedEvents, gameState.GetScore());
+}
+
+
+/*!
+ * Plays a game with a player swapping a pair that makes no match every STALL_INTERVAL_MILIS, so tiles always move.
+ * @return the number of errors found, 1 if the game does not end once its gameplay time is up.
+ */
+static int PlayStallingPlayer ()
+{
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, STALL_GAME_SECONDS, 99);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    GameRandom random (7);
+    Uint32 nextMoveTime = STALL_INTERVAL_MILIS;
+    int moves = 0;
+    // a second of slack for the steps and for the falls that fill the board at the start
+    const Uint32 deadline = STALL_GAME_SECONDS * 1000 + 1000;
+    while (gameState.GetAnimationState() != GameState::GameOver && gameState.GetGameTime() < 10 * deadline) {
+        int row = 0;
+        int column = 0;
+        bool isVertical = false;
+        if (gameState.GetGameTime() >= nextMoveTime && FindNonMatchingSwap (gameState, random, row, column, isVertical)) {
+            nextMoveTime += STALL_INTERVAL_MILIS;
+            SDL_Event event;
+            event.type = SDL_MOUSEBUTTONDOWN;
+            GetTileScreenLocation (row, column, event.button.x, event.button.y);
+            gameStateLogic.Input (event, gameState);
+            event.type = SDL_MOUSEMOTION;
+            GetTileScreenLocation (isVertical ? row + 1 : row, isVertical ? column : column + 1, event.motion.x, event.motion.y);
+            gameStateLogic.Input (event, gameState);
+            event.type = SDL_MOUSEBUTTONUP;
+            GetTileScreenLocation (isVertical ? row + 1 : row, isVertical ? column : column + 1, event.button.x, event.button.y);
+            gameStateLogic.Input (event, gameState);
+            moves++;
+        }
+        gameStateLogic.Update (STEP_MILIS, gameState);
+    }
+    const bool isOver = gameState.GetAnimationState() == GameState::GameOver;
+    const int errors = isOver && gameState.GetGameTime() <= deadline ? 0 : 1;
+    printf ("a player swapping without a match every %u ms: %d moves, game %s after %u ms of %d s gameplay, %d errors\n",
+            STALL_INTERVAL_MILIS, moves, isOver ? "over" : "still running", gameState.GetGameTime(), STALL_GAME_SECONDS, errors);
+    return errors;
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const int frames = argc > 1 ? atoi (argv [1]) : 200000;
+    if (frames < 1) {
+        printf ("usage: InputQueueBenchmark [frames]\n");
+        return EXIT_FAILURE;
+    }
+    int errors = MeasureQueue (frames);
+    printf ("a player dragging every %u ms for %u s:\n", MOVE_INTERVAL_MILIS, GAME_MILIS / 1000);
+    PlayFastPlayer (false);
+    PlayFastPlayer (true);
+    errors += PlayStallingPlayer();
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <GameState.h>
+#include <GameStateBatch.h>
+#include <GameRandom.h>
+#include <JobSystem.h>
+
+
+/*!
+ * Measures how JobSystem scales with its worker count on tiny jobs, on dependency graphs and on GameStateBatch stepping,
+ * then prints the per worker counters of the largest configuration.
+ */
+
+
+static const int TINY_JOBS = 1 << 16;
+static const int GRAPH_ROUNDS = 4096;
+static const int GRAPH_WIDTH = 4;
+static const int BATCH_BOARDS = 16384;
+static const int BATCH_STEPS = 32;
+
+
+static double SecondsSince (std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+
+/*!
+ * A little arithmetic standing in for real work.
+ */
+static void SpinWork (const void* context, int begin, int end)
+{
+    std::atomic<Uint32>* sink = static_cast<std::atomic<Uint32>*>(const_cast<void*>(context));
+    Uint32 state = GameRandom::SeedToState (begin);
+    for (int i = begin; i < end; i++) {
+        for (int k = 0; k < 64; k++) {
+            state = GameRandom::Step (state);
+        }
+    }
+    sink->fetch_add (state, std::memory_order_relaxed);
+}
+
+
+/*!
+ * Runs many single index jobs through ParallelFor.
+ * @return jobs per second.
+ */
+static double RunTinyJobs (JobSystem& jobSystem)
+{
+    std::atomic<Uint32> sink (0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    jobSystem.ParallelFor (TINY_JOBS, 1, &SpinWork, &sink);
+    return TINY_JOBS / SecondsSince (start);
+}
+
+
+/*!
+ * Runs rounds of a fork-join graph: one job, GRAPH_WIDTH jobs depending on it, one job depending on all of them.
+ * @return graphs per second.
+ */
+static double RunDependencyGraphs (JobSystem& jobSystem)
+{
+    std::atomic<Uint32> sink (0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int round = 0; round < GRAPH_ROUNDS; round++) {
+        JobSystem::Job* first = jobSystem.CreateJob (&SpinWork, &sink, 0, 16);
+        JobSystem::Job* last = jobSystem.CreateJob (&SpinWork, &sink, 0, 16);
+        JobSystem::Job* middle [GRAPH_WIDTH];
+        for (int i = 0; i < GRAPH_WIDTH; i++) {
+            middle [i] = jobSystem.CreateJob (&SpinWork, &sink, i * 16, i * 16 + 16);
+            jobSystem.AddDependency (middle [i], first);
+            jobSystem.AddDependency (last, middle [i]);
+        }
+        jobSystem.Submit (last);
+        for (int i = 0; i < GRAPH_WIDTH; i++) {
+            jobSystem.Submit (middle [i]);
+        }
+        jobSystem.Submit (first);
+        jobSystem.Wait (last);
+    }
+    return GRAPH_ROUNDS / SecondsSince (start);
+}
+
+
+/*!
+ * Steps a GameStateBatch with its blocks spread over the workers.
+ * @return board moves per second.
+ */
+static double RunBatch (JobSystem& jobSystem)
+{
+    GameStateBatch gameStateBatch (BATCH_BOARDS, 8, 8, 3, GameState::sNUMBER_OF_TILE_COLORS, BATCH_STEPS);
+    gameStateBatch.Reset (1);
+    std::vector<int> moves (BATCH_BOARDS);
+    GameRandom random (1);
+    double seconds = 0.0;
+    for (int step = 0; step < BATCH_STEPS; step++) {
+        for (int board = 0; board < BATCH_BOARDS; board++) {
+            bool isVertical = random.NextInt (2) == 1;
+            moves [board] = GameStateBatch::EncodeMove (random.NextInt (isVertical ? 7 : 8), random.NextInt (isVertical ? 8 : 7), isVertical);
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        gameStateBatch.Step (moves.data(), jobSystem);
+        seconds += SecondsSince (start);
+    }
+    return static_cast<double>(BATCH_BOARDS) * BATCH_STEPS / seconds;
+}
+
+
+int main (int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    GameState::SetIsLoggingEnabled (false);
+
+    int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardwareThreads < 1) {
+        hardwareThreads = 1;
+    }
+    std::vector<int> workerCounts;
+    for (int workers = 1; workers < hardwareThreads; workers *= 2) {
+        workerCounts.push_back (workers);
+    }
+    workerCounts.push_back (hardwareThreads);
+
+    double baseline [3] = { 0.0, 0.0, 0.0 };
+    printf ("%8s %14s %8s %14s %8s %14s %8s\n", "workers", "tiny jobs/s", "scale", "graphs/s", "scale", "batch mv/s", "scale");
+    for (size_t i = 0; i < workerCounts.size(); i++) {
+        JobSystem jobSystem (workerCounts [i]);
+        double results [3];
+        results [0] = RunTinyJobs (jobSystem);
+        results [1] = RunDependencyGraphs (jobSystem);
+        results [2] = RunBatch (jobSystem);
+        if (i == 0) {
+            baseline [0] = results [0];
+            baseline [1] = results [1];
+            baseline [2] = results [2];
+        }
+        printf ("%8d %14.0f %7.2fx %14.0f %7.2fx %14.0f %7.2fx\n", workerCounts [i],
+                results [0], results [0] / baseline [0], results [1], results [1] / baseline [1], results [2], results [2] / baseline [2]);
+        if (i + 1 == workerCounts.size()) {
+            jobSystem.PrintWorkerStats();
+        }
+    }
+    return EXIT_SUCCESS;
+}
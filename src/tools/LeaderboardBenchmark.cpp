@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <GameRandom.h>
+#include <Histogram.h>
+#include <Leaderboard.h>
+
+
+/*!
+ * Submits scores of several rules configurations from many threads, spread over two weeks, and prints the inserts
+ * per second and the scores per fdatasync, as fast as possible and at a game server's pace. Then measures top-100 queries, checks every all-time list against a
+ * sort of all submitted scores, appends a torn record to the log and checks that reopening it cuts the record
+ * off and rebuilds the same lists, printing the rebuild time.
+ *
+ * usage: LeaderboardBenchmark [scores] [threads] [commit interval miliseconds] [log file]
+ */
+
+
+static const int DEFAULT_SCORES = 500000;
+static const int DEFAULT_THREADS = 8;
+static const int DEFAULT_COMMIT_INTERVAL_MILIS = 10;
+static const int RULES_COUNT = 6;
+static const int DAYS = 14;
+static const int QUERIES = 100000;
+static const int PACED_SCORES_PER_SECOND = 50000;
+static const int PACED_SECONDS = 2;
+// 2026-01-05, a Monday
+static const Uint64 START_TIME = 1767571200000ULL;
+
+
+static Uint32 GetRules (int index)
+{
+    static const int SIDES [RULES_COUNT] = { 6, 8, 10, 6, 8, 10 };
+    return Leaderboard::MakeRules (SIDES [index], SIDES [index], index < 3 ? 3 : 4, 60);
+}
+
+
+/*!
+ * Collects the all-time top lists of the log.
+ */
+static std::vector<Leaderboard::Record> GetAllTopLists (const Leaderboard& leaderboard)
+{
+    std::vector<Leaderboard::Record> records (RULES_COUNT * Leaderboard::TOP_COUNT);
+    for (int rules = 0; rules < RULES_COUNT; rules++) {
+        const int count = leaderboard.GetTop (GetRules (rules), Leaderboard::AllTime, 0, Leaderboard::TOP_COUNT, &records [rules * Leaderboard::TOP_COUNT]);
+        for (int index = count; index < Leaderboard::TOP_COUNT; index++) {
+            records [rules * Leaderboard::TOP_COUNT + index] = Leaderboard::Record();
+        }
+    }
+    return records;
+}
+
+
+static bool IsSameRecord (const Leaderboard::Record& recordA, const Leaderboard::Record& recordB)
+{
+    return recordA.mScore == recordB.mScore && recordA.mTime == recordB.mTime && recordA.mPlayer == recordB.mPlayer && recordA.mSeed == recordB.mSeed;
+}
+
+
+/*!
+ * Main function of the leaderboard benchmark.
+ * @param argc up to 4 arguments: the number of scores (default DEFAULT_SCORES), submitting threads (default DEFAULT_THREADS),
+ *  the commit interval (default DEFAULT_COMMIT_INTERVAL_MILIS) and the log file (default 'leaderboard_benchmark.tms', removed at the end).
+ * @return returns 0 if the index and the recovered log were correct.
+ */
+int main (int argc, char* argv[])
+{
+    const int scoreCount = argc > 1 ? atoi (argv [1]) : DEFAULT_SCORES;
+    const int threadCount = argc > 2 ? atoi (argv [2]) : DEFAULT_THREADS;
+    const int commitIntervalMilis = argc > 3 ? atoi (argv [3]) : DEFAULT_COMMIT_INTERVAL_MILIS;
+    const char* filePath = argc > 4 ? argv [4] : "leaderboard_benchmark.tms";
+    if (scoreCount < 1 || threadCount < 1 || commitIntervalMilis < 0) {
+        printf ("usage: LeaderboardBenchmark [scores] [threads] [commit interval miliseconds] [log file]\n");
+        return EXIT_FAILURE;
+    }
+    unlink (filePath);
+
+    Leaderboard leaderboard;
+    if (!leaderboard.Open (filePath, static_cast<Uint32>(commitIntervalMilis))) {
+        return EXIT_FAILURE;
+    }
+
+    // every thread submits its share, the last score of a thread is the one to wait for
+    std::vector<std::vector<Leaderboard::Record>> submitted (threadCount);
+    std::vector<Uint64> lastSequences (threadCount, 0);
+    std::vector<std::thread> threads;
+    std::atomic<int> failedWaitCount (0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int thread = 0; thread < threadCount; thread++) {
+        threads.push_back (std::thread ([&, thread] {
+            GameRandom random (thread + 1);
+            const int count = scoreCount / threadCount + (thread < scoreCount % threadCount ? 1 : 0);
+            submitted [thread].reserve (count);
+            for (int index = 0; index < count; index++) {
+                Leaderboard::Record record;
+                record.mRules = GetRules (random.NextInt (RULES_COUNT));
+                record.mScore = random.NextInt (200) + random.NextInt (200);
+                record.mSeed = random.Next();
+                record.mTime = START_TIME + random.NextInt (DAYS) * Leaderboard::DAY_MILIS + random.NextInt (1000000);
+                record.mPlayer = (static_cast<Uint64>(thread) << 32) | index;
+                lastSequences [thread] = leaderboard.Submit (record.mRules, record.mScore, record.mSeed, record.mPlayer, record.mTime);
+                submitted [thread].push_back (record);
+            }
+            failedWaitCount += leaderboard.WaitForCommit (lastSequences [thread]) ? 0 : 1;
+        }));
+    }
+    for (size_t thread = 0; thread < threads.size(); thread++) {
+        threads [thread].join();
+    }
+    const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    printf ("%d scores from %d threads in %.2f s: %.0f durable inserts/s, %llu fdatasyncs (%.0f scores per sync)\n", scoreCount, threadCount,
+            seconds, scoreCount / seconds, static_cast<unsigned long long>(leaderboard.GetCommitCount()),
+            static_cast<double>(scoreCount) / leaderboard.GetCommitCount());
+
+    // at a steady pace, as from a game server
+    const Uint64 startCommitCount = leaderboard.GetCommitCount();
+    Uint64 lastSequence = 0;
+    start = std::chrono::steady_clock::now();
+    for (int index = 0; index < PACED_SCORES_PER_SECOND * PACED_SECONDS; index++) {
+        std::this_thread::sleep_until (start + std::chrono::microseconds (static_cast<Uint64>(index) * 1000000 / PACED_SCORES_PER_SECOND));
+        lastSequence = leaderboard.Submit (GetRules (0), -1, 0, 0, START_TIME - Leaderboard::DAY_MILIS * 100);
+    }
+    failedWaitCount += leaderboard.WaitForCommit (lastSequence) ? 0 : 1;
+    const Uint64 pacedCommitCount = leaderboard.GetCommitCount() - startCommitCount;
+    printf ("%d scores/s for %d s: %.0f fdatasyncs/s, %.0f scores per sync\n", PACED_SCORES_PER_SECOND, PACED_SECONDS,
+            static_cast<double>(pacedCommitCount) / PACED_SECONDS, static_cast<double>(PACED_SCORES_PER_SECOND * PACED_SECONDS) / pacedCommitCount);
+
+    // queries, every window of every rules configuration
+    Histogram queryMicroseconds (1000, 0.01);
+    Leaderboard::Record top [Leaderboard::TOP_COUNT];
+    GameRandom random (12345);
+    int returnedCount = 0;
+    for (int query = 0; query < QUERIES; query++) {
+        const Uint32 rules = GetRules (random.NextInt (RULES_COUNT));
+        const Leaderboard::Window window = static_cast<Leaderboard::Window>(random.NextInt (Leaderboard::WINDOW_COUNT));
+        const Uint64 time = START_TIME + random.NextInt (DAYS) * Leaderboard::DAY_MILIS;
+        std::chrono::steady_clock::time_point queryStart = std::chrono::steady_clock::now();
+        returnedCount += leaderboard.GetTop (rules, window, time, Leaderboard::TOP_COUNT, top);
+        queryMicroseconds.Add (std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - queryStart).count());
+    }
+    printf ("top-%d queries: %.0f records on average, mean %.2f us, p99 %.2f us, max %.2f us\n", Leaderboard::TOP_COUNT,
+            static_cast<double>(returnedCount) / QUERIES, queryMicroseconds.GetMean(), queryMicroseconds.GetPercentile (99.0), queryMicroseconds.GetMaximum());
+
+    // the all-time lists against a full sort of everything submitted
+    int wrongCount = 0;
+    const std::vector<Leaderboard::Record> topLists = GetAllTopLists (leaderboard);
+    for (int rules = 0; rules < RULES_COUNT; rules++) {
+        std::vector<Leaderboard::Record> expected;
+        for (int thread = 0; thread < threadCount; thread++) {
+            for (size_t index = 0; index < submitted [thread].size(); index++) {
+                if (submitted [thread][index].mRules == GetRules (rules)) {
+                    expected.push_back (submitted [thread][index]);
+                }
+            }
+        }
+        std::stable_sort (expected.begin(), expected.end(), [] (const Leaderboard::Record& recordA, const Leaderboard::Record& recordB) {
+            return recordA.mScore > recordB.mScore || (recordA.mScore == recordB.mScore && recordA.mTime < recordB.mTime);
+        });
+        for (int index = 0; index < Leaderboard::TOP_COUNT && index < static_cast<int>(expected.size()); index++) {
+            // equal score and time may rank either way
+            const Leaderboard::Record& record = topLists [rules * Leaderboard::TOP_COUNT + index];
+            if (record.mScore != expected [index].mScore || record.mTime != expected [index].mTime) {
+                wrongCount++;
+            }
+        }
+    }
+    printf ("all-time lists: %d wrong entries\n", wrongCount);
+    leaderboard.Close();
+
+    // a crash in the middle of a write
+    FILE* file = fopen (filePath, "ab");
+    const Uint8 tornRecord [sizeof (Leaderboard::Record) / 2] = { 1, 2, 3 };
+    if (file == NULL || fwrite (tornRecord, sizeof (tornRecord), 1, file) != 1) {
+        printf ("ERROR: LeaderboardBenchmark cannot append to %s.\n", filePath);
+        return EXIT_FAILURE;
+    }
+    fclose (file);
+    start = std::chrono::steady_clock::now();
+    if (!leaderboard.Open (filePath)) {
+        return EXIT_FAILURE;
+    }
+    const double rebuildSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    const std::vector<Leaderboard::Record> recoveredTopLists = GetAllTopLists (leaderboard);
+    int differentCount = 0;
+    for (size_t index = 0; index < topLists.size(); index++) {
+        differentCount += IsSameRecord (topLists [index], recoveredTopLists [index]) ? 0 : 1;
+    }
+    printf ("reopened %llu scores in %.1f ms (%.1f M scores/s), %llu torn bytes cut off, %d entries differ after the rebuild\n",
+            static_cast<unsigned long long>(leaderboard.GetRecordCount()), rebuildSeconds * 1000.0,
+            leaderboard.GetRecordCount() / rebuildSeconds / 1e6, static_cast<unsigned long long>(leaderboard.GetTruncatedBytes()), differentCount);
+    if (failedWaitCount > 0) {
+        printf ("ERROR: %d waits found the log failed.\n", failedWaitCount.load());
+    }
+    const bool isCorrect = failedWaitCount == 0 && wrongCount == 0 && differentCount == 0 && leaderboard.GetRecordCount() == static_cast<Uint64>(scoreCount + PACED_SCORES_PER_SECOND * PACED_SECONDS) &&
+        leaderboard.GetTruncatedBytes() == sizeof (tornRecord);
+    leaderboard.Close();
+    if (argc <= 4) {
+        unlink (filePath);
+    }
+    return isCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}				/* ----------  end of function main  ---------- */
@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <GameBoard.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <JobSystem.h>
+#include <MctsBot.h>
+
+
+/*!
+ * Runs MctsBot headless: measures playouts per second from 1 worker to every hardware thread,
+ * then plays games with the bot, a greedy player and a random player on the same boards and compares their scores.
+ */
+
+
+static const int SCALING_PLAYOUTS = 20000;
+static const int GAMES = 4;
+static const int MOVES_PER_GAME = 20;
+static const int PLAYOUTS_PER_MOVE = 2000;
+
+
+enum Player {
+    RandomPlayer = 0,
+    GreedyPlayer = 1,
+    BotPlayer = 2
+};
+
+
+/*!
+ * Picks the move of a player.
+ * @return the move, -1 if no swap makes a match.
+ */
+static int ChooseMove (Player player, const GameBoard& board, MctsBot& mctsBot, GameRandom& random, double& playoutsPerSecond)
+{
+    int moves [GameBoard::MAX_MOVES];
+    const int moveCount = board.GetMatchingMoves (moves);
+    if (moveCount == 0) {
+        return -1;
+    }
+    if (player == RandomPlayer) {
+        return moves [random.NextInt (moveCount)];
+    }
+    if (player == GreedyPlayer) {
+        int bestMove = moves [0];
+        int bestPoints = -1;
+        for (int i = 0; i < moveCount; i++) {
+            GameBoard nextBoard = board;
+            const int points = nextBoard.ApplyMove (moves [i]);
+            if (points > bestPoints) {
+                bestPoints = points;
+                bestMove = moves [i];
+            }
+        }
+        return bestMove;
+    }
+    MctsBot::SearchResult result = mctsBot.Search (board, PLAYOUTS_PER_MOVE, 0, random.Next());
+    playoutsPerSecond += result.mPlayoutsPerSecond;
+    return result.mMove;
+}
+
+
+int main (int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    GameState::SetIsLoggingEnabled (false);
+
+    int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardwareThreads < 1) {
+        hardwareThreads = 1;
+    }
+    std::vector<int> workerCounts;
+    for (int workers = 1; workers < hardwareThreads; workers *= 2) {
+        workerCounts.push_back (workers);
+    }
+    workerCounts.push_back (hardwareThreads);
+
+    GameBoard startBoard (8, 8, 3, GameState::sNUMBER_OF_TILE_COLORS);
+    startBoard.Reset (1);
+    double baseline = 0.0;
+    printf ("%8s %12s %8s %10s %14s\n", "workers", "playouts/s", "scale", "nodes", "best move");
+    for (size_t i = 0; i < workerCounts.size(); i++) {
+        JobSystem jobSystem (workerCounts [i]);
+        MctsBot mctsBot (jobSystem);
+        MctsBot::SearchResult result = mctsBot.Search (startBoard, SCALING_PLAYOUTS, 0, 1);
+        if (i == 0) {
+            baseline = result.mPlayoutsPerSecond;
+        }
+        int tileARow, tileAColumn, tileBRow, tileBColumn;
+        GameBoard::DecodeMove (result.mMove, tileARow, tileAColumn, tileBRow, tileBColumn);
+        printf ("%8d %12.0f %7.2fx %10d   (%d,%d)-(%d,%d)\n", workerCounts [i], result.mPlayoutsPerSecond,
+                result.mPlayoutsPerSecond / baseline, result.mNodes, tileARow, tileAColumn, tileBRow, tileBColumn);
+    }
+
+    JobSystem jobSystem (hardwareThreads);
+    MctsBot mctsBot (jobSystem);
+    const char* playerNames [3] = { "random", "greedy", "mcts" };
+    printf ("\n%d games of %d moves, the bot runs %d playouts per move:\n", GAMES, MOVES_PER_GAME, PLAYOUTS_PER_MOVE);
+    for (int player = RandomPlayer; player <= BotPlayer; player++) {
+        GameRandom random (7);
+        double playoutsPerSecond = 0.0;
+        int searches = 0;
+        int totalScore = 0;
+        for (int game = 0; game < GAMES; game++) {
+            GameBoard board (8, 8, 3, GameState::sNUMBER_OF_TILE_COLORS);
+            board.Reset (100 + game);
+            for (int moveIndex = 0; moveIndex < MOVES_PER_GAME; moveIndex++) {
+                const int move = ChooseMove (static_cast<Player>(player), board, mctsBot, random, playoutsPerSecond);
+                if (move < 0) {
+                    break;
+                }
+                searches += player == BotPlayer ? 1 : 0;
+                board.ApplyMove (move);
+            }
+            totalScore += board.GetScore();
+        }
+        printf ("%8s: average score %7.1f", playerNames [player], static_cast<double>(totalScore) / GAMES);
+        if (searches > 0) {
+            printf (", %.0f playouts/s", playoutsPerSecond / searches);
+        }
+        printf ("\n");
+    }
+    return EXIT_SUCCESS;
+}
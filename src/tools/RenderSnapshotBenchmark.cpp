@@ -0,0 +1,253 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <FixedTimestep.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <Histogram.h>
+#include <RenderSnapshot.h>
+#include <TripleBuffer.h>
+
+
+/*!
+ * Measures handing the game from a simulation thread to a render thread through RenderSnapshots in a TripleBuffer,
+ * the way the game does.
+ *
+ * First the simulation captures and publishes snapshots as fast as it can while a reader thread keeps acquiring them,
+ * checking every snapshot it gets against a hash the writer recorded for it, so a snapshot read while it was being
+ * written would be caught. Then a game loop with 8 ms steps and a 60 Hz renderer that stalls for a while every second
+ * runs in real time, once with simulation and rendering on one thread, as the game did, and once on two. It prints
+ * how late the steps run (input waits for the next step) and how old the snapshots drawn are.
+ *
+ * usage: RenderSnapshotBenchmark [seconds] [render stall miliseconds]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const Uint32 STEP_MILIS = 8;             ///< TestGame::SIMULATION_STEP_MILIS
+static const int MAX_CATCH_UP_STEPS = 25;       ///< TestGame::MAX_CATCH_UP_STEPS
+static const int SWAP_ONE_IN = 20;              ///< chance per resting step that the bot swaps
+static const int PUBLISHES = 1000000;
+static const Uint64 FRAME_NANOSECONDS = 1000000000 / 60;
+static const int FRAMES_PER_STALL = 60;
+static const Uint64 NANOSECONDS_PER_SECOND = 1000000000;
+
+
+static std::chrono::steady_clock::time_point sStart = std::chrono::steady_clock::now();
+
+
+/// the counter of the tool, nanoseconds since it started
+static Uint64 GetCounter ()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - sStart).count();
+}
+
+
+static void SleepUntil (Uint64 counter)
+{
+    const Uint64 now = GetCounter();
+    if (counter > now) {
+        std::this_thread::sleep_for (std::chrono::nanoseconds (counter - now));
+    }
+}
+
+
+/*!
+ * A game played by a bot that swaps random pairs.
+ */
+struct BotGame {
+    GameState mGameState;
+    GameState mPreviousGameState;
+    GameStateLogic mGameStateLogic;
+    GameRandom mRandom;
+
+    BotGame () :
+        mGameState (ROWS, COLUMNS, MIN_MATCH_SIZE, 3600, 777),
+        mPreviousGameState (ROWS, COLUMNS, MIN_MATCH_SIZE, 3600, 777),
+        mRandom (1)
+    {
+        mGameState.AttachGameStateGridChangeObserver (&mGameStateLogic);
+    }
+
+    void Step ()
+    {
+        if (mGameState.GetAnimationState() == GameState::Idle && !mGameStateLogic.IsGridCheckPending() && mRandom.NextInt (SWAP_ONE_IN) == 0) {
+            const bool isVertical = mRandom.NextInt (2) == 1;
+            const int row = mRandom.NextInt (isVertical ? ROWS - 1 : ROWS);
+            const int column = mRandom.NextInt (isVertical ? COLUMNS : COLUMNS - 1);
+            mGameStateLogic.RequestSwap (row, column, isVertical ? row + 1 : row, isVertical ? column : column + 1, mGameState);
+        }
+        mPreviousGameState.CopyStateFrom (mGameState);
+        mGameStateLogic.Update (STEP_MILIS, mGameState);
+    }
+};
+
+
+static Uint64 HashSnapshot (const RenderSnapshot& snapshot, std::vector<float>& tweenValues, std::vector<RenderSnapshot::TileAnimation>& tileAnimations)
+{
+    Uint64 hash = 14695981039346656037ULL;
+    const std::vector<RenderSnapshot::Tile>& tiles = snapshot.GetTiles();
+    snapshot.AnimateTiles (1.0f, tweenValues, tileAnimations);
+    for (size_t index = 0; index < tiles.size(); index++) {
+        const RenderSnapshot::Tile& tile = tiles [index];
+        hash = (hash ^ tile.mColor) * 1099511628211ULL;
+        hash = (hash ^ static_cast<Uint64>((tile.mX + tileAnimations [index].mOffsetX) * 1e6f)) * 1099511628211ULL;
+        hash = (hash ^ static_cast<Uint64>((tile.mY + tileAnimations [index].mOffsetY) * 1e6f)) * 1099511628211ULL;
+        hash = (hash ^ static_cast<Uint64>(tileAnimations [index].mDestruction * 1e6f)) * 1099511628211ULL;
+    }
+    hash = (hash ^ static_cast<Uint64>(snapshot.GetScore())) * 1099511628211ULL;
+    return (hash ^ tiles.size()) * 1099511628211ULL;
+}
+
+
+/*!
+ * Publishes PUBLISHES snapshots as fast as possible while another thread reads them.
+ * @return the number of snapshots read that did not match what was published.
+ */
+static int MeasureThroughput ()
+{
+    BotGame game;
+    TripleBuffer<RenderSnapshot> snapshots;
+    std::vector<Uint64> hashes (PUBLISHES, 0);   ///< by publish, written before the snapshot is published
+    std::atomic<bool> isWriting (true);
+    Uint64 acquires = 0;
+    Uint64 polls = 0;
+    int mismatches = 0;
+    std::thread reader ([&] () {
+        std::vector<float> tweenValues;
+        std::vector<RenderSnapshot::TileAnimation> tileAnimations;
+        while (isWriting.load (std::memory_order_relaxed)) {
+            polls++;
+            if (!snapshots.Acquire()) {
+                continue;
+            }
+            acquires++;
+            const RenderSnapshot& snapshot = snapshots.GetReadBuffer();
+            mismatches += HashSnapshot (snapshot, tweenValues, tileAnimations) == hashes [snapshot.GetStepCounter()] ? 0 : 1;
+        }
+    });
+
+    // the step counter of a snapshot is the number of its publish
+    std::vector<float> tweenValues;
+    std::vector<RenderSnapshot::TileAnimation> tileAnimations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int publish = 0; publish < PUBLISHES; publish++) {
+        game.Step();
+        RenderSnapshot& snapshot = snapshots.GetWriteBuffer();
+        snapshot.Capture (game.mGameState, game.mPreviousGameState, publish, 1);
+        hashes [publish] = HashSnapshot (snapshot, tweenValues, tileAnimations);
+        snapshots.Publish();
+    }
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    isWriting = false;
+    reader.join();
+    printf ("throughput: %d steps captured and published in %.2f s, %.0f/s (%.2f us each), %llu acquired of %llu polls, %d torn\n",
+            PUBLISHES, seconds.count(), PUBLISHES / seconds.count(), 1e6 * seconds.count() / PUBLISHES,
+            static_cast<unsigned long long>(acquires), static_cast<unsigned long long>(polls), mismatches);
+    return mismatches;
+}
+
+
+/*!
+ * Plays the game steps due at counter and records how late each one runs.
+ * @return the number of steps played.
+ */
+static int PlayDueSteps (BotGame& game, FixedTimestep& fixedTimestep, Histogram& stepLateness)
+{
+    const Uint64 counter = GetCounter();
+    const int stepCount = fixedTimestep.Advance (counter);
+    for (int step = 0; step < stepCount; step++) {
+        const Uint64 dueCounter = fixedTimestep.GetStepCounter() - (stepCount - 1 - step) * fixedTimestep.GetStepCounterTicks();
+        stepLateness.Add ((counter - dueCounter) / 1e6);
+        game.Step();
+    }
+    return stepCount;
+}
+
+
+/// a frame of the renderer: 60 Hz, with a stall every FRAMES_PER_STALL frames
+static void Render (Uint64 frame, Uint64 frameStartCounter, Uint32 stallMilis)
+{
+    SleepUntil (frameStartCounter + FRAME_NANOSECONDS + (frame % FRAMES_PER_STALL == FRAMES_PER_STALL - 1 ? stallMilis * 1000000ULL : 0));
+}
+
+
+static void PrintLatencies (const char* name, const Histogram& histogram)
+{
+    printf ("  %-26s p50 %6.2f ms, p99 %6.2f ms, max %6.2f ms\n", name, histogram.GetPercentile (50), histogram.GetPercentile (99), histogram.GetMaximum());
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const int seconds = argc > 1 ? atoi (argv [1]) : 5;
+    const Uint32 stallMilis = argc > 2 ? static_cast<Uint32>(atoi (argv [2])) : 100;
+    if (seconds < 1) {
+        printf ("usage: RenderSnapshotBenchmark [seconds] [render stall miliseconds]\n");
+        return EXIT_FAILURE;
+    }
+    int failures = MeasureThroughput();
+
+    // one thread: a stalled frame delays the steps behind it
+    printf ("%d s of %u ms steps, rendering at 60 Hz with a %u ms stall every %d frames\n", seconds, STEP_MILIS, stallMilis, FRAMES_PER_STALL);
+    {
+        BotGame game;
+        FixedTimestep fixedTimestep (STEP_MILIS, MAX_CATCH_UP_STEPS);
+        Histogram stepLateness (10000, 0.01);
+        fixedTimestep.Start (GetCounter(), NANOSECONDS_PER_SECOND);
+        const Uint64 endCounter = GetCounter() + seconds * NANOSECONDS_PER_SECOND;
+        Uint64 frames = 0;
+        for (Uint64 counter = GetCounter(); counter < endCounter; counter = GetCounter()) {
+            PlayDueSteps (game, fixedTimestep, stepLateness);
+            Render (frames++, counter, stallMilis);
+        }
+        printf ("one thread:  %llu steps, %llu frames\n", static_cast<unsigned long long>(fixedTimestep.GetStepCount()), static_cast<unsigned long long>(frames));
+        PrintLatencies ("step lateness", stepLateness);
+    }
+
+    // two threads: the simulation keeps its steps whatever the renderer does
+    {
+        BotGame game;
+        FixedTimestep fixedTimestep (STEP_MILIS, MAX_CATCH_UP_STEPS);
+        TripleBuffer<RenderSnapshot> snapshots;
+        Histogram stepLateness (10000, 0.01);
+        Histogram snapshotAge (10000, 0.01);
+        fixedTimestep.Start (GetCounter(), NANOSECONDS_PER_SECOND);
+        snapshots.GetWriteBuffer().Capture (game.mGameState, game.mPreviousGameState, fixedTimestep.GetStepCounter(), fixedTimestep.GetStepCounterTicks());
+        snapshots.Publish();
+        const Uint64 endCounter = GetCounter() + seconds * NANOSECONDS_PER_SECOND;
+        std::atomic<bool> isRunning (true);
+        std::thread simulation ([&] () {
+            while (isRunning.load (std::memory_order_relaxed)) {
+                if (PlayDueSteps (game, fixedTimestep, stepLateness) > 0) {
+                    snapshots.GetWriteBuffer().Capture (game.mGameState, game.mPreviousGameState, fixedTimestep.GetStepCounter(), fixedTimestep.GetStepCounterTicks());
+                    snapshots.Publish();
+                }
+                SleepUntil (fixedTimestep.GetStepCounter() + fixedTimestep.GetStepCounterTicks());
+            }
+        });
+        Uint64 frames = 0;
+        float interpolationSum = 0.0f;
+        for (Uint64 counter = GetCounter(); counter < endCounter; counter = GetCounter()) {
+            snapshots.Acquire();
+            const RenderSnapshot& snapshot = snapshots.GetReadBuffer();
+            interpolationSum += snapshot.GetInterpolation (counter);
+            snapshotAge.Add ((counter - snapshot.GetStepCounter()) / 1e6);
+            Render (frames++, counter, stallMilis);
+        }
+        isRunning = false;
+        simulation.join();
+        printf ("two threads: %llu steps, %llu frames, %.2f average interpolation\n", static_cast<unsigned long long>(fixedTimestep.GetStepCount()),
+                static_cast<unsigned long long>(frames), frames > 0 ? interpolationSum / frames : 0.0f);
+        PrintLatencies ("step lateness", stepLateness);
+        PrintLatencies ("age of the snapshot drawn", snapshotAge);
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <Replay.h>
+
+
+/*!
+ * Records an hour-long game of random swaps at about 60 updates per second, saves and loads the replay,
+ * plays it back checking it against the recorded game and measures seeking to random updates. It prints a hash of
+ * the replay and the final board, which has to be the same for every build, whatever the optimization level, and
+ * fails unless it is EXPECTED_REPLAY_HASH.
+ * Given a replay file (eg. 'last_game.tmr' written by the game), plays it back and prints its final score instead.
+ *
+ * usage: ReplayBenchmark [replay file]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int GAMEPLAY_SECONDS = 3600;
+static const int SWAP_ONE_IN = 20;          ///< chance per resting update that the player swaps
+static const Uint32 CHECKPOINT_UPDATES = 997;
+static const int SEEKS = 2000;
+static const char* REPLAY_FILE_PATH = "benchmark_replay.tmr";
+/// the hash of the game above, to be updated with the rules or the replay format, never for a build
+static const Uint64 EXPECTED_REPLAY_HASH = 0xb514680538146176ULL;
+
+
+/*!
+ * What the game looked like after some updates.
+ */
+struct Checkpoint {
+    Uint32 mUpdateIndex;
+    Uint32 mGameTime;
+    int mScore;
+    Uint64 mGridHash;
+};
+
+
+static Checkpoint MakeCheckpoint (Uint32 updateIndex, const GameState& gameState)
+{
+    Checkpoint checkpoint;
+    checkpoint.mUpdateIndex = updateIndex;
+    checkpoint.mGameTime = gameState.GetGameTime();
+    checkpoint.mScore = gameState.GetScore();
+    checkpoint.mGridHash = 14695981039346656037ULL;
+    for (int index = 0; index < gameState.GetRows() * gameState.GetColumns(); index++) {
+        checkpoint.mGridHash = (checkpoint.mGridHash ^ gameState.GetColorAt (index)) * 1099511628211ULL;
+    }
+    return checkpoint;
+}
+
+
+static bool IsSameCheckpoint (const Checkpoint& a, const Checkpoint& b)
+{
+    return a.mGameTime == b.mGameTime && a.mScore == b.mScore && a.mGridHash == b.mGridHash;
+}
+
+
+/*!
+ * Plays a replay file to the end.
+ */
+static int PrintReplay (const char* filePath)
+{
+    Replay replay;
+    if (!replay.Load (filePath)) {
+        return EXIT_FAILURE;
+    }
+    ReplayPlayer replayPlayer (replay);
+    while (replayPlayer.Step()) {
+    }
+    const GameState& gameState = replayPlayer.GetGameState();
+    printf ("%s: seed %u, %dx%d, %u updates, %d keyframes, %u stream bytes, %.1f s played, final score %d%s\n", filePath, replay.GetSeed(),
+            replay.GetRows(), replay.GetColumns(), replay.GetUpdateCount(), replay.GetKeyframeCount(), static_cast<Uint32>(replay.GetStream().size()),
+            gameState.GetGameTime() / 1000.0, gameState.GetScore(), gameState.GetAnimationState() == GameState::GameOver ? ", game over" : "");
+    return replayPlayer.IsFinished() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    if (argc > 1) {
+        return PrintReplay (argv [1]);
+    }
+
+    // record
+    const Uint32 seed = 12345;
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, seed);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    ReplayRecorder replayRecorder;
+    replayRecorder.Begin (gameState, seed);
+    gameStateLogic.SetReplayRecorder (&replayRecorder);
+    GameRandom random (1);
+    std::vector<Checkpoint> checkpoints;
+    Uint32 updates = 0;
+    int swaps = 0;
+    while (gameState.GetAnimationState() != GameState::GameOver) {
+        if (gameState.GetAnimationState() == GameState::Idle && !gameStateLogic.IsGridCheckPending() && random.NextInt (SWAP_ONE_IN) == 0) {
+            const bool isVertical = random.NextInt (2) == 1;
+            const int row = random.NextInt (isVertical ? ROWS - 1 : ROWS);
+            const int column = random.NextInt (isVertical ? COLUMNS : COLUMNS - 1);
+            swaps += gameStateLogic.RequestSwap (row, column, isVertical ? row + 1 : row, isVertical ? column : column + 1, gameState) ? 1 : 0;
+        }
+        // frame times of a 60 Hz display measured in whole miliseconds
+        gameStateLogic.Update (16 + random.NextInt (2), gameState);
+        updates++;
+        if (updates % CHECKPOINT_UPDATES == 0) {
+            checkpoints.push_back (MakeCheckpoint (updates, gameState));
+        }
+    }
+    replayRecorder.Finish (gameState);
+    // updates after the game is over are not recorded
+    const Uint32 recordedUpdates = replayRecorder.GetReplay().GetUpdateCount();
+    const Checkpoint finalCheckpoint = MakeCheckpoint (recordedUpdates, gameState);
+    while (!checkpoints.empty() && checkpoints.back().mUpdateIndex > recordedUpdates) {
+        checkpoints.pop_back();
+    }
+
+    // save, load and play through
+    Replay replay;
+    if (!replayRecorder.GetReplay().Save (REPLAY_FILE_PATH) || !replay.Load (REPLAY_FILE_PATH)) {
+        return EXIT_FAILURE;
+    }
+    int mismatches = 0;
+    ReplayPlayer replayPlayer (replay);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t nextCheckpoint = 0;
+    while (replayPlayer.Step()) {
+        if (nextCheckpoint < checkpoints.size() && checkpoints [nextCheckpoint].mUpdateIndex == replayPlayer.GetUpdateIndex()) {
+            mismatches += IsSameCheckpoint (checkpoints [nextCheckpoint], MakeCheckpoint (replayPlayer.GetUpdateIndex(), replayPlayer.GetGameState())) ? 0 : 1;
+            nextCheckpoint++;
+        }
+    }
+    std::chrono::duration<double> playSeconds = std::chrono::steady_clock::now() - start;
+    mismatches += IsSameCheckpoint (finalCheckpoint, MakeCheckpoint (replayPlayer.GetUpdateIndex(), replayPlayer.GetGameState())) ? 0 : 1;
+
+    // seek back and forth, half of the seeks to checkpoints so the result can be checked
+    double totalSeekSeconds = 0.0;
+    double maxSeekSeconds = 0.0;
+    for (int seek = 0; seek < SEEKS; seek++) {
+        const bool isToCheckpoint = seek % 2 == 0 && !checkpoints.empty();
+        const Checkpoint& checkpoint = checkpoints [random.NextInt (static_cast<int>(checkpoints.size()))];
+        const Uint32 target = isToCheckpoint ? checkpoint.mUpdateIndex : static_cast<Uint32>(random.Next() % (recordedUpdates + 1));
+        start = std::chrono::steady_clock::now();
+        replayPlayer.SeekToUpdate (target);
+        std::chrono::duration<double> seekSeconds = std::chrono::steady_clock::now() - start;
+        totalSeekSeconds += seekSeconds.count();
+        maxSeekSeconds = seekSeconds.count() > maxSeekSeconds ? seekSeconds.count() : maxSeekSeconds;
+        if (isToCheckpoint) {
+            mismatches += IsSameCheckpoint (checkpoint, MakeCheckpoint (target, replayPlayer.GetGameState())) ? 0 : 1;
+        }
+    }
+
+    const Uint32 streamSize = static_cast<Uint32>(replay.GetStream().size());
+    // the simulation is integer only, so builds with any compiler and optimization level record the same bytes
+    Uint64 replayHash = finalCheckpoint.mGridHash;
+    for (Uint32 index = 0; index < streamSize; index++) {
+        replayHash = (replayHash ^ replay.GetStream() [index]) * 1099511628211ULL;
+    }
+    printf ("recorded %u updates, %d swaps, %.0f s of game time, final score %d\n", recordedUpdates, swaps, finalCheckpoint.mGameTime / 1000.0, finalCheckpoint.mScore);
+    printf ("stream %u bytes (%.1f bytes/s), %d keyframes of %u bytes\n", streamSize, streamSize / (finalCheckpoint.mGameTime / 1000.0),
+            replay.GetKeyframeCount(), static_cast<Uint32>(sizeof (Replay::KeyframeEntry)) + ROWS * COLUMNS);
+    const bool isExpectedHash = replayHash == EXPECTED_REPLAY_HASH;
+    printf ("replay hash %016llx%s\n", static_cast<unsigned long long>(replayHash), isExpectedHash ? ", as expected" : "");
+    if (!isExpectedHash) {
+        printf ("ERROR: ReplayBenchmark: the replay hash should be %016llx, this build plays another game.\n",
+                static_cast<unsigned long long>(EXPECTED_REPLAY_HASH));
+    }
+    printf ("playback %.0f updates/s, %d seeks: %.1f us average, %.1f us max, %d mismatches\n", recordedUpdates / playSeconds.count(),
+            SEEKS, 1e6 * totalSeekSeconds / SEEKS, 1e6 * maxSeekSeconds, mismatches);
+    remove (REPLAY_FILE_PATH);
+    return mismatches == 0 && isExpectedHash ? EXIT_SUCCESS : EXIT_FAILURE;
+}
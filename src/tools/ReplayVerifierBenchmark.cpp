@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <JobSystem.h>
+#include <Leaderboard.h>
+#include <Replay.h>
+#include <ReplayVerifier.h>
+
+
+/*!
+ * Records one-minute games of random swaps, turns them into submissions and tampers with every other one
+ * (a claimed score too high, a score changed at a move, a move after the time ran out, a move off the board,
+ * a longer game or larger match size claimed, a move back in time). Then verifies them on 1 worker and on every hardware thread, prints the submissions
+ * per second and checks that each verdict and first divergent move is the expected one.
+ *
+ * usage: ReplayVerifierBenchmark [games]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int GAMEPLAY_SECONDS = 60;
+static const int SWAP_ONE_IN = 20;          ///< chance per resting update that the player swaps
+static const int DEFAULT_GAMES = 2000;
+static const int TAMPERINGS = 6;
+
+
+/*!
+ * Plays and records a game of random swaps at about 60 updates per second.
+ */
+static void RecordGame (Uint32 seed, Replay& replay)
+{
+    GameState gameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, seed);
+    GameStateLogic gameStateLogic;
+    gameState.AttachGameStateGridChangeObserver (&gameStateLogic);
+    ReplayRecorder replayRecorder;
+    replayRecorder.Begin (gameState, seed);
+    gameStateLogic.SetReplayRecorder (&replayRecorder);
+    GameRandom random (seed);
+    while (gameState.GetAnimationState() != GameState::GameOver) {
+        // swaps on moving tiles are refused, the rest of the board takes them while other tiles fall
+        if (random.NextInt (SWAP_ONE_IN) == 0) {
+            const bool isVertical = random.NextInt (2) == 1;
+            const int row = random.NextInt (isVertical ? ROWS - 1 : ROWS);
+            const int column = random.NextInt (isVertical ? COLUMNS : COLUMNS - 1);
+            gameStateLogic.RequestSwap (row, column, isVertical ? row + 1 : row, isVertical ? column : column + 1, gameState);
+        }
+        gameStateLogic.Update (16 + random.NextInt (2), gameState);
+    }
+    replayRecorder.Finish (gameState);
+    replay = replayRecorder.GetReplay();
+}
+
+
+/*!
+ * Cheats in a submission.
+ * @param tampering which cheat, 0 to TAMPERINGS - 1.
+ * @param expected output of the verdict the cheat has to get.
+ * @return the move the cheat changes, -1 if it changes the final score.
+ */
+static int Tamper (int tampering, GameRandom& random, ReplayVerifier::Submission& submission, ReplayVerifier::Verdict& expected)
+{
+    std::vector<ReplayVerifier::Move>& moves = submission.mMoves;
+    const int move = random.NextInt (static_cast<int>(moves.size()));
+    switch (tampering) {
+        case 0:
+            submission.mFinalScore += 1 + random.NextInt (100);
+            expected = ReplayVerifier::FinalScoreMismatch;
+            return -1;
+        case 1:
+            // every later move carries the higher score, like a client with a patched score counter
+            for (size_t later = move; later < moves.size(); later++) {
+                moves [later].mScore += 3;
+            }
+            submission.mFinalScore += 3;
+            expected = ReplayVerifier::ScoreMismatch;
+            return move;
+        case 2:
+            moves.push_back (moves.back());
+            moves.back().mGameTime += GAMEPLAY_SECONDS * 1000;
+            moves.back().mScore = submission.mFinalScore;
+            expected = ReplayVerifier::TimeIsUp;
+            return static_cast<int>(moves.size()) - 1;
+        case 3:
+            moves [move].mTileBRow = moves [move].mTileARow + 1;
+            moves [move].mTileBColumn = moves [move].mTileAColumn + 1;
+            expected = ReplayVerifier::IllegalMove;
+            return move;
+        case 4:
+            // other rules than the leaderboard's, a game that never ends or one whose initial grid keeps matches
+            if (random.NextInt (2) == 0) {
+                submission.mMaxGameplayTimeSeconds = 100000;
+            } else {
+                submission.mMinMatchSize = MIN_MATCH_SIZE + 2;
+            }
+            expected = ReplayVerifier::BadRules;
+            return -1;
+        default: {
+            // the first move made after some game time is moved before the move it follows
+            int later = move;
+            while (later < static_cast<int>(moves.size()) && (later == 0 || moves [later - 1].mGameTime == 0 ||
+                    moves [later].mGameTime == moves [later - 1].mGameTime)) {
+                later++;
+            }
+            if (later == static_cast<int>(moves.size())) {
+                expected = ReplayVerifier::Valid;
+                return -1;
+            }
+            moves [later].mGameTime = moves [later - 1].mGameTime - 1;
+            expected = ReplayVerifier::TimeGoesBack;
+            return later;
+        }
+    }
+}
+
+
+int main (int argc, char* argv[])
+{
+    GameState::SetIsLoggingEnabled (false);
+    const int games = argc > 1 ? atoi (argv [1]) : DEFAULT_GAMES;
+    if (games < 1) {
+        printf ("usage: ReplayVerifierBenchmark [games]\n");
+        return EXIT_FAILURE;
+    }
+
+    // record the games on every core
+    JobSystem jobSystem;
+    std::vector<ReplayVerifier::Submission> submissions (games);
+    std::vector<int> readErrors (games, 0);
+    jobSystem.ParallelFor (games, 8, [&submissions, &readErrors] (int begin, int end) {
+        for (int game = begin; game < end; game++) {
+            Replay replay;
+            RecordGame (static_cast<Uint32>(game + 1), replay);
+            readErrors [game] = ReplayVerifier::ReadSubmission (replay, submissions [game]) ? 0 : 1;
+        }
+    });
+    size_t totalMoves = 0;
+    for (int game = 0; game < games; game++) {
+        if (readErrors [game] != 0) {
+            printf ("game %d: broken replay stream\n", game);
+            return EXIT_FAILURE;
+        }
+        totalMoves += submissions [game].mMoves.size();
+    }
+
+    // every other submission cheats, taking turns in the way it does
+    GameRandom random (7);
+    std::vector<ReplayVerifier::Verdict> expectedVerdicts (games, ReplayVerifier::Valid);
+    std::vector<int> expectedMoves (games, -1);
+    for (int game = 1; game < games; game += 2) {
+        if (!submissions [game].mMoves.empty()) {
+            expectedMoves [game] = Tamper ((game / 2) % TAMPERINGS, random, submissions [game], expectedVerdicts [game]);
+        }
+    }
+
+    // verify on 1 worker, then on all of them
+    const Uint32 rules = Leaderboard::MakeRules (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS);
+    std::vector<ReplayVerifier::Result> results (games);
+    const int workerCounts [] = {1, jobSystem.GetWorkerCount()};
+    for (int run = 0; run < 2; run++) {
+        if (run == 1 && workerCounts [1] == 1) {
+            break;
+        }
+        JobSystem runJobSystem (workerCounts [run]);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ReplayVerifier::VerifyBatch (&submissions [0], games, rules, &results [0], runJobSystem);
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        printf ("%2d workers: %.0f submissions/s (%.0f per worker), %.1f M moves/s\n", workerCounts [run], games / seconds.count(),
+                games / seconds.count() / workerCounts [run], totalMoves / seconds.count() / 1e6);
+    }
+
+    // check the verdicts of the last run
+    int verdictCounts [ReplayVerifier::BadRules + 1] = {0};
+    int wrongVerdicts = 0;
+    for (int game = 0; game < games; game++) {
+        const ReplayVerifier::Result& result = results [game];
+        verdictCounts [result.mVerdict]++;
+        if (result.mVerdict != expectedVerdicts [game] || result.mFirstDivergentMove != expectedMoves [game]) {
+            printf ("game %d: %s at move %d, expected %s at move %d\n", game, ReplayVerifier::GetVerdictName (result.mVerdict),
+                    result.mFirstDivergentMove, ReplayVerifier::GetVerdictName (expectedVerdicts [game]), expectedMoves [game]);
+            wrongVerdicts++;
+        }
+    }
+    printf ("%d submissions, %.1f moves on average\n", games, static_cast<double>(totalMoves) / games);
+    for (int verdict = 0; verdict <= ReplayVerifier::BadRules; verdict++) {
+        printf ("  %-22s %d\n", ReplayVerifier::GetVerdictName (static_cast<ReplayVerifier::Verdict>(verdict)), verdictCounts [verdict]);
+    }
+    printf ("%d wrong verdicts\n", wrongVerdicts);
+    return wrongVerdicts == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
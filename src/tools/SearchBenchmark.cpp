@@ -0,0 +1,54 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <BestMoveSearch.h>
+#include <GameBoard.h>
+#include <GameState.h>
+#include <JobSystem.h>
+
+
+/*!
+ * Runs BestMoveSearch on 8x8 boards at depths 2 to 6 and prints nodes per second and transposition table hit rate.
+ * The boards use column refills, so moves in different parts of the board lead to the same positions.
+ * Deeper searches visit exponentially more nodes, so they run on fewer boards.
+ */
+
+
+static const int MIN_DEPTH = 2;
+static const int MAX_DEPTH = 6;
+static const int BOARDS_AT_DEPTH [MAX_DEPTH + 1] = { 0, 0, 32, 16, 4, 2, 1 };
+
+
+int main (int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    GameState::SetIsLoggingEnabled (false);
+
+    JobSystem jobSystem;
+    BestMoveSearch bestMoveSearch (jobSystem, 22);
+    printf ("%6s %7s %14s %12s %14s %9s %12s\n", "depth", "boards", "nodes", "nodes/s", "table probes", "hit rate", "avg points");
+    for (int depth = MIN_DEPTH; depth <= MAX_DEPTH; depth++) {
+        Uint64 nodes = 0;
+        Uint64 tableProbes = 0;
+        Uint64 tableHits = 0;
+        double seconds = 0.0;
+        int totalPoints = 0;
+        for (int boardIndex = 0; boardIndex < BOARDS_AT_DEPTH [depth]; boardIndex++) {
+            GameBoard board (8, 8, 3, GameState::sNUMBER_OF_TILE_COLORS);
+            board.Reset (1000 + boardIndex);
+            board.SetColumnRefills (boardIndex);
+            // every board starts with an empty table, so the hit rate only counts transpositions within one search
+            bestMoveSearch.ClearTable();
+            BestMoveSearch::SearchResult result = bestMoveSearch.Search (board, depth);
+            nodes += result.mNodes;
+            tableProbes += result.mTableProbes;
+            tableHits += result.mTableHits;
+            seconds += result.mSeconds;
+            totalPoints += result.mPoints;
+        }
+        printf ("%6d %7d %14llu %12.0f %14llu %8.2f%% %12.1f\n", depth, BOARDS_AT_DEPTH [depth],
+                static_cast<unsigned long long>(nodes), nodes / seconds, static_cast<unsigned long long>(tableProbes),
+                tableProbes > 0 ? 100.0 * tableHits / tableProbes : 0.0, static_cast<double>(totalPoints) / BOARDS_AT_DEPTH [depth]);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,392 @@
+#include <errno.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <GameRandom.h>
+#include <GameServer.h>
+#include <GameState.h>
+#include <Histogram.h>
+
+
+/*!
+ * Synthetic clients for the GameServer on this machine. Idle sessions start a game and then only keep their connection;
+ * playing sessions swap random neighbouring tiles, the next swap as soon as the previous one is resolved.
+ * Once every session is connected, measures for some seconds and prints the swaps per second and the latency of a swap,
+ * from sending it to receiving its SWAP_ACCEPTED or SWAP_REJECTED.
+ * Then every idle session swaps once and the latency of these first swaps is printed separately.
+ * With the address "local" the server runs in this process on a Unix socket, which also prints the sessions per event loop
+ * and the heap memory per session; given a hibernation time, the server hibernates resting games, the measurement waits
+ * for the idle sessions to hibernate and the first swaps of the idle sessions restore them.
+ *
+ * usage: ServerLoadGenerator [local | unix:<socket path> | port] [idle sessions] [playing sessions] [seconds] [client threads]
+ *  [hibernation miliseconds]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int LOCAL_GAMEPLAY_SECONDS = 3600;
+static const int MAX_EVENTS = 256;
+static const int LATENCY_BINS = 100000;
+static const double LATENCY_BIN_MICROSECONDS = 10.0;
+static const int WAKES_PER_MILISECOND = 4;          ///< first swaps of idle sessions sent by a thread
+
+
+/// a connection to the server
+struct Client {
+    int mSocket;
+    bool mIsPlaying;
+    bool mIsWaking;                         ///< an idle session waiting for the answer to its first swap
+    Uint32 mSequence;
+    std::chrono::steady_clock::time_point mSwapTime;
+    Uint8 mInput [sizeof (GameServerMessage)];
+    int mInputSize;
+};
+
+
+/// what the clients of a thread do and measure; the main thread reads the counters while the thread runs
+struct ClientThread {
+    int mIdleSessions, mPlayingSessions;
+    std::atomic<int> mConnectedSessions;
+    std::atomic<int> mWokenSessions;
+    std::atomic<Uint64> mStartedGames, mSwaps, mRejectedSwaps, mSendErrors;
+    Histogram mLatencies;                   ///< read after the thread is joined, like mWakeLatencies
+    Histogram mWakeLatencies;
+    ClientThread () : mIdleSessions (0), mPlayingSessions (0), mConnectedSessions (0), mWokenSessions (0), mStartedGames (0), mSwaps (0),
+        mRejectedSwaps (0), mSendErrors (0), mLatencies (LATENCY_BINS, LATENCY_BIN_MICROSECONDS), mWakeLatencies (LATENCY_BINS, LATENCY_BIN_MICROSECONDS) {}
+};
+
+
+static std::atomic<int> sConnectingThreads (0);
+static std::atomic<bool> sIsMeasuring (false);
+static std::atomic<bool> sIsWaking (false);
+static std::atomic<bool> sIsToStop (false);
+
+
+static int Connect (const char* address)
+{
+    int clientSocket = -1;
+    if (strncmp (address, "unix:", 5) == 0) {
+        sockaddr_un unixAddress;
+        memset (&unixAddress, 0, sizeof (unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        strncpy (unixAddress.sun_path, address + 5, sizeof (unixAddress.sun_path) - 1);
+        clientSocket = socket (AF_UNIX, SOCK_STREAM, 0);
+        if (clientSocket >= 0 && connect (clientSocket, reinterpret_cast<sockaddr*>(&unixAddress), sizeof (unixAddress)) != 0) {
+            close (clientSocket);
+            return -1;
+        }
+    } else {
+        sockaddr_in tcpAddress;
+        memset (&tcpAddress, 0, sizeof (tcpAddress));
+        tcpAddress.sin_family = AF_INET;
+        tcpAddress.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+        tcpAddress.sin_port = htons (static_cast<uint16_t>(atoi (address)));
+        clientSocket = socket (AF_INET, SOCK_STREAM, 0);
+        if (clientSocket >= 0 && connect (clientSocket, reinterpret_cast<sockaddr*>(&tcpAddress), sizeof (tcpAddress)) != 0) {
+            close (clientSocket);
+            return -1;
+        }
+        int isNoDelay = 1;
+        setsockopt (clientSocket, IPPROTO_TCP, TCP_NODELAY, &isNoDelay, sizeof (isNoDelay));
+    }
+    if (clientSocket >= 0) {
+        fcntl (clientSocket, F_SETFL, fcntl (clientSocket, F_GETFL) | O_NONBLOCK);
+    }
+    return clientSocket;
+}
+
+
+static void SendMessage (ClientThread& thread, Client& client, const GameServerMessage& message)
+{
+    if (send (client.mSocket, &message, sizeof (message), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof (message))) {
+        thread.mSendErrors.fetch_add (1, std::memory_order_relaxed);
+    }
+}
+
+
+static void SendSwap (ClientThread& thread, Client& client, GameRandom& random)
+{
+    GameServerMessage message;
+    memset (&message, 0, sizeof (message));
+    message.mType = GameServerMessage::SWAP;
+    const bool isVertical = random.NextInt (2) == 1;
+    message.mTileARow = static_cast<Uint8>(random.NextInt (isVertical ? ROWS - 1 : ROWS));
+    message.mTileAColumn = static_cast<Uint8>(random.NextInt (isVertical ? COLUMNS : COLUMNS - 1));
+    message.mTileBRow = message.mTileARow + (isVertical ? 1 : 0);
+    message.mTileBColumn = message.mTileAColumn + (isVertical ? 0 : 1);
+    message.mSequence = ++client.mSequence;
+    client.mSwapTime = std::chrono::steady_clock::now();
+    SendMessage (thread, client, message);
+}
+
+
+static void HandleMessage (ClientThread& thread, Client& client, const GameServerMessage& message, GameRandom& random)
+{
+    if (client.mIsWaking && (message.mType == GameServerMessage::SWAP_ACCEPTED || message.mType == GameServerMessage::SWAP_REJECTED)) {
+        thread.mWakeLatencies.Add (static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - client.mSwapTime).count()));
+        thread.mWokenSessions.fetch_add (1, std::memory_order_relaxed);
+        client.mIsWaking = false;
+        return;
+    }
+    if (message.mType == GameServerMessage::SWAP_ACCEPTED || message.mType == GameServerMessage::SWAP_REJECTED) {
+        if (sIsMeasuring) {
+            thread.mLatencies.Add (static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - client.mSwapTime).count()));
+            thread.mSwaps.fetch_add (1, std::memory_order_relaxed);
+            thread.mRejectedSwaps.fetch_add (message.mType == GameServerMessage::SWAP_REJECTED ? 1 : 0, std::memory_order_relaxed);
+        }
+    }
+    if (message.mType == GameServerMessage::GAME_STARTED) {
+        thread.mStartedGames.fetch_add (1, std::memory_order_relaxed);
+    }
+    if (message.mType == GameServerMessage::GAME_OVER) {
+        GameServerMessage startMessage;
+        memset (&startMessage, 0, sizeof (startMessage));
+        startMessage.mType = GameServerMessage::START_GAME;
+        SendMessage (thread, client, startMessage);
+    } else if (client.mIsPlaying && message.mType != GameServerMessage::SWAP_ACCEPTED) {
+        SendSwap (thread, client, random);
+    }
+}
+
+
+static void RunClients (const char* address, ClientThread& thread, int threadIndex)
+{
+    GameRandom random (static_cast<Uint32>(threadIndex + 1));
+    const int epoll = epoll_create1 (0);
+    std::vector<std::unique_ptr<Client>> clients;
+    GameServerMessage startMessage;
+    memset (&startMessage, 0, sizeof (startMessage));
+    startMessage.mType = GameServerMessage::START_GAME;
+    for (int index = 0; index < thread.mIdleSessions + thread.mPlayingSessions; index++) {
+        std::unique_ptr<Client> client (new Client());
+        client->mSocket = Connect (address);
+        if (client->mSocket < 0) {
+            printf ("ServerLoadGenerator: connection %d of thread %d failed: %s\n", index, threadIndex, strerror (errno));
+            break;
+        }
+        client->mIsPlaying = index >= thread.mIdleSessions;
+        client->mIsWaking = false;
+        client->mSequence = 0;
+        client->mInputSize = 0;
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = client.get();
+        epoll_ctl (epoll, EPOLL_CTL_ADD, client->mSocket, &event);
+        SendMessage (thread, *client, startMessage);
+        clients.push_back (std::move (client));
+    }
+    thread.mConnectedSessions.store (static_cast<int>(clients.size()), std::memory_order_relaxed);
+    sConnectingThreads--;
+
+    epoll_event events [MAX_EVENTS];
+    Uint8 buffer [4096];
+    size_t nextWakingClient = 0;
+    std::chrono::steady_clock::time_point nextWakeTime = std::chrono::steady_clock::now();
+    while (!sIsToStop) {
+        // WAKES_PER_MILISECOND idle sessions at a time, so that the latency is not that of a queue
+        const bool isWaking = sIsWaking && nextWakingClient < clients.size() && !clients [nextWakingClient]->mIsPlaying;
+        if (isWaking && std::chrono::steady_clock::now() >= nextWakeTime) {
+            for (int count = 0; count < WAKES_PER_MILISECOND && nextWakingClient < clients.size() && !clients [nextWakingClient]->mIsPlaying; count++) {
+                clients [nextWakingClient]->mIsWaking = true;
+                SendSwap (thread, *clients [nextWakingClient++], random);
+            }
+            nextWakeTime = std::chrono::steady_clock::now() + std::chrono::milliseconds (1);
+        }
+        const int eventCount = epoll_wait (epoll, events, MAX_EVENTS, isWaking ? 1 : 10);
+        for (int index = 0; index < eventCount; index++) {
+            Client& client = *static_cast<Client*>(events [index].data.ptr);
+            const ssize_t size = recv (client.mSocket, buffer, sizeof (buffer), 0);
+            if (size <= 0) {
+                if (size == 0 || (errno != EAGAIN && errno != EINTR)) {
+                    epoll_ctl (epoll, EPOLL_CTL_DEL, client.mSocket, NULL);
+                    client.mIsPlaying = false;
+                }
+                continue;
+            }
+            for (ssize_t position = 0; position < size; ) {
+                const int copySize = static_cast<int>(std::min (static_cast<ssize_t>(sizeof (client.mInput) - client.mInputSize), size - position));
+                memcpy (client.mInput + client.mInputSize, buffer + position, copySize);
+                client.mInputSize += copySize;
+                position += copySize;
+                if (client.mInputSize == static_cast<int>(sizeof (client.mInput))) {
+                    GameServerMessage message;
+                    memcpy (&message, client.mInput, sizeof (message));
+                    client.mInputSize = 0;
+                    HandleMessage (thread, client, message, random);
+                }
+            }
+        }
+    }
+    for (size_t index = 0; index < clients.size(); index++) {
+        close (clients [index]->mSocket);
+    }
+    close (epoll);
+}
+
+
+/*!
+ * Retrieves the resident memory of this process in bytes.
+ */
+static double GetResidentBytes ()
+{
+    long pages = 0;
+    long residentPages = 0;
+    FILE* file = fopen ("/proc/self/statm", "r");
+    if (file == NULL) {
+        return 0.0;
+    }
+    if (fscanf (file, "%ld %ld", &pages, &residentPages) != 2) {
+        residentPages = 0;
+    }
+    fclose (file);
+    return static_cast<double>(residentPages) * sysconf (_SC_PAGESIZE);
+}
+
+
+int main (int argc, char* argv[])
+{
+    const char* address = argc > 1 ? argv [1] : "local";
+    const int idleSessions = argc > 2 ? atoi (argv [2]) : 10000;
+    const int playingSessions = argc > 3 ? atoi (argv [3]) : 200;
+    const int seconds = argc > 4 ? atoi (argv [4]) : 10;
+    int threadCount = argc > 5 ? atoi (argv [5]) : static_cast<int>(std::thread::hardware_concurrency());
+    threadCount = std::max (1, threadCount);
+    const int hibernationMilis = argc > 6 ? atoi (argv [6]) : 0;
+    if (idleSessions < 0 || playingSessions < 0 || seconds < 1) {
+        printf ("usage: ServerLoadGenerator [local | unix:<socket path> | port] [idle sessions] [playing sessions] [seconds] [client threads] [hibernation miliseconds]\n");
+        return EXIT_FAILURE;
+    }
+
+    // every session takes a socket here and one in the server
+    rlimit fileLimit;
+    if (getrlimit (RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_cur < fileLimit.rlim_max) {
+        fileLimit.rlim_cur = fileLimit.rlim_max;
+        setrlimit (RLIMIT_NOFILE, &fileLimit);
+    }
+    const int neededFiles = (strcmp (address, "local") == 0 ? 2 : 1) * (idleSessions + playingSessions) + 64;
+    if (getrlimit (RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_cur < static_cast<rlim_t>(neededFiles)) {
+        printf ("ServerLoadGenerator: %d sessions need %d open files but the limit is %lu, raise it with 'ulimit -n'.\n",
+                idleSessions + playingSessions, neededFiles, static_cast<unsigned long>(fileLimit.rlim_cur));
+    }
+
+    GameState::SetIsLoggingEnabled (false);
+    std::unique_ptr<GameServer> gameServer;
+    char localAddress [64];
+    const double startBytes = GetResidentBytes();
+    const double startHeapBytes = static_cast<double>(mallinfo2().uordblks);
+    if (strcmp (address, "local") == 0) {
+        snprintf (localAddress, sizeof (localAddress), "unix:/tmp/tilematch_server_%d.sock", static_cast<int>(getpid()));
+        address = localAddress;
+        gameServer.reset (new GameServer (ROWS, COLUMNS, 3, LOCAL_GAMEPLAY_SECONDS));
+        if (hibernationMilis > 0) {
+            gameServer->SetHibernation (static_cast<Uint32>(hibernationMilis));
+        }
+        if (!gameServer->Start (address)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // connect, then measure
+    std::vector<ClientThread> threads (threadCount);
+    std::vector<std::thread> runningThreads;
+    sConnectingThreads = threadCount;
+    std::chrono::steady_clock::time_point connectStart = std::chrono::steady_clock::now();
+    for (int index = 0; index < threadCount; index++) {
+        threads [index].mIdleSessions = idleSessions / threadCount + (index < idleSessions % threadCount ? 1 : 0);
+        threads [index].mPlayingSessions = playingSessions / threadCount + (index < playingSessions % threadCount ? 1 : 0);
+        runningThreads.push_back (std::thread (RunClients, address, std::ref (threads [index]), index));
+    }
+    while (sConnectingThreads > 0) {
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+    }
+    std::chrono::duration<double> connectSeconds = std::chrono::steady_clock::now() - connectStart;
+    // let the server answer the last starts and hibernate the idle games
+    std::this_thread::sleep_for (std::chrono::milliseconds (500 + (gameServer && hibernationMilis > 0 ? hibernationMilis + 2 * GameServer::SWEEP_MILIS : 0)));
+    sIsMeasuring = true;
+    std::this_thread::sleep_for (std::chrono::seconds (seconds));
+    sIsMeasuring = false;
+
+    int connectedSessions = 0;
+    Uint64 startedGames = 0, swaps = 0, rejectedSwaps = 0, sendErrors = 0;
+    Histogram latencies (LATENCY_BINS, LATENCY_BIN_MICROSECONDS);
+    Histogram wakeLatencies (LATENCY_BINS, LATENCY_BIN_MICROSECONDS);
+    for (int index = 0; index < threadCount; index++) {
+        connectedSessions += threads [index].mConnectedSessions.load (std::memory_order_relaxed);
+        startedGames += threads [index].mStartedGames.load (std::memory_order_relaxed);
+        swaps += threads [index].mSwaps.load (std::memory_order_relaxed);
+        rejectedSwaps += threads [index].mRejectedSwaps.load (std::memory_order_relaxed);
+        sendErrors += threads [index].mSendErrors.load (std::memory_order_relaxed);
+    }
+    printf ("%d sessions connected in %.2f s, %llu games started\n", connectedSessions, connectSeconds.count(), static_cast<unsigned long long>(startedGames));
+    if (gameServer) {
+        const double bytes = GetResidentBytes() - startBytes;
+        const double heapBytes = static_cast<double>(mallinfo2().uordblks) - startHeapBytes;
+        for (int loop = 0; loop < gameServer->GetLoopCount(); loop++) {
+            printf ("  event loop %2d: %d sessions, %d hibernating\n", loop, gameServer->GetLoopStats (loop).mSessions.load(),
+                    gameServer->GetLoopStats (loop).mHibernatingSessions.load());
+        }
+        printf ("%.0f sessions per core, %.0f heap bytes and %.1f KB resident per session (server and client)\n",
+                static_cast<double>(connectedSessions) / gameServer->GetLoopCount(), connectedSessions > 0 ? heapBytes / connectedSessions : 0.0,
+                connectedSessions > 0 ? bytes / connectedSessions / 1024.0 : 0.0);
+    }
+
+    // the first swap of every idle session
+    sIsWaking = true;
+    int wokenSessions = 0;
+    std::chrono::steady_clock::time_point wakeStart = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - wakeStart < std::chrono::seconds (10)) {
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        wokenSessions = 0;
+        for (int index = 0; index < threadCount; index++) {
+            wokenSessions += threads [index].mWokenSessions.load (std::memory_order_relaxed);
+        }
+        if (wokenSessions >= idleSessions) {
+            break;
+        }
+    }
+
+    sIsToStop = true;
+    // the send errors of the wakes too
+    sendErrors = 0;
+    for (int index = 0; index < threadCount; index++) {
+        runningThreads [index].join();
+        latencies.Merge (threads [index].mLatencies);
+        wakeLatencies.Merge (threads [index].mWakeLatencies);
+        sendErrors += threads [index].mSendErrors.load (std::memory_order_relaxed);
+    }
+    Uint64 restores = 0, restoreNanoseconds = 0;
+    if (gameServer) {
+        for (int loop = 0; loop < gameServer->GetLoopCount(); loop++) {
+            restores += gameServer->GetLoopStats (loop).mRestores.load();
+            restoreNanoseconds += gameServer->GetLoopStats (loop).mRestoreNanoseconds.load();
+        }
+        gameServer->Stop();
+    }
+    printf ("%llu swaps in %d s (%.0f/s), %llu rejected, %llu send errors\n", static_cast<unsigned long long>(swaps), seconds, static_cast<double>(swaps) / seconds,
+            static_cast<unsigned long long>(rejectedSwaps), static_cast<unsigned long long>(sendErrors));
+    printf ("swap latency: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", latencies.GetPercentile (50.0) / 1000.0,
+            latencies.GetPercentile (99.0) / 1000.0, latencies.GetMaximum() / 1000.0);
+    printf ("first swap of %d idle sessions: p50 %.3f ms, p99 %.3f ms", wokenSessions, wakeLatencies.GetPercentile (50.0) / 1000.0,
+            wakeLatencies.GetPercentile (99.0) / 1000.0);
+    if (restores > 0) {
+        printf (", %llu games restored in %.2f us on average", static_cast<unsigned long long>(restores), restoreNanoseconds / 1000.0 / restores);
+    }
+    printf ("\n");
+    return connectedSessions == idleSessions + playingSessions && sendErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,369 @@
+#include <errno.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <GameRandom.h>
+#include <GameState.h>
+#include <GameStateLogic.h>
+#include <Histogram.h>
+#include <SpectatorBroadcast.h>
+#include <SpectatorStream.h>
+
+
+/*!
+ * Streams live games to many spectators over local sockets and checks that every spectator sees the right boards.
+ *
+ * The parent plays the games with random swaps at 60 ticks per second, encodes every game once per tick and
+ * broadcasts the frames to the spectators of the game, sending every few ticks. The spectators run in a child
+ * process, on a few threads with an epoll instance each, and put the boards together from the frames, checking the
+ * board checksum of every frame.
+ * Some spectators only read every few seconds, so they fall behind and have to skip ahead to keyframes.
+ *
+ * usage: SpectatorBenchmark [spectators] [games] [seconds] [slow spectators percent] [spectator threads] [send interval ticks]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int GAMEPLAY_SECONDS = 3600;
+static const int TICKS_PER_SECOND = 60;
+static const int SWAP_ONE_IN = 30;          ///< chance per resting tick that a game's bot swaps
+static const int DEFAULT_SPECTATORS = 10000;
+static const int DEFAULT_GAMES = 20;
+static const int DEFAULT_SECONDS = 10;
+static const double DEFAULT_SLOW_PERCENT = 1.0;
+static const int DEFAULT_SEND_INTERVAL_TICKS = 6;
+static const int SLOW_READ_MILIS = 5000;    ///< how often slow spectators read
+static const int SEND_BUFFER_BYTES = 8192;  ///< small, so slow spectators fall behind within seconds
+static const int READ_BYTES = 65536;
+
+
+/// a game and its stream
+struct StreamedGame {
+    std::unique_ptr<GameState> mGameState;
+    GameStateLogic mGameStateLogic;
+    SpectatorEncoder mEncoder;
+    SpectatorBroadcast mBroadcast;
+};
+
+
+/// a spectator in the child process
+struct Spectator {
+    int mSocket;
+    bool mIsSlow;
+    bool mIsClosed;
+    SpectatorView mView;
+    std::vector<Uint8> mPending;            ///< bytes of a frame not read whole yet
+};
+
+
+/// what the spectators report to the parent
+struct SpectatorResult {
+    Uint64 mFrames;
+    Uint64 mKeyframes;
+    Uint64 mBytes;
+    Uint64 mRejectedFrames;                 ///< deltas that came while waiting for a keyframe
+    Uint64 mMismatches;
+    int mSynchronizedSpectators;            ///< spectators that showed the right board at the end
+};
+
+
+/*!
+ * Reads what arrived for a spectator and applies the frames.
+ * @return false once the stream ended.
+ */
+static bool ReadSpectator (Spectator& spectator, Uint8* buffer, SpectatorResult& result)
+{
+    while (true) {
+        const ssize_t size = read (spectator.mSocket, buffer, READ_BYTES);
+        if (size <= 0) {
+            return size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        }
+        result.mBytes += size;
+        spectator.mPending.insert (spectator.mPending.end(), buffer, buffer + size);
+        size_t offset = 0;
+        while (spectator.mPending.size() - offset >= sizeof (SpectatorFrameHeader)) {
+            SpectatorFrameHeader header;
+            memcpy (&header, &spectator.mPending [offset], sizeof (header));
+            if (spectator.mPending.size() - offset < header.mSize) {
+                break;
+            }
+            if (spectator.mView.Apply (&spectator.mPending [offset], header.mSize)) {
+                result.mFrames++;
+                result.mKeyframes += header.mType == SpectatorFrameHeader::KEYFRAME ? 1 : 0;
+            } else {
+                result.mRejectedFrames++;
+            }
+            offset += header.mSize;
+        }
+        spectator.mPending.erase (spectator.mPending.begin(), spectator.mPending.begin() + offset);
+    }
+}
+
+
+/*!
+ * Runs the spectators of one thread until all their streams ended.
+ */
+static void RunSpectators (std::vector<Spectator>* spectators, SpectatorResult* result)
+{
+    std::vector<Uint8> buffer (READ_BYTES);
+    const int epollFd = epoll_create1 (0);
+    int openCount = 0;
+    for (size_t index = 0; index < spectators->size(); index++) {
+        Spectator& spectator = (*spectators) [index];
+        fcntl (spectator.mSocket, F_SETFL, fcntl (spectator.mSocket, F_GETFL, 0) | O_NONBLOCK);
+        openCount++;
+        if (!spectator.mIsSlow) {
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u64 = index;
+            epoll_ctl (epollFd, EPOLL_CTL_ADD, spectator.mSocket, &event);
+        }
+    }
+    std::chrono::steady_clock::time_point nextSlowRead = std::chrono::steady_clock::now() + std::chrono::milliseconds (SLOW_READ_MILIS);
+    epoll_event events [256];
+    while (openCount > 0) {
+        const int eventCount = epoll_wait (epollFd, events, 256, 100);
+        for (int index = 0; index < eventCount; index++) {
+            Spectator& spectator = (*spectators) [events [index].data.u64];
+            if (!spectator.mIsClosed && !ReadSpectator (spectator, buffer.data(), *result)) {
+                spectator.mIsClosed = true;
+                openCount--;
+                epoll_ctl (epollFd, EPOLL_CTL_DEL, spectator.mSocket, NULL);
+            }
+        }
+        // slow spectators drain what piled up now and then, and at the end
+        if (std::chrono::steady_clock::now() >= nextSlowRead) {
+            nextSlowRead += std::chrono::milliseconds (SLOW_READ_MILIS);
+            for (size_t index = 0; index < spectators->size(); index++) {
+                Spectator& spectator = (*spectators) [index];
+                if (spectator.mIsSlow && !spectator.mIsClosed && !ReadSpectator (spectator, buffer.data(), *result)) {
+                    spectator.mIsClosed = true;
+                    openCount--;
+                }
+            }
+        }
+    }
+    close (epollFd);
+    for (size_t index = 0; index < spectators->size(); index++) {
+        Spectator& spectator = (*spectators) [index];
+        result->mMismatches += spectator.mView.GetMismatchCount();
+        result->mSynchronizedSpectators += spectator.mView.IsSynchronized() ? 1 : 0;
+        close (spectator.mSocket);
+    }
+}
+
+
+/*!
+ * Main function of the spectator benchmark.
+ * @param argc up to 6 arguments: the number of spectators (default DEFAULT_SPECTATORS), of games they are spread
+ *  over (default DEFAULT_GAMES), the seconds to stream (default DEFAULT_SECONDS), the share of slow spectators
+ *  (default DEFAULT_SLOW_PERCENT), the number of spectator threads (default the hardware threads) and how many
+ *  ticks of frames are sent at once (default DEFAULT_SEND_INTERVAL_TICKS).
+ * @return returns 0 if every frame applied gave the sender's board.
+ */
+int main (int argc, char* argv[])
+{
+    const int spectatorCount = argc > 1 ? atoi (argv [1]) : DEFAULT_SPECTATORS;
+    const int gameCount = argc > 2 ? atoi (argv [2]) : DEFAULT_GAMES;
+    const int seconds = argc > 3 ? atoi (argv [3]) : DEFAULT_SECONDS;
+    const double slowPercent = argc > 4 ? atof (argv [4]) : DEFAULT_SLOW_PERCENT;
+    int threadCount = argc > 5 ? atoi (argv [5]) : static_cast<int>(std::thread::hardware_concurrency());
+    threadCount = threadCount < 1 ? 1 : threadCount;
+    const int sendIntervalTicks = argc > 6 ? atoi (argv [6]) : DEFAULT_SEND_INTERVAL_TICKS;
+    if (spectatorCount < 1 || gameCount < 1 || seconds < 1 || slowPercent < 0.0 || slowPercent > 100.0 || sendIntervalTicks < 1) {
+        printf ("usage: SpectatorBenchmark [spectators] [games] [seconds] [slow spectators percent] [spectator threads] [send interval ticks]\n");
+        return EXIT_FAILURE;
+    }
+
+    // the parent and the child hold one socket per spectator each
+    rlimit fileLimit;
+    if (getrlimit (RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_cur < fileLimit.rlim_max) {
+        fileLimit.rlim_cur = fileLimit.rlim_max;
+        setrlimit (RLIMIT_NOFILE, &fileLimit);
+    }
+    const int neededFiles = spectatorCount + 64;
+    if (getrlimit (RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_cur < static_cast<rlim_t>(neededFiles)) {
+        printf ("SpectatorBenchmark: %d spectators need %d open files but the limit is %lu, raise it with 'ulimit -n'.\n",
+                spectatorCount, neededFiles, static_cast<unsigned long>(fileLimit.rlim_cur));
+        return EXIT_FAILURE;
+    }
+    GameState::SetIsLoggingEnabled (false);
+    printf ("%d spectators (%.1f%% slow) of %d games over local sockets for %d s, %d spectator threads, sending every %d ticks\n",
+            spectatorCount, slowPercent, gameCount, seconds, threadCount, sendIntervalTicks);
+    fflush (stdout);
+
+    std::vector<std::unique_ptr<StreamedGame>> games;
+    for (int game = 0; game < gameCount; game++) {
+        games.push_back (std::unique_ptr<StreamedGame> (new StreamedGame()));
+        games.back()->mGameState.reset (new GameState (ROWS, COLUMNS, MIN_MATCH_SIZE, GAMEPLAY_SECONDS, 1000 + game));
+        games.back()->mGameState->AttachGameStateGridChangeObserver (&games.back()->mGameStateLogic);
+    }
+
+    // the spectators run in a child process that connects to an abstract local socket, so each process holds one
+    // socket per spectator
+    sockaddr_un address;
+    memset (&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    snprintf (address.sun_path + 1, sizeof (address.sun_path) - 1, "tilematch_spectators_%d", static_cast<int>(getpid()));
+    const socklen_t addressSize = static_cast<socklen_t>(offsetof (sockaddr_un, sun_path) + 1 + strlen (address.sun_path + 1));
+    const int listenSocket = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket < 0 || bind (listenSocket, reinterpret_cast<sockaddr*>(&address), addressSize) != 0 || listen (listenSocket, SOMAXCONN) != 0) {
+        printf ("ERROR: SpectatorBenchmark cannot listen: %s\n", strerror (errno));
+        return EXIT_FAILURE;
+    }
+    int resultPipe [2];
+    if (pipe (resultPipe) != 0) {
+        printf ("ERROR: SpectatorBenchmark cannot create a pipe.\n");
+        return EXIT_FAILURE;
+    }
+    const pid_t child = fork();
+    if (child < 0) {
+        printf ("ERROR: SpectatorBenchmark cannot fork.\n");
+        return EXIT_FAILURE;
+    }
+    if (child == 0) {
+        close (resultPipe [0]);
+        close (listenSocket);
+        std::vector<std::vector<Spectator>> threadSpectators (threadCount);
+        GameRandom random (7);
+        const Uint32 slowThreshold = static_cast<Uint32>(slowPercent / 100.0 * 4294967295.0);
+        for (int index = 0; index < spectatorCount; index++) {
+            Spectator spectator;
+            spectator.mSocket = socket (AF_UNIX, SOCK_STREAM, 0);
+            if (spectator.mSocket < 0 || connect (spectator.mSocket, reinterpret_cast<sockaddr*>(&address), addressSize) != 0) {
+                printf ("ERROR: SpectatorBenchmark cannot connect spectator %d: %s\n", index, strerror (errno));
+                _exit (EXIT_FAILURE);
+            }
+            spectator.mIsSlow = slowThreshold > 0 && random.Next() < slowThreshold;
+            spectator.mIsClosed = false;
+            threadSpectators [index % threadCount].push_back (spectator);
+        }
+        std::vector<SpectatorResult> results (threadCount, SpectatorResult());
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < threadCount; thread++) {
+            threads.push_back (std::thread (RunSpectators, &threadSpectators [thread], &results [thread]));
+        }
+        SpectatorResult total = SpectatorResult();
+        for (int thread = 0; thread < threadCount; thread++) {
+            threads [thread].join();
+            total.mFrames += results [thread].mFrames;
+            total.mKeyframes += results [thread].mKeyframes;
+            total.mBytes += results [thread].mBytes;
+            total.mRejectedFrames += results [thread].mRejectedFrames;
+            total.mMismatches += results [thread].mMismatches;
+            total.mSynchronizedSpectators += results [thread].mSynchronizedSpectators;
+        }
+        const bool isWritten = write (resultPipe [1], &total, sizeof (total)) == static_cast<ssize_t>(sizeof (total));
+        _exit (isWritten ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close (resultPipe [1]);
+    for (int index = 0; index < spectatorCount; index++) {
+        const int spectatorSocket = accept (listenSocket, NULL, NULL);
+        if (spectatorSocket < 0) {
+            printf ("ERROR: SpectatorBenchmark cannot accept spectator %d: %s\n", index, strerror (errno));
+            kill (child, SIGKILL);
+            return EXIT_FAILURE;
+        }
+        setsockopt (spectatorSocket, SOL_SOCKET, SO_SNDBUF, &SEND_BUFFER_BYTES, sizeof (SEND_BUFFER_BYTES));
+        games [index % gameCount]->mBroadcast.AddSubscriber (spectatorSocket);
+    }
+    close (listenSocket);
+
+    // every tick updates, encodes and broadcasts every game
+    GameRandom random (11);
+    Histogram encodeNanoseconds (100000, 10.0);
+    Histogram tickMicroseconds (100000, 1.0);
+    int overBudgetTicks = 0;
+    const int tickCount = seconds * TICKS_PER_SECOND;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < tickCount; tick++) {
+        std::this_thread::sleep_until (start + std::chrono::microseconds (static_cast<Sint64>(tick) * 1000000 / TICKS_PER_SECOND));
+        const std::chrono::steady_clock::time_point tickStart = std::chrono::steady_clock::now();
+        const Uint32 tickMilis = (tick + 1) * 1000 / TICKS_PER_SECOND - tick * 1000 / TICKS_PER_SECOND;
+        for (int game = 0; game < gameCount; game++) {
+            StreamedGame& streamedGame = *games [game];
+            GameState& gameState = *streamedGame.mGameState;
+            if (gameState.GetAnimationState() == GameState::Idle && random.NextInt (SWAP_ONE_IN) == 0) {
+                const bool isVertical = random.NextInt (2) == 1;
+                const int row = random.NextInt (isVertical ? ROWS - 1 : ROWS);
+                const int column = random.NextInt (isVertical ? COLUMNS : COLUMNS - 1);
+                streamedGame.mGameStateLogic.RequestSwap (row, column, isVertical ? row + 1 : row, isVertical ? column : column + 1, gameState);
+            }
+            streamedGame.mGameStateLogic.Update (tickMilis, gameState);
+            const std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+            const SpectatorFramePtr frame = streamedGame.mEncoder.Encode (gameState, streamedGame.mBroadcast.IsKeyframeWanted());
+            encodeNanoseconds.Add (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - encodeStart).count()));
+            streamedGame.mBroadcast.Publish (frame);
+            // the games take turns, so every tick sends about as much
+            if ((tick + game) % sendIntervalTicks == 0 || tick == tickCount - 1) {
+                streamedGame.mBroadcast.Flush();
+            }
+        }
+        const double microseconds = std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - tickStart).count();
+        tickMicroseconds.Add (microseconds);
+        overBudgetTicks += microseconds > 1000000.0 / TICKS_PER_SECOND ? 1 : 0;
+    }
+    const double elapsedSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+
+    Uint64 keyframes = 0, keyframeBytes = 0, deltas = 0, deltaBytes = 0;
+    Uint64 sentFrames = 0, sentBytes = 0, skips = 0, droppedFrames = 0;
+    int subscribers = 0;
+    for (int game = 0; game < gameCount; game++) {
+        const StreamedGame& streamedGame = *games [game];
+        keyframes += streamedGame.mEncoder.GetKeyframeCount();
+        keyframeBytes += streamedGame.mEncoder.GetKeyframeBytes();
+        deltas += streamedGame.mEncoder.GetDeltaCount();
+        deltaBytes += streamedGame.mEncoder.GetDeltaBytes();
+        sentFrames += streamedGame.mBroadcast.GetSentFrameCount();
+        sentBytes += streamedGame.mBroadcast.GetSentBytes();
+        skips += streamedGame.mBroadcast.GetSkipCount();
+        droppedFrames += streamedGame.mBroadcast.GetDroppedFrameCount();
+        subscribers += streamedGame.mBroadcast.GetSubscriberCount();
+    }
+    // ending the streams lets the spectators finish
+    games.clear();
+    SpectatorResult result = SpectatorResult();
+    const bool isRead = read (resultPipe [0], &result, sizeof (result)) == static_cast<ssize_t>(sizeof (result));
+    close (resultPipe [0]);
+    waitpid (child, NULL, 0);
+
+    printf ("encoded %llu deltas of %.1f bytes on average and %llu keyframes of %.1f bytes (a full board every tick would be %u bytes), encode p50 %.2f us, p99 %.2f us\n",
+            static_cast<unsigned long long>(deltas), deltas > 0 ? static_cast<double>(deltaBytes) / deltas : 0.0,
+            static_cast<unsigned long long>(keyframes), keyframes > 0 ? static_cast<double>(keyframeBytes) / keyframes : 0.0,
+            static_cast<unsigned int>(sizeof (SpectatorFrameHeader) + ROWS * COLUMNS),
+            encodeNanoseconds.GetPercentile (50.0) / 1000.0, encodeNanoseconds.GetPercentile (99.0) / 1000.0);
+    printf ("tick (update, encode and send to %d spectators) p50 %.0f us, p99 %.0f us, max %.0f us, %d of %d ticks over the %.1f ms budget\n",
+            subscribers, tickMicroseconds.GetPercentile (50.0), tickMicroseconds.GetPercentile (99.0), tickMicroseconds.GetMaximum(),
+            overBudgetTicks, tickCount, 1000.0 / TICKS_PER_SECOND);
+    printf ("sent %.0f spectator frames/s, %.2f MB/s; %llu skips ahead to a keyframe, %llu frames dropped for slow spectators\n",
+            sentFrames / elapsedSeconds, sentBytes / elapsedSeconds / 1e6, static_cast<unsigned long long>(skips),
+            static_cast<unsigned long long>(droppedFrames));
+    if (!isRead) {
+        printf ("ERROR: SpectatorBenchmark got no result from the spectators.\n");
+        return EXIT_FAILURE;
+    }
+    printf ("spectators applied %llu frames (%llu keyframes), %llu deltas waited for a keyframe, %llu mismatching boards, %d of %d in sync at the end\n",
+            static_cast<unsigned long long>(result.mFrames), static_cast<unsigned long long>(result.mKeyframes),
+            static_cast<unsigned long long>(result.mRejectedFrames), static_cast<unsigned long long>(result.mMismatches),
+            result.mSynchronizedSpectators, spectatorCount);
+    const bool isCorrect = result.mMismatches == 0 && result.mSynchronizedSpectators == spectatorCount;
+    if (!isCorrect) {
+        printf ("ERROR: spectators did not see the sender's boards.\n");
+    }
+    return isCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}				/* ----------  end of function main  ---------- */
@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <GameRandom.h>
+#include <Histogram.h>
+#include <VersusLink.h>
+#include <VersusSession.h>
+
+
+/*!
+ * Plays a versus game between two processes over UDP on the loopback interface, each player a bot that swaps at
+ * random, at 60 frames per second in real time. Both peers add the given latency, jitter and loss to the packets they
+ * send. Every peer prints its rollbacks, how long a frame with its rollback took against the 16.7 ms a frame has and
+ * how much faster than real time frames are simulated; at the end the parent checks that both peers ended with the
+ * same two boards.
+ *
+ * usage: VersusLoopback [latency miliseconds] [loss percent] [gameplay seconds] [input delay frames] [port]
+ */
+
+
+static const int ROWS = 8;
+static const int COLUMNS = 8;
+static const int MIN_MATCH_SIZE = 3;
+static const int DEFAULT_LATENCY_MILIS = 50;
+static const double DEFAULT_LOSS_PERCENT = 5.0;
+static const int DEFAULT_GAMEPLAY_SECONDS = 20;
+static const int DEFAULT_INPUT_DELAY_FRAMES = 2;
+static const int DEFAULT_PORT = 7800;
+static const int SWAP_ONE_IN = 60;          ///< chance per resting frame that a bot swaps
+static const int LINGER_FRAMES = 120;       ///< frames a finished peer keeps sending, so the other one finishes too
+static const int TIMEOUT_SECONDS = 60;      ///< a peer gives up after the gameplay time with all its animations and this long
+
+
+/// what a peer reports to the parent
+struct PeerResult {
+    bool mIsFinished;
+    Uint32 mFrames;
+    Uint64 mChecksums [VersusSession::PLAYER_COUNT];
+    int mScores [VersusSession::PLAYER_COUNT];
+};
+
+
+/*!
+ * Runs one peer until the game is finished and the remote peer had time to finish as well.
+ */
+static PeerResult RunPeer (int player, int latencyMilis, double lossPercent, int gameplaySeconds, int inputDelayFrames, int port)
+{
+    PeerResult result = PeerResult();
+    VersusSession versusSession (ROWS, COLUMNS, MIN_MATCH_SIZE, gameplaySeconds, 777, player, inputDelayFrames);
+    VersusLink versusLink;
+    if (!versusLink.Open (static_cast<Uint16>(port + player), static_cast<Uint16>(port + 1 - player))) {
+        return result;
+    }
+    versusLink.SetConditions (latencyMilis, latencyMilis / 5, lossPercent);
+    GameRandom random (player + 1);
+    Histogram frameMicroseconds (100000, 1.0);
+    double rollbackSeconds = 0.0;
+    int aheadFrames = 0;
+    int waitedFrames = 0;
+    int stalledFrames = 0;
+    int overBudgetFrames = 0;
+    int lingerFrames = -1;
+    const std::chrono::microseconds frameDuration (1000000 / VersusSession::FRAMES_PER_SECOND);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point nextFrameTime = start;
+    while (lingerFrames != 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds (gameplaySeconds * 4 + TIMEOUT_SECONDS)) {
+        std::this_thread::sleep_until (nextFrameTime);
+        nextFrameTime += frameDuration;
+        versusLink.Exchange (versusSession);
+        if (lingerFrames > 0) {
+            lingerFrames--;
+        }
+        // a peer too far ahead skips a frame now and then instead of running into the rollback limit
+        if (versusLink.GetFramesToWait (versusSession) > 0 && aheadFrames++ % 4 == 0) {
+            waitedFrames++;
+            continue;
+        }
+        if (!versusSession.CanAdvance()) {
+            stalledFrames++;
+            continue;
+        }
+
+        // the bot decides on what it sees, its swap is played inputDelayFrames later
+        const GameState& gameState = versusSession.GetGameState (player);
+        VersusInput input;
+        if (gameState.GetAnimationState() == GameState::Idle && random.NextInt (SWAP_ONE_IN) == 0) {
+            const bool isVertical = random.NextInt (2) == 1;
+            input.mTileARow = static_cast<Sint8>(random.NextInt (isVertical ? ROWS - 1 : ROWS));
+            input.mTileAColumn = static_cast<Sint8>(random.NextInt (isVertical ? COLUMNS : COLUMNS - 1));
+            input.mTileBRow = static_cast<Sint8>(isVertical ? input.mTileARow + 1 : input.mTileARow);
+            input.mTileBColumn = static_cast<Sint8>(isVertical ? input.mTileAColumn : input.mTileAColumn + 1);
+        }
+        versusSession.SetLocalInput (input);
+        const Uint64 resimulatedFrames = versusSession.GetResimulatedFrameCount();
+        std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+        versusSession.AdvanceFrame();
+        const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - frameStart).count();
+        frameMicroseconds.Add (seconds * 1e6);
+        overBudgetFrames += seconds > 1.0 / VersusSession::FRAMES_PER_SECOND ? 1 : 0;
+        if (versusSession.GetResimulatedFrameCount() > resimulatedFrames) {
+            rollbackSeconds += seconds;
+        }
+        if (lingerFrames < 0 && versusSession.IsFinished()) {
+            lingerFrames = LINGER_FRAMES;
+        }
+    }
+
+    result.mIsFinished = versusSession.IsFinished();
+    result.mFrames = versusSession.GetFrame();
+    for (int index = 0; index < VersusSession::PLAYER_COUNT; index++) {
+        result.mChecksums [index] = VersusSession::GetChecksum (versusSession.GetGameState (index));
+        result.mScores [index] = versusSession.GetGameState (index).GetScore();
+    }
+    const Uint64 resimulatedFrames = versusSession.GetResimulatedFrameCount();
+    printf ("player %d: %u frames%s, %llu rollbacks (%.1f frames on average, at most %u), %d frames stalled at the rollback limit, %d waited for the other peer\n",
+            player, result.mFrames, result.mIsFinished ? "" : " (NOT FINISHED)", static_cast<unsigned long long>(versusSession.GetRollbackCount()),
+            versusSession.GetRollbackCount() > 0 ? static_cast<double>(resimulatedFrames) / versusSession.GetRollbackCount() : 0.0,
+            versusSession.GetMaxRollbackFrames(), stalledFrames, waitedFrames);
+    printf ("player %d: frame p50 %.0f us, p99 %.0f us, max %.0f us, %d over the %.1f ms budget; rollbacks simulate %.0f frames/ms, %.0fx real time\n",
+            player, frameMicroseconds.GetPercentile (50.0), frameMicroseconds.GetPercentile (99.0), frameMicroseconds.GetMaximum(), overBudgetFrames,
+            1000.0 / VersusSession::FRAMES_PER_SECOND, rollbackSeconds > 0.0 ? resimulatedFrames / rollbackSeconds / 1000.0 : 0.0,
+            rollbackSeconds > 0.0 ? resimulatedFrames / rollbackSeconds / VersusSession::FRAMES_PER_SECOND : 0.0);
+    printf ("player %d: %llu packets sent, %llu dropped, %llu received; scores %d : %d\n", player,
+            static_cast<unsigned long long>(versusLink.GetSentCount()), static_cast<unsigned long long>(versusLink.GetDroppedCount()),
+            static_cast<unsigned long long>(versusLink.GetReceivedCount()), result.mScores [0], result.mScores [1]);
+    fflush (stdout);
+    return result;
+}
+
+
+/*!
+ * Main function of the versus loopback test.
+ * @param argc up to 5 arguments: the one-way latency both peers add (default DEFAULT_LATENCY_MILIS, with a fifth of it
+ *  as jitter), the packet loss (default DEFAULT_LOSS_PERCENT), the gameplay time (default DEFAULT_GAMEPLAY_SECONDS),
+ *  the input delay (default DEFAULT_INPUT_DELAY_FRAMES) and the UDP port of player 0, player 1 uses the next one.
+ * @return returns 0 if both peers finished with the same boards.
+ */
+int main (int argc, char* argv[])
+{
+    const int latencyMilis = argc > 1 ? atoi (argv [1]) : DEFAULT_LATENCY_MILIS;
+    const double lossPercent = argc > 2 ? atof (argv [2]) : DEFAULT_LOSS_PERCENT;
+    const int gameplaySeconds = argc > 3 ? atoi (argv [3]) : DEFAULT_GAMEPLAY_SECONDS;
+    const int inputDelayFrames = argc > 4 ? atoi (argv [4]) : DEFAULT_INPUT_DELAY_FRAMES;
+    const int port = argc > 5 ? atoi (argv [5]) : DEFAULT_PORT;
+    if (latencyMilis < 0 || lossPercent < 0.0 || lossPercent >= 100.0 || gameplaySeconds < 1 || inputDelayFrames < 0 || port < 1 || port > 65534) {
+        printf ("usage: VersusLoopback [latency miliseconds] [loss percent] [gameplay seconds] [input delay frames] [port]\n");
+        return EXIT_FAILURE;
+    }
+    GameState::SetIsLoggingEnabled (false);
+    printf ("versus over 127.0.0.1:%d-%d, %d ms latency (+ up to %d ms jitter) and %.1f%% loss each way, %d s games, %d frames input delay\n",
+            port, port + 1, latencyMilis, latencyMilis / 5, lossPercent, gameplaySeconds, inputDelayFrames);
+    fflush (stdout);
+
+    // every peer is a process of its own and writes its result into a pipe
+    int pipes [VersusSession::PLAYER_COUNT][2];
+    pid_t children [VersusSession::PLAYER_COUNT];
+    for (int player = 0; player < VersusSession::PLAYER_COUNT; player++) {
+        if (pipe (pipes [player]) != 0) {
+            printf ("ERROR: VersusLoopback cannot create a pipe.\n");
+            return EXIT_FAILURE;
+        }
+        children [player] = fork();
+        if (children [player] < 0) {
+            printf ("ERROR: VersusLoopback cannot fork.\n");
+            return EXIT_FAILURE;
+        }
+        if (children [player] == 0) {
+            close (pipes [player][0]);
+            const PeerResult result = RunPeer (player, latencyMilis, lossPercent, gameplaySeconds, inputDelayFrames, port);
+            const bool isWritten = write (pipes [player][1], &result, sizeof (result)) == static_cast<ssize_t>(sizeof (result));
+            _exit (isWritten ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        close (pipes [player][1]);
+    }
+
+    PeerResult results [VersusSession::PLAYER_COUNT];
+    bool isCorrect = true;
+    for (int player = 0; player < VersusSession::PLAYER_COUNT; player++) {
+        isCorrect = read (pipes [player][0], &results [player], sizeof (PeerResult)) == static_cast<ssize_t>(sizeof (PeerResult)) && isCorrect;
+        close (pipes [player][0]);
+        waitpid (children [player], NULL, 0);
+    }
+    isCorrect = isCorrect && results [0].mIsFinished && results [1].mIsFinished;
+    for (int board = 0; isCorrect && board < VersusSession::PLAYER_COUNT; board++) {
+        isCorrect = results [0].mChecksums [board] == results [1].mChecksums [board];
+    }
+    if (isCorrect) {
+        printf ("both peers agree: player 0 %d, player 1 %d, %s\n", results [0].mScores [0], results [0].mScores [1],
+                results [0].mScores [0] == results [0].mScores [1] ? "draw" : (results [0].mScores [0] > results [0].mScores [1] ? "player 0 wins" : "player 1 wins"));
+    } else {
+        printf ("ERROR: the peers did not finish with the same boards.\n");
+    }
+    return isCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}				/* ----------  end of function main  ---------- */